@@ -279,8 +279,27 @@ inline float3 sample_environment(float2 uv, float mip_level)
     return tex_environment.SampleLevel(sampler_trilinear_clamp, uv, mip_level).rgb;
 }
 
+// Evaluates the irradiance that was baked as spherical harmonics (already convolved with the cosine lobe and divided by pi)
+inline float3 environment_irradiance(float3 n)
+{
+    float3 irradiance = g_environment_irradiance[0].rgb * 0.282095f;
+    irradiance += g_environment_irradiance[1].rgb * 0.488603f * n.y;
+    irradiance += g_environment_irradiance[2].rgb * 0.488603f * n.z;
+    irradiance += g_environment_irradiance[3].rgb * 0.488603f * n.x;
+    irradiance += g_environment_irradiance[4].rgb * 1.092548f * n.x * n.y;
+    irradiance += g_environment_irradiance[5].rgb * 1.092548f * n.y * n.z;
+    irradiance += g_environment_irradiance[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+    irradiance += g_environment_irradiance[7].rgb * 1.092548f * n.x * n.z;
+    irradiance += g_environment_irradiance[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+
+    return max(irradiance, 0.0f);
+}
+
 inline float3 Brdf_Diffuse_Ibl(Surface surface, float3 normal)
 {
+    if (g_irradiance_available != 0.0f)
+        return environment_irradiance(normal) * surface.albedo.rgb;
+
     return sample_environment(direction_sphere_uv(normal), g_envrionement_max_mip) * surface.albedo.rgb;
 }
 
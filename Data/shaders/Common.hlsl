@@ -207,6 +207,15 @@ float3 get_normal_view_space(float2 uv)
     return normalize(mul(float4(get_normal(uv), 0.0f), g_view).xyz);
 }
 
+// Octahedral decoding, the inverse of what RHI_Vertex_PosTexNorTanPacked does on the cpu
+float3 octahedral_decode(float2 value)
+{
+    float3 normal   = float3(value.x, value.y, 1.0f - abs(value.x) - abs(value.y));
+    float t         = saturate(-normal.z);
+    normal.xy       += normal.xy >= 0.0f ? -t : t;
+    return normalize(normal);
+}
+
 float3x3 makeTBN(float3 n, float3 t)
 {
     // re-orthogonalize T with respect to N
@@ -217,6 +226,19 @@ float3x3 makeTBN(float3 n, float3 t)
     return float3x3(t, b, n); 
 }
 
+/*------------------------------------------------------------------------------
+    VERTEX
+------------------------------------------------------------------------------*/
+Vertex_PosUvNorTan vertex_unpack(Vertex_PosUvNorTanPacked input)
+{
+    Vertex_PosUvNorTan output;
+    output.position = float4(g_vertex_position_offset + input.position.xyz * g_vertex_position_scale, 1.0f);
+    output.uv       = input.uv;
+    output.normal   = octahedral_decode(input.normal_tangent.xy);
+    output.tangent  = octahedral_decode(input.normal_tangent.zw);
+    return output;
+}
+
 /*------------------------------------------------------------------------------
     DEPTH
 ------------------------------------------------------------------------------*/
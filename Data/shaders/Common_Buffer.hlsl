@@ -54,10 +54,13 @@ cbuffer BufferFrame : register(b0)
     
     float g_shadow_resolution;
     float g_fog_density;
-    float2 g_padding;
+    float g_irradiance_available;
+    float g_padding;
 
     float2 g_taa_jitter_offset_previous;
     float2 g_taa_jitter_offset;
+
+    float4 g_environment_irradiance[9];
 };
 
 // Low frequency - Updates once per frame
@@ -96,6 +99,12 @@ cbuffer BufferUber : register(b2)
     float g_mip_index;
     float g_is_transprent_pass;
     float g_padding2;
+
+    float3 g_vertex_position_offset;
+    float g_padding3;
+
+    float3 g_vertex_position_scale;
+    float g_padding4;
 };
 
 // High frequency - Updates per light
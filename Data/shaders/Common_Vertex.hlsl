@@ -44,6 +44,14 @@ struct Vertex_PosUvNorTan
     float3 tangent      : TANGENT0;
 };
 
+// Compressed Vertex_PosUvNorTan, see vertex_unpack() and RHI_Vertex_PosTexNorTanPacked
+struct Vertex_PosUvNorTanPacked
+{
+    float4 position         : POSITION0; // unorm, relative to the bounding box of the mesh
+    float2 uv               : TEXCOORD0;
+    float4 normal_tangent   : NORMAL0;   // octahedral encoded normal (xy) and tangent (zw)
+};
+
 struct Vertex_Pos2dUvColor
 {
     float2 position     : POSITION0;
@@ -31,8 +31,14 @@ struct PixelInputType
     float3 positionWS   : POSITIONT_WS;
 };
 
+#if VERTEX_PACKED
+PixelInputType mainVS(Vertex_PosUvNorTanPacked input_packed)
+{
+    Vertex_PosUvNorTan input = vertex_unpack(input_packed);
+#else
 PixelInputType mainVS(Vertex_PosUvNorTan input)
 {
+#endif
     PixelInputType output;
 
     input.position.w    = 1.0f;
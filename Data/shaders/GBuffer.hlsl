@@ -39,8 +39,14 @@ struct PixelOutputType
     float2 velocity : SV_Target3;
 };
 
+#if VERTEX_PACKED
+PixelInputType mainVS(Vertex_PosUvNorTanPacked input_packed)
+{
+    Vertex_PosUvNorTan input = vertex_unpack(input_packed);
+#else
 PixelInputType mainVS(Vertex_PosUvNorTan input)
 {
+#endif
     PixelInputType output;
     
     input.position.w            = 1.0f;
@@ -114,8 +120,10 @@ PixelOutputType mainPS(PixelInputType input)
     #endif
     
     #if NORMAL_MAP
-        // Get tangent space normal and apply intensity
-        float3 tangent_normal   = normalize(unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, uv).rgb));
+        // Get tangent space normal and apply intensity (z is reconstructed, as block compressed normal maps only store x and y)
+        float3 tangent_normal   = 0.0f;
+        tangent_normal.xy       = unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, uv).rg);
+        tangent_normal.z        = sqrt(saturate(1.0f - dot(tangent_normal.xy, tangent_normal.xy)));
         float normal_intensity  = clamp(g_mat_normal, 0.012f, g_mat_normal);
         tangent_normal.xy       *= saturate(normal_intensity);
         normal                  = normalize(mul(tangent_normal, TBN).xyz); // Transform to world space
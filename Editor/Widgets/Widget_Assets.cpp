@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Widget_Assets.h"
 #include "Widget_Properties.h"
 #include "Rendering/Model.h"
+#include "Resource/Import/ModelImporter.h"
+#include "Resource/Import/ImageImporter.h"
 #include "../WidgetsDeferred/FileDialog.h"
 //========================================
 
@@ -56,6 +58,25 @@ void Widget_Assets::TickVisible()
         Widget_Assets_Statics::g_show_file_dialog_load = true;
     }
 
+    ImGui::SameLine();
+
+    // Import options
+    ModelImporter* model_importer = m_context->GetSubsystem<ResourceCache>()->GetModelImporter();
+    bool vertex_compression = model_importer->GetVertexCompression();
+    if (ImGui::Checkbox("Compress vertices", &vertex_compression))
+    {
+        model_importer->SetVertexCompression(vertex_compression);
+    }
+
+    ImGui::SameLine();
+
+    ImageImporter* image_importer = m_context->GetSubsystem<ResourceCache>()->GetImageImporter();
+    bool texture_compression = image_importer->GetCompression();
+    if (ImGui::Checkbox("Compress textures", &texture_compression))
+    {
+        image_importer->SetCompression(texture_compression);
+    }
+
     ImGui::SameLine();
     
     // VIEW
@@ -25,6 +25,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../WidgetsDeferred/FileDialog.h"
 #include "Core/Settings.h"
 #include "Rendering/Model.h"
+#include "Rendering/Skinning.h"
+#include "Rendering/Material.h"
+#include "Physics/Physics.h"
+#include "Resource/Import/ImageImporter.h"
+#include "Threading/Threading.h"
+#include "World/Entity.h"
+#include "World/Components/Renderable.h"
+#include "World/Components/Terrain.h"
 //========================================
 
 //= NAMESPACES ==========
@@ -97,6 +105,47 @@ void Widget_MenuBar::TickAlways()
             ImGui::EndMenu();
         }
 
+        if (ImGui::BeginMenu("Tools"))
+        {
+            // The benchmarks run on the spot (the editor stalls until they are done) and log their results to the console.
+            // The ones that need something to work on take it from the selected entity.
+            if (ImGui::BeginMenu("Benchmark"))
+            {
+                const shared_ptr<Entity> entity = EditorHelper::Get().g_selected_entity.lock();
+
+                if (ImGui::MenuItem("Physics"))
+                {
+                    m_context->GetSubsystem<Physics>()->Benchmark();
+                }
+
+                Renderable* renderable  = entity ? entity->GetComponent<Renderable>() : nullptr;
+                const Model* model      = renderable ? renderable->GeometryModel() : nullptr;
+                if (ImGui::MenuItem("Skinning (selected model)", nullptr, false, model && !model->GetBones().empty()))
+                {
+                    Skinning::benchmark(m_context->GetSubsystem<Threading>(), model, 1024);
+                }
+
+                Terrain* terrain = entity ? entity->GetComponent<Terrain>() : nullptr;
+                if (ImGui::MenuItem("Terrain normals (selected terrain)", nullptr, false, terrain != nullptr))
+                {
+                    terrain->Benchmark();
+                }
+
+                // The image that the color texture of the selected entity's material was imported from
+                Material* material          = renderable ? renderable->GetMaterial() : nullptr;
+                RHI_Texture* texture        = material ? material->GetTexture_Ptr(Material_Color) : nullptr;
+                const string image_path     = texture ? texture->GetResourceFilePath() : "";
+                if (ImGui::MenuItem("Block compression (selected color texture)", nullptr, false, FileSystem::IsSupportedImageFile(image_path) && FileSystem::Exists(image_path)))
+                {
+                    m_context->GetSubsystem<ResourceCache>()->GetImageImporter()->Benchmark(image_path);
+                }
+
+                ImGui::EndMenu();
+            }
+
+            ImGui::EndMenu();
+        }
+
         if (ImGui::BeginMenu("Help"))
         {
             ImGui::MenuItem("About", nullptr, &_Widget_MenuBar::g_showAboutWindow);
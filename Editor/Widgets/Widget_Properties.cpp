@@ -575,7 +575,9 @@ void Widget_Properties::ShowCollider(Collider* collider) const
             "Cylinder",
             "Capsule",
             "Cone",
-            "Mesh"
+            "Mesh",
+            "Heightfield",
+            "Mesh (Concave)"
         };
         const char* shape_char_ptr        = type[static_cast<int>(collider->GetShapeType())].c_str();
         bool optimize                    = collider->GetOptimize();
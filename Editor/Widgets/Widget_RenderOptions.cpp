@@ -325,6 +325,13 @@ void Widget_RenderOptions::TickVisible()
         // Reflect from engine
         auto do_depth_prepass   = m_renderer->GetOption(Render_DepthPrepass);
         auto do_reverse_z       = m_renderer->GetOption(Render_ReverseZ);
+        auto do_meshlet_culling = m_renderer->GetOption(Render_MeshletCulling);
+        auto do_lod             = m_renderer->GetOption(Render_Lod);
+        auto lod_threshold      = m_renderer->GetOptionValue<float>(Renderer_Option_Value::LodThreshold);
+        auto do_streaming       = m_renderer->GetOption(Render_GeometryStreaming);
+        auto streaming_budget   = m_renderer->GetOptionValue<int>(Renderer_Option_Value::GeometryStreamingBudget);
+        auto do_tex_streaming   = m_renderer->GetOption(Render_TextureStreaming);
+        auto tex_stream_budget  = m_renderer->GetOptionValue<int>(Renderer_Option_Value::TextureStreamingBudget);
 
         {
             // Buffer
@@ -386,10 +393,46 @@ void Widget_RenderOptions::TickVisible()
 
             // Reverse-Z
             ImGui::Checkbox("Reverse-Z", &do_reverse_z);
+
+            // Meshlet culling
+            ImGui::Checkbox("Meshlet Culling", &do_meshlet_culling);
+
+            // Levels of detail
+            ImGui::Checkbox("LOD", &do_lod);
+            ImGui::SameLine();
+            ImGui::PushItemWidth(120);
+            ImGui::InputFloat("Threshold", &lod_threshold, 0.1f);
+            ImGui::PopItemWidth();
+            ImGuiEx::Tooltip("The screen space error (in pixels) that a level of detail is allowed to have");
+
+            // Geometry streaming
+            ImGui::Checkbox("Geometry Streaming", &do_streaming);
+            ImGuiEx::Tooltip("Models that are loaded while this is enabled only keep the submeshes that are near the camera on the gpu");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(120);
+            ImGui::InputInt("Budget (MB)", &streaming_budget, 64);
+            ImGui::PopItemWidth();
+            ImGuiEx::Tooltip("The gpu memory that streamed geometry is allowed to use");
+
+            // Texture streaming
+            ImGui::Checkbox("Texture Streaming", &do_tex_streaming);
+            ImGuiEx::Tooltip("Textures that are loaded while this is enabled only keep the mips that their size on screen calls for on the gpu");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(120);
+            ImGui::InputInt("Budget (MB)##texture_streaming", &tex_stream_budget, 64);
+            ImGui::PopItemWidth();
+            ImGuiEx::Tooltip("The gpu memory that streamed textures are allowed to use");
         }
 
         // Map back to engine
         m_renderer->SetOption(Render_DepthPrepass, do_depth_prepass);
         m_renderer->SetOption(Render_ReverseZ, do_reverse_z);
+        m_renderer->SetOption(Render_MeshletCulling, do_meshlet_culling);
+        m_renderer->SetOption(Render_Lod, do_lod);
+        m_renderer->SetOptionValue(Renderer_Option_Value::LodThreshold, Helper::Max(lod_threshold, 0.0f));
+        m_renderer->SetOption(Render_GeometryStreaming, do_streaming);
+        m_renderer->SetOptionValue(Renderer_Option_Value::GeometryStreamingBudget, static_cast<float>(streaming_budget));
+        m_renderer->SetOption(Render_TextureStreaming, do_tex_streaming);
+        m_renderer->SetOptionValue(Renderer_Option_Value::TextureStreamingBudget, static_cast<float>(tex_stream_budget));
     }
 }
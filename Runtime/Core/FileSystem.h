@@ -114,6 +114,7 @@ namespace Spartan
             ".bmp",
             ".tga",
             ".dds",
+            ".ktx2",
             ".exr",
             ".raw",
             ".gif",
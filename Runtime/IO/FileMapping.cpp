@@ -0,0 +1,125 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===========
+#include "Spartan.h"
+#include "FileMapping.h"
+#include <windows.h>
+//======================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    FileMapping::FileMapping(const string& path)
+    {
+        m_path = path;
+
+        const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
+            return;
+        }
+        m_file = static_cast<void*>(file);
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            LOG_ERROR("\"%s\" is empty", path.c_str());
+            return;
+        }
+
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            LOG_ERROR("Failed to map \"%s\"", path.c_str());
+            return;
+        }
+        m_mapping = static_cast<void*>(mapping);
+
+        m_data = static_cast<const byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data)
+        {
+            LOG_ERROR("Failed to map a view of \"%s\"", path.c_str());
+            return;
+        }
+
+        m_size = static_cast<uint64_t>(size.QuadPart);
+    }
+
+    FileMapping::~FileMapping()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+        }
+
+        if (m_mapping)
+        {
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+        }
+
+        if (m_file)
+        {
+            CloseHandle(static_cast<HANDLE>(m_file));
+        }
+    }
+
+    void FileMapping::Read(string* value)
+    {
+        uint32_t length = 0;
+        Read(&length);
+
+        const byte* data = Advance(length);
+        value->assign(data ? reinterpret_cast<const char*>(data) : "", data ? length : 0);
+    }
+
+    const byte* FileMapping::ReadArray(const uint64_t element_size, uint32_t* count)
+    {
+        *count = 0;
+        Read(count);
+
+        const byte* data = Advance(element_size * *count);
+        if (!data)
+        {
+            *count = 0;
+        }
+
+        return data;
+    }
+
+    const byte* FileMapping::Advance(const uint64_t size)
+    {
+        if (!m_data || m_has_error || size > m_size - m_position)
+        {
+            m_has_error = true;
+            return nullptr;
+        }
+
+        const byte* data = m_data + m_position;
+        m_position += size;
+        return data;
+    }
+}
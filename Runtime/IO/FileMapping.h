@@ -0,0 +1,99 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ===========================
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include "../Core/Spartan_Definitions.h"
+//======================================
+
+namespace Spartan
+{
+    // A read-only, memory mapped file. The OS pages the contents in as they are accessed (and can drop them again), so data can be
+    // used straight from the mapping without reading it into memory first. Reads follow the layout that FileStream writes.
+    class SPARTAN_CLASS FileMapping
+    {
+    public:
+        FileMapping(const std::string& path);
+        ~FileMapping();
+
+        bool IsOpen()                   const { return m_data != nullptr; }
+        const std::string& GetPath()    const { return m_path; }
+        // True if a read went past the end of the file
+        bool HasError()                 const { return m_has_error; }
+        const std::byte* GetData()      const { return m_data; }
+        uint64_t GetSize()              const { return m_size; }
+        uint64_t GetPosition()          const { return m_position; }
+        void SetPosition(const uint64_t position) { m_position = position <= m_size ? position : m_size; }
+
+        template <class T>
+        void Read(T* value)
+        {
+            if (const std::byte* data = Advance(sizeof(T)))
+            {
+                std::memcpy(value, data, sizeof(T));
+            }
+        }
+
+        template <class T>
+        void Read(std::vector<T>* vec)
+        {
+            uint32_t count = 0;
+            const std::byte* data = ReadArray(sizeof(T), &count);
+            vec->resize(count);
+            if (count != 0)
+            {
+                std::memcpy(vec->data(), data, sizeof(T) * count);
+            }
+        }
+
+        void Read(std::string* value);
+
+        template <class T>
+        T ReadAs()
+        {
+            T value = {};
+            Read(&value);
+            return value;
+        }
+
+        // Skips over an array written by FileStream, returning where its elements are in the mapping (which isn't necessarily aligned for T)
+        const std::byte* ReadArray(uint64_t element_size, uint32_t* count);
+
+    private:
+        const std::byte* Advance(uint64_t size);
+
+        std::string m_path;
+        const std::byte* m_data = nullptr;
+        uint64_t m_size         = 0;
+        uint64_t m_position     = 0;
+        bool m_has_error        = false;
+
+        // API
+        void* m_file            = nullptr;
+        void* m_mapping         = nullptr;
+    };
+}
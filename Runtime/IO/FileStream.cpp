@@ -19,11 +19,16 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =================
+//= INCLUDES ========================
 #include "Spartan.h"
 #include "FileStream.h"
 #include "../RHI/RHI_Vertex.h"
-//============================
+#include "../Rendering/Meshlet.h"
+#include "../Rendering/MeshLod.h"
+#include "../Rendering/MeshSubmesh.h"
+#include "../Rendering/MeshBvh.h"
+#include "../Rendering/Animation.h"
+//===================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -115,6 +120,62 @@ namespace Spartan
         out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
     }
 
+    void FileStream::Write(const vector<Meshlet>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(Meshlet) * length);
+    }
+
+    void FileStream::Write(const vector<MeshLod>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(MeshLod) * length);
+    }
+
+    void FileStream::Write(const vector<MeshSubmesh>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(MeshSubmesh) * length);
+    }
+
+    void FileStream::Write(const vector<BvhNode>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(BvhNode) * length);
+    }
+
+    void FileStream::Write(const vector<MeshBvh>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(MeshBvh) * length);
+    }
+
+    void FileStream::Write(const vector<BoneWeights>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(BoneWeights) * length);
+    }
+
+    void FileStream::Write(const vector<KeyVector>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(KeyVector) * length);
+    }
+
+    void FileStream::Write(const vector<KeyQuaternionPacked>& value)
+    {
+        const auto length = static_cast<uint32_t>(value.size());
+        Write(length);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(KeyQuaternionPacked) * length);
+    }
+
     void FileStream::Write(const vector<unsigned char>& value)
     {
         const auto size = static_cast<uint32_t>(value.size());
@@ -202,6 +263,134 @@ namespace Spartan
         in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
     }
 
+    void FileStream::Read(vector<Meshlet>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(Meshlet) * length);
+    }
+
+    void FileStream::Read(vector<MeshLod>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(MeshLod) * length);
+    }
+
+    void FileStream::Read(vector<MeshSubmesh>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(MeshSubmesh) * length);
+    }
+
+    void FileStream::Read(vector<BvhNode>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(BvhNode) * length);
+    }
+
+    void FileStream::Read(vector<MeshBvh>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(MeshBvh) * length);
+    }
+
+    void FileStream::Read(vector<BoneWeights>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(BoneWeights) * length);
+    }
+
+    void FileStream::Read(vector<KeyVector>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(KeyVector) * length);
+    }
+
+    void FileStream::Read(vector<KeyQuaternionPacked>* vec)
+    {
+        if (!vec)
+            return;
+
+        vec->clear();
+        vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+        vec->reserve(length);
+        vec->resize(length);
+
+        in.read(reinterpret_cast<char*>(vec->data()), sizeof(KeyQuaternionPacked) * length);
+    }
+
     void FileStream::Read(vector<unsigned char>* vec)
     {
         if (!vec)
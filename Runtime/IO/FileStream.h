@@ -28,12 +28,21 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
 #include "../Math/Quaternion.h"
+#include "../Math/Matrix.h"
 #include "../Math/BoundingBox.h"
 //==============================
 
 namespace Spartan
 {
     class Entity;
+    struct Meshlet;
+    struct MeshLod;
+    struct MeshSubmesh;
+    struct BvhNode;
+    struct MeshBvh;
+    struct BoneWeights;
+    struct KeyVector;
+    struct KeyQuaternionPacked;
 
     enum FileStream_Mode : uint32_t
     {
@@ -72,6 +81,7 @@ namespace Spartan
             std::is_same<T, Math::Vector3>::value       ||
             std::is_same<T, Math::Vector4>::value       ||
             std::is_same<T, Math::Quaternion>::value    ||
+            std::is_same<T, Math::Matrix>::value        ||
             std::is_same<T, Math::BoundingBox>::value
         >::type>
         void Write(T value)
@@ -83,6 +93,14 @@ namespace Spartan
         void Write(const std::vector<std::string>& value);
         void Write(const std::vector<RHI_Vertex_PosTexNorTan>& value);
         void Write(const std::vector<uint32_t>& value);
+        void Write(const std::vector<Meshlet>& value);
+        void Write(const std::vector<MeshLod>& value);
+        void Write(const std::vector<MeshSubmesh>& value);
+        void Write(const std::vector<BvhNode>& value);
+        void Write(const std::vector<MeshBvh>& value);
+        void Write(const std::vector<BoneWeights>& value);
+        void Write(const std::vector<KeyVector>& value);
+        void Write(const std::vector<KeyQuaternionPacked>& value);
         void Write(const std::vector<unsigned char>& value);
         void Write(const std::vector<std::byte>& value);
         void Skip(uint32_t n);
@@ -110,6 +128,7 @@ namespace Spartan
             std::is_same<T, Math::Vector3>::value       ||
             std::is_same<T, Math::Vector4>::value       ||
             std::is_same<T, Math::Quaternion>::value    ||
+            std::is_same<T, Math::Matrix>::value        ||
             std::is_same<T, Math::BoundingBox>::value
         >::type>
         void Read(T* value)
@@ -120,6 +139,14 @@ namespace Spartan
         void Read(std::vector<std::string>* vec);
         void Read(std::vector<RHI_Vertex_PosTexNorTan>* vec);
         void Read(std::vector<uint32_t>* vec);
+        void Read(std::vector<Meshlet>* vec);
+        void Read(std::vector<MeshLod>* vec);
+        void Read(std::vector<MeshSubmesh>* vec);
+        void Read(std::vector<BvhNode>* vec);
+        void Read(std::vector<MeshBvh>* vec);
+        void Read(std::vector<BoneWeights>* vec);
+        void Read(std::vector<KeyVector>* vec);
+        void Read(std::vector<KeyQuaternionPacked>* vec);
         void Read(std::vector<unsigned char>* vec);
         void Read(std::vector<std::byte>* vec);
 
@@ -108,6 +108,18 @@ namespace Spartan::Math
         return false;
     }
 
+    bool Frustum::IsVisible(const Vector3& center, const float radius, const bool ignore_depth_planes /*= false*/) const
+    {
+        // The first two planes are the near and the far plane
+        for (uint32_t i = ignore_depth_planes ? 2 : 0; i < 6; i++)
+        {
+            if (Vector3::Dot(m_planes[i].normal, center) + m_planes[i].d < -radius)
+                return false;
+        }
+
+        return true;
+    }
+
     Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent) const
     {
         Intersection result = Inside;
@@ -21,11 +21,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ====
+//= INCLUDES =====
 #include <cmath>
 #include <limits>
 #include <random>
-//===============
+#include <cstring>
+//================
 
 namespace Spartan::Math
 {
@@ -134,4 +135,36 @@ namespace Spartan::Math::Helper
         n |= n >> 16;
         return n++;
     }
+
+    // Converts a 32-bit float to a 16-bit (half precision) float, rounding to the nearest even
+    inline uint16_t FloatToHalf(const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+
+        const uint32_t sign = (bits >> 16) & 0x8000;
+        const uint32_t abs  = bits & 0x7FFFFFFF;
+
+        // NaN and infinity
+        if (abs >= 0x7F800000)
+            return static_cast<uint16_t>(sign | 0x7C00 | (abs > 0x7F800000 ? 0x0200 : 0));
+
+        // Too large to be represented, becomes infinity
+        if (abs >= 0x477FF000)
+            return static_cast<uint16_t>(sign | 0x7C00);
+
+        // Too small to be represented as a normal half, becomes a denormal (or zero)
+        if (abs < 0x38800000)
+        {
+            if (abs < 0x33000000)
+                return static_cast<uint16_t>(sign);
+
+            const uint32_t mantissa = (abs & 0x007FFFFF) | 0x00800000;
+            const uint32_t shift    = 126 - (abs >> 23);
+            return static_cast<uint16_t>(sign | ((mantissa + (1 << (shift - 1))) >> shift));
+        }
+
+        // Re-bias the exponent and round the mantissa
+        return static_cast<uint16_t>(sign | ((abs - 0x38000000 + 0x0FFF + ((abs >> 13) & 1)) >> 13));
+    }
 }
@@ -187,6 +187,21 @@ namespace Spartan::Math
 
         auto Conjugate() const        { return Quaternion(-x, -y, -z, w); }
         float LengthSquared() const    { return (x * x) + (y * y) + (z * z) + (w * w); }
+        float Dot(const Quaternion& rhs) const { return (x * rhs.x) + (y * rhs.y) + (z * rhs.z) + (w * rhs.w); }
+
+        // Interpolates on the shortest path and normalizes, which is close enough to a slerp for rotations that are near each other
+        static inline Quaternion Lerp(const Quaternion& from, const Quaternion& to, const float t)
+        {
+            const float t_from  = 1.0f - t;
+            const float t_to    = from.Dot(to) < 0.0f ? -t : t;
+
+            return Quaternion(
+                (from.x * t_from) + (to.x * t_to),
+                (from.y * t_from) + (to.y * t_to),
+                (from.z * t_from) + (to.z * t_to),
+                (from.w * t_from) + (to.w * t_to)
+            ).Normalized();
+        }
 
         // Normalizes the quaternion
         void Normalize()
@@ -19,14 +19,20 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =====================
+//= INCLUDES =============================
 #include "Spartan.h"
 #include "Physics.h"
 #include "PhysicsDebugDraw.h"
+#include "PhysicsTaskScheduler.h"
+#include "ShapeCache.h"
 #include "BulletPhysicsHelper.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
-//================================
+#include "../Threading/Threading.h"
+#include "../Core/Stopwatch.h"
+#include "../World/Components/RigidBody.h"
+#include "../World/Components/Transform.h"
+//========================================
 
 //= NAMESPACES ================
 using namespace std;
@@ -35,21 +41,223 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
-    static const bool m_soft_body_support = true;
+    // Rigid bodies are simulated across the threads of the engine (see PhysicsTaskScheduler). Soft bodies are only simulated by the soft rigid world,
+    // which is single threaded, so the multithreaded world is only used when soft body support is off. That's the case when Bullet is thread safe,
+    // which is opted into when the project files are generated (see premake.lua), as the prebuilt Bullet libraries aren't.
+    #if BT_THREADSAFE
+    static const bool m_soft_body_support   = false;
+    #else
+    static const bool m_soft_body_support   = true;
+    #endif
+    static const bool m_multithreaded       = true;
+    static const int dispatcher_grain_size  = 40; // collision pairs per task
+    // The world is stepped by a thread of its own (see Physics::Tick()), otherwise the steps are taken by the engine thread
+    static const bool m_threaded_simulation = true;
+
+    static btDiscreteDynamicsWorld* world_create(const bool multithreaded, const int thread_count, btDefaultCollisionConfiguration*& configuration, btCollisionDispatcher*& dispatcher, btBroadphaseInterface*& broadphase, btConstraintSolver*& solver, btConstraintSolverPoolMt*& solver_pool)
+    {
+        broadphase      = new btDbvtBroadphase();
+        configuration   = new btDefaultCollisionConfiguration();
+
+        if (!multithreaded)
+        {
+            dispatcher  = new btCollisionDispatcher(configuration);
+            solver      = new btSequentialImpulseConstraintSolver();
+            return new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, configuration);
+        }
+
+        // Islands are solved in parallel, each with a solver from the pool, and an island that is too large to be solved by one thread is solved by all of them
+        dispatcher  = new btCollisionDispatcherMt(configuration, dispatcher_grain_size);
+        solver_pool = new btConstraintSolverPoolMt(thread_count);
+        solver      = new btSequentialImpulseConstraintSolverMt();
+        return new btDiscreteDynamicsWorldMt(dispatcher, broadphase, solver_pool, solver, configuration);
+    }
+
+    // The benchmark scene, pyramids of boxes (one island each) and ragdolls (capsules held by hinges and cone twists) which fall in piles
+    static const uint32_t benchmark_pyramids        = 16;
+    static const uint32_t benchmark_pyramid_base    = 10;
+    static const uint32_t benchmark_ragdolls        = 64;
+    static const uint32_t benchmark_steps           = 300;
+
+    struct BenchmarkScene
+    {
+        vector<btCollisionShape*> shapes;
+        vector<btRigidBody*> bodies;
+        vector<btTypedConstraint*> constraints;
+
+        btRigidBody* AddBody(btDiscreteDynamicsWorld* world, btCollisionShape* shape, const float mass, const btTransform& transform)
+        {
+            btVector3 inertia(0, 0, 0);
+            if (mass != 0.0f)
+            {
+                shape->calculateLocalInertia(mass, inertia);
+            }
+
+            btRigidBody::btRigidBodyConstructionInfo info(mass, nullptr, shape, inertia);
+            info.m_startWorldTransform = transform;
+            btRigidBody* body = new btRigidBody(info);
+            world->addRigidBody(body);
+            bodies.emplace_back(body);
+
+            return body;
+        }
+
+        void AddConstraint(btDiscreteDynamicsWorld* world, btTypedConstraint* constraint)
+        {
+            world->addConstraint(constraint, true);
+            constraints.emplace_back(constraint);
+        }
+
+        void Clear(btDiscreteDynamicsWorld* world)
+        {
+            for (btTypedConstraint* constraint : constraints)
+            {
+                world->removeConstraint(constraint);
+                delete constraint;
+            }
+
+            for (btRigidBody* body : bodies)
+            {
+                world->removeRigidBody(body);
+                delete body;
+            }
+
+            for (btCollisionShape* shape : shapes)
+            {
+                delete shape;
+            }
+
+            constraints.clear();
+            bodies.clear();
+            shapes.clear();
+        }
+    };
+
+    static btTransform benchmark_frame(const btVector3& origin, const float rotation_y = 0.0f, const float rotation_z = 0.0f)
+    {
+        btTransform transform;
+        transform.setIdentity();
+        transform.getBasis().setEulerZYX(0.0f, rotation_y, rotation_z);
+        transform.setOrigin(origin);
+        return transform;
+    }
+
+    static void benchmark_ragdoll(btDiscreteDynamicsWorld* world, BenchmarkScene& scene, const btVector3& position)
+    {
+        // Pelvis, spine, head, upper and lower legs, upper and lower arms (left then right)
+        static const float radii[]      = { 0.15f, 0.15f, 0.10f, 0.07f, 0.05f, 0.07f, 0.05f, 0.05f, 0.04f, 0.05f, 0.04f };
+        static const float heights[]    = { 0.20f, 0.28f, 0.05f, 0.45f, 0.37f, 0.45f, 0.37f, 0.33f, 0.25f, 0.33f, 0.25f };
+        static const btVector3 offsets[] =
+        {
+            btVector3(0.0f, 1.0f, 0.0f), btVector3(0.0f, 1.2f, 0.0f), btVector3(0.0f, 1.6f, 0.0f),
+            btVector3(-0.18f, 0.65f, 0.0f), btVector3(-0.18f, 0.2f, 0.0f), btVector3(0.18f, 0.65f, 0.0f), btVector3(0.18f, 0.2f, 0.0f),
+            btVector3(-0.35f, 1.45f, 0.0f), btVector3(-0.7f, 1.45f, 0.0f), btVector3(0.35f, 1.45f, 0.0f), btVector3(0.7f, 1.45f, 0.0f)
+        };
+        static const float quarter_pi    = SIMD_PI * 0.25f;
+        static const float rotations_z[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, SIMD_HALF_PI, SIMD_HALF_PI, -SIMD_HALF_PI, -SIMD_HALF_PI };
+
+        btRigidBody* parts[11];
+        for (uint32_t i = 0; i < 11; i++)
+        {
+            btCollisionShape* shape = scene.shapes.emplace_back(new btCapsuleShape(radii[i], heights[i]));
+            parts[i] = scene.AddBody(world, shape, 1.0f, benchmark_frame(position + offsets[i], 0.0f, rotations_z[i]));
+            parts[i]->setDamping(0.05f, 0.85f);
+        }
+
+        const auto hinge = [&](const uint32_t a, const uint32_t b, const btVector3& origin_a, const btVector3& origin_b, const float low, const float high)
+        {
+            btHingeConstraint* constraint = new btHingeConstraint(*parts[a], *parts[b], benchmark_frame(origin_a, SIMD_HALF_PI), benchmark_frame(origin_b, SIMD_HALF_PI));
+            constraint->setLimit(low, high);
+            scene.AddConstraint(world, constraint);
+        };
+
+        const auto cone = [&](const uint32_t a, const uint32_t b, const btVector3& origin_a, const float rotation_a, const btVector3& origin_b, const float rotation_b, const float swing, const float twist)
+        {
+            btConeTwistConstraint* constraint = new btConeTwistConstraint(*parts[a], *parts[b], benchmark_frame(origin_a, 0.0f, rotation_a), benchmark_frame(origin_b, 0.0f, rotation_b));
+            constraint->setLimit(swing, swing, twist);
+            scene.AddConstraint(world, constraint);
+        };
+
+        hinge(0, 1, btVector3(0.0f, 0.15f, 0.0f), btVector3(0.0f, -0.15f, 0.0f), -quarter_pi, SIMD_HALF_PI);                         // spine
+        cone(1, 2, btVector3(0.0f, 0.30f, 0.0f), SIMD_HALF_PI, btVector3(0.0f, -0.14f, 0.0f), SIMD_HALF_PI, quarter_pi, SIMD_HALF_PI); // neck
+        cone(0, 3, btVector3(-0.18f, -0.10f, 0.0f), -quarter_pi * 5.0f, btVector3(0.0f, 0.225f, 0.0f), -quarter_pi * 5.0f, quarter_pi, 0.0f);
+        hinge(3, 4, btVector3(0.0f, -0.225f, 0.0f), btVector3(0.0f, 0.185f, 0.0f), 0.0f, SIMD_HALF_PI);
+        cone(0, 5, btVector3(0.18f, -0.10f, 0.0f), quarter_pi, btVector3(0.0f, 0.225f, 0.0f), quarter_pi, quarter_pi, 0.0f);
+        hinge(5, 6, btVector3(0.0f, -0.225f, 0.0f), btVector3(0.0f, 0.185f, 0.0f), 0.0f, SIMD_HALF_PI);
+        cone(1, 7, btVector3(-0.2f, 0.15f, 0.0f), SIMD_PI, btVector3(0.0f, -0.18f, 0.0f), SIMD_HALF_PI, SIMD_HALF_PI, 0.0f);
+        hinge(7, 8, btVector3(0.0f, 0.18f, 0.0f), btVector3(0.0f, -0.14f, 0.0f), 0.0f, SIMD_HALF_PI);
+        cone(1, 9, btVector3(0.2f, 0.15f, 0.0f), 0.0f, btVector3(0.0f, -0.18f, 0.0f), SIMD_HALF_PI, SIMD_HALF_PI, 0.0f);
+        hinge(9, 10, btVector3(0.0f, 0.18f, 0.0f), btVector3(0.0f, -0.14f, 0.0f), 0.0f, SIMD_HALF_PI);
+    }
+
+    static void benchmark_scene_create(btDiscreteDynamicsWorld* world, BenchmarkScene& scene)
+    {
+        // Ground
+        btCollisionShape* ground = scene.shapes.emplace_back(new btBoxShape(btVector3(100.0f, 1.0f, 100.0f)));
+        scene.AddBody(world, ground, 0.0f, benchmark_frame(btVector3(0.0f, -1.0f, 0.0f)));
+
+        // Pyramids, on a grid on one side
+        btCollisionShape* box = scene.shapes.emplace_back(new btBoxShape(btVector3(0.5f, 0.5f, 0.5f)));
+        const uint32_t pyramids_per_row = static_cast<uint32_t>(sqrt(static_cast<float>(benchmark_pyramids)));
+        for (uint32_t pyramid = 0; pyramid < benchmark_pyramids; pyramid++)
+        {
+            const btVector3 origin(-60.0f + (pyramid % pyramids_per_row) * 14.0f, 0.5f, -30.0f + (pyramid / pyramids_per_row) * 14.0f);
+            for (uint32_t level = 0; level < benchmark_pyramid_base; level++)
+            {
+                for (uint32_t i = 0; i < benchmark_pyramid_base - level; i++)
+                {
+                    scene.AddBody(world, box, 1.0f, benchmark_frame(origin + btVector3(i * 1.01f + level * 0.505f, level * 1.0f, 0.0f)));
+                }
+            }
+        }
+
+        // Ragdolls, a few on top of each other so that they end up in piles
+        for (uint32_t ragdoll = 0; ragdoll < benchmark_ragdolls; ragdoll++)
+        {
+            const uint32_t pile = ragdoll / 4;
+            benchmark_ragdoll(world, scene, btVector3(10.0f + (pile % 4) * 4.0f, 1.0f + (ragdoll % 4) * 2.0f, -30.0f + (pile / 4) * 4.0f));
+        }
+    }
 
     Physics::Physics(Context* context) : ISubsystem(context)
     {
-        m_broadphase        = new btDbvtBroadphase();
-        m_constraint_solver = new btSequentialImpulseConstraintSolver();
+        // Subsystems are created by the main thread, which is the only one that starts steps and waits for them
+        m_thread_id_main = this_thread::get_id();
 
-        if (m_soft_body_support)
+        m_shape_cache = new ShapeCache(context);
+
+        // The scheduler has to be set before any of the multithreaded classes are created, the benchmark creates them even if the world isn't multithreaded.
+        // Bullet only runs its loops through a scheduler when its libraries are built with BT_THREADSAFE (which the engine has to be compiled with too),
+        // otherwise btParallelFor() asserts, so without it neither the scheduler nor the multithreaded world are used.
+        #if BT_THREADSAFE
+        Threading* threading = context->GetSubsystem<Threading>();
+        if (m_multithreaded && threading->GetThreadCount() > 0)
+        {
+            m_task_scheduler = new PhysicsTaskScheduler(threading);
+            btSetTaskScheduler(m_task_scheduler);
+        }
+        #endif
+
+        if (m_task_scheduler && !m_soft_body_support)
+        {
+            m_world = world_create(true, m_task_scheduler->getNumThreads(), m_collision_configuration, m_collision_dispatcher, m_broadphase, m_constraint_solver, m_constraint_solver_pool);
+        }
+        else if (m_soft_body_support)
         {
             // Create
-            m_collision_configuration  = new btSoftBodyRigidBodyCollisionConfiguration();
-            m_collision_dispatcher     = new btCollisionDispatcher(m_collision_configuration);
-            m_world                    = new btSoftRigidDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration);
+            m_broadphase                = new btDbvtBroadphase();
+            m_constraint_solver         = new btSequentialImpulseConstraintSolver();
+            m_collision_configuration   = new btSoftBodyRigidBodyCollisionConfiguration();
+            m_collision_dispatcher      = new btCollisionDispatcher(m_collision_configuration);
+            m_world                     = new btSoftRigidDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration);
+        }
+        else
+        {
+            m_world = world_create(false, 1, m_collision_configuration, m_collision_dispatcher, m_broadphase, m_constraint_solver, m_constraint_solver_pool);
+        }
 
-            // Setup         
+        // Soft bodies are created with this, even if the world can't simulate them (see AddBody())
+        {
             m_world_info = new btSoftBodyWorldInfo();
             m_world_info->m_sparsesdf.Initialize();
             m_world->getDispatchInfo().m_enableSPU  = true;
@@ -60,14 +268,6 @@ namespace Spartan
             m_world_info->water_offset              = 0;
             m_world_info->water_normal              = btVector3(0, 0, 0);
             m_world_info->m_gravity                 = ToBtVector3(m_gravity);
-
-        }
-        else
-        {
-            // Create
-            m_collision_configuration   = new btDefaultCollisionConfiguration();
-            m_collision_dispatcher      = new btCollisionDispatcher(m_collision_configuration);
-            m_world                     = new btDiscreteDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration);
         }
 
         // Setup
@@ -75,17 +275,38 @@ namespace Spartan
         m_world->getDispatchInfo().m_useContinuous  = true;
         m_world->getSolverInfo().m_splitImpulse     = false;
         m_world->getSolverInfo().m_numIterations    = m_max_solve_iterations;
+
+        // The motion states get the pose of the step that was just taken (instead of the one before it), the interpolation is done by the engine (see Tick())
+        m_world->setLatencyMotionStateInterpolation(false);
     }
 
     Physics::~Physics()
     {
+        if (m_thread.joinable())
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_stopping = true;
+            lock.unlock();
+
+            m_condition.notify_all();
+            m_thread.join();
+        }
+
         sp_ptr_delete(m_world);
         sp_ptr_delete(m_constraint_solver);
+        sp_ptr_delete(m_constraint_solver_pool);
         sp_ptr_delete(m_collision_dispatcher);
         sp_ptr_delete(m_collision_configuration);
         sp_ptr_delete(m_broadphase);
         sp_ptr_delete(m_world_info);
         sp_ptr_delete(m_debug_draw);
+        sp_ptr_delete(m_shape_cache);
+
+        if (m_task_scheduler)
+        {
+            btSetTaskScheduler(nullptr);
+            sp_ptr_delete(m_task_scheduler);
+        }
     }
 
     bool Physics::Initialize()
@@ -109,6 +330,11 @@ namespace Spartan
             }
         }
 
+        if (m_world && m_threaded_simulation)
+        {
+            m_thread = thread(&Physics::ThreadLoop, this);
+        }
+
         return true;
     }
 
@@ -116,7 +342,16 @@ namespace Spartan
     {
         if (!m_world)
             return;
-        
+
+        // While the simulation is stopped, another thread is changing the world (see Stop())
+        lock_guard<mutex> lock_tick(m_mutex_tick);
+        if (!m_is_allowed_to_simulate)
+            return;
+
+        // The steps of the previous frame have to be done before anything else touches the world
+        WaitForSimulation();
+        CommandsExecute();
+
         // Debug draw
         if (m_renderer->GetOptions() & Render_Debug_Physics)
         {
@@ -125,82 +360,244 @@ namespace Spartan
 
         // Don't simulate physics if they are turned off or the we are in editor mode
         if (!m_context->m_engine->EngineMode_IsSet(Engine_Physics) || !m_context->m_engine->EngineMode_IsSet(Engine_Game))
+        {
+            m_time_accumulated = 0.0f;
             return;
+        }
 
         SCOPED_TIME_BLOCK(m_profiler);
 
-        // This equation must be met: timeStep < maxSubSteps * fixedTimeStep
-        auto internal_time_step    = 1.0f / m_internal_fps;
-        auto max_substeps        = static_cast<int>(delta_time_sec * m_internal_fps) + 1;
-        if (m_max_sub_steps < 0)
+        // Publish the poses of the last steps and move the transforms to where the bodies were, between the last two of them
+        TransformsSync();
+
+        // The world is stepped at a fixed rate, what's left of the time is how far the transforms are between the two poses once these steps are done
+        const float time_step       = 1.0f / m_internal_fps;
+        m_time_accumulated          += delta_time_sec;
+        const uint32_t steps_due    = static_cast<uint32_t>(m_time_accumulated / time_step);
+        m_time_accumulated          -= steps_due * time_step;
+        m_interpolation             = m_time_accumulated / time_step;
+
+        // Time which can't be caught up with is dropped, so that a slow frame doesn't make the frames that follow it even slower
+        const uint32_t steps = m_max_sub_steps > 0 ? Helper::Min(steps_due, static_cast<uint32_t>(m_max_sub_steps)) : steps_due;
+
+        Simulate(steps);
+    }
+
+    void Physics::TransformsSync()
+    {
+        // Only the bodies which can move are walked, and of them, the ones which are asleep since they were last published are skipped
+        m_transform_writes.clear();
+        const btAlignedObjectArray<btRigidBody*>& bodies = m_world->getNonStaticRigidBodies();
+        for (int i = 0; i < bodies.size(); i++)
         {
-            internal_time_step    = delta_time_sec;
-            max_substeps        = 1;
+            btRigidBody* body       = bodies[i];
+            RigidBody* rigid_body   = static_cast<RigidBody*>(body->getUserPointer());
+            if (!rigid_body || (!body->isActive() && !rigid_body->IsPosePending()))
+                continue;
+
+            rigid_body->PublishPose(m_step_count);
+
+            // Kinematic bodies are moved by the engine
+            if (body->isKinematicObject())
+                continue;
+
+            // Where the body was, between the last two steps
+            const RigidBodyPose pose = rigid_body->GetPoseInterpolated(m_interpolation);
+            m_transform_writes.push_back({ rigid_body->GetTransform(), pose.position, pose.rotation });
+        }
+
+        // All the positions and rotations are written in one go, with every transform updated once
+        Transform::SetPositionsAndRotations(m_transform_writes);
+    }
+
+    void Physics::WaitForSimulation()
+    {
+        // Other threads can't wait, as the main thread could start new steps right after, they have to stop the simulation instead
+        if (this_thread::get_id() != m_thread_id_main)
+        {
+            SP_ASSERT(!m_is_allowed_to_simulate && "The simulation has to be stopped before another thread changes the world");
+            return;
         }
-        else if (m_max_sub_steps > 0)
+
+        if (!m_simulating)
+            return;
+
+        unique_lock<mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_steps_pending == 0; });
+        m_simulating = false;
+    }
+
+    void Physics::AddCommand(btCollisionObject* body, function<void()>&& command)
+    {
+        lock_guard<mutex> lock(m_mutex_commands);
+        m_commands.push_back({ body, move(command) });
+    }
+
+    void Physics::Stop()
+    {
+        // Once the main thread is out of Tick(), it won't start new steps, so only the ones in flight have to be waited for
         {
-            max_substeps = Helper::Min(max_substeps, m_max_sub_steps);
+            lock_guard<mutex> lock_tick(m_mutex_tick);
+            m_is_allowed_to_simulate = false;
         }
 
-        // Step the physics world. 
-        m_simulating = true;
-        m_world->stepSimulation(delta_time_sec, max_substeps, internal_time_step);
+        unique_lock<mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_steps_pending == 0; });
         m_simulating = false;
     }
 
-    void Physics::AddBody(btRigidBody* body) const
+    void Physics::Start()
+    {
+        lock_guard<mutex> lock_tick(m_mutex_tick);
+        m_is_allowed_to_simulate = true;
+    }
+
+    void Physics::Simulate(const uint32_t steps)
+    {
+        if (steps == 0)
+            return;
+
+        if (!m_thread.joinable())
+        {
+            Step(steps);
+            return;
+        }
+
+        unique_lock<mutex> lock(m_mutex);
+        m_steps_pending = steps;
+        m_simulating    = true;
+        lock.unlock();
+
+        m_condition.notify_all();
+    }
+
+    void Physics::Step(const uint32_t steps)
+    {
+        const float time_step = 1.0f / m_internal_fps;
+
+        for (uint32_t i = 0; i < steps; i++)
+        {
+            // Counted before the step, so that the motion states can tell which bodies moved during it
+            m_step_count++;
+            m_world->stepSimulation(time_step, 1, time_step);
+        }
+    }
+
+    void Physics::ThreadLoop()
+    {
+        while (true)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_steps_pending != 0 || m_stopping; });
+
+            if (m_stopping)
+                return;
+
+            const uint32_t steps = m_steps_pending;
+            lock.unlock();
+
+            Step(steps);
+
+            lock.lock();
+            m_steps_pending = 0;
+            lock.unlock();
+
+            m_condition.notify_all();
+        }
+    }
+
+    void Physics::CommandsExecute()
+    {
+        // Taken out first, as the commands run with the world idle and won't add any more of them
+        unique_lock<mutex> lock(m_mutex_commands);
+        vector<Command> commands = move(m_commands);
+        m_commands.clear();
+        lock.unlock();
+
+        m_executing_commands = true;
+        for (const Command& command : commands)
+        {
+            command.function();
+        }
+        m_executing_commands = false;
+    }
+
+    void Physics::AddBody(btRigidBody* body)
     {
         if (!m_world)
             return;
 
+        WaitForSimulation();
         m_world->addRigidBody(body);
     }
 
-    void Physics::RemoveBody(btRigidBody*& body) const
+    void Physics::RemoveBody(btRigidBody*& body)
     {
         if (!m_world)
             return;
 
+        WaitForSimulation();
+
+        // The commands which are still waiting for it, are dropped with it
+        unique_lock<mutex> lock(m_mutex_commands);
+        m_commands.erase(remove_if(m_commands.begin(), m_commands.end(), [body](const Command& command) { return command.body == body; }), m_commands.end());
+        lock.unlock();
+
         m_world->removeRigidBody(body);
         delete body->getMotionState();
         sp_ptr_delete(body);
     }
 
-    void Physics::AddConstraint(btTypedConstraint* constraint, bool collision_with_linked_body /*= true*/) const
+    void Physics::AddConstraint(btTypedConstraint* constraint, bool collision_with_linked_body /*= true*/)
     {
         if (!m_world)
             return;
 
+        WaitForSimulation();
         m_world->addConstraint(constraint, !collision_with_linked_body);
     }
 
-    void Physics::RemoveConstraint(btTypedConstraint*& constraint) const
+    void Physics::RemoveConstraint(btTypedConstraint*& constraint)
     {
         if (!m_world)
             return;
 
+        WaitForSimulation();
         m_world->removeConstraint(constraint);
         sp_ptr_delete(constraint);
     }
 
-    void Physics::AddBody(btSoftBody* body) const
+    void Physics::AddBody(btSoftBody* body)
     {
         if (!m_world)
             return;
 
-        if (btSoftRigidDynamicsWorld* world = static_cast<btSoftRigidDynamicsWorld*>(m_world))
+        WaitForSimulation();
+
+        if (m_world->getWorldType() != BT_SOFT_RIGID_DYNAMICS_WORLD)
         {
-            world->addSoftBody(body);
+            LOG_WARNING("Soft bodies are only simulated by the single threaded physics world.");
+            return;
         }
+
+        static_cast<btSoftRigidDynamicsWorld*>(m_world)->addSoftBody(body);
     }
 
-    void Physics::RemoveBody(btSoftBody*& body) const
+    void Physics::RemoveBody(btSoftBody*& body)
     {
-        if (btSoftRigidDynamicsWorld* world = static_cast<btSoftRigidDynamicsWorld*>(m_world))
+        WaitForSimulation();
+
+        // The commands which are still waiting for it, are dropped with it
+        unique_lock<mutex> lock(m_mutex_commands);
+        m_commands.erase(remove_if(m_commands.begin(), m_commands.end(), [body](const Command& command) { return command.body == body; }), m_commands.end());
+        lock.unlock();
+
+        if (m_world && m_world->getWorldType() == BT_SOFT_RIGID_DYNAMICS_WORLD)
         {
-            world->removeSoftBody(body);
-            sp_ptr_delete(body);
+            static_cast<btSoftRigidDynamicsWorld*>(m_world)->removeSoftBody(body);
         }
+
+        sp_ptr_delete(body);
     }
 
     Vector3 Physics::GetGravity() const
@@ -213,4 +610,64 @@ namespace Spartan
         }
         return gravity ? ToVector3(gravity) : Vector3::Zero;
     }
+
+    void Physics::Benchmark()
+    {
+        // The benchmark worlds use the same threads
+        WaitForSimulation();
+
+        for (const bool multithreaded : { false, true })
+        {
+            if (multithreaded && !m_task_scheduler)
+            {
+                LOG_INFO("Physics benchmark, multithreaded: skipped, Bullet isn't built with BT_THREADSAFE or there are no threads to run on");
+                continue;
+            }
+
+            btDefaultCollisionConfiguration* configuration  = nullptr;
+            btCollisionDispatcher* dispatcher               = nullptr;
+            btBroadphaseInterface* broadphase               = nullptr;
+            btConstraintSolver* solver                      = nullptr;
+            btConstraintSolverPoolMt* solver_pool           = nullptr;
+            const int thread_count                          = multithreaded ? m_task_scheduler->getNumThreads() : 1;
+            btDiscreteDynamicsWorld* world                  = world_create(multithreaded, thread_count, configuration, dispatcher, broadphase, solver, solver_pool);
+
+            // The same settings as the world of the engine
+            world->setGravity(ToBtVector3(m_gravity));
+            world->getSolverInfo().m_splitImpulse   = false;
+            world->getSolverInfo().m_numIterations  = m_max_solve_iterations;
+
+            BenchmarkScene scene;
+            benchmark_scene_create(world, scene);
+
+            // Fixed steps, so both runs simulate exactly the same thing
+            const float time_step = 1.0f / m_internal_fps;
+            float duration_max_ms = 0.0f;
+            const Stopwatch timer;
+            for (uint32_t i = 0; i < benchmark_steps; i++)
+            {
+                const Stopwatch timer_step;
+                world->stepSimulation(time_step, 1, time_step);
+                duration_max_ms = Helper::Max(duration_max_ms, timer_step.GetElapsedTimeMs());
+            }
+            const float duration_ms = timer.GetElapsedTimeMs();
+
+            LOG_INFO("Physics benchmark, %s (%d threads): %d bodies, %d constraints, %.2f ms per step, %.2f ms at most",
+                multithreaded ? "multithreaded" : "single threaded",
+                thread_count,
+                static_cast<int>(scene.bodies.size()),
+                static_cast<int>(scene.constraints.size()),
+                duration_ms / benchmark_steps,
+                duration_max_ms
+            );
+
+            scene.Clear(world);
+            delete world;
+            delete solver;
+            delete solver_pool;
+            delete dispatcher;
+            delete configuration;
+            delete broadphase;
+        }
+    }
 }
@@ -22,6 +22,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <vector>
 #include "../Core/ISubsystem.h"
 #include "../Math/Vector3.h"
 //=============================
@@ -29,7 +35,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= FORWARD DECLARATIONS =================
 class btBroadphaseInterface;
 class btCollisionDispatcher;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
+class btConstraintSolverPoolMt;
 class btDefaultCollisionConfiguration;
 class btCollisionObject;
 class btDiscreteDynamicsWorld;
@@ -43,6 +50,9 @@ namespace Spartan
 {
     class Renderer;
     class PhysicsDebugDraw;
+    class PhysicsTaskScheduler;
+    class ShapeCache;
+    struct TransformWrite;
     class Profiler;
     namespace Math { class Vector3; }    
 
@@ -58,42 +68,92 @@ namespace Spartan
         //===================================
 
         // Rigid body
-        void AddBody(btRigidBody* body) const;
-        void RemoveBody(btRigidBody*& body) const;
+        void AddBody(btRigidBody* body);
+        void RemoveBody(btRigidBody*& body);
 
         // Soft body
-        void AddBody(btSoftBody* body) const;
-        void RemoveBody(btSoftBody*& body) const;
+        void AddBody(btSoftBody* body);
+        void RemoveBody(btSoftBody*& body);
 
         // Constraint
-        void AddConstraint(btTypedConstraint* constraint, bool collision_with_linked_body = true) const;
-        void RemoveConstraint(btTypedConstraint*& constraint) const;
+        void AddConstraint(btTypedConstraint* constraint, bool collision_with_linked_body = true);
+        void RemoveConstraint(btTypedConstraint*& constraint);
+
+        // The world is stepped by a thread of its own, from the end of Tick() until the start of the next one, while the engine renders and runs the game.
+        // Anything that changes the world in the meantime, waits for the steps to finish (main thread only). Bodies that are in the world are only changed
+        // through commands, which are executed at the start of Tick(), with the world idle.
+        void WaitForSimulation();
+        void AddCommand(btCollisionObject* body, std::function<void()>&& command);
+        bool IsExecutingCommands() const { return m_executing_commands; }
+
+        // Other threads (e.g. the one loading the world) stop the simulation before they change the world, and start it again once they are done
+        void Stop();
+        void Start();
 
         // Properties
         Math::Vector3 GetGravity()  const;
         auto& GetSoftWorldInfo()    const { return *m_world_info; }
         auto GetPhysicsDebugDraw()  const { return m_debug_draw; }
+        auto GetShapeCache()        const { return m_shape_cache; }
         bool IsSimulating()         const { return m_simulating; }
+        uint64_t GetStepCount()     const { return m_step_count; }
+        bool IsMultithreaded()      const { return m_constraint_solver_pool != nullptr; }
+
+        // Times stacks of boxes and piles of ragdolls in worlds of their own (nothing is drawn), single threaded and then multithreaded
+        void Benchmark();
 
     private:
+        void Simulate(uint32_t steps);
+        void Step(uint32_t steps);
+        void ThreadLoop();
+        void CommandsExecute();
+        void TransformsSync();
+
         btBroadphaseInterface* m_broadphase                         = nullptr;
         btCollisionDispatcher* m_collision_dispatcher               = nullptr;
-        btSequentialImpulseConstraintSolver* m_constraint_solver    = nullptr;
+        btConstraintSolver* m_constraint_solver                     = nullptr;
+        btConstraintSolverPoolMt* m_constraint_solver_pool          = nullptr;
+        PhysicsTaskScheduler* m_task_scheduler                      = nullptr;
         btDefaultCollisionConfiguration* m_collision_configuration  = nullptr;
         btDiscreteDynamicsWorld* m_world                            = nullptr;
         btSoftBodyWorldInfo* m_world_info                           = nullptr;
         PhysicsDebugDraw* m_debug_draw                              = nullptr;
+        ShapeCache* m_shape_cache                                   = nullptr;
+
+        // Physics thread (m_simulating is only written by the main thread, or by a thread which stopped the simulation)
+        std::thread m_thread;
+        std::thread::id m_thread_id_main;
+        std::mutex m_mutex;
+        std::mutex m_mutex_tick;
+        std::condition_variable m_condition;
+        std::atomic<bool> m_simulating      = { false };
+        uint32_t m_steps_pending            = 0;
+        bool m_stopping                     = false;
+        bool m_is_allowed_to_simulate       = true;
+        uint64_t m_step_count               = 0;
+        float m_time_accumulated            = 0.0f;
+        float m_interpolation               = 1.0f;
+        std::vector<TransformWrite> m_transform_writes;
+
+        // Commands for the bodies, which were added while the world was being stepped
+        struct Command
+        {
+            btCollisionObject* body = nullptr;
+            std::function<void()> function;
+        };
+        std::vector<Command> m_commands;
+        std::mutex m_mutex_commands;
+        std::atomic<bool> m_executing_commands = { false };
 
         // Misc
         Renderer* m_renderer = nullptr;
         Profiler* m_profiler = nullptr;
 
         //= PROPERTIES =================================================
-        int m_max_sub_steps         = 1;
+        int m_max_sub_steps         = 4;
         int m_max_solve_iterations  = 256;
         float m_internal_fps        = 60.0f;
         Math::Vector3 m_gravity     = Math::Vector3(0.0f, -9.81f, 0.0f);
-        bool m_simulating           = false;
         //==============================================================
     };
 }
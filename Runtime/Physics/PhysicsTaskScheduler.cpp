@@ -0,0 +1,92 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "PhysicsTaskScheduler.h"
+#include "../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    PhysicsTaskScheduler::PhysicsTaskScheduler(Threading* threading) : btITaskScheduler("Spartan")
+    {
+        m_threading     = threading;
+        m_thread_count  = getMaxNumThreads();
+    }
+
+    int PhysicsTaskScheduler::getMaxNumThreads() const
+    {
+        // Bullet keeps per thread data for a fixed number of threads, the calling thread included
+        return min(static_cast<int>(m_threading->GetThreadCount()) + 1, static_cast<int>(BT_MAX_THREAD_COUNT));
+    }
+
+    void PhysicsTaskScheduler::setNumThreads(const int thread_count)
+    {
+        m_thread_count = max(1, min(thread_count, getMaxNumThreads()));
+    }
+
+    void PhysicsTaskScheduler::parallelFor(const int begin, const int end, const int grain_size, const btIParallelForBody& body)
+    {
+        const int grain = max(grain_size, 1);
+        if (m_thread_count == 1 || end - begin <= grain)
+        {
+            body.forLoop(begin, end);
+            return;
+        }
+
+        // A task per grain, which the threads (and this one) pick up as they become free
+        const uint32_t task_count = static_cast<uint32_t>((end - begin + grain - 1) / grain);
+        m_threading->ParallelFor(task_count, [&body, begin, end, grain](const uint32_t i)
+        {
+            const int task_begin = begin + static_cast<int>(i) * grain;
+            body.forLoop(task_begin, min(task_begin + grain, end));
+        });
+    }
+
+    btScalar PhysicsTaskScheduler::parallelSum(const int begin, const int end, const int grain_size, const btIParallelSumBody& body)
+    {
+        const int grain = max(grain_size, 1);
+        if (m_thread_count == 1 || end - begin <= grain)
+            return body.sumLoop(begin, end);
+
+        // The sums are added in order, so the result doesn't depend on which thread did what
+        const uint32_t task_count = static_cast<uint32_t>((end - begin + grain - 1) / grain);
+        vector<btScalar> sums(task_count, btScalar(0));
+        m_threading->ParallelFor(task_count, [&body, &sums, begin, end, grain](const uint32_t i)
+        {
+            const int task_begin = begin + static_cast<int>(i) * grain;
+            sums[i] = body.sumLoop(task_begin, min(task_begin + grain, end));
+        });
+
+        btScalar sum = btScalar(0);
+        for (const btScalar value : sums)
+        {
+            sum += value;
+        }
+        return sum;
+    }
+}
@@ -0,0 +1,56 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==========================
+// Hide warnings which belong to Bullet
+#pragma warning(push, 0)   
+#include <LinearMath/btThreads.h>
+#pragma warning(pop)
+//=====================================
+
+namespace Spartan
+{
+    class Threading;
+
+    // Runs the parallel loops of Bullet's multithreaded classes (see btParallelFor()) on the threads of the engine, instead of a pool of its own.
+    // The calling thread takes part in every loop, so a loop can't stall waiting for threads that are busy with other tasks.
+    class PhysicsTaskScheduler : public btITaskScheduler
+    {
+    public:
+        PhysicsTaskScheduler(Threading* threading);
+        ~PhysicsTaskScheduler() = default;
+
+        //= btITaskScheduler ================================================================================
+        int getMaxNumThreads() const override;
+        int getNumThreads() const override { return m_thread_count; }
+        void setNumThreads(int thread_count) override;
+        void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) override;
+        btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) override;
+        //===================================================================================================
+
+    private:
+        Threading* m_threading  = nullptr;
+        int m_thread_count      = 1;
+    };
+}
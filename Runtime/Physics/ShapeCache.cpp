@@ -0,0 +1,308 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==============================
+#include "Spartan.h"
+#include "ShapeCache.h"
+#include "BulletPhysicsHelper.h"
+#include "../IO/FileStream.h"
+#include "../IO/FileMapping.h"
+#include "../Rendering/Model.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../Resource/ResourceCache.h"
+#include "../World/Components/Renderable.h"
+#include "../Utilities/Hash.h"
+//=========================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    // Cooked bvhs of concave meshes, which are only valid for the exact triangles they were built from
+    static const uint32_t collision_file_magic      = 0x4C435053; // "SPCL"
+    static const uint32_t collision_file_version    = 1;
+    static const char* collision_file_extension     = ".collision";
+
+    // The triangles of a geometry and the unscaled bvh shape over them, the triangles are referenced by the shape so they live as long as it does
+    struct ShapeCache::ConcaveMesh
+    {
+        ~ConcaveMesh()
+        {
+            delete shape;
+            delete mesh;
+
+            // A bvh that was loaded from a file lives in its buffer, it's not owned by the shape
+            btAlignedFree(bvh_buffer);
+        }
+
+        vector<float> positions;
+        vector<uint32_t> indices;
+        btTriangleIndexVertexArray* mesh    = nullptr;
+        btBvhTriangleMeshShape* shape       = nullptr;
+        void* bvh_buffer                    = nullptr;
+    };
+
+    static void geometry_get(const Renderable* renderable, vector<float>& positions, vector<uint32_t>& indices)
+    {
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        renderable->GeometryGet(&indices, &vertices);
+
+        positions.resize(vertices.size() * 3);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            positions[i * 3 + 0] = vertices[i].pos[0];
+            positions[i * 3 + 1] = vertices[i].pos[1];
+            positions[i * 3 + 2] = vertices[i].pos[2];
+        }
+    }
+
+    static uint64_t geometry_hash(const vector<float>& positions, const vector<uint32_t>& indices)
+    {
+        uint64_t hash           = Utility::Hash::hash_fnv1a(reinterpret_cast<const std::byte*>(positions.data()), positions.size() * sizeof(float));
+        const uint64_t hash_b   = Utility::Hash::hash_fnv1a(reinterpret_cast<const std::byte*>(indices.data()), indices.size() * sizeof(uint32_t));
+        hash ^= hash_b + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    ShapeCache::ShapeCache(Context* context)
+    {
+        m_context = context;
+    }
+
+    ShapeCache::~ShapeCache()
+    {
+        // Colliders give their shapes back when they are removed, which is before the physics go away
+        for (auto& it : m_shapes)
+        {
+            if (!it.second.concave || it.second.shape != it.second.concave->shape)
+            {
+                delete it.second.shape;
+            }
+        }
+        m_shapes.clear();
+        m_shape_keys.clear();
+        m_concave_meshes.clear();
+    }
+
+    btCollisionShape* ShapeCache::Acquire(const Renderable* renderable, const MeshShape type, const Vector3& scale)
+    {
+        if (!renderable || renderable->GeometryVertexCount() == 0)
+            return nullptr;
+
+        const GeometryKey geometry_key  = make_tuple(renderable->GeometryModel(), renderable->GeometryIndexOffset(), renderable->GeometryIndexCount(), renderable->GeometryVertexOffset(), renderable->GeometryVertexCount());
+        const ShapeKey key              = make_tuple(geometry_key, type, scale.x, scale.y, scale.z);
+
+        // Another instance of the same mesh
+        auto it = m_shapes.find(key);
+        if (it != m_shapes.end())
+        {
+            it->second.ref_count++;
+            return it->second.shape;
+        }
+
+        Entry entry;
+        entry.ref_count = 1;
+
+        if (type == MeshShape::Concave)
+        {
+            entry.concave = ConcaveMeshAcquire(renderable, geometry_key);
+            if (!entry.concave)
+                return nullptr;
+
+            // The bvh is built for the unscaled triangles, a scale wraps it instead of building another one
+            if (scale == Vector3::One)
+            {
+                entry.shape = entry.concave->shape;
+            }
+            else
+            {
+                entry.shape = new btScaledBvhTriangleMeshShape(entry.concave->shape, ToBtVector3(scale));
+            }
+        }
+        else
+        {
+            vector<float> positions;
+            vector<uint32_t> indices;
+            geometry_get(renderable, positions, indices);
+            if (positions.empty())
+                return nullptr;
+
+            // The hull copies the points
+            btConvexHullShape* hull = new btConvexHullShape(positions.data(), static_cast<int>(positions.size() / 3), static_cast<int>(sizeof(float) * 3));
+
+            if (type == MeshShape::HullSimplified)
+            {
+                // Keeps the vertices that are the furthest along a set of directions, a few dozen at most no matter how dense the mesh is
+                btShapeHull shape_hull(hull);
+                shape_hull.buildHull(hull->getMargin());
+                btConvexHullShape* hull_simplified = new btConvexHullShape(reinterpret_cast<const btScalar*>(shape_hull.getVertexPointer()), shape_hull.numVertices(), static_cast<int>(sizeof(btVector3)));
+                delete hull;
+                hull = hull_simplified;
+            }
+
+            // Scaling has to be done before the polyhedral features are computed
+            hull->setLocalScaling(ToBtVector3(scale));
+
+            if (type == MeshShape::HullSimplified)
+            {
+                hull->initializePolyhedralFeatures();
+            }
+
+            entry.shape = hull;
+        }
+
+        m_shape_keys[entry.shape] = key;
+        return m_shapes.emplace(key, move(entry)).first->second.shape;
+    }
+
+    void ShapeCache::Release(btCollisionShape* shape)
+    {
+        auto it_key = m_shape_keys.find(shape);
+        if (it_key == m_shape_keys.end())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        auto it = m_shapes.find(it_key->second);
+        if (--it->second.ref_count != 0)
+            return;
+
+        // The concave mesh goes with the last scale of it
+        Entry& entry = it->second;
+        if (!entry.concave || entry.shape != entry.concave->shape)
+        {
+            delete entry.shape;
+        }
+
+        const GeometryKey geometry_key = get<0>(it_key->second);
+        m_shapes.erase(it);
+        m_shape_keys.erase(it_key);
+
+        auto it_concave = m_concave_meshes.find(geometry_key);
+        if (it_concave != m_concave_meshes.end() && it_concave->second.expired())
+        {
+            m_concave_meshes.erase(it_concave);
+        }
+    }
+
+    shared_ptr<ShapeCache::ConcaveMesh> ShapeCache::ConcaveMeshAcquire(const Renderable* renderable, const GeometryKey& key)
+    {
+        auto it = m_concave_meshes.find(key);
+        if (it != m_concave_meshes.end())
+        {
+            if (shared_ptr<ConcaveMesh> concave = it->second.lock())
+                return concave;
+        }
+
+        shared_ptr<ConcaveMesh> concave = make_shared<ConcaveMesh>();
+        geometry_get(renderable, concave->positions, concave->indices);
+        if (concave->positions.empty() || concave->indices.size() < 3)
+            return nullptr;
+
+        concave->mesh = new btTriangleIndexVertexArray(
+            static_cast<int>(concave->indices.size() / 3),
+            reinterpret_cast<int*>(concave->indices.data()),
+            static_cast<int>(sizeof(uint32_t) * 3),
+            static_cast<int>(concave->positions.size() / 3),
+            concave->positions.data(),
+            static_cast<int>(sizeof(float) * 3)
+        );
+
+        // The cooked bvh is named after the model and the geometry in it, and keyed by the triangles
+        const uint64_t hash = geometry_hash(concave->positions, concave->indices);
+        string file_path;
+        if (const Model* model = renderable->GeometryModel())
+        {
+            if (!model->GetResourceFilePathNative().empty())
+            {
+                file_path =
+                    m_context->GetSubsystem<ResourceCache>()->GetProjectDirectory() +
+                    FileSystem::GetFileNameNoExtensionFromFilePath(model->GetResourceFilePathNative()) + "_" +
+                    to_string(renderable->GeometryVertexOffset()) + "_" + to_string(renderable->GeometryIndexOffset()) +
+                    collision_file_extension;
+            }
+        }
+
+        // Load the bvh, it's used in place so it stays in its (aligned) buffer
+        if (!file_path.empty())
+        {
+            FileMapping file(file_path);
+            if (file.IsOpen() && file.ReadAs<uint32_t>() == collision_file_magic && file.ReadAs<uint32_t>() == collision_file_version && file.ReadAs<uint64_t>() == hash)
+            {
+                uint32_t size = 0;
+                const std::byte* data = file.ReadArray(1, &size);
+                if (!file.HasError() && size != 0)
+                {
+                    concave->bvh_buffer = btAlignedAlloc(size, 16);
+                    memcpy(concave->bvh_buffer, data, size);
+                    if (btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(concave->bvh_buffer, size, false))
+                    {
+                        concave->shape = new btBvhTriangleMeshShape(concave->mesh, true, false);
+                        concave->shape->setOptimizedBvh(bvh);
+                    }
+                    else
+                    {
+                        btAlignedFree(concave->bvh_buffer);
+                        concave->bvh_buffer = nullptr;
+                    }
+                }
+            }
+        }
+
+        // Cook it
+        if (!concave->shape)
+        {
+            concave->shape = new btBvhTriangleMeshShape(concave->mesh, true, true);
+
+            if (!file_path.empty())
+            {
+                const btOptimizedBvh* bvh   = concave->shape->getOptimizedBvh();
+                const uint32_t size         = bvh->calculateSerializeBufferSize();
+                void* buffer                = btAlignedAlloc(size, 16);
+                if (bvh->serializeInPlace(buffer, size, false))
+                {
+                    // If saving fails, the next load simply cooks it again
+                    FileStream file(file_path, FileStream_Write);
+                    if (file.IsOpen())
+                    {
+                        file.Write(collision_file_magic);
+                        file.Write(collision_file_version);
+                        file.Write(hash);
+                        file.Write(vector<std::byte>(static_cast<const std::byte*>(buffer), static_cast<const std::byte*>(buffer) + size));
+                    }
+                    else
+                    {
+                        LOG_WARNING("Failed to save \"%s\"", file_path.c_str());
+                    }
+                }
+                btAlignedFree(buffer);
+            }
+        }
+
+        m_concave_meshes[key] = concave;
+        return concave;
+    }
+}
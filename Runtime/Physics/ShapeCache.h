@@ -0,0 +1,81 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ===============
+#include <map>
+#include <tuple>
+#include <memory>
+#include <unordered_map>
+#include "../Math/Vector3.h"
+//==========================
+
+class btCollisionShape;
+
+namespace Spartan
+{
+    class Context;
+    class Model;
+    class Renderable;
+
+    enum class MeshShape
+    {
+        Hull,           // a convex hull of all the vertices
+        HullSimplified, // a convex hull reduced with btShapeHull, with polyhedral features for better contacts
+        Concave         // the triangles themselves in a bvh, which is cooked once and saved, for static bodies only
+    };
+
+    // Mesh collision shapes, shared by every collider with the same geometry, shape and scale. A concave shape is also shared
+    // by every scale of its geometry, since a scale only wraps it (see btScaledBvhTriangleMeshShape).
+    class ShapeCache
+    {
+    public:
+        ShapeCache(Context* context);
+        ~ShapeCache();
+
+        // Returns nullptr if the renderable has no geometry, a shape has to be given back with Release()
+        btCollisionShape* Acquire(const Renderable* renderable, MeshShape type, const Math::Vector3& scale);
+        void Release(btCollisionShape* shape);
+
+        uint32_t GetShapeCount() const { return static_cast<uint32_t>(m_shapes.size()); }
+
+    private:
+        struct ConcaveMesh;
+        using GeometryKey   = std::tuple<const Model*, uint32_t, uint32_t, uint32_t, uint32_t>;
+        using ShapeKey      = std::tuple<GeometryKey, MeshShape, float, float, float>;
+
+        struct Entry
+        {
+            btCollisionShape* shape = nullptr;
+            std::shared_ptr<ConcaveMesh> concave;
+            uint32_t ref_count      = 0;
+        };
+
+        std::shared_ptr<ConcaveMesh> ConcaveMeshAcquire(const Renderable* renderable, const GeometryKey& key);
+
+        std::map<ShapeKey, Entry> m_shapes;
+        std::unordered_map<btCollisionShape*, ShapeKey> m_shape_keys;
+        std::map<GeometryKey, std::weak_ptr<ConcaveMesh>> m_concave_meshes;
+        Context* m_context = nullptr;
+    };
+}
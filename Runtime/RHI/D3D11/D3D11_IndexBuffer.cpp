@@ -105,4 +105,33 @@ namespace Spartan
         m_rhi_device->GetContextRhi()->device_context->Unmap(static_cast<ID3D11Resource*>(m_buffer), 0);
         return true;
     }
+
+    bool RHI_IndexBuffer::Update(const void* data, const uint64_t offset, const uint64_t size)
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device_context || !m_buffer)
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return false;
+        }
+
+        if (!data || offset + size > m_size_gpu)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // No overwrite, the rest of the buffer keeps its contents and can still be in use by the gpu
+        D3D11_MAPPED_SUBRESOURCE mapped_resource;
+        const auto result = m_rhi_device->GetContextRhi()->device_context->Map(static_cast<ID3D11Resource*>(m_buffer), 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped_resource);
+        if (FAILED(result))
+        {
+            LOG_ERROR("Failed to map index buffer");
+            return false;
+        }
+
+        memcpy(static_cast<byte*>(mapped_resource.pData) + offset, data, size);
+
+        m_rhi_device->GetContextRhi()->device_context->Unmap(static_cast<ID3D11Resource*>(m_buffer), 0);
+        return true;
+    }
 }
@@ -88,6 +88,23 @@ namespace Spartan
         return d3d11_format[format];
     }
 
+    // Line width in bytes, for block compressed formats a line is a row of 4x4 blocks
+    inline UINT GetRowPitch(const DXGI_FORMAT format, const uint32_t width, const uint32_t channels, const uint32_t bits_per_channel)
+    {
+        switch (format)
+        {
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC4_UNORM:
+                return ((max(width, 1u) + 3) / 4) * 8;
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC5_UNORM:
+            case DXGI_FORMAT_BC7_UNORM:
+                return ((max(width, 1u) + 3) / 4) * 16;
+            default:
+                return width * channels * (bits_per_channel / 8);
+        }
+    }
+
     // TEXTURE 2D
 
     inline bool CreateTexture2d(
@@ -98,13 +115,16 @@ namespace Spartan
         const uint32_t bits_per_channel,
         const uint32_t array_size,
         const uint8_t mip_count,
+        const uint8_t mip_resident,
         const DXGI_FORMAT format,
         const UINT bind_flags,
         vector<vector<std::byte>>& data,
+        const vector<std::byte>& data_blank,
         const shared_ptr<RHI_Device>& rhi_device
     )
     {
-        const bool has_initial_data = data.size() == mip_count;
+        // A streamed texture only has the data of the mips from mip_resident down, the ones above it are uploaded later so it can't be immutable
+        const bool has_initial_data = !data.empty() && mip_resident + data.size() == mip_count;
 
         // Describe
         D3D11_TEXTURE2D_DESC texture_desc   = {};
@@ -115,7 +135,7 @@ namespace Spartan
         texture_desc.Format                 = format;
         texture_desc.SampleDesc.Count       = 1;
         texture_desc.SampleDesc.Quality     = 0;
-        texture_desc.Usage                  = has_initial_data ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DEFAULT;
+        texture_desc.Usage                  = has_initial_data && mip_resident == 0 ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DEFAULT;
         texture_desc.BindFlags              = bind_flags;
         texture_desc.MiscFlags              = 0;
         texture_desc.CPUAccessFlags         = 0;
@@ -127,9 +147,9 @@ namespace Spartan
             for (uint8_t i = 0; i < mip_count; i++)
             {
                 D3D11_SUBRESOURCE_DATA& subresource_data    = vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
-                subresource_data.pSysMem                    = i < data.size()? data[i].data() : nullptr;        // Data pointer
-                subresource_data.SysMemPitch                = (width >> i) * channels * (bits_per_channel / 8); // Line width in bytes
-                subresource_data.SysMemSlicePitch           = 0;                                                // This is only used for 3D textures
+                subresource_data.pSysMem                    = i < mip_resident ? data_blank.data() : data[i - mip_resident].data(); // Data pointer
+                subresource_data.SysMemPitch                = GetRowPitch(format, width >> i, channels, bits_per_channel);  // Line width in bytes
+                subresource_data.SysMemSlicePitch           = 0;                                                            // This is only used for 3D textures
             }
         }
 
@@ -188,15 +208,15 @@ namespace Spartan
         return true;
     }
 
-    inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, vector<vector<std::byte>>& data, const shared_ptr<RHI_Device>& rhi_device)
+    inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, uint8_t mip_index, uint8_t mip_count, const shared_ptr<RHI_Device>& rhi_device)
     {
         // Describe
         D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc   = {};
         shader_resource_view_desc.Format                            = format;
         shader_resource_view_desc.ViewDimension                     = (array_size == 1) ? D3D11_SRV_DIMENSION_TEXTURE2D : D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
         shader_resource_view_desc.Texture2DArray.FirstArraySlice    = 0;
-        shader_resource_view_desc.Texture2DArray.MostDetailedMip    = 0;
-        shader_resource_view_desc.Texture2DArray.MipLevels          = data.empty() ? 1 : static_cast<UINT>(data.size());
+        shader_resource_view_desc.Texture2DArray.MostDetailedMip    = static_cast<UINT>(mip_index);
+        shader_resource_view_desc.Texture2DArray.MipLevels          = static_cast<UINT>(mip_count);
         shader_resource_view_desc.Texture2DArray.ArraySize          = array_size;
 
         // Create
@@ -217,6 +237,14 @@ namespace Spartan
     }
 
     RHI_Texture2D::~RHI_Texture2D()
+    {
+        // Stop streaming first, so that the streamer doesn't touch the texture while it's being destroyed
+        StreamStop();
+
+        DestroyResourceGpu();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu()
     {
         d3d11_utility::release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource_view[0]));
         d3d11_utility::release(*reinterpret_cast<ID3D11UnorderedAccessView**>(&m_resource_view_unorderedAccess));
@@ -262,6 +290,13 @@ namespace Spartan
         const DXGI_FORMAT format_dsv    = GetDepthFormatDsv(m_format);
         const DXGI_FORMAT format_srv    = GetDepthFormatSrv(m_format);
 
+        // The mips above the resident one (streaming) start out blank, they aren't sampled until they are uploaded
+        vector<std::byte> data_blank;
+        if (HasData() && GetMipResident() != 0)
+        {
+            data_blank.resize(rhi_format_mip_size(m_format, m_width, m_height, GetBytesPerPixel()));
+        }
+
         // TEXTURE
         result_tex = CreateTexture2d
         (
@@ -272,9 +307,11 @@ namespace Spartan
             m_bits_per_channel,
             m_array_size,
             m_mip_count,
+            GetMipResident(),
             format,
             flags,
             m_data,
+            data_blank,
             m_rhi_device
         );
 
@@ -286,7 +323,8 @@ namespace Spartan
                 m_resource_view[0],
                 format_srv,
                 m_array_size,
-                m_data,
+                GetMipResident(),
+                HasData() ? GetMipCountResident() : 1,
                 m_rhi_device
             );
         }
@@ -342,6 +380,35 @@ namespace Spartan
         return result_tex && result_srv && result_uav && result_rt && result_ds;
     }
 
+    bool RHI_Texture2D::UpdateResourceGpu()
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device_context || !m_resource_view[0])
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // The view holds the only reference to the texture
+        ID3D11Resource* resource = nullptr;
+        static_cast<ID3D11ShaderResourceView*>(m_resource_view[0])->GetResource(&resource);
+
+        // Upload the new mips, they go right above the resident one
+        const DXGI_FORMAT format = GetDepthFormat(m_format);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_data.size()); i++)
+        {
+            const uint32_t mip_index = GetMipResident() + i;
+            const UINT row_pitch     = GetRowPitch(format, m_width >> mip_index, m_channel_count, m_bits_per_channel);
+            m_rhi_device->GetContextRhi()->device_context->UpdateSubresource(resource, D3D11CalcSubresource(mip_index, 0, m_mip_count), nullptr, m_data[i].data(), row_pitch, 0);
+        }
+
+        // Point the view at the resident mips, the context keeps the old one alive for as long as it's bound
+        d3d11_utility::release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource_view[0]));
+        const bool result = CreateShaderResourceView2d(resource, m_resource_view[0], GetDepthFormatSrv(m_format), m_array_size, GetMipResident(), GetMipCountResident(), m_rhi_device);
+        resource->Release();
+
+        return result;
+    }
+
     // TEXTURE CUBE
 
     inline bool CreateTextureCube(
@@ -399,8 +466,8 @@ namespace Spartan
                     // D3D11_SUBRESOURCE_DATA
                     auto & subresource_data             = vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
                     subresource_data.pSysMem            = mip_data.data();                                          // Data pointer
-                    subresource_data.SysMemPitch        = (width >> mip_level) * channels * (bits_per_channel / 8); // Line width in bytes
-                    subresource_data.SysMemSlicePitch   = 0;                                                        // This is only used for 3D textures
+                    subresource_data.SysMemPitch        = GetRowPitch(format, width >> mip_level, channels, bits_per_channel);  // Line width in bytes
+                    subresource_data.SysMemSlicePitch   = 0;                                                                    // This is only used for 3D textures
                 }
 
                 vec_texture_desc.emplace_back(texture_desc);
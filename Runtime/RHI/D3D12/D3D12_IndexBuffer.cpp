@@ -51,4 +51,9 @@ namespace Spartan
 	{
 		return true;
 	}
+
+	bool RHI_IndexBuffer::Update(const void* data, const uint64_t offset, const uint64_t size)
+	{
+		return true;
+	}
 }
@@ -49,6 +49,11 @@ namespace Spartan
         return true;
 	}
 
+	bool RHI_Texture2D::UpdateResourceGpu()
+	{
+        return true;
+	}
+
 	// TEXTURE CUBE
 
     RHI_TextureCube::~RHI_TextureCube()
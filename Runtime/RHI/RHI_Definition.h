@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===============
 #include <cstdint>
+#include <algorithm>
 #include "../Math/Vector4.h"
 //==========================
 
@@ -59,6 +60,7 @@ namespace Spartan
     struct RHI_Vertex_PosCol;
     struct RHI_Vertex_PosUvCol;
     struct RHI_Vertex_PosTexNorTan;
+    struct RHI_Vertex_PosTexNorTanPacked;
 
     enum RHI_PhysicalDevice_Type
     {
@@ -199,7 +201,25 @@ namespace Spartan
         RHI_Format_D32_Float,
         RHI_Format_D32_Float_S8X24_Uint,
 
-        RHI_Format_Undefined
+        RHI_Format_Undefined,
+
+        // Appended formats (after RHI_Format_Undefined, so that the values which older files hold don't change)
+        RHI_Format_R16G16B16A16_Unorm,
+        RHI_Format_BC1_Unorm,
+        RHI_Format_BC3_Unorm,
+        RHI_Format_BC4_Unorm,
+        RHI_Format_BC5_Unorm,
+        RHI_Format_BC7_Unorm,
+        RHI_Format_R9G9B9E5_Float
+    };
+
+    // What a texture holds, determines which block compressed format it gets (see BlockCompression::select_format())
+    enum class RHI_Texture_Content : uint8_t
+    {
+        Unknown,
+        Color,      // albedo, emission, mask
+        Normal,     // tangent space normals (or height, when the image is grayscale)
+        Channel     // a single value, like roughness, metalness or occlusion
     };
 
     enum RHI_Blend
@@ -278,12 +298,50 @@ namespace Spartan
             case RHI_Format_R32G32B32A32_Float:     return "RHI_Format_R32G32B32A32_Float";
             case RHI_Format_D32_Float:              return "RHI_Format_D32_Float";
             case RHI_Format_D32_Float_S8X24_Uint:   return "RHI_Format_D32_Float_S8X24_Uint";
+            case RHI_Format_R16G16B16A16_Unorm:     return "RHI_Format_R16G16B16A16_Unorm";
+            case RHI_Format_BC1_Unorm:              return "RHI_Format_BC1_Unorm";
+            case RHI_Format_BC3_Unorm:              return "RHI_Format_BC3_Unorm";
+            case RHI_Format_BC4_Unorm:              return "RHI_Format_BC4_Unorm";
+            case RHI_Format_BC5_Unorm:              return "RHI_Format_BC5_Unorm";
+            case RHI_Format_BC7_Unorm:              return "RHI_Format_BC7_Unorm";
+            case RHI_Format_R9G9B9E5_Float:         return "RHI_Format_R9G9B9E5_Float";
             case RHI_Format_Undefined:              return "RHI_Format_Undefined";
         }
 
         return "Unknown format";
     }
 
+    // Block compressed formats store 4x4 blocks of texels, instead of texels
+    inline bool rhi_format_is_block_compressed(const RHI_Format format)
+    {
+        return format >= RHI_Format_BC1_Unorm && format <= RHI_Format_BC7_Unorm;
+    }
+
+    // The size of a 4x4 block in bytes (0 if the format isn't block compressed)
+    inline uint32_t rhi_format_block_size(const RHI_Format format)
+    {
+        if (format == RHI_Format_BC1_Unorm || format == RHI_Format_BC4_Unorm)
+            return 8;
+
+        return rhi_format_is_block_compressed(format) ? 16 : 0;
+    }
+
+    // The size of a row in bytes, for block compressed formats a row is a row of blocks
+    inline uint32_t rhi_format_row_pitch(const RHI_Format format, const uint32_t width, const uint32_t bytes_per_pixel)
+    {
+        if (rhi_format_is_block_compressed(format))
+            return ((std::max(width, 1u) + 3) / 4) * rhi_format_block_size(format);
+
+        return width * bytes_per_pixel;
+    }
+
+    // The size of a mip in bytes
+    inline uint64_t rhi_format_mip_size(const RHI_Format format, const uint32_t width, const uint32_t height, const uint32_t bytes_per_pixel)
+    {
+        const uint32_t rows = rhi_format_is_block_compressed(format) ? (std::max(height, 1u) + 3) / 4 : height;
+        return static_cast<uint64_t>(rhi_format_row_pitch(format, width, bytes_per_pixel)) * rows;
+    }
+
     enum RHI_Shader_Type : uint8_t
     {
         RHI_Shader_Unknown  = 0,
@@ -77,7 +77,16 @@ static const DXGI_FORMAT d3d11_format[] =
     DXGI_FORMAT_D32_FLOAT,
     DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
 
-    DXGI_FORMAT_UNKNOWN
+    DXGI_FORMAT_UNKNOWN,
+
+    // Appended
+    DXGI_FORMAT_R16G16B16A16_UNORM,
+    DXGI_FORMAT_BC1_UNORM,
+    DXGI_FORMAT_BC3_UNORM,
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
+    DXGI_FORMAT_BC7_UNORM,
+    DXGI_FORMAT_R9G9B9E5_SHAREDEXP
 };
 
 static const D3D11_TEXTURE_ADDRESS_MODE d3d11_sampler_address_mode[] =
@@ -208,7 +217,16 @@ static const VkFormat vulkan_format[] =
     VK_FORMAT_D32_SFLOAT,
     VK_FORMAT_D32_SFLOAT_S8_UINT,
 
-    VK_FORMAT_MAX_ENUM
+    VK_FORMAT_MAX_ENUM,
+
+    // APPENDED
+    VK_FORMAT_R16G16B16A16_UNORM,
+    VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+    VK_FORMAT_BC3_UNORM_BLOCK,
+    VK_FORMAT_BC4_UNORM_BLOCK,
+    VK_FORMAT_BC5_UNORM_BLOCK,
+    VK_FORMAT_BC7_UNORM_BLOCK,
+    VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
 };
 
 static const VkSamplerAddressMode vulkan_sampler_address_mode[] =
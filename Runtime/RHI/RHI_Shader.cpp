@@ -184,12 +184,13 @@ namespace Spartan
         return shader_model;
     }
 
-    //= Explicit template instantiation =======================================================================
+    //= Explicit template instantiation =============================================================================
     template void RHI_Shader::CompileAsync<RHI_Vertex_Undefined>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_Pos>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_PosTex>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_PosCol>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_Pos2dTexCol8>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTan>(const RHI_Shader_Type, const std::string&);
-    //=========================================================================================================
+    template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTanPacked>(const RHI_Shader_Type, const std::string&);
+    //===============================================================================================================
 }
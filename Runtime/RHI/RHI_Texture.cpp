@@ -24,7 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Texture.h"
 #include "RHI_Device.h"
 #include "../IO/FileStream.h"
+#include "../IO/FileMapping.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/TextureStreamer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ImageImporter.h"
 //===========================================
@@ -35,6 +37,25 @@ using namespace std;
 
 namespace Spartan
 {
+    // Engine texture files start with these, the files which don't are from before the header was moved in front of the mips
+    static const uint32_t texture_file_magic        = 0x58545053; // "SPTX"
+    static const uint32_t texture_file_version      = 1;
+
+    // The largest mip that a streamed texture loads right away
+    static const uint32_t stream_mip_size_initial   = 128;
+
+    static bool read_mips(FileMapping& file, const vector<uint64_t>& mip_offsets, const uint8_t mip_index, const uint8_t mip_count, vector<vector<std::byte>>* mips)
+    {
+        mips->resize(mip_count);
+        for (uint32_t i = mip_index; i < static_cast<uint32_t>(mip_index + mip_count); i++)
+        {
+            file.SetPosition(mip_offsets[i]);
+            file.Read(&(*mips)[i - mip_index]);
+        }
+
+        return !file.HasError();
+    }
+
     RHI_Texture::RHI_Texture(Context* context) : IResource(context, ResourceType::Texture)
     {
         m_rhi_device = context->GetSubsystem<Renderer>()->GetRhiDevice();
@@ -42,59 +63,32 @@ namespace Spartan
 
     RHI_Texture::~RHI_Texture()
     {
+        StreamStop();
         m_data.clear();
         m_data.shrink_to_fit();
     }
 
     bool RHI_Texture::SaveToFile(const string& file_path)
     {
-        // Check to see if the file already exists (if so, get the byte count)
-        uint32_t byte_count = 0;
+        // If we hold no data, the mips of the existing file are carried over to the new one
+        vector<vector<std::byte>> mips_existing;
+        if (m_data.empty() && FileSystem::Exists(file_path))
         {
-            if (FileSystem::Exists(file_path))
+            RHI_Texture texture(m_context);
+            if (texture.LoadFromFile_NativeFormat(file_path, false))
             {
-                auto file = make_unique<FileStream>(file_path, FileStream_Read);
-                if (file->IsOpen())
-                {
-                    file->Read(&byte_count);
-                }
+                mips_existing = move(texture.m_data);
             }
         }
+        const vector<vector<std::byte>>& mips = m_data.empty() ? mips_existing : m_data;
 
-        auto append = true;
-        auto file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Append);
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
         if (!file->IsOpen())
             return false;
 
-        // If the existing file has a byte count but we 
-        // hold no data, don't overwrite the file's bytes.
-        if (byte_count != 0 && m_data.empty())
-        {
-            file->Skip
-            (
-                sizeof(uint32_t) +    // byte count
-                sizeof(uint32_t) +    // mipmap count
-                byte_count            // bytes
-            );
-        }
-        else
-        {
-            byte_count = GetByteCount();
-
-            // Write byte count
-            file->Write(byte_count);
-            // Write mipmap count
-            file->Write(static_cast<uint32_t>(m_data.size()));
-            // Write bytes
-            for (auto& mip : m_data)
-            {
-                file->Write(mip);
-            }
-
-            // The bytes have been saved, so we can now free some memory
-            m_data.clear();
-            m_data.shrink_to_fit();
-        }
+        // Write the header
+        file->Write(texture_file_magic);
+        file->Write(texture_file_version);
 
         // Write properties
         file->Write(m_bits_per_channel);
@@ -106,6 +100,25 @@ namespace Spartan
         file->Write(GetId());
         file->Write(GetResourceFilePath());
 
+        // Write the mip offsets, they are relative to the end of the table so that a mip can be read without reading the ones before it
+        file->Write(static_cast<uint32_t>(mips.size()));
+        uint64_t mip_offset = 0;
+        for (const vector<std::byte>& mip : mips)
+        {
+            file->Write(mip_offset);
+            mip_offset += sizeof(uint32_t) + mip.size();
+        }
+
+        // Write bytes
+        for (const vector<std::byte>& mip : mips)
+        {
+            file->Write(mip);
+        }
+
+        // The bytes have been saved, so we can now free some memory
+        m_data.clear();
+        m_data.shrink_to_fit();
+
         return true;
     }
 
@@ -118,6 +131,8 @@ namespace Spartan
             return false;
         }
 
+        StreamStop();
+        m_mip_resident = 0;
         m_data.clear();
         m_data.shrink_to_fit();
         m_load_state = LoadState::Started;
@@ -126,7 +141,7 @@ namespace Spartan
         auto texture_data_loaded = false;
         if (FileSystem::IsEngineTextureFile(path)) // engine format (binary)
         {
-            texture_data_loaded = LoadFromFile_NativeFormat(path);
+            texture_data_loaded = LoadFromFile_NativeFormat(path, true);
         }    
         else if (FileSystem::IsSupportedImageFile(path)) // foreign format (most known image formats)
         {
@@ -141,7 +156,7 @@ namespace Spartan
             return false;
         }
 
-        m_mip_count = static_cast<uint32_t>(m_data.size());
+        m_mip_count = static_cast<uint8_t>(m_mip_resident + m_data.size());
 
         // Create GPU resource
         if (!m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() || !CreateResourceGpu())
@@ -157,22 +172,17 @@ namespace Spartan
             m_data.clear();
             m_data.shrink_to_fit();
         }
-        m_load_state = LoadState::Completed;
 
-        // Compute memory usage
+        // The higher mips of a texture that was only partly loaded are left to the streamer
+        if (m_mip_resident != 0)
         {
-            m_size_cpu = 0;
-            m_size_gpu = 0;
-            for (uint8_t mip_index = 0; mip_index < m_mip_count; mip_index++)
-            {
-                const uint32_t mip_width  = m_width >> mip_index;
-                const uint32_t mip_height = m_height >> mip_index;
-
-                m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
-                m_size_gpu += mip_width * mip_height * (m_bits_per_channel / 8);
-            }
+            StreamStart();
         }
 
+        m_load_state = LoadState::Completed;
+
+        ComputeMemoryUsage();
+
         return true;
     }
 
@@ -194,31 +204,24 @@ namespace Spartan
         vector<std::byte> data;
 
         // Use existing data, if it's there
-        if (index < m_data.size())
+        if (index >= m_mip_resident && index - m_mip_resident < m_data.size())
         {
-            data = m_data[index];
+            data = m_data[index - m_mip_resident];
         }
         // Else attempt to load the data
         else
         {
-            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
-            if (file->IsOpen())
+            RHI_Texture texture(m_context);
+            if (texture.LoadFromFile_NativeFormat(GetResourceFilePathNative(), false))
             {
-                auto byte_count = file->ReadAs<uint32_t>();
-                const uint32_t mip_count  = file->ReadAs<uint32_t>();
-
-                if (index < mip_count)
+                if (index < texture.m_data.size())
                 {
-                    for (uint8_t i = 0; i <= index; i++)
-                    {
-                        file->Read(&data);
-                    }
+                    data = move(texture.m_data[index]);
                 }
                 else
                 {
                     LOG_ERROR("Invalid index");
                 }
-                file->Close();
             }
             else
             {
@@ -229,6 +232,49 @@ namespace Spartan
         return data;
     }
 
+    bool RHI_Texture::SetMipResident(const uint8_t mip_index, vector<vector<std::byte>>& mips)
+    {
+        const size_t mip_count_new = mip_index < m_mip_resident ? static_cast<size_t>(m_mip_resident - mip_index) : 0;
+        if (mip_index >= m_mip_count || mip_index == m_mip_resident || mips.size() != mip_count_new)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // The gpu resource has the whole mip chain, so only the new mips are uploaded and the view is moved to the new resident mip
+        const uint8_t mip_resident = m_mip_resident;
+        m_mip_resident = mip_index;
+        m_data.swap(mips);
+        const bool result = UpdateResourceGpu();
+        m_data.clear();
+        m_data.shrink_to_fit();
+
+        if (!result)
+        {
+            m_mip_resident = mip_resident;
+            LOG_ERROR("Failed to update shader resource for \"%s\".", GetResourceFilePathNative().c_str());
+        }
+
+        ComputeMemoryUsage();
+
+        return result;
+    }
+
+    bool RHI_Texture::LoadMips(const string& file_path, const vector<uint64_t>& mip_offsets, const uint8_t mip_index, const uint8_t mip_count, vector<vector<std::byte>>* mips)
+    {
+        if (!mips || mip_count == 0 || static_cast<size_t>(mip_index + mip_count) > mip_offsets.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        FileMapping file(file_path);
+        if (!file.IsOpen())
+            return false;
+
+        return read_mips(file, mip_offsets, mip_index, mip_count, mips);
+    }
+
     bool RHI_Texture::LoadFromFile_ForeignFormat(const string& file_path, const bool generate_mipmaps)
     {
         // Load texture
@@ -242,37 +288,122 @@ namespace Spartan
         return true;
     }
 
-    bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path)
+    bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path, const bool stream)
     {
-        auto file = make_unique<FileStream>(file_path, FileStream_Read);
-        if (!file->IsOpen())
+        FileMapping file(file_path);
+        if (!file.IsOpen())
             return false;
 
         m_data.clear();
         m_data.shrink_to_fit();
+        m_mip_offsets.clear();
+        m_mip_resident = 0;
+
+        auto read_properties = [this, &file]()
+        {
+            file.Read(&m_bits_per_channel);
+            file.Read(&m_width);
+            file.Read(&m_height);
+            file.Read(reinterpret_cast<uint32_t*>(&m_format));
+            file.Read(&m_channel_count);
+            file.Read(&m_flags);
+            SetId(file.ReadAs<uint32_t>());
+            SetResourceFilePath(file.ReadAs<string>());
+        };
+
+        // Files saved before the header was moved to the front start with their byte count, their mips can only be read in order
+        if (file.ReadAs<uint32_t>() != texture_file_magic)
+        {
+            file.SetPosition(0);
 
-        // Read byte and mipmap count
-        auto byte_count = file->ReadAs<uint32_t>();
-        const auto mip_count  = file->ReadAs<uint32_t>();
+            // Read byte and mipmap count
+            file.ReadAs<uint32_t>();
+            m_data.resize(file.ReadAs<uint32_t>());
 
-        // Read bytes
-        m_data.resize(mip_count);
-        for (auto& mip : m_data)
+            // Read bytes
+            for (auto& mip : m_data)
+            {
+                file.Read(&mip);
+            }
+
+            read_properties();
+
+            return !file.HasError();
+        }
+
+        if (file.ReadAs<uint32_t>() != texture_file_version)
         {
-            file->Read(&mip);
+            LOG_ERROR("\"%s\" was saved by an incompatible version of the engine.", file_path.c_str());
+            return false;
         }
 
-        // Read properties
-        file->Read(&m_bits_per_channel);
-        file->Read(&m_width);
-        file->Read(&m_height);
-        file->Read(reinterpret_cast<uint32_t*>(&m_format));
-        file->Read(&m_channel_count);
-        file->Read(&m_flags);
-        SetId(file->ReadAs<uint32_t>());
-        SetResourceFilePath(file->ReadAs<string>());
+        read_properties();
 
-        return true;
+        // Read the mip offsets and make them absolute
+        m_mip_offsets.resize(file.ReadAs<uint32_t>());
+        for (uint64_t& mip_offset : m_mip_offsets)
+        {
+            file.Read(&mip_offset);
+        }
+        const uint64_t mip_offset_base = file.GetPosition();
+        for (uint64_t& mip_offset : m_mip_offsets)
+        {
+            mip_offset += mip_offset_base;
+        }
+
+        if (file.HasError() || m_mip_offsets.empty())
+            return false;
+
+        // A streamed texture starts with its smallest mips only, the streamer loads the rest once it's seen up close
+        if (stream && IsStreamable())
+        {
+            const uint8_t mip_last = static_cast<uint8_t>(m_mip_offsets.size() - 1);
+            while (m_mip_resident < mip_last && std::max(m_width >> m_mip_resident, m_height >> m_mip_resident) > stream_mip_size_initial)
+            {
+                m_mip_resident++;
+            }
+        }
+
+        return read_mips(file, m_mip_offsets, m_mip_resident, static_cast<uint8_t>(m_mip_offsets.size() - m_mip_resident), &m_data);
+    }
+
+    bool RHI_Texture::IsStreamable() const
+    {
+        // Only sampled 2D textures that are loaded from the engine format can stream, they have mips which can be read on their own
+        Renderer* renderer = m_context->GetSubsystem<Renderer>();
+        return
+            renderer->GetOption(Render_TextureStreaming)        &&
+            renderer->GetTextureStreamer()                      &&
+            GetResourceType() == ResourceType::Texture2d        &&
+            IsSampled()                                         &&
+            !IsStorage()                                        &&
+            !IsRenderTarget()                                   &&
+            !IsDepthStencil()                                   &&
+            m_array_size == 1;
+    }
+
+    void RHI_Texture::StreamStart()
+    {
+        shared_ptr<TextureStreamer> texture_streamer = m_context->GetSubsystem<Renderer>()->GetTextureStreamer();
+        if (!texture_streamer || !texture_streamer->Register(this))
+            return;
+
+        m_texture_streamer  = texture_streamer;
+        m_is_streamed       = true;
+    }
+
+    void RHI_Texture::StreamStop()
+    {
+        if (!m_is_streamed)
+            return;
+
+        if (shared_ptr<TextureStreamer> texture_streamer = m_texture_streamer.lock())
+        {
+            texture_streamer->Unregister(this);
+        }
+
+        m_texture_streamer.reset();
+        m_is_streamed = false;
     }
 
     uint32_t RHI_Texture::GetChannelCountFromFormat(const RHI_Format format)
@@ -296,19 +427,30 @@ namespace Spartan
             case RHI_Format_R32G32B32A32_Float:     return 4;
             case RHI_Format_D32_Float:              return 1;
             case RHI_Format_D32_Float_S8X24_Uint:   return 2;
+            case RHI_Format_R16G16B16A16_Unorm:     return 4;
+            case RHI_Format_BC1_Unorm:              return 4;
+            case RHI_Format_BC3_Unorm:              return 4;
+            case RHI_Format_BC4_Unorm:              return 1;
+            case RHI_Format_BC5_Unorm:              return 2;
+            case RHI_Format_BC7_Unorm:              return 4;
+            case RHI_Format_R9G9B9E5_Float:         return 4; // packed into 32 bits, like RHI_Format_R10G10B10A2_Unorm
             default:                                return 0;
         }
     }
 
-    uint32_t RHI_Texture::GetByteCount()
+    void RHI_Texture::ComputeMemoryUsage()
     {
-        uint32_t byte_count = 0;
-
-        for (auto& mip : m_data)
+        m_size_cpu = 0;
+        for (const vector<std::byte>& mip : m_data)
         {
-            byte_count += static_cast<uint32_t>(mip.size());
+            m_size_cpu += mip.size() * sizeof(std::byte);
         }
 
-        return byte_count;
+        // The whole mip chain is allocated, even when only some of it is resident
+        m_size_gpu = 0;
+        for (uint8_t mip_index = 0; mip_index < m_mip_count; mip_index++)
+        {
+            m_size_gpu += rhi_format_mip_size(m_format, m_width >> mip_index, m_height >> mip_index, GetBytesPerPixel());
+        }
     }
 }
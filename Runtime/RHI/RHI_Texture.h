@@ -31,6 +31,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class TextureStreamer;
+
     enum RHI_Texture_Flags : uint16_t
     {
         RHI_Texture_Sampled                    = 1 << 0,
@@ -84,6 +86,10 @@ namespace Spartan
         auto GetFormat() const                                          { return m_format; }
         void SetFormat(const RHI_Format format)                         { m_format = format; }
 
+        // What the texture holds, set before loading so that the importer can pick a block compressed format for it
+        auto GetContent() const                                         { return m_content; }
+        void SetContent(const RHI_Texture_Content content)              { m_content = content; }
+
         // Data
         bool HasData() const                                            { return !m_data.empty(); }
         void SetData(const std::vector<std::vector<std::byte>>& data)   { m_data = data; }
@@ -94,6 +100,18 @@ namespace Spartan
         std::vector<std::byte>& GetMip(const uint8_t mip_index);
         std::vector<std::byte> GetOrLoadMip(const uint8_t mip_index);
 
+        // Streaming (see TextureStreamer), a streamed texture has its whole mip chain allocated on the gpu but only the mips from GetMipResident() down to the smallest one are loaded and sampled
+        bool IsStreamed()                                       const { return m_is_streamed; }
+        uint8_t GetMipResident()                                const { return m_mip_resident; }
+        uint8_t GetMipCountResident()                           const { return m_mip_count - m_mip_resident; }
+        uint32_t GetWidthResident()                             const { return std::max(m_width >> m_mip_resident, 1u); }
+        uint32_t GetHeightResident()                            const { return std::max(m_height >> m_mip_resident, 1u); }
+        const std::vector<uint64_t>& GetMipOffsets()            const { return m_mip_offsets; }
+        // Loading a larger mip takes the mips from mip_index down to the resident one, evicting (a smaller mip) takes none as the mips are just no longer sampled
+        bool SetMipResident(uint8_t mip_index, std::vector<std::vector<std::byte>>& mips);
+        // Reads mip_count mips, from mip_index down, out of a texture file in the engine format (safe to call from any thread)
+        static bool LoadMips(const std::string& file_path, const std::vector<uint64_t>& mip_offsets, uint8_t mip_index, uint8_t mip_count, std::vector<std::vector<std::byte>>* mips);
+
         // Binding type
         bool IsSampled()        const { return m_flags & RHI_Texture_Sampled; }
         bool IsStorage()        const { return m_flags & RHI_Texture_Storage; }
@@ -125,20 +143,26 @@ namespace Spartan
         void* Get_Resource_View_RenderTarget(const uint32_t i = 0)          const { return i < m_resource_view_renderTarget.size() ? m_resource_view_renderTarget[i] : nullptr; }
 
     protected:
-        bool LoadFromFile_NativeFormat(const std::string& file_path);
+        bool LoadFromFile_NativeFormat(const std::string& file_path, bool stream);
         bool LoadFromFile_ForeignFormat(const std::string& file_path, bool generate_mipmaps);
         static uint32_t GetChannelCountFromFormat(RHI_Format format);
         virtual bool CreateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
-
-        uint32_t m_bits_per_channel = 8;
-        uint32_t m_width            = 0;
-        uint32_t m_height           = 0;
-        uint32_t m_channel_count    = 4;
-        uint32_t m_array_size       = 1;
-        uint8_t m_mip_count         = 1;
-        RHI_Format m_format         = RHI_Format_Undefined;
-        RHI_Image_Layout m_layout   = RHI_Image_Layout::Undefined;
-        uint16_t m_flags            = 0;
+        virtual void DestroyResourceGpu() {}
+        // Uploads the mips in m_data into the gpu resource, from the resident mip down, and limits the shader resource view to the resident mips
+        virtual bool UpdateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
+        void StreamStart();
+        void StreamStop();
+
+        uint32_t m_bits_per_channel   = 8;
+        uint32_t m_width              = 0;
+        uint32_t m_height             = 0;
+        uint32_t m_channel_count      = 4;
+        uint32_t m_array_size         = 1;
+        uint8_t m_mip_count           = 1;
+        RHI_Format m_format           = RHI_Format_Undefined;
+        RHI_Texture_Content m_content = RHI_Texture_Content::Unknown;
+        RHI_Image_Layout m_layout     = RHI_Image_Layout::Undefined;
+        uint16_t m_flags              = 0;
         RHI_Viewport m_viewport;
         std::vector<std::vector<std::byte>> m_data;
         std::shared_ptr<RHI_Device> m_rhi_device;
@@ -151,6 +175,14 @@ namespace Spartan
         std::array<void*, rhi_max_render_target_count> m_resource_view_depthStencil           = { nullptr };
         std::array<void*, rhi_max_render_target_count> m_resource_view_depthStencilReadOnly   = { nullptr };
     private:
-        uint32_t GetByteCount();
+        void ComputeMemoryUsage();
+
+        bool IsStreamable() const;
+
+        // Streaming
+        bool m_is_streamed      = false;
+        uint8_t m_mip_resident  = 0;
+        std::vector<uint64_t> m_mip_offsets; // where each mip is in the texture file
+        std::weak_ptr<TextureStreamer> m_texture_streamer;
     };
 }
@@ -95,5 +95,7 @@ namespace Spartan
 
         // RHI_Texture
         bool CreateResourceGpu() override;
+        void DestroyResourceGpu() override;
+        bool UpdateResourceGpu() override;
     };
 }
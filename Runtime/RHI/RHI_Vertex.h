@@ -21,11 +21,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ===============
+//= INCLUDES ==================
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
-//==========================
+#include "../Math/MathHelper.h"
+//=============================
 
 namespace Spartan
 {
@@ -129,11 +130,77 @@ namespace Spartan
         float tan[3] = { 0 };
     };
 
+    // A compressed RHI_Vertex_PosTexNorTan (20 bytes instead of 44), meant for static geometry.
+    // - Position: 16-bit unorm, relative to the bounding box of the mesh (the shader gets the offset and scale to restore it).
+    // - Texture:  16-bit float.
+    // - Normal:   16-bit snorm, octahedral encoded, packed together with the tangent (xy = normal, zw = tangent).
+    struct RHI_Vertex_PosTexNorTanPacked
+    {
+        RHI_Vertex_PosTexNorTanPacked() = default;
+        RHI_Vertex_PosTexNorTanPacked(const RHI_Vertex_PosTexNorTan& vertex, const Math::Vector3& position_offset, const Math::Vector3& position_scale_inverse)
+        {
+            this->pos[0] = QuantizeUnorm((vertex.pos[0] - position_offset.x) * position_scale_inverse.x);
+            this->pos[1] = QuantizeUnorm((vertex.pos[1] - position_offset.y) * position_scale_inverse.y);
+            this->pos[2] = QuantizeUnorm((vertex.pos[2] - position_offset.z) * position_scale_inverse.z);
+            this->pos[3] = 0;
+
+            this->tex[0] = Math::Helper::FloatToHalf(vertex.tex[0]);
+            this->tex[1] = Math::Helper::FloatToHalf(vertex.tex[1]);
+
+            EncodeOctahedral(vertex.nor, &this->nor_tan[0]);
+            EncodeOctahedral(vertex.tan, &this->nor_tan[2]);
+        }
+
+        uint16_t pos[4]     = { 0 };
+        uint16_t tex[2]     = { 0 };
+        int16_t nor_tan[4]  = { 0 };
+
+    private:
+        static uint16_t QuantizeUnorm(const float value)
+        {
+            return static_cast<uint16_t>(Math::Helper::Saturate(value) * 65535.0f + 0.5f);
+        }
+
+        static int16_t QuantizeSnorm(const float value)
+        {
+            return static_cast<int16_t>(Math::Helper::Round(Math::Helper::Clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        // Projects the direction onto an octahedron and unfolds it onto a plane, see octahedral_decode() in Common_Vertex.hlsl
+        static void EncodeOctahedral(const float direction[3], int16_t* encoded)
+        {
+            const float length = Math::Helper::Abs(direction[0]) + Math::Helper::Abs(direction[1]) + Math::Helper::Abs(direction[2]);
+            if (length == 0.0f)
+            {
+                encoded[0] = 0;
+                encoded[1] = 0;
+                return;
+            }
+
+            float x = direction[0] / length;
+            float y = direction[1] / length;
+
+            // Fold the lower hemisphere over the diagonals
+            if (direction[2] < 0.0f)
+            {
+                const float x_folded = (1.0f - Math::Helper::Abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+                const float y_folded = (1.0f - Math::Helper::Abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+                x = x_folded;
+                y = y_folded;
+            }
+
+            encoded[0] = QuantizeSnorm(x);
+            encoded[1] = QuantizeSnorm(y);
+        }
+    };
+
     static_assert(std::is_trivially_copyable<RHI_Vertex_Pos>::value,            "RHI_Vertex_Pos is not trivially copyable");
     static_assert(std::is_trivially_copyable<RHI_Vertex_PosTex>::value,            "RHI_Vertex_PosTex is not trivially copyable");
     static_assert(std::is_trivially_copyable<RHI_Vertex_PosCol>::value,            "RHI_Vertex_PosCol is not trivially copyable");
     static_assert(std::is_trivially_copyable<RHI_Vertex_Pos2dTexCol8>::value,    "RHI_Vertex_Pos2dTexCol8 is not trivially copyable");
     static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTan>::value,    "RHI_Vertex_PosTexNorTan is not trivially copyable");
+    static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTanPacked>::value,    "RHI_Vertex_PosTexNorTanPacked is not trivially copyable");
+    static_assert(sizeof(RHI_Vertex_PosTexNorTanPacked) == 20,                            "RHI_Vertex_PosTexNorTanPacked is expected to be 20 bytes");
 
     enum RHI_Vertex_Type
     {
@@ -142,7 +209,8 @@ namespace Spartan
         RHI_Vertex_Type_PositionColor,
         RHI_Vertex_Type_PositionTexture,
         RHI_Vertex_Type_PositionTextureNormalTangent,
-        RHI_Vertex_Type_Position2dTextureColor8
+        RHI_Vertex_Type_Position2dTextureColor8,
+        RHI_Vertex_Type_PositionTextureNormalTangentPacked
     };
 
     template <typename T>
@@ -153,4 +221,5 @@ namespace Spartan
     template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosCol>()            { return RHI_Vertex_Type_PositionColor; }
     template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_Pos2dTexCol8>()    { return RHI_Vertex_Type_Position2dTextureColor8; }
     template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTan>()    { return RHI_Vertex_Type_PositionTextureNormalTangent; }
+    template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTanPacked>()    { return RHI_Vertex_Type_PositionTextureNormalTangentPacked; }
 }
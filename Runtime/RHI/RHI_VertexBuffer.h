@@ -72,6 +72,9 @@ namespace Spartan
         void* Map();
         bool Unmap();
 
+        // Writes to a range of a dynamic buffer without discarding the rest of it, the range must not be in use by the gpu
+        bool Update(const void* data, uint64_t offset, uint64_t size);
+
         void* GetResource()         const { return m_buffer; }
         uint32_t GetStride()        const { return m_stride; }
         uint32_t GetVertexCount()   const { return m_vertex_count; }
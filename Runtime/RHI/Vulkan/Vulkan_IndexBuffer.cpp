@@ -190,4 +190,33 @@ namespace Spartan
 
         return true;
     }
+
+    bool RHI_IndexBuffer::Update(const void* data, const uint64_t offset, const uint64_t size)
+    {
+        if (!data || offset + size > m_size_gpu)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        void* mapped = Map();
+        if (!mapped)
+            return false;
+
+        memcpy(static_cast<byte*>(mapped) + offset, data, size);
+
+        // Only the written range has to be flushed
+        if (m_persistent_mapping)
+        {
+            if (!vulkan_utility::error::check(vmaFlushAllocation(m_rhi_device->GetContextRhi()->allocator, static_cast<VmaAllocation>(m_allocation), offset, size)))
+            {
+                LOG_ERROR("Failed to flush memory");
+                return false;
+            }
+
+            return true;
+        }
+
+        return Unmap();
+    }
 }
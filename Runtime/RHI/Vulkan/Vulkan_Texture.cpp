@@ -70,7 +70,36 @@ namespace Spartan
         }
     }
 
-    inline bool copy_to_staging_buffer(RHI_Texture* texture, std::vector<VkBufferImageCopy>& buffer_image_copies, void*& staging_buffer)
+    // Views that the gpu might still be using, they are destroyed once the frames that could be using them are done
+    struct RetiredView
+    {
+        void* view      = nullptr;
+        uint64_t frame  = 0;
+    };
+    static vector<RetiredView> views_retired;
+    static mutex views_retired_mutex;
+    static const uint64_t views_retired_frames = 3; // frames that the cpu can be ahead of the gpu (the swap chain buffer count)
+
+    inline void destroy_retired_views(const uint64_t frame, const bool all)
+    {
+        lock_guard<mutex> lock(views_retired_mutex);
+
+        for (auto it = views_retired.begin(); it != views_retired.end();)
+        {
+            if (all || frame >= it->frame + views_retired_frames)
+            {
+                vulkan_utility::image::view::destroy(it->view);
+                it = views_retired.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    // The data of the texture holds the mips from mip_index_first down (mip_levels of them)
+    inline bool copy_to_staging_buffer(RHI_Texture* texture, const uint32_t mip_index_first, const uint32_t mip_levels, std::vector<VkBufferImageCopy>& buffer_image_copies, void*& staging_buffer)
     {
         if (!texture->HasData())
         {
@@ -78,11 +107,11 @@ namespace Spartan
             return true;
         }
 
-        const uint32_t width            = texture->GetWidth();
-        const uint32_t height           = texture->GetHeight();
+        const uint32_t width            = texture->GetWidth() >> mip_index_first;
+        const uint32_t height           = texture->GetHeight() >> mip_index_first;
         const uint32_t array_size       = texture->GetArraySize();
-        const uint32_t mip_levels       = texture->GetMipCount();
         const uint32_t bytes_per_pixel  = texture->GetBytesPerPixel();
+        const RHI_Format format         = texture->GetFormat();
 
         // Fill out VkBufferImageCopy structs describing the array and the mip levels   
         VkDeviceSize buffer_offset = 0;
@@ -98,7 +127,7 @@ namespace Spartan
                 region.bufferRowLength                  = 0;
                 region.bufferImageHeight                = 0;
                 region.imageSubresource.aspectMask      = vulkan_utility::image::get_aspect_mask(texture);
-                region.imageSubresource.mipLevel        = mip_index;
+                region.imageSubresource.mipLevel        = mip_index_first + mip_index;
                 region.imageSubresource.baseArrayLayer  = array_index;
                 region.imageSubresource.layerCount      = array_size;
                 region.imageOffset                      = { 0, 0, 0 };
@@ -107,7 +136,7 @@ namespace Spartan
                 buffer_image_copies[mip_index] = region;
 
                 // Update staging buffer memory requirement (in bytes)
-                buffer_offset += mip_width * mip_height * bytes_per_pixel;
+                buffer_offset += rhi_format_mip_size(format, mip_width, mip_height, bytes_per_pixel);
             }
         }
 
@@ -123,7 +152,7 @@ namespace Spartan
             {
                 for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
                 {
-                    uint64_t buffer_size = (width >> mip_index) * (height >> mip_index) * bytes_per_pixel;
+                    uint64_t buffer_size = rhi_format_mip_size(format, width >> mip_index, height >> mip_index, bytes_per_pixel);
                     memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetMip(array_index + mip_index).data(), buffer_size);
                     buffer_offset += buffer_size;
                 }
@@ -135,12 +164,12 @@ namespace Spartan
         return true;
     }
 
-    inline bool stage(RHI_Texture* texture, RHI_Image_Layout& texture_layout)
+    inline bool stage(RHI_Texture* texture, const uint32_t mip_index_first, const uint32_t mip_levels, RHI_Image_Layout& texture_layout)
     {
         // Copy the texture's data to a staging buffer
         void* staging_buffer = nullptr;
-        std::vector<VkBufferImageCopy> buffer_image_copies(texture->GetMipCount());
-        if (!copy_to_staging_buffer(texture, buffer_image_copies, staging_buffer))
+        std::vector<VkBufferImageCopy> buffer_image_copies(mip_levels);
+        if (!copy_to_staging_buffer(texture, mip_index_first, mip_levels, buffer_image_copies, staging_buffer))
             return false;
 
         // Copy the staging buffer into the image
@@ -197,6 +226,15 @@ namespace Spartan
     }
 
     RHI_Texture2D::~RHI_Texture2D()
+    {
+        // Stop streaming first, so that the streamer doesn't touch the texture while it's being destroyed
+        StreamStop();
+
+        DestroyResourceGpu();
+        m_data.clear();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu()
     {
         if (!m_rhi_device || !m_rhi_device->IsInitialized())
         {
@@ -205,6 +243,7 @@ namespace Spartan
 
         // Wait in case it's still in use by the GPU
         m_rhi_device->Queue_WaitAll();
+        destroy_retired_views(0, true);
         
         // Make sure that no descriptor sets refer to this texture.
         // Right now I just reset the descriptor set layout cache, which works but it's not ideal.
@@ -218,7 +257,6 @@ namespace Spartan
         }
 
         // De-allocate everything
-        m_data.clear();
         vulkan_utility::image::view::destroy(m_resource_view[0]);
         vulkan_utility::image::view::destroy(m_resource_view[1]);
         for (uint32_t i = 0; i < rhi_max_render_target_count; i++)
@@ -227,6 +265,9 @@ namespace Spartan
             vulkan_utility::image::view::destroy(m_resource_view_renderTarget[i]);
         }
         vulkan_utility::image::destroy(this);
+
+        // A new image starts out undefined
+        m_layout = RHI_Image_Layout::Undefined;
     }
 
     void RHI_Texture::SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* command_list /*= nullptr*/)
@@ -262,7 +303,7 @@ namespace Spartan
         // If the texture has any data, stage it
         if (HasData())
         {
-            if (!stage(this, m_layout))
+            if (!stage(this, GetMipResident(), GetMipCountResident(), m_layout))
             {
                 LOG_ERROR("Failed to stage");
                 return false;
@@ -339,6 +380,53 @@ namespace Spartan
         return true;
     }
 
+    bool RHI_Texture2D::UpdateResourceGpu()
+    {
+        if (!m_rhi_device || !m_rhi_device->IsInitialized() || !m_resource)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Upload the new mips, they go right above the resident one
+        if (HasData())
+        {
+            if (!stage(this, GetMipResident(), static_cast<uint32_t>(m_data.size()), m_layout))
+            {
+                LOG_ERROR("Failed to stage");
+                return false;
+            }
+
+            if (VkCommandBuffer cmd_buffer = vulkan_utility::command_buffer_immediate::begin(RHI_Queue_Graphics))
+            {
+                const RHI_Image_Layout target_layout = GetAppropriateLayout(this);
+
+                if (!vulkan_utility::image::set_layout(cmd_buffer, this, target_layout) || !vulkan_utility::command_buffer_immediate::end(RHI_Queue_Graphics))
+                {
+                    LOG_ERROR("Failed to transition layout");
+                    return false;
+                }
+
+                m_layout = target_layout;
+            }
+        }
+
+        // Point the view at the resident mips, the previous one is destroyed once the gpu is done with the frames that might use it
+        const uint64_t frame = m_context->GetSubsystem<Renderer>()->GetFrameNum();
+        destroy_retired_views(frame, false);
+        {
+            lock_guard<mutex> lock(views_retired_mutex);
+            views_retired.push_back({ m_resource_view[0], frame });
+        }
+        m_resource_view[0] = nullptr;
+        if (!vulkan_utility::image::view::create(m_resource, m_resource_view[0], this))
+            return false;
+
+        set_debug_name(this);
+
+        return true;
+    }
+
     // TEXTURE CUBE
 
     RHI_TextureCube::~RHI_TextureCube()
@@ -371,7 +459,7 @@ namespace Spartan
         // If the texture has any data, stage it
         if (HasData())
         {
-            if (!stage(this, m_layout))
+            if (!stage(this, GetMipResident(), GetMipCountResident(), m_layout))
                 return false;
         }
 
@@ -49,13 +49,14 @@ namespace Spartan::vulkan_utility
         // Get format support
         RHI_Format format                   = texture->GetFormat();
         bool is_render_target_depth_stencil = texture->IsDepthStencil();
-        VkFormatFeatureFlags format_flags   = is_render_target_depth_stencil ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+        bool is_render_target_color         = texture->IsRenderTarget();
+        VkFormatFeatureFlags format_flags   = is_render_target_depth_stencil ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT : is_render_target_color ? VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT : VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT; // block compressed formats can only be sampled
         VkImageTiling image_tiling          = get_format_tiling(format, format_flags);
         
         // Ensure the format is supported by the GPU
         if (image_tiling == VK_IMAGE_TILING_MAX_ENUM)
         {
-            LOG_ERROR("GPU does not support the usage of %s as a %s.", rhi_format_to_string(format), is_render_target_depth_stencil ? "depth-stencil attachment" : "color attachment");
+            LOG_ERROR("GPU does not support the usage of %s as a %s.", rhi_format_to_string(format), is_render_target_depth_stencil ? "depth-stencil attachment" : is_render_target_color ? "color attachment" : "sampled image");
             return false;
         }
         
@@ -787,7 +787,7 @@ namespace Spartan::vulkan_utility
 
         namespace view
         {
-            inline bool create(void* image, void*& image_view, VkImageViewType type, const VkFormat format, const VkImageAspectFlags aspect_mask, const uint32_t level_count = 1, const uint32_t layer_index = 0, const uint32_t layer_count = 1)
+            inline bool create(void* image, void*& image_view, VkImageViewType type, const VkFormat format, const VkImageAspectFlags aspect_mask, const uint32_t level_count = 1, const uint32_t layer_index = 0, const uint32_t layer_count = 1, const uint32_t level_index = 0)
             {
                 VkImageViewCreateInfo create_info           = {};
                 create_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -795,7 +795,7 @@ namespace Spartan::vulkan_utility
                 create_info.viewType                        = type;
                 create_info.format                          = format;
                 create_info.subresourceRange.aspectMask     = aspect_mask;
-                create_info.subresourceRange.baseMipLevel   = 0;
+                create_info.subresourceRange.baseMipLevel   = level_index;
                 create_info.subresourceRange.levelCount     = level_count;
                 create_info.subresourceRange.baseArrayLayer = layer_index;
                 create_info.subresourceRange.layerCount     = layer_count;
@@ -821,7 +821,8 @@ namespace Spartan::vulkan_utility
                     type = VK_IMAGE_VIEW_TYPE_CUBE;
                 }
 
-                return create(image, image_view, type, vulkan_format[texture->GetFormat()], get_aspect_mask(texture, only_depth, only_stencil), texture->GetMipCount(), array_index, array_length);
+                // A streamed texture is only viewed from its resident mip down
+                return create(image, image_view, type, vulkan_format[texture->GetFormat()], get_aspect_mask(texture, only_depth, only_stencil), texture->GetMipCountResident(), array_index, array_length, texture->GetMipResident());
             }
 
             inline void destroy(void*& image_view)
@@ -19,29 +19,344 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========
+//= INCLUDES =================
 #include "Spartan.h"
 #include "Animation.h"
-//====================
+#include "../IO/FileStream.h"
+#include "../IO/FileMapping.h"
+//============================
 
-//= NAMESPACES =====
+//= NAMESPACES ================
 using namespace std;
-//==================
+using namespace Spartan::Math;
+//=============================
 
 namespace Spartan
 {
+    // Standalone animation files start with these
+    static const uint32_t animation_file_magic      = 0x4E415053; // "SPAN"
+    static const uint32_t animation_file_version    = 1;
+
+    // How far a reduced curve may be from the imported one, in units (positions and scales) and in quaternion distance (rotations, roughly half the angle in radians)
+    static const float tolerance_position   = 0.0001f;
+    static const float tolerance_rotation   = 0.00005f;
+    static const float tolerance_scale      = 0.0001f;
+
+    // The smallest three components of a unit quaternion are within [-1/sqrt(2), 1/sqrt(2)]
+    static const float quaternion_component_max = 0.70710678f;
+    static const float quaternion_quantization  = 32767.0f;
+
+    static Quaternion quaternion_nlerp(const Quaternion& a, const Quaternion& b, const float t)
+    {
+        // Interpolate along the shortest path, q and -q are the same rotation
+        const float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+        Quaternion q
+        (
+            a.x + (b.x * sign - a.x) * t,
+            a.y + (b.y * sign - a.y) * t,
+            a.z + (b.z * sign - a.z) * t,
+            a.w + (b.w * sign - a.w) * t
+        );
+        q.Normalize();
+
+        return q;
+    }
+
+    static float quaternion_distance(const Quaternion& a, const Quaternion& b)
+    {
+        const float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+        const float x = a.x - b.x * sign;
+        const float y = a.y - b.y * sign;
+        const float z = a.z - b.z * sign;
+        const float w = a.w - b.w * sign;
+
+        return sqrt(x * x + y * y + z * z + w * w);
+    }
+
+    static void quaternion_pack(const Quaternion& rotation, uint16_t* packed)
+    {
+        const Quaternion q = rotation.Normalized();
+        const float components[4] = { q.x, q.y, q.z, q.w };
+
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; i++)
+        {
+            if (abs(components[i]) > abs(components[largest]))
+            {
+                largest = i;
+            }
+        }
+
+        // The largest component is made positive, so that its sign doesn't have to be stored
+        const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+        uint32_t k = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            if (i == largest)
+                continue;
+
+            const float value = Helper::Clamp(components[i] * sign / quaternion_component_max, -1.0f, 1.0f) * 0.5f + 0.5f;
+            packed[k++] = static_cast<uint16_t>(value * quaternion_quantization + 0.5f);
+        }
+
+        // The index of the largest component goes into the top bits of the first two values
+        packed[0] |= static_cast<uint16_t>((largest & 1) << 15);
+        packed[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+    }
+
+    static Quaternion quaternion_unpack(const uint16_t* packed)
+    {
+        const uint32_t largest = (packed[0] >> 15) | ((packed[1] >> 15) << 1);
+
+        float components[4];
+        float sum_squared = 0.0f;
+        uint32_t k = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            if (i == largest)
+                continue;
+
+            const float value   = static_cast<float>(packed[k++] & 0x7FFF) / quaternion_quantization;
+            components[i]       = (value * 2.0f - 1.0f) * quaternion_component_max;
+            sum_squared         += components[i] * components[i];
+        }
+        components[largest] = sqrt(Helper::Max(1.0f - sum_squared, 0.0f));
+
+        return Quaternion(components[0], components[1], components[2], components[3]);
+    }
+
+    // Keeps the first and the last key, and any key in between that the keys around it can't interpolate within the tolerance
+    template <typename Key, typename Value, typename Lerp, typename Distance>
+    static vector<Key> reduce_keys(const vector<Key>& keys, const float tolerance, Value Key::* value, Lerp lerp, Distance distance)
+    {
+        if (keys.size() <= 2)
+        {
+            vector<Key> output = keys;
+            if (output.size() == 2 && distance(output[0].*value, output[1].*value) <= tolerance)
+            {
+                output.pop_back();
+            }
+
+            return output;
+        }
+
+        vector<Key> output;
+        output.emplace_back(keys.front());
+        uint32_t anchor = 0;
+        for (uint32_t i = 1; i + 1 < static_cast<uint32_t>(keys.size()); i++)
+        {
+            // Without key i, the keys after the anchor would be interpolated from the anchor and the key after i
+            const Key& a        = keys[anchor];
+            const Key& b        = keys[i + 1];
+            const float span    = b.time - a.time;
+            bool is_redundant   = span > 0.0f;
+            for (uint32_t j = anchor + 1; j <= i && is_redundant; j++)
+            {
+                const float t = (keys[j].time - a.time) / span;
+                is_redundant = distance(lerp(a.*value, b.*value, t), keys[j].*value) <= tolerance;
+            }
+
+            if (!is_redundant)
+            {
+                output.emplace_back(keys[i]);
+                anchor = i;
+            }
+        }
+        output.emplace_back(keys.back());
+
+        // A curve that doesn't change is a single key
+        if (output.size() == 2 && distance(output[0].*value, output[1].*value) <= tolerance)
+        {
+            output.pop_back();
+        }
+
+        return output;
+    }
+
+    // The index of the last key at or before the time, and how far the time is towards the next key
+    template <typename Key>
+    static uint32_t find_key(const vector<Key>& keys, const float time, float* t)
+    {
+        const auto it = upper_bound(keys.begin(), keys.end(), time, [](const float time, const Key& key) { return time < key.time; });
+        if (it == keys.begin())
+        {
+            *t = 0.0f;
+            return 0;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(it - keys.begin()) - 1;
+        if (index + 1 >= static_cast<uint32_t>(keys.size()))
+        {
+            *t = 0.0f;
+            return index;
+        }
+
+        const float span = keys[index + 1].time - keys[index].time;
+        *t = span > 0.0f ? (time - keys[index].time) / span : 0.0f;
+
+        return index;
+    }
+
+    static Vector3 sample_vector(const vector<KeyVector>& keys, const float time)
+    {
+        float t = 0.0f;
+        const uint32_t index = find_key(keys, time, &t);
+        if (t == 0.0f)
+            return keys[index].value;
+
+        return Helper::Lerp(keys[index].value, keys[index + 1].value, t);
+    }
+
+    static Quaternion sample_quaternion(const vector<KeyQuaternionPacked>& keys, const float time)
+    {
+        float t = 0.0f;
+        const uint32_t index = find_key(keys, time, &t);
+        if (t == 0.0f)
+            return quaternion_unpack(keys[index].value);
+
+        return quaternion_nlerp(quaternion_unpack(keys[index].value), quaternion_unpack(keys[index + 1].value), t);
+    }
+
     Animation::Animation(Context* context): IResource(context, ResourceType::Animation)
     {
 
     }
 
-    bool Animation::LoadFromFile(const string& filePath)
+    bool Animation::LoadFromFile(const string& file_path)
     {
+        FileMapping file(file_path);
+        if (!file.IsOpen())
+            return false;
+
+        if (file.ReadAs<uint32_t>() != animation_file_magic || file.ReadAs<uint32_t>() > animation_file_version)
+        {
+            LOG_ERROR("\"%s\" is not an animation that this version of the engine can read", file_path.c_str());
+            return false;
+        }
+
+        if (!Deserialize(&file))
+        {
+            LOG_ERROR("\"%s\" is truncated", file_path.c_str());
+            return false;
+        }
+
+        m_size_cpu = file.GetSize();
+
         return true;
     }
 
-    bool Animation::SaveToFile(const string& filePath)
+    bool Animation::SaveToFile(const string& file_path)
     {
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
+        if (!file->IsOpen())
+            return false;
+
+        file->Write(animation_file_magic);
+        file->Write(animation_file_version);
+        Serialize(file.get());
+        file->Close();
+
         return true;
     }
+
+    void Animation::Serialize(FileStream* file) const
+    {
+        file->Write(m_name);
+        file->Write(m_duration);
+        file->Write(static_cast<uint32_t>(m_channels.size()));
+        for (const AnimationChannel& channel : m_channels)
+        {
+            file->Write(channel.name);
+            file->Write(channel.bone_index);
+            file->Write(channel.positions);
+            file->Write(channel.rotations);
+            file->Write(channel.scales);
+        }
+    }
+
+    bool Animation::Deserialize(FileMapping* file)
+    {
+        m_name      = file->ReadAs<string>();
+        m_duration  = file->ReadAs<float>();
+        m_channels.resize(file->ReadAs<uint32_t>());
+        for (AnimationChannel& channel : m_channels)
+        {
+            channel.name        = file->ReadAs<string>();
+            channel.bone_index  = file->ReadAs<uint32_t>();
+            file->Read(&channel.positions);
+            file->Read(&channel.rotations);
+            file->Read(&channel.scales);
+
+            if (file->HasError())
+                break;
+        }
+
+        if (file->HasError())
+        {
+            m_channels.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Animation::AddChannel(const string& name, const uint32_t bone_index, const vector<KeyVector>& positions, const vector<KeyQuaternion>& rotations, const vector<KeyVector>& scales)
+    {
+        const auto vector_lerp      = [](const Vector3& a, const Vector3& b, const float t) { return Helper::Lerp(a, b, t); };
+        const auto vector_distance  = [](const Vector3& a, const Vector3& b) { return Vector3::Distance(a, b); };
+
+        AnimationChannel channel;
+        channel.name        = name;
+        channel.bone_index  = bone_index;
+        channel.positions   = reduce_keys(positions, tolerance_position, &KeyVector::value, vector_lerp, vector_distance);
+        channel.scales      = reduce_keys(scales, tolerance_scale, &KeyVector::value, vector_lerp, vector_distance);
+
+        // The rotations are reduced before they are quantized, the quantization error (about 0.00004) is well within the tolerance
+        const vector<KeyQuaternion> rotations_reduced = reduce_keys(rotations, tolerance_rotation, &KeyQuaternion::value, quaternion_nlerp, quaternion_distance);
+        channel.rotations.resize(rotations_reduced.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(rotations_reduced.size()); i++)
+        {
+            channel.rotations[i].time = rotations_reduced[i].time;
+            quaternion_pack(rotations_reduced[i].value, channel.rotations[i].value);
+        }
+
+        m_channels.emplace_back(move(channel));
+    }
+
+    void Animation::Sample(const float time, BoneTransform* pose, const uint32_t bone_count) const
+    {
+        for (const AnimationChannel& channel : m_channels)
+        {
+            if (channel.bone_index >= bone_count)
+                continue;
+
+            BoneTransform& transform = pose[channel.bone_index];
+
+            if (!channel.positions.empty())
+            {
+                transform.position = sample_vector(channel.positions, time);
+            }
+
+            if (!channel.rotations.empty())
+            {
+                transform.rotation = sample_quaternion(channel.rotations, time);
+            }
+
+            if (!channel.scales.empty())
+            {
+                transform.scale = sample_vector(channel.scales, time);
+            }
+        }
+    }
+
+    uint32_t Animation::GetKeyCount() const
+    {
+        uint32_t count = 0;
+        for (const AnimationChannel& channel : m_channels)
+        {
+            count += static_cast<uint32_t>(channel.positions.size() + channel.rotations.size() + channel.scales.size());
+        }
+
+        return count;
+    }
 }
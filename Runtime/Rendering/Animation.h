@@ -28,37 +28,64 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
-    struct AnimationVertexWeight
+    class FileStream;
+    class FileMapping;
+
+    // The most bones that a vertex follows, assimp limits the weights to this many on import
+    static const uint32_t bone_influence_count = 4;
+
+    // The transform of a bone, relative to its parent
+    struct BoneTransform
     {
-        uint32_t vertexID;
-        float weight;
+        Math::Vector3 position      = Math::Vector3::Zero;
+        Math::Quaternion rotation   = Math::Quaternion::Identity;
+        Math::Vector3 scale         = Math::Vector3::One;
     };
 
+    // A node of a skeleton, the bones of a skeleton are sorted so that parents come before their children
     struct AnimationBone
     {
         std::string name;
-        std::vector<AnimationVertexWeight> vertexWeights;
-        Math::Matrix offset;
+        int32_t parent          = -1;                       // -1 for the bones which hang from the model's root
+        Math::Matrix offset     = Math::Matrix::Identity;   // from the space of the mesh to the space of the bone, in the bind pose
+        BoneTransform rest;                                 // for the bones that an animation doesn't move
+    };
+
+    // The bones that a vertex follows, the weights add up to one (a vertex that no bone influences uses the bone index of the skeleton's size)
+    struct BoneWeights
+    {
+        uint16_t indices[bone_influence_count]  = {};
+        float weights[bone_influence_count]     = {};
     };
 
+    // Keys, times are in seconds
     struct KeyVector
     {
-        double time;
+        float time;
         Math::Vector3 value;
     };
 
     struct KeyQuaternion
     {
-        double time;
+        float time;
         Math::Quaternion value;
     };
 
-    struct AnimationNode
+    // A rotation quantized to 48 bits, the three smallest components take 15 bits each and the largest one is reconstructed from them
+    struct KeyQuaternionPacked
+    {
+        float time;
+        uint16_t value[3];
+    };
+
+    // The curves that move a single bone
+    struct AnimationChannel
     {
         std::string name;
-        std::vector<KeyVector> positionFrames;
-        std::vector<KeyQuaternion> rotationFrames;
-        std::vector<KeyVector> scaleFrames;
+        uint32_t bone_index = 0;
+        std::vector<KeyVector> positions;
+        std::vector<KeyQuaternionPacked> rotations;
+        std::vector<KeyVector> scales;
     };
 
     class SPARTAN_CLASS Animation : public IResource
@@ -67,21 +94,39 @@ namespace Spartan
         Animation(Context* context);
         ~Animation() = default;
 
-        //= IResource ==========================================
-        bool LoadFromFile(const std::string& filePath) override;
-        bool SaveToFile(const std::string& filePath) override;
-        //======================================================
+        //= IResource ===========================================
+        bool LoadFromFile(const std::string& file_path) override;
+        bool SaveToFile(const std::string& file_path) override;
+        //=======================================================
+
+        // Models keep their animations in their own file
+        void Serialize(FileStream* file) const;
+        bool Deserialize(FileMapping* file);
+
+        // Drops the keys that can be interpolated from their neighbours (within a tolerance) and quantizes the rotations
+        void AddChannel(
+            const std::string& name,
+            uint32_t bone_index,
+            const std::vector<KeyVector>& positions,
+            const std::vector<KeyQuaternion>& rotations,
+            const std::vector<KeyVector>& scales
+        );
+
+        // Writes the transforms of the bones that the channels move, the rest of the pose is left as it is
+        void Sample(float time, BoneTransform* pose, uint32_t bone_count) const;
 
         void SetName(const std::string& name)   { m_name = name; }
-        void SetDuration(double duration)       { m_duration = duration; }
-        void SetTicksPerSec(double ticksPerSec) { m_ticksPerSec = ticksPerSec; }
+        const std::string& GetName()    const   { return m_name; }
+        void SetDuration(const float duration)  { m_duration = duration; }
+        float GetDuration()             const   { return m_duration; }
+        const auto& GetChannels()       const   { return m_channels; }
+        uint32_t GetKeyCount()          const;
 
     private:
         std::string m_name;
-        double m_duration       = 0;
-        double m_ticksPerSec    = 0;
+        float m_duration = 0.0f;
 
-        // Each channel controls a single node
-        std::vector<AnimationNode> m_channels;
+        // Each channel moves a single bone
+        std::vector<AnimationChannel> m_channels;
     };
 }
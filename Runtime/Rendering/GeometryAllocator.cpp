@@ -0,0 +1,239 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "Spartan.h"
+#include "GeometryAllocator.h"
+#include "../RHI/RHI_Vertex.h"
+//============================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    // Sizes of a new heap's buffers, unless an allocation needs more
+    static const uint64_t heap_vertex_size  = 64 * 1024 * 1024;
+    static const uint64_t heap_index_size   = 32 * 1024 * 1024;
+
+    GeometryAllocator::GeometryAllocator(const shared_ptr<RHI_Device>& rhi_device)
+    {
+        m_rhi_device        = rhi_device;
+        m_thread_id_main    = this_thread::get_id();
+    }
+
+    bool GeometryAllocator::Allocate(const bool vertex_compression, const uint32_t vertex_count, const uint32_t index_count, GeometryAllocation* allocation)
+    {
+        if (!allocation || vertex_count == 0 || index_count == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        vector<unique_ptr<GeometryHeap>>& heaps = m_heaps[vertex_compression ? 1 : 0];
+        for (const unique_ptr<GeometryHeap>& heap : heaps)
+        {
+            if (heap->Allocate(vertex_count, index_count, allocation))
+                return true;
+        }
+
+        // None of the heaps has room, add one
+        const uint32_t vertex_stride    = static_cast<uint32_t>(vertex_compression ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
+        const uint32_t vertex_capacity  = Helper::Max(vertex_count, static_cast<uint32_t>(heap_vertex_size / vertex_stride));
+        const uint32_t index_capacity   = Helper::Max(index_count, static_cast<uint32_t>(heap_index_size / sizeof(uint32_t)));
+        auto heap = make_unique<GeometryHeap>(m_rhi_device, vertex_compression, vertex_capacity, index_capacity);
+        if (!heap->IsValid())
+        {
+            LOG_ERROR("Failed to create geometry heap");
+            return false;
+        }
+
+        if (!heap->Allocate(vertex_count, index_count, allocation))
+            return false;
+
+        heaps.emplace_back(move(heap));
+
+        return true;
+    }
+
+    void GeometryAllocator::Free(const GeometryAllocation& allocation)
+    {
+        if (!allocation.IsValid())
+            return;
+
+        lock_guard<mutex> lock(m_mutex);
+        m_frees.push_back({ allocation, m_frame });
+    }
+
+    bool GeometryAllocator::Update(const GeometryAllocation& allocation, const void* vertices, const uint32_t* indices)
+    {
+        if (!allocation.IsValid())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        if (this_thread::get_id() == m_thread_id_main)
+            return allocation.heap->Update(allocation, vertices, indices);
+
+        if (!vertices || !indices)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Mapping the buffers has to wait for the main thread
+        const std::byte* vertex_bytes = static_cast<const std::byte*>(vertices);
+        GeometryUpload& upload        = m_uploads.emplace_back();
+        upload.allocation             = allocation;
+        upload.vertex_count           = allocation.vertex_count;
+        upload.vertices.assign(vertex_bytes, vertex_bytes + static_cast<uint64_t>(allocation.vertex_count) * allocation.heap->GetVertexStride());
+        upload.indices.assign(indices, indices + allocation.index_count);
+
+        return true;
+    }
+
+    bool GeometryAllocator::UpdateVertices(const GeometryAllocation& allocation, const uint32_t vertex_offset, const uint32_t vertex_count, const void* vertices)
+    {
+        if (!allocation.IsValid())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        if (this_thread::get_id() == m_thread_id_main)
+            return allocation.heap->UpdateVertices(allocation, vertex_offset, vertex_count, vertices);
+
+        if (!vertices || vertex_offset + vertex_count > allocation.vertex_count)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Mapping the buffers has to wait for the main thread
+        const std::byte* vertex_bytes = static_cast<const std::byte*>(vertices);
+        GeometryUpload& upload        = m_uploads.emplace_back();
+        upload.allocation             = allocation;
+        upload.vertex_offset          = vertex_offset;
+        upload.vertex_count           = vertex_count;
+        upload.vertices.assign(vertex_bytes, vertex_bytes + static_cast<uint64_t>(vertex_count) * allocation.heap->GetVertexStride());
+
+        return true;
+    }
+
+    void GeometryAllocator::Tick(const uint64_t frame)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        m_frame = frame;
+
+        // Write what other threads have updated, before the ranges can be freed and the heaps released
+        for (const GeometryUpload& upload : m_uploads)
+        {
+            const bool updated = upload.indices.empty() ?
+                upload.allocation.heap->UpdateVertices(upload.allocation, upload.vertex_offset, upload.vertex_count, upload.vertices.data()) :
+                upload.allocation.heap->Update(upload.allocation, upload.vertices.data(), upload.indices.data());
+
+            if (!updated)
+            {
+                LOG_ERROR("Failed to update geometry");
+            }
+        }
+        m_uploads.clear();
+
+        // Free the ranges that the gpu is done with
+        for (auto it = m_frees.begin(); it != m_frees.end();)
+        {
+            if (m_frame >= it->frame + frames_in_flight)
+            {
+                it->allocation.heap->Free(it->allocation);
+                it = m_frees.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+
+        // Release the heaps that nothing is in anymore, the first one of each vertex format is kept around
+        for (vector<unique_ptr<GeometryHeap>>& heaps : m_heaps)
+        {
+            for (auto it = heaps.begin(); it != heaps.end();)
+            {
+                const bool is_pending = any_of(m_frees.begin(), m_frees.end(), [&it](const GeometryFree& free) { return free.allocation.heap == it->get(); });
+                if (it != heaps.begin() && (*it)->IsEmpty() && !is_pending)
+                {
+                    it = heaps.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+    }
+
+    uint32_t GeometryAllocator::GetHeapCount() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return static_cast<uint32_t>(m_heaps[0].size() + m_heaps[1].size());
+    }
+
+    uint64_t GeometryAllocator::GetSizeGpu() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        uint64_t size = 0;
+        for (const vector<unique_ptr<GeometryHeap>>& heaps : m_heaps)
+        {
+            for (const unique_ptr<GeometryHeap>& heap : heaps)
+            {
+                size += heap->GetSizeGpu();
+            }
+        }
+
+        return size;
+    }
+
+    uint64_t GeometryAllocator::GetSizeUsed() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        uint64_t size = 0;
+        for (const vector<unique_ptr<GeometryHeap>>& heaps : m_heaps)
+        {
+            for (const unique_ptr<GeometryHeap>& heap : heaps)
+            {
+                size += heap->GetSizeUsed();
+            }
+        }
+
+        return size;
+    }
+}
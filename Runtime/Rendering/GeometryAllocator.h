@@ -0,0 +1,90 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ============
+#include <array>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+#include "GeometryHeap.h"
+//=======================
+
+namespace Spartan
+{
+    // The geometry heaps that all the models (including the terrain and the default meshes) suballocate their vertices and indices from,
+    // so that the render passes only rebind geometry when the heap changes. There are heaps for each vertex format, a new one is created
+    // when an allocation doesn't fit in any of the existing ones and the ones that become empty are released (all but the first).
+    class GeometryAllocator
+    {
+    public:
+        // Frames that the cpu can be ahead of the gpu, a freed range can still be read by the gpu for this long
+        static const uint32_t frames_in_flight = 3;
+
+        GeometryAllocator(const std::shared_ptr<RHI_Device>& rhi_device);
+        ~GeometryAllocator() = default;
+
+        // Safe to call from any thread, freed ranges are only reused once the gpu can no longer be using them
+        bool Allocate(bool vertex_compression, uint32_t vertex_count, uint32_t index_count, GeometryAllocation* allocation);
+        void Free(const GeometryAllocation& allocation);
+
+        // Writes the geometry of an allocation (vertices have to be in the vertex format it was allocated with).
+        // Writes from other threads are copied and done by Tick(), as the buffers can only be mapped on the main thread (D3D11's immediate context isn't thread safe).
+        bool Update(const GeometryAllocation& allocation, const void* vertices, const uint32_t* indices);
+        bool UpdateVertices(const GeometryAllocation& allocation, uint32_t vertex_offset, uint32_t vertex_count, const void* vertices);
+
+        // Does the writes of other threads and frees the ranges that the gpu is done with (main thread, once per frame, before anything is drawn)
+        void Tick(uint64_t frame);
+
+        // Stats
+        uint32_t GetHeapCount() const;
+        uint64_t GetSizeGpu()   const;
+        uint64_t GetSizeUsed()  const;
+
+    private:
+        struct GeometryFree
+        {
+            GeometryAllocation allocation;
+            uint64_t frame = 0;
+        };
+
+        struct GeometryUpload
+        {
+            GeometryAllocation allocation;
+            uint32_t vertex_offset = 0;      // relative to the allocation
+            uint32_t vertex_count  = 0;
+            std::vector<std::byte> vertices;
+            std::vector<uint32_t> indices;   // empty when only vertices are written
+        };
+
+        std::array<std::vector<std::unique_ptr<GeometryHeap>>, 2> m_heaps; // per vertex format (uncompressed and compressed)
+        std::vector<GeometryFree> m_frees;
+        std::vector<GeometryUpload> m_uploads;
+        mutable std::mutex m_mutex;
+        uint64_t m_frame = 0;
+        std::thread::id m_thread_id_main;
+
+        // Dependencies
+        std::shared_ptr<RHI_Device> m_rhi_device;
+    };
+}
@@ -0,0 +1,203 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =======================
+#include "Spartan.h"
+#include "GeometryHeap.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../RHI/RHI_VertexBuffer.h"
+#include "../RHI/RHI_IndexBuffer.h"
+//==================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    GeometryHeap::GeometryHeap(const shared_ptr<RHI_Device>& rhi_device, const bool vertex_compression, const uint32_t vertex_capacity, const uint32_t index_capacity)
+    {
+        m_vertex_compression    = vertex_compression;
+        m_vertex_stride         = static_cast<uint32_t>(vertex_compression ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
+
+        // The buffers are dynamic so that ranges of them can be written while the rest is in use
+        m_vertex_buffer = make_shared<RHI_VertexBuffer>(rhi_device);
+        const bool vertices_created = vertex_compression ? m_vertex_buffer->CreateDynamic<RHI_Vertex_PosTexNorTanPacked>(vertex_capacity) : m_vertex_buffer->CreateDynamic<RHI_Vertex_PosTexNorTan>(vertex_capacity);
+        if (!vertices_created)
+        {
+            LOG_ERROR("Failed to create vertex buffer");
+            m_vertex_buffer = nullptr;
+            return;
+        }
+
+        m_index_buffer = make_shared<RHI_IndexBuffer>(rhi_device);
+        if (!m_index_buffer->CreateDynamic<uint32_t>(index_capacity))
+        {
+            LOG_ERROR("Failed to create index buffer");
+            m_index_buffer = nullptr;
+            return;
+        }
+
+        m_vertex_capacity   = vertex_capacity;
+        m_index_capacity    = index_capacity;
+        m_free_vertices[0]  = vertex_capacity;
+        m_free_indices[0]   = index_capacity;
+    }
+
+    bool GeometryHeap::Allocate(const uint32_t vertex_count, const uint32_t index_count, GeometryAllocation* allocation)
+    {
+        if (!allocation || vertex_count == 0 || index_count == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        uint32_t vertex_offset = 0;
+        if (!FreeListAllocate(m_free_vertices, vertex_count, &vertex_offset))
+            return false;
+
+        uint32_t index_offset = 0;
+        if (!FreeListAllocate(m_free_indices, index_count, &index_offset))
+        {
+            FreeListFree(m_free_vertices, vertex_offset, vertex_count);
+            return false;
+        }
+
+        allocation->heap            = this;
+        allocation->vertex_offset   = vertex_offset;
+        allocation->vertex_count    = vertex_count;
+        allocation->index_offset    = index_offset;
+        allocation->index_count     = index_count;
+
+        m_vertices_used += vertex_count;
+        m_indices_used  += index_count;
+
+        return true;
+    }
+
+    void GeometryHeap::Free(const GeometryAllocation& allocation)
+    {
+        if (!allocation.IsValid() || allocation.heap != this)
+            return;
+
+        FreeListFree(m_free_vertices, allocation.vertex_offset, allocation.vertex_count);
+        FreeListFree(m_free_indices, allocation.index_offset, allocation.index_count);
+
+        m_vertices_used -= allocation.vertex_count;
+        m_indices_used  -= allocation.index_count;
+    }
+
+    bool GeometryHeap::Update(const GeometryAllocation& allocation, const void* vertices, const uint32_t* indices) const
+    {
+        if (!IsValid() || !allocation.IsValid() || allocation.heap != this || !vertices || !indices)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        const uint64_t vertex_offset    = static_cast<uint64_t>(allocation.vertex_offset) * m_vertex_stride;
+        const uint64_t vertex_size      = static_cast<uint64_t>(allocation.vertex_count) * m_vertex_stride;
+        const uint64_t index_offset     = static_cast<uint64_t>(allocation.index_offset) * sizeof(uint32_t);
+        const uint64_t index_size       = static_cast<uint64_t>(allocation.index_count) * sizeof(uint32_t);
+
+        return m_vertex_buffer->Update(vertices, vertex_offset, vertex_size) && m_index_buffer->Update(indices, index_offset, index_size);
+    }
+
+    bool GeometryHeap::UpdateVertices(const GeometryAllocation& allocation, const uint32_t vertex_offset, const uint32_t vertex_count, const void* vertices) const
+    {
+        if (!IsValid() || !allocation.IsValid() || allocation.heap != this || !vertices || vertex_offset + vertex_count > allocation.vertex_count)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        const uint64_t offset   = (static_cast<uint64_t>(allocation.vertex_offset) + vertex_offset) * m_vertex_stride;
+        const uint64_t size     = static_cast<uint64_t>(vertex_count) * m_vertex_stride;
+
+        return m_vertex_buffer->Update(vertices, offset, size);
+    }
+
+    uint64_t GeometryHeap::GetSizeGpu() const
+    {
+        return static_cast<uint64_t>(m_vertex_capacity) * m_vertex_stride + static_cast<uint64_t>(m_index_capacity) * sizeof(uint32_t);
+    }
+
+    uint64_t GeometryHeap::GetSizeUsed() const
+    {
+        return static_cast<uint64_t>(m_vertices_used) * m_vertex_stride + static_cast<uint64_t>(m_indices_used) * sizeof(uint32_t);
+    }
+
+    bool GeometryHeap::FreeListAllocate(FreeList& free_list, const uint32_t size, uint32_t* offset)
+    {
+        // Best fit, the smallest range that's large enough leaves the large ranges for large allocations
+        auto best = free_list.end();
+        for (auto it = free_list.begin(); it != free_list.end(); it++)
+        {
+            if (it->second >= size && (best == free_list.end() || it->second < best->second))
+            {
+                best = it;
+
+                if (it->second == size)
+                    break;
+            }
+        }
+
+        if (best == free_list.end())
+            return false;
+
+        // Take the start of the range, the rest stays free
+        *offset = best->first;
+        const uint32_t remaining = best->second - size;
+        free_list.erase(best);
+        if (remaining != 0)
+        {
+            free_list[*offset + size] = remaining;
+        }
+
+        return true;
+    }
+
+    void GeometryHeap::FreeListFree(FreeList& free_list, uint32_t offset, uint32_t size)
+    {
+        auto next = free_list.lower_bound(offset);
+
+        // Merge with the previous range, if it ends where this one starts
+        if (next != free_list.begin())
+        {
+            auto previous = prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size  += previous->second;
+                free_list.erase(previous);
+            }
+        }
+
+        // Merge with the next range, if it starts where this one ends
+        if (next != free_list.end() && offset + size == next->first)
+        {
+            size += next->second;
+            free_list.erase(next);
+        }
+
+        free_list[offset] = size;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <map>
+#include <memory>
+#include "../RHI/RHI_Definition.h"
+//================================
+
+namespace Spartan
+{
+    class GeometryHeap;
+
+    // A range of the buffers of a GeometryHeap, offsets and counts are in vertices and indices
+    struct GeometryAllocation
+    {
+        GeometryHeap* heap      = nullptr;
+        uint32_t vertex_offset  = 0;
+        uint32_t vertex_count   = 0;
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+
+        bool IsValid() const { return heap && vertex_count != 0 && index_count != 0; }
+    };
+
+    // Translates the offsets of a submesh to where its geometry is in the geometry heaps, which is per submesh for streamed models (see Model::GetSubmeshPlacement())
+    struct SubmeshPlacement
+    {
+        GeometryHeap* heap      = nullptr;
+        int64_t index_delta     = 0; // for the full detail indices (and the meshlets)
+        int64_t lod_index_delta = 0; // for the indices of the lower levels of detail
+        uint32_t vertex_offset  = 0;
+    };
+
+    // A large vertex buffer and a large index buffer that the geometry of many meshes is suballocated from.
+    // Allocations take the smallest free range that fits them and freed ranges are merged with their free neighbours.
+    class GeometryHeap
+    {
+    public:
+        GeometryHeap(const std::shared_ptr<RHI_Device>& rhi_device, bool vertex_compression, uint32_t vertex_capacity, uint32_t index_capacity);
+        ~GeometryHeap() = default;
+
+        // Returns false if there is no free range that's large enough (the heap is full or too fragmented)
+        bool Allocate(uint32_t vertex_count, uint32_t index_count, GeometryAllocation* allocation);
+        void Free(const GeometryAllocation& allocation);
+
+        // Writes the geometry of an allocation, which must not be in use by the gpu (vertices have to be in the heap's vertex format)
+        bool Update(const GeometryAllocation& allocation, const void* vertices, const uint32_t* indices) const;
+
+        // Writes a range of the vertices of an allocation only (the offset is relative to the allocation), for geometry that changes every frame
+        bool UpdateVertices(const GeometryAllocation& allocation, uint32_t vertex_offset, uint32_t vertex_count, const void* vertices) const;
+
+        bool IsValid()                  const { return m_vertex_buffer && m_index_buffer; }
+        bool IsEmpty()                  const { return m_vertices_used == 0 && m_indices_used == 0; }
+        bool IsVertexCompressed()       const { return m_vertex_compression; }
+        uint32_t GetVertexStride()      const { return m_vertex_stride; }
+        uint32_t GetVertexCapacity()    const { return m_vertex_capacity; }
+        uint32_t GetIndexCapacity()     const { return m_index_capacity; }
+        uint64_t GetSizeGpu()           const;
+        uint64_t GetSizeUsed()          const;
+        const auto& GetVertexBuffer()   const { return m_vertex_buffer; }
+        const auto& GetIndexBuffer()    const { return m_index_buffer; }
+
+    private:
+        // Free ranges, from their offset to their size
+        using FreeList = std::map<uint32_t, uint32_t>;
+        static bool FreeListAllocate(FreeList& free_list, uint32_t size, uint32_t* offset);
+        static void FreeListFree(FreeList& free_list, uint32_t offset, uint32_t size);
+
+        FreeList m_free_vertices;
+        FreeList m_free_indices;
+        uint32_t m_vertex_capacity  = 0;
+        uint32_t m_index_capacity   = 0;
+        uint32_t m_vertices_used    = 0;
+        uint32_t m_indices_used     = 0;
+        uint32_t m_vertex_stride    = 0;
+        bool m_vertex_compression   = false;
+        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
+        std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
+    };
+}
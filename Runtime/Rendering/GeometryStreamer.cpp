@@ -0,0 +1,272 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "GeometryStreamer.h"
+#include "Model.h"
+#include "MeshSubmesh.h"
+#include "GeometryAllocator.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    // Limits that keep a burst of requests (e.g. a camera cut) from stalling a frame
+    static const uint32_t loads_in_flight_max       = 32;
+    static const uint64_t upload_size_per_frame_max = 32 * 1024 * 1024;
+
+    GeometryStreamer::GeometryStreamer(Context* context, const shared_ptr<GeometryAllocator>& geometry_allocator)
+    {
+        m_context               = context;
+        m_geometry_allocator    = geometry_allocator;
+    }
+
+    GeometryStreamer::~GeometryStreamer()
+    {
+        // Loads in flight only hold on to their own data, so they can finish after the streamer is gone
+        lock_guard<mutex> lock(m_mutex);
+        m_loads.clear();
+        m_models.clear();
+    }
+
+    bool GeometryStreamer::Register(Model* model)
+    {
+        if (!model || model->GetSubmeshes().empty() || !m_geometry_allocator)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        const uint32_t vertex_stride        = static_cast<uint32_t>(model->IsVertexCompressed() ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
+        StreamedModel& streamed_model       = m_models[model];
+        streamed_model.registration         = ++m_registrations;
+        streamed_model.vertex_compression   = model->IsVertexCompressed();
+        streamed_model.submeshes.clear();
+        for (const MeshSubmesh& submesh : model->GetSubmeshes())
+        {
+            StreamedSubmesh& streamed_submesh   = streamed_model.submeshes.emplace_back();
+            streamed_submesh.vertex_count       = submesh.vertex_count;
+            streamed_submesh.index_count        = submesh.index_count + submesh.lod_index_count;
+            streamed_submesh.size               = static_cast<uint64_t>(streamed_submesh.vertex_count) * vertex_stride + static_cast<uint64_t>(streamed_submesh.index_count) * sizeof(uint32_t);
+        }
+
+        return true;
+    }
+
+    void GeometryStreamer::Unregister(Model* model)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_models.find(model);
+        if (it == m_models.end())
+            return;
+
+        // Loads of this model are dropped when they complete, as the registration no longer matches
+        for (uint32_t i = 0; i < static_cast<uint32_t>(it->second.submeshes.size()); i++)
+        {
+            Evict(it->second, i);
+        }
+
+        m_models.erase(it);
+    }
+
+    void GeometryStreamer::Request(Model* model, const uint32_t submesh_index, const float distance)
+    {
+        m_requests.push_back({ model, submesh_index, distance });
+    }
+
+    void GeometryStreamer::Tick(const uint64_t budget)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // Upload the submeshes that finished loading
+        uint64_t upload_size = 0;
+        for (auto it = m_loads.begin(); it != m_loads.end();)
+        {
+            SubmeshLoad& load = **it;
+            if (!load.is_done || upload_size >= upload_size_per_frame_max)
+            {
+                it++;
+                continue;
+            }
+
+            // The model might have been cleared, or the submesh might have fallen out of the budget, while it was loading
+            auto model_it = m_models.find(load.model);
+            if (model_it != m_models.end() && model_it->second.registration == load.registration)
+            {
+                StreamedModel& streamed_model       = model_it->second;
+                StreamedSubmesh& streamed_submesh   = streamed_model.submeshes[load.submesh_index];
+                streamed_submesh.is_loading         = false;
+
+                // If there is no room for it, the submesh is requested again later
+                GeometryAllocation allocation;
+                if (streamed_submesh.is_wanted && m_geometry_allocator->Allocate(streamed_model.vertex_compression, streamed_submesh.vertex_count, streamed_submesh.index_count, &allocation))
+                {
+                    if (m_geometry_allocator->Update(allocation, load.vertices.data(), load.indices.data()))
+                    {
+                        streamed_submesh.allocation = allocation;
+                        load.model->SetSubmeshAllocation(load.submesh_index, allocation);
+                        m_size_resident += streamed_submesh.size;
+                        upload_size     += streamed_submesh.size;
+                    }
+                    else
+                    {
+                        m_geometry_allocator->Free(allocation);
+                    }
+                }
+            }
+
+            it = m_loads.erase(it);
+        }
+
+        // Rank the requested submeshes by distance
+        m_candidates.clear();
+        for (const SubmeshRequest& request : m_requests)
+        {
+            auto model_it = m_models.find(request.model);
+            if (model_it == m_models.end() || request.submesh_index >= model_it->second.submeshes.size())
+                continue;
+
+            StreamedSubmesh& streamed_submesh = model_it->second.submeshes[request.submesh_index];
+            if (streamed_submesh.distance == Helper::INFINITY_)
+            {
+                m_candidates.push_back({ request.model, &model_it->second, request.submesh_index, request.distance });
+            }
+            streamed_submesh.distance = Helper::Min(streamed_submesh.distance, request.distance);
+        }
+        m_requests.clear();
+
+        for (SubmeshCandidate& candidate : m_candidates)
+        {
+            candidate.distance = candidate.streamed->submeshes[candidate.submesh_index].distance;
+        }
+
+        sort(m_candidates.begin(), m_candidates.end(), [](const SubmeshCandidate& a, const SubmeshCandidate& b) { return a.distance < b.distance; });
+
+        // The nearest submeshes that fit in the budget are wanted, loads start in that order as well
+        for (auto& it : m_models)
+        {
+            for (StreamedSubmesh& streamed_submesh : it.second.submeshes)
+            {
+                streamed_submesh.is_wanted = false;
+            }
+        }
+
+        uint64_t size_wanted = 0;
+        for (const SubmeshCandidate& candidate : m_candidates)
+        {
+            StreamedSubmesh& streamed_submesh = candidate.streamed->submeshes[candidate.submesh_index];
+            if (size_wanted + streamed_submesh.size > budget)
+                continue;
+
+            size_wanted                 += streamed_submesh.size;
+            streamed_submesh.is_wanted  = true;
+
+            if (streamed_submesh.allocation.IsValid() || streamed_submesh.is_loading || m_loads.size() >= loads_in_flight_max)
+                continue;
+
+            auto load               = make_shared<SubmeshLoad>();
+            load->model             = candidate.model;
+            load->registration      = candidate.streamed->registration;
+            load->submesh_index     = candidate.submesh_index;
+            candidate.model->GetSubmeshSource(candidate.submesh_index, &load->source);
+            streamed_submesh.is_loading = true;
+            m_loads.emplace_back(load);
+
+            m_context->GetSubsystem<Threading>()->AddTask([load]() { Load(load.get()); });
+        }
+
+        // Evict everything else and start the next frame's ranking from scratch
+        m_submesh_count         = 0;
+        m_submeshes_resident    = 0;
+        for (auto& it : m_models)
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(it.second.submeshes.size()); i++)
+            {
+                StreamedSubmesh& streamed_submesh = it.second.submeshes[i];
+                if (!streamed_submesh.is_wanted && streamed_submesh.allocation.IsValid())
+                {
+                    Evict(it.second, i);
+                    it.first->SetSubmeshAllocation(i, GeometryAllocation());
+                }
+
+                streamed_submesh.distance = Helper::INFINITY_;
+
+                m_submesh_count++;
+                m_submeshes_resident += streamed_submesh.allocation.IsValid() ? 1 : 0;
+            }
+        }
+    }
+
+    void GeometryStreamer::Evict(StreamedModel& streamed_model, const uint32_t submesh_index)
+    {
+        StreamedSubmesh& streamed_submesh = streamed_model.submeshes[submesh_index];
+        if (!streamed_submesh.allocation.IsValid())
+            return;
+
+        m_geometry_allocator->Free(streamed_submesh.allocation);
+        m_size_resident -= streamed_submesh.size;
+        streamed_submesh.allocation = GeometryAllocation();
+    }
+
+    void GeometryStreamer::Load(SubmeshLoad* load)
+    {
+        const SubmeshSource& source = load->source;
+
+        // The full detail indices are followed by the ones of the lower levels of detail, which is how they are laid out in the heap
+        load->indices.resize(static_cast<uint64_t>(source.index_count) + source.lod_index_count);
+        memcpy(load->indices.data(), source.indices, static_cast<uint64_t>(source.index_count) * sizeof(uint32_t));
+        if (source.lod_index_count != 0)
+        {
+            memcpy(load->indices.data() + source.index_count, source.lod_indices, static_cast<uint64_t>(source.lod_index_count) * sizeof(uint32_t));
+        }
+
+        // The vertices are converted to the vertex format of the heap
+        if (source.vertex_compression)
+        {
+            vector<RHI_Vertex_PosTexNorTan> vertices(source.vertex_count);
+            memcpy(vertices.data(), source.vertices, static_cast<uint64_t>(source.vertex_count) * sizeof(RHI_Vertex_PosTexNorTan));
+
+            load->vertices.resize(static_cast<uint64_t>(source.vertex_count) * sizeof(RHI_Vertex_PosTexNorTanPacked));
+            RHI_Vertex_PosTexNorTanPacked* vertices_packed = reinterpret_cast<RHI_Vertex_PosTexNorTanPacked*>(load->vertices.data());
+            for (uint32_t i = 0; i < source.vertex_count; i++)
+            {
+                vertices_packed[i] = RHI_Vertex_PosTexNorTanPacked(vertices[i], source.vertex_position_offset, source.vertex_position_scale_inverse);
+            }
+        }
+        else
+        {
+            load->vertices.resize(static_cast<uint64_t>(source.vertex_count) * sizeof(RHI_Vertex_PosTexNorTan));
+            memcpy(load->vertices.data(), source.vertices, load->vertices.size());
+        }
+
+        load->is_done = true;
+    }
+}
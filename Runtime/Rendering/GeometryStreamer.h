@@ -0,0 +1,141 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "GeometryHeap.h"
+#include "../Math/Vector3.h"
+#include "../Math/MathHelper.h"
+//=============================
+
+namespace Spartan
+{
+    class Context;
+    class Model;
+    class FileMapping;
+    class GeometryAllocator;
+
+    // Where the geometry of a submesh is in a mapped model file, which is all that a worker needs to load it (see Model::GetSubmeshSource())
+    struct SubmeshSource
+    {
+        std::shared_ptr<FileMapping> file; // keeps the mapping alive, even if the model is cleared while the submesh is loading
+        const std::byte* indices                        = nullptr;
+        const std::byte* lod_indices                    = nullptr;
+        const std::byte* vertices                       = nullptr;
+        uint32_t index_count                            = 0;
+        uint32_t lod_index_count                        = 0;
+        uint32_t vertex_count                           = 0;
+        bool vertex_compression                         = false;
+        Math::Vector3 vertex_position_offset            = Math::Vector3::Zero;
+        Math::Vector3 vertex_position_scale_inverse     = Math::Vector3::One;
+    };
+
+    // Loads and evicts the geometry of streamed models (see Model::IsStreamed()) one submesh at a time. Every frame, the submeshes are ranked by
+    // the distance of the nearest renderable that uses them, the nearest ones that fit in the memory budget are made resident and the rest are evicted.
+    // A submesh is copied out of the mapped model file by a worker, then it's uploaded to the geometry heaps which all the models share.
+    class GeometryStreamer
+    {
+    public:
+        GeometryStreamer(Context* context, const std::shared_ptr<GeometryAllocator>& geometry_allocator);
+        ~GeometryStreamer();
+
+        // Models register when they are loaded and unregister when they are cleared (safe to call from any thread)
+        bool Register(Model* model);
+        void Unregister(Model* model);
+
+        // Every renderable that uses a streamed model requests its submesh, then Tick() loads and evicts based on the requests (main thread only)
+        void Request(Model* model, uint32_t submesh_index, float distance);
+        void Tick(uint64_t budget);
+
+        // Stats
+        uint64_t GetSizeResident()      const { return m_size_resident; }
+        uint32_t GetSubmeshCount()      const { return m_submesh_count; }
+        uint32_t GetSubmeshesResident() const { return m_submeshes_resident; }
+
+    private:
+        struct StreamedSubmesh
+        {
+            GeometryAllocation allocation;                      // valid while resident
+            uint32_t vertex_count   = 0;
+            uint32_t index_count    = 0;                        // including the indices of the lower levels of detail
+            uint64_t size           = 0;                        // gpu memory it needs (bytes)
+            float distance          = Math::Helper::INFINITY_;  // to the nearest renderable that requested it this frame
+            bool is_wanted          = false;                    // it fit in the budget the last time the submeshes were ranked
+            bool is_loading         = false;
+        };
+
+        struct StreamedModel
+        {
+            uint64_t registration       = 0; // tells a model apart from a later one which is allocated at the same address
+            bool vertex_compression     = false;
+            std::vector<StreamedSubmesh> submeshes;
+        };
+
+        struct SubmeshLoad
+        {
+            Model* model            = nullptr;
+            uint64_t registration   = 0;
+            uint32_t submesh_index  = 0;
+            SubmeshSource source;
+            std::vector<std::byte> vertices;
+            std::vector<uint32_t> indices;
+            std::atomic<bool> is_done = false;
+        };
+
+        struct SubmeshRequest
+        {
+            Model* model            = nullptr;
+            uint32_t submesh_index  = 0;
+            float distance          = 0.0f;
+        };
+
+        struct SubmeshCandidate
+        {
+            Model* model            = nullptr;
+            StreamedModel* streamed = nullptr;
+            uint32_t submesh_index  = 0;
+            float distance          = 0.0f;
+        };
+
+        void Evict(StreamedModel& streamed_model, uint32_t submesh_index);
+        static void Load(SubmeshLoad* load);
+
+        std::unordered_map<Model*, StreamedModel> m_models;
+        std::vector<SubmeshRequest> m_requests;
+        std::vector<SubmeshCandidate> m_candidates;
+        std::vector<std::shared_ptr<SubmeshLoad>> m_loads;
+        std::mutex m_mutex;
+        uint64_t m_registrations        = 0;
+        uint64_t m_size_resident        = 0;
+        uint32_t m_submesh_count        = 0;
+        uint32_t m_submeshes_resident   = 0;
+
+        // Dependencies
+        Context* m_context = nullptr;
+        std::shared_ptr<GeometryAllocator> m_geometry_allocator;
+    };
+}
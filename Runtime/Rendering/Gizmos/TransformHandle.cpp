@@ -236,14 +236,9 @@ namespace Spartan
         return m_handle_xyz.GetColor();
     }
 
-    const RHI_VertexBuffer* TransformHandle::GetVertexBuffer() const
+    const GeometryAllocation& TransformHandle::GetGeometry() const
     {
-        return m_model->GetVertexBuffer();
-    }
-
-    const RHI_IndexBuffer* TransformHandle::GetIndexBuffer() const
-    {
-        return m_model->GetIndexBuffer();
+        return m_model->GetGeometryAllocation();
     }
 
     void TransformHandle::SnapToTransform(const TransformHandle_Space space, Entity* entity, Camera* camera, const float handle_size)
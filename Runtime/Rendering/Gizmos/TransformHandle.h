@@ -34,13 +34,12 @@ namespace Spartan
     class Transform_Gizmo;
     class Renderer;
     class Context;
-    class RHI_VertexBuffer;
-    class RHI_IndexBuffer;
     class Entity;
     class Model;
     class Input;
     class Transform;
     class Camera;
+    struct GeometryAllocation;
 
     struct TransformHandleAxis
     {
@@ -97,8 +96,7 @@ namespace Spartan
         bool Update(TransformHandle_Space space, Entity* entity, Camera* camera, float handle_size, float handle_speed);
         const Math::Matrix& GetTransform(const Math::Vector3& axis) const;
         const Math::Vector3& GetColor(const Math::Vector3& axis) const;
-        const RHI_VertexBuffer* GetVertexBuffer() const;
-        const RHI_IndexBuffer* GetIndexBuffer() const;
+        const GeometryAllocation& GetGeometry() const;
     
     private:
         void SnapToTransform(TransformHandle_Space space, Entity* entity, Camera* camera, float handle_size);
@@ -23,7 +23,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Transform_Gizmo.h"
 #include "../Model.h"
-#include "../../RHI/RHI_IndexBuffer.h"
 #include "../../Input/Input.h"
 #include "../../World/World.h"
 #include "../../World/Entity.h"
@@ -119,48 +118,6 @@ namespace Spartan
         return true;
     }
 
-    uint32_t Transform_Gizmo::GetIndexCount() const
-    {
-        if (m_type == TransformHandle_Position)
-        {
-            return m_handle_position.GetIndexBuffer()->GetIndexCount();
-        }
-        else if (m_type == TransformHandle_Scale)
-        {
-            return m_handle_scale.GetIndexBuffer()->GetIndexCount();
-        }
-
-        return m_handle_rotation.GetIndexBuffer()->GetIndexCount();
-    }
-
-    const RHI_VertexBuffer* Transform_Gizmo::GetVertexBuffer() const
-    {
-        if (m_type == TransformHandle_Position)
-        {
-            return m_handle_position.GetVertexBuffer();
-        }
-        else if (m_type == TransformHandle_Scale)
-        {
-            return m_handle_scale.GetVertexBuffer();
-        }
-
-        return m_handle_rotation.GetVertexBuffer();
-    }
-
-    const RHI_IndexBuffer* Transform_Gizmo::GetIndexBuffer() const
-    {
-        if (m_type == TransformHandle_Position)
-        {
-            return m_handle_position.GetIndexBuffer();
-        }
-        else if (m_type == TransformHandle_Scale)
-        {
-            return m_handle_scale.GetIndexBuffer();
-        }
-
-        return m_handle_rotation.GetIndexBuffer();
-    }
-
      const TransformHandle& Transform_Gizmo::GetHandle() const
      {
          if (m_type == TransformHandle_Position)
@@ -34,8 +34,6 @@ namespace Spartan
     class Camera;
     class Context;
     class Entity;
-    class RHI_IndexBuffer;
-    class RHI_VertexBuffer;
 
     class SPARTAN_CLASS Transform_Gizmo
     {
@@ -45,9 +43,6 @@ namespace Spartan
 
         std::weak_ptr<Spartan::Entity> SetSelectedEntity(const std::shared_ptr<Entity>& entity);
         bool Update(Camera* camera, float handle_size, float handle_speed);
-        uint32_t GetIndexCount()                    const;
-        const RHI_VertexBuffer* GetVertexBuffer()   const;
-        const RHI_IndexBuffer* GetIndexBuffer()     const;
         const TransformHandle& GetHandle()          const;
         bool DrawXYZ()                              const { return m_type == TransformHandle_Scale; }
         bool IsEntitySelected()                     const { return m_is_editing; }
@@ -189,6 +189,29 @@ namespace Spartan
         return false;
     }
 
+    RHI_Texture_Content Material::GetTextureContent(const Material_Property type)
+    {
+        switch (type)
+        {
+            case Material_Color:
+            case Material_Emission:
+            case Material_Mask:
+                return RHI_Texture_Content::Color;
+
+            case Material_Normal:
+            case Material_Height:
+                return RHI_Texture_Content::Normal;
+
+            case Material_Roughness:
+            case Material_Metallic:
+            case Material_Occlusion:
+                return RHI_Texture_Content::Channel;
+
+            default:
+                return RHI_Texture_Content::Unknown;
+        }
+    }
+
     string Material::GetTexturePathByType(const Material_Property type)
     {
         if (!HasTexture(type))
@@ -73,6 +73,8 @@ namespace Spartan
         std::vector<std::string> GetTexturePaths();
         RHI_Texture* GetTexture_Ptr(const Material_Property type) { return HasTexture(type) ? m_textures[type].get() : nullptr; }
         std::shared_ptr<RHI_Texture>& GetTexture_PtrShared(const Material_Property type);
+        const auto& GetTextures() const { return m_textures; }
+        static RHI_Texture_Content GetTextureContent(const Material_Property type); // what a texture in this slot holds, decides how it's compressed
         //=======================================================================================================================
         
         //= PROPERTIES =====================================================================================
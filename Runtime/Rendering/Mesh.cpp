@@ -38,6 +38,18 @@ namespace Spartan
         m_vertices.shrink_to_fit();
         m_indices.clear();
         m_indices.shrink_to_fit();
+        m_meshlets.clear();
+        m_meshlets.shrink_to_fit();
+        m_lods.clear();
+        m_lods.shrink_to_fit();
+        m_submeshes.clear();
+        m_submeshes.shrink_to_fit();
+        m_bvh_nodes.clear();
+        m_bvh_nodes.shrink_to_fit();
+        m_bvh_triangles.clear();
+        m_bvh_triangles.shrink_to_fit();
+        m_bvhs.clear();
+        m_bvhs.shrink_to_fit();
     }
 
     uint32_t Mesh::GetMemoryUsage() const
@@ -45,27 +57,39 @@ namespace Spartan
         uint32_t size = 0;
         size += uint32_t(m_vertices.size()    * sizeof(RHI_Vertex_PosTexNorTan));
         size += uint32_t(m_indices.size()    * sizeof(uint32_t));
+        size += uint32_t(m_meshlets.size()   * sizeof(Meshlet));
+        size += uint32_t(m_lods.size()       * sizeof(MeshLod));
+        size += uint32_t(m_submeshes.size()  * sizeof(MeshSubmesh));
+        size += uint32_t(m_bvh_nodes.size()     * sizeof(BvhNode));
+        size += uint32_t(m_bvh_triangles.size() * sizeof(uint32_t));
+        size += uint32_t(m_bvhs.size()          * sizeof(MeshBvh));
 
         return size;
     }
 
     void Mesh::GetGeometry(uint32_t indexOffset, uint32_t indexCount, uint32_t vertexOffset, unsigned vertexCount, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices)
     {
-        if ((indexOffset == 0 && indexCount == 0) || (vertexOffset == 0 && vertexCount == 0) || !vertices || !indices)
+        if ((indexOffset == 0 && indexCount == 0) || (vertexOffset == 0 && vertexCount == 0) || (!vertices && !indices))
         {
             LOG_ERROR("Mesh::Geometry_Get: Invalid parameters");
             return;
         }
 
         // Indices
-        const auto indexFirst   = m_indices.begin() + indexOffset;
-        const auto indexLast    = m_indices.begin() + indexOffset + indexCount;
-        *indices                = vector<uint32_t>(indexFirst, indexLast);
+        if (indices)
+        {
+            const auto indexFirst   = m_indices.begin() + indexOffset;
+            const auto indexLast    = m_indices.begin() + indexOffset + indexCount;
+            *indices                = vector<uint32_t>(indexFirst, indexLast);
+        }
 
         // Vertices
-        const auto vertexFirst  = m_vertices.begin() + vertexOffset;
-        const auto vertexLast   = m_vertices.begin() + vertexOffset + vertexCount;
-        *vertices               = vector<RHI_Vertex_PosTexNorTan>(vertexFirst, vertexLast);
+        if (vertices)
+        {
+            const auto vertexFirst  = m_vertices.begin() + vertexOffset;
+            const auto vertexLast   = m_vertices.begin() + vertexOffset + vertexCount;
+            *vertices               = vector<RHI_Vertex_PosTexNorTan>(vertexFirst, vertexLast);
+        }
     }
 
     void Mesh::Vertices_Append(const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* vertexOffset)
@@ -97,4 +121,89 @@ namespace Spartan
 
         m_indices.insert(m_indices.end(), indices.begin(), indices.end());
     }
+
+    void Mesh::Meshlets_Append(const vector<Meshlet>& meshlets, const uint32_t indexOffset, uint32_t* meshletOffset)
+    {
+        if (meshletOffset)
+        {
+            *meshletOffset = static_cast<uint32_t>(m_meshlets.size());
+        }
+
+        // Meshlets are built per mesh, so their index offsets have to be moved to where the mesh's indices start
+        for (const Meshlet& meshlet : meshlets)
+        {
+            m_meshlets.emplace_back(meshlet);
+            m_meshlets.back().index_offset += indexOffset;
+        }
+    }
+
+    void Mesh::Lods_Append(const vector<uint32_t>& indices, const vector<MeshLod>& lods, uint32_t* lodOffset)
+    {
+        if (lodOffset)
+        {
+            *lodOffset = static_cast<uint32_t>(m_lods.size());
+        }
+
+        // The indices of the levels go after the existing ones
+        uint32_t index_offset = 0;
+        Indices_Append(indices, &index_offset);
+
+        for (const MeshLod& lod : lods)
+        {
+            m_lods.emplace_back(lod);
+            m_lods.back().index_offset += index_offset;
+        }
+
+        if (!m_submeshes.empty())
+        {
+            MeshSubmesh& submesh = m_submeshes.back();
+            if (submesh.lod_index_count == 0)
+            {
+                submesh.lod_index_offset = index_offset;
+            }
+            submesh.lod_index_count += static_cast<uint32_t>(indices.size());
+        }
+    }
+
+    void Mesh::Bvh_Append(const MeshBvhData& bvh)
+    {
+        // The offsets in the nodes stay relative to the bvh, so it's appended as it is
+        MeshBvh range;
+        range.node_offset       = static_cast<uint32_t>(m_bvh_nodes.size());
+        range.node_count        = static_cast<uint32_t>(bvh.nodes.size());
+        range.triangle_offset   = static_cast<uint32_t>(m_bvh_triangles.size());
+        range.triangle_count    = static_cast<uint32_t>(bvh.triangles.size());
+        m_bvhs.emplace_back(range);
+
+        m_bvh_nodes.insert(m_bvh_nodes.end(), bvh.nodes.begin(), bvh.nodes.end());
+        m_bvh_triangles.insert(m_bvh_triangles.end(), bvh.triangles.begin(), bvh.triangles.end());
+    }
+
+    void Mesh::Bvh_Replace(const uint32_t index, const MeshBvhData& bvh)
+    {
+        if (index >= m_bvhs.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // The triangle count doesn't change when the vertices do, but the node count can, so the bvhs that follow might have to move
+        MeshBvh& range = m_bvhs[index];
+        const int64_t node_delta        = static_cast<int64_t>(bvh.nodes.size()) - static_cast<int64_t>(range.node_count);
+        const int64_t triangle_delta    = static_cast<int64_t>(bvh.triangles.size()) - static_cast<int64_t>(range.triangle_count);
+
+        m_bvh_nodes.erase(m_bvh_nodes.begin() + range.node_offset, m_bvh_nodes.begin() + range.node_offset + range.node_count);
+        m_bvh_nodes.insert(m_bvh_nodes.begin() + range.node_offset, bvh.nodes.begin(), bvh.nodes.end());
+        m_bvh_triangles.erase(m_bvh_triangles.begin() + range.triangle_offset, m_bvh_triangles.begin() + range.triangle_offset + range.triangle_count);
+        m_bvh_triangles.insert(m_bvh_triangles.begin() + range.triangle_offset, bvh.triangles.begin(), bvh.triangles.end());
+
+        range.node_count        = static_cast<uint32_t>(bvh.nodes.size());
+        range.triangle_count    = static_cast<uint32_t>(bvh.triangles.size());
+
+        for (uint32_t i = index + 1; i < static_cast<uint32_t>(m_bvhs.size()); i++)
+        {
+            m_bvhs[i].node_offset       = static_cast<uint32_t>(m_bvhs[i].node_offset + node_delta);
+            m_bvhs[i].triangle_offset   = static_cast<uint32_t>(m_bvhs[i].triangle_offset + triangle_delta);
+        }
+    }
 }
@@ -24,6 +24,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <vector>
 #include "../RHI/RHI_Definition.h"
+#include "Meshlet.h"
+#include "MeshLod.h"
+#include "MeshBvh.h"
+#include "MeshSubmesh.h"
 //================================
 
 namespace Spartan
@@ -59,6 +63,26 @@ namespace Spartan
         void Indices_Set(const std::vector<uint32_t>& indices)  { m_indices = indices; }
         uint32_t Indices_Count() const                          { return static_cast<uint32_t>(m_indices.size()); }
         void Indices_Append(const std::vector<uint32_t>& indices, uint32_t* indexOffset);
+
+        // Meshlets
+        std::vector<Meshlet>& Meshlets_Get()                    { return m_meshlets; }
+        uint32_t Meshlets_Count() const                         { return static_cast<uint32_t>(m_meshlets.size()); }
+        void Meshlets_Append(const std::vector<Meshlet>& meshlets, uint32_t indexOffset, uint32_t* meshletOffset);
+
+        // Levels of detail
+        std::vector<MeshLod>& Lods_Get()                        { return m_lods; }
+        void Lods_Append(const std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, uint32_t* lodOffset);
+
+        // Submeshes (the levels of detail that get appended belong to the last one)
+        std::vector<MeshSubmesh>& Submeshes_Get()               { return m_submeshes; }
+        void Submesh_Add(const MeshSubmesh& submesh)            { m_submeshes.emplace_back(submesh); }
+
+        // Bounding volume hierarchies (one per submesh, for ray queries)
+        std::vector<BvhNode>& BvhNodes_Get()                    { return m_bvh_nodes; }
+        std::vector<uint32_t>& BvhTriangles_Get()               { return m_bvh_triangles; }
+        std::vector<MeshBvh>& Bvhs_Get()                        { return m_bvhs; }
+        void Bvh_Append(const MeshBvhData& bvh);
+        void Bvh_Replace(uint32_t index, const MeshBvhData& bvh);
     
         // Misc
         uint32_t GetTriangleCount() const { return Indices_Count() / 3; }
@@ -66,5 +90,11 @@ namespace Spartan
     private:
         std::vector<RHI_Vertex_PosTexNorTan> m_vertices;
         std::vector<uint32_t> m_indices;
+        std::vector<Meshlet> m_meshlets;
+        std::vector<MeshLod> m_lods;
+        std::vector<MeshSubmesh> m_submeshes;
+        std::vector<BvhNode> m_bvh_nodes;
+        std::vector<uint32_t> m_bvh_triangles;
+        std::vector<MeshBvh> m_bvhs;
     };
 }
@@ -0,0 +1,465 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "Spartan.h"
+#include "MeshBvh.h"
+#include "../Math/Ray.h"
+#include "../RHI/RHI_Vertex.h"
+#include <emmintrin.h>
+//============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::MeshBvhHelper
+{
+    // Enough for the surface area heuristic to find good splits, few enough to evaluate cheaply
+    static const uint32_t bin_count = 16;
+
+    // Below this depth, nodes are split at the median so that the bvh can't get deeper than bvh_depth_max
+    static const uint32_t depth_median = bvh_depth_max / 2;
+
+    struct Bounds
+    {
+        float min[3] = { Helper::INFINITY_, Helper::INFINITY_, Helper::INFINITY_ };
+        float max[3] = { -Helper::INFINITY_, -Helper::INFINITY_, -Helper::INFINITY_ };
+
+        void Merge(const float* point)
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                min[axis] = Helper::Min(min[axis], point[axis]);
+                max[axis] = Helper::Max(max[axis], point[axis]);
+            }
+        }
+
+        void Merge(const Bounds& bounds)
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                min[axis] = Helper::Min(min[axis], bounds.min[axis]);
+                max[axis] = Helper::Max(max[axis], bounds.max[axis]);
+            }
+        }
+
+        // Half of the surface area, which is all that the heuristic needs
+        float Area() const
+        {
+            const float x = max[0] - min[0];
+            const float y = max[1] - min[1];
+            const float z = max[2] - min[2];
+            return x < 0.0f ? 0.0f : x * y + y * z + z * x;
+        }
+    };
+
+    struct Bin
+    {
+        Bounds bounds;
+        uint32_t count = 0;
+    };
+
+    struct BuildTask
+    {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+    };
+
+    static inline void vertex_position(const byte* vertices, const uint32_t index, float* position)
+    {
+        memcpy(position, vertices + static_cast<uint64_t>(index) * sizeof(RHI_Vertex_PosTexNorTan) + offsetof(RHI_Vertex_PosTexNorTan, pos), sizeof(float) * 3);
+    }
+
+    static inline uint32_t vertex_index(const byte* indices, const uint64_t i)
+    {
+        uint32_t index;
+        memcpy(&index, indices + i * sizeof(uint32_t), sizeof(uint32_t));
+        return index;
+    }
+
+    // Finds the binned split with the lowest surface area heuristic cost, returns false if the centroids can't be told apart on any axis
+    static bool find_split(const vector<Bounds>& triangle_bounds, const vector<Vector3>& centroids, const uint32_t* triangles, const uint32_t count, const Bounds& centroid_bounds, uint32_t* split_axis, float* split_position)
+    {
+        float cost_best = Helper::INFINITY_;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            Bin bins[bin_count];
+            const float scale = bin_count / extent;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const float centroid    = (&centroids[triangles[i]].x)[axis];
+                const uint32_t bin      = Helper::Min(bin_count - 1, static_cast<uint32_t>((centroid - centroid_bounds.min[axis]) * scale));
+                bins[bin].bounds.Merge(triangle_bounds[triangles[i]]);
+                bins[bin].count++;
+            }
+
+            // Sweep from the left, then from the right while evaluating the cost of every plane between two bins
+            float area_left[bin_count - 1];
+            uint32_t count_left[bin_count - 1];
+            Bounds bounds;
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < bin_count - 1; i++)
+            {
+                bounds.Merge(bins[i].bounds);
+                sum             += bins[i].count;
+                area_left[i]    = bounds.Area();
+                count_left[i]   = sum;
+            }
+
+            bounds  = Bounds();
+            sum     = 0;
+            for (uint32_t i = bin_count - 1; i > 0; i--)
+            {
+                bounds.Merge(bins[i].bounds);
+                sum += bins[i].count;
+                if (sum == 0 || count_left[i - 1] == 0)
+                    continue;
+
+                const float cost = count_left[i - 1] * area_left[i - 1] + sum * bounds.Area();
+                if (cost < cost_best)
+                {
+                    cost_best       = cost;
+                    *split_axis     = axis;
+                    *split_position = centroid_bounds.min[axis] + i / scale;
+                }
+            }
+        }
+
+        return cost_best != Helper::INFINITY_;
+    }
+
+    void build(const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices, MeshBvhData* bvh)
+    {
+        bvh->nodes.clear();
+        bvh->triangles.clear();
+
+        const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        if (triangle_count == 0)
+            return;
+
+        // The bounds and the centroids of the triangles
+        vector<Bounds> triangle_bounds(triangle_count);
+        vector<Vector3> centroids(triangle_count);
+        bvh->triangles.resize(triangle_count);
+        for (uint32_t i = 0; i < triangle_count; i++)
+        {
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                triangle_bounds[i].Merge(vertices[indices[i * 3 + corner]].pos);
+            }
+
+            const Bounds& bounds    = triangle_bounds[i];
+            centroids[i]            = Vector3(bounds.min[0] + bounds.max[0], bounds.min[1] + bounds.max[1], bounds.min[2] + bounds.max[2]) * 0.5f;
+            bvh->triangles[i]       = i;
+        }
+
+        // A binary tree with at least one triangle per leaf can't have more nodes than this, so references to the nodes stay valid
+        bvh->nodes.reserve(static_cast<size_t>(triangle_count) * 2 - 1);
+        bvh->nodes.emplace_back();
+
+        vector<BuildTask> tasks = { { 0, 0, triangle_count, 1 } };
+        while (!tasks.empty())
+        {
+            const BuildTask task = tasks.back();
+            tasks.pop_back();
+
+            uint32_t* triangles = bvh->triangles.data() + task.first;
+            Bounds bounds;
+            Bounds centroid_bounds;
+            for (uint32_t i = 0; i < task.count; i++)
+            {
+                bounds.Merge(triangle_bounds[triangles[i]]);
+                centroid_bounds.Merge(&centroids[triangles[i]].x);
+            }
+
+            BvhNode& node   = bvh->nodes[task.node];
+            node.min        = Vector3(bounds.min[0], bounds.min[1], bounds.min[2]);
+            node.max        = Vector3(bounds.max[0], bounds.max[1], bounds.max[2]);
+
+            if (task.count <= bvh_leaf_triangles_max)
+            {
+                node.offset = task.first;
+                node.count  = task.count;
+                continue;
+            }
+
+            // Split where the heuristic says, or at the median (along the longest axis) when it can't or the bvh is getting too deep
+            uint32_t split_axis     = 0;
+            float split_position    = 0.0f;
+            uint32_t count_left     = 0;
+            if (task.depth < depth_median && find_split(triangle_bounds, centroids, triangles, task.count, centroid_bounds, &split_axis, &split_position))
+            {
+                count_left = static_cast<uint32_t>(partition(triangles, triangles + task.count, [&centroids, split_axis, split_position](const uint32_t triangle)
+                {
+                    return (&centroids[triangle].x)[split_axis] < split_position;
+                }) - triangles);
+            }
+
+            if (count_left == 0 || count_left == task.count)
+            {
+                const float extent_x = centroid_bounds.max[0] - centroid_bounds.min[0];
+                const float extent_y = centroid_bounds.max[1] - centroid_bounds.min[1];
+                const float extent_z = centroid_bounds.max[2] - centroid_bounds.min[2];
+                split_axis = extent_x >= extent_y && extent_x >= extent_z ? 0 : (extent_y >= extent_z ? 1 : 2);
+                count_left = task.count / 2;
+                nth_element(triangles, triangles + count_left, triangles + task.count, [&centroids, split_axis](const uint32_t a, const uint32_t b)
+                {
+                    return (&centroids[a].x)[split_axis] < (&centroids[b].x)[split_axis];
+                });
+            }
+
+            const uint32_t child = static_cast<uint32_t>(bvh->nodes.size());
+            node.offset = child;
+            node.count  = 0;
+            bvh->nodes.emplace_back();
+            bvh->nodes.emplace_back();
+
+            tasks.push_back({ child + 1, task.first + count_left, task.count - count_left, task.depth + 1 });
+            tasks.push_back({ child, task.first, count_left, task.depth + 1 });
+        }
+
+        bvh->nodes.shrink_to_fit();
+    }
+
+    // The ray in the form that the slab tests and the triangle tests want it
+    struct RaySimd
+    {
+        __m128 origin;
+        __m128 direction_inverse;
+        __m128 origin_x, origin_y, origin_z;
+        __m128 direction_x, direction_y, direction_z;
+    };
+
+    static RaySimd ray_simd(const Ray& ray)
+    {
+        const Vector3& origin       = ray.GetStart();
+        const Vector3& direction    = ray.GetDirection();
+
+        // Axis aligned rays would divide by zero, a tiny component instead keeps the slab tests free of NaNs
+        const auto inverse = [](const float value) { return 1.0f / (Helper::Abs(value) < 1e-12f ? (value < 0.0f ? -1e-12f : 1e-12f) : value); };
+
+        RaySimd simd;
+        simd.origin             = _mm_set_ps(0.0f, origin.z, origin.y, origin.x);
+        simd.direction_inverse  = _mm_set_ps(0.0f, inverse(direction.z), inverse(direction.y), inverse(direction.x));
+        simd.origin_x           = _mm_set1_ps(origin.x);
+        simd.origin_y           = _mm_set1_ps(origin.y);
+        simd.origin_z           = _mm_set1_ps(origin.z);
+        simd.direction_x        = _mm_set1_ps(direction.x);
+        simd.direction_y        = _mm_set1_ps(direction.y);
+        simd.direction_z        = _mm_set1_ps(direction.z);
+
+        return simd;
+    }
+
+    // Slab test, the distance is where the ray enters the node (zero if it starts inside)
+    static inline bool node_hit(const BvhNode& node, const RaySimd& ray, const float distance_max, float* distance)
+    {
+        // The w lane of the node holds the offset and the count, it's masked out so that it can't turn into a denormal or a NaN
+        const __m128 mask_xyz   = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        const __m128 min        = _mm_and_ps(_mm_loadu_ps(&node.min.x), mask_xyz);
+        const __m128 max        = _mm_and_ps(_mm_loadu_ps(&node.max.x), mask_xyz);
+        const __m128 t0         = _mm_mul_ps(_mm_sub_ps(min, ray.origin), ray.direction_inverse);
+        const __m128 t1         = _mm_mul_ps(_mm_sub_ps(max, ray.origin), ray.direction_inverse);
+        const __m128 t_near     = _mm_min_ps(t0, t1);
+        const __m128 t_far      = _mm_max_ps(t0, t1);
+
+        __m128 enter = _mm_max_ss(_mm_max_ss(t_near, _mm_shuffle_ps(t_near, t_near, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(t_near, t_near, _MM_SHUFFLE(2, 2, 2, 2)));
+        __m128 exit  = _mm_min_ss(_mm_min_ss(t_far, _mm_shuffle_ps(t_far, t_far, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(t_far, t_far, _MM_SHUFFLE(2, 2, 2, 2)));
+        enter        = _mm_max_ss(enter, _mm_setzero_ps());
+        exit         = _mm_min_ss(exit, _mm_set_ss(distance_max));
+
+        _mm_store_ss(distance, enter);
+        return _mm_comile_ss(enter, exit) != 0;
+    }
+
+    // Tests up to four triangles at once (Moller-Trumbore, front faces only, like Ray::HitDistance()), keeps the nearest hit
+    static inline void triangles_hit(const MeshBvhView& view, const uint32_t* triangles, const uint32_t count, const RaySimd& ray, float* distance_best, uint32_t* triangle_best)
+    {
+        // Gather the corners into lanes, the unused lanes repeat the last triangle
+        alignas(16) float corners[3][3][4];
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            const uint64_t first_index = static_cast<uint64_t>(triangles[Helper::Min(lane, count - 1)]) * 3;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                float position[3];
+                vertex_position(view.vertices, vertex_index(view.indices, first_index + corner), position);
+                corners[corner][0][lane] = position[0];
+                corners[corner][1][lane] = position[1];
+                corners[corner][2][lane] = position[2];
+            }
+        }
+
+        const __m128 v0_x = _mm_load_ps(corners[0][0]), v0_y = _mm_load_ps(corners[0][1]), v0_z = _mm_load_ps(corners[0][2]);
+        const __m128 e1_x = _mm_sub_ps(_mm_load_ps(corners[1][0]), v0_x), e1_y = _mm_sub_ps(_mm_load_ps(corners[1][1]), v0_y), e1_z = _mm_sub_ps(_mm_load_ps(corners[1][2]), v0_z);
+        const __m128 e2_x = _mm_sub_ps(_mm_load_ps(corners[2][0]), v0_x), e2_y = _mm_sub_ps(_mm_load_ps(corners[2][1]), v0_y), e2_z = _mm_sub_ps(_mm_load_ps(corners[2][2]), v0_z);
+
+        // p = direction x edge2, det = edge1 . p
+        const __m128 p_x = _mm_sub_ps(_mm_mul_ps(ray.direction_y, e2_z), _mm_mul_ps(ray.direction_z, e2_y));
+        const __m128 p_y = _mm_sub_ps(_mm_mul_ps(ray.direction_z, e2_x), _mm_mul_ps(ray.direction_x, e2_z));
+        const __m128 p_z = _mm_sub_ps(_mm_mul_ps(ray.direction_x, e2_y), _mm_mul_ps(ray.direction_y, e2_x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1_x, p_x), _mm_mul_ps(e1_y, p_y)), _mm_mul_ps(e1_z, p_z));
+
+        // u = t . p, with t = origin - v0
+        const __m128 t_x = _mm_sub_ps(ray.origin_x, v0_x), t_y = _mm_sub_ps(ray.origin_y, v0_y), t_z = _mm_sub_ps(ray.origin_z, v0_z);
+        const __m128 u   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t_x, p_x), _mm_mul_ps(t_y, p_y)), _mm_mul_ps(t_z, p_z));
+
+        // q = t x edge1, v = direction . q
+        const __m128 q_x = _mm_sub_ps(_mm_mul_ps(t_y, e1_z), _mm_mul_ps(t_z, e1_y));
+        const __m128 q_y = _mm_sub_ps(_mm_mul_ps(t_z, e1_x), _mm_mul_ps(t_x, e1_z));
+        const __m128 q_z = _mm_sub_ps(_mm_mul_ps(t_x, e1_y), _mm_mul_ps(t_y, e1_x));
+        const __m128 v   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ray.direction_x, q_x), _mm_mul_ps(ray.direction_y, q_y)), _mm_mul_ps(ray.direction_z, q_z));
+
+        // distance = (edge2 . q) / det
+        const __m128 distance = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2_x, q_x), _mm_mul_ps(e2_y, q_y)), _mm_mul_ps(e2_z, q_z)), det);
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 valid = _mm_cmpge_ps(det, _mm_set1_ps(Helper::EPSILON));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(u, det));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), det));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(distance, zero));
+        valid = _mm_and_ps(valid, _mm_cmplt_ps(distance, _mm_set1_ps(*distance_best)));
+
+        const int mask = _mm_movemask_ps(valid);
+        if (mask == 0)
+            return;
+
+        alignas(16) float distances[4];
+        _mm_store_ps(distances, distance);
+        for (uint32_t lane = 0; lane < count; lane++)
+        {
+            if ((mask & (1 << lane)) && distances[lane] < *distance_best)
+            {
+                *distance_best = distances[lane];
+                *triangle_best = triangles[lane];
+            }
+        }
+    }
+
+    float intersect(const MeshBvhView& view, const Ray& ray, uint32_t* triangle)
+    {
+        if (!view.indices || !view.vertices || view.triangle_count == 0)
+            return Helper::INFINITY_;
+
+        const RaySimd ray_simd_ = ray_simd(ray);
+        float distance_best     = Helper::INFINITY_;
+        uint32_t triangle_best  = 0;
+
+        if (view.nodes)
+        {
+            // Front to back, the far child waits on the stack and gets skipped if something nearer was hit in the meantime
+            struct StackEntry
+            {
+                uint32_t node;
+                float distance;
+            };
+            StackEntry stack[bvh_depth_max];
+            uint32_t stack_size = 0;
+
+            float distance = 0.0f;
+            uint32_t node_index = 0;
+            bool visit = node_hit(view.nodes[0], ray_simd_, distance_best, &distance);
+            while (true)
+            {
+                if (visit)
+                {
+                    const BvhNode& node = view.nodes[node_index];
+                    if (node.IsLeaf())
+                    {
+                        triangles_hit(view, view.triangles + node.offset, node.count, ray_simd_, &distance_best, &triangle_best);
+                    }
+                    else
+                    {
+                        float distance_left     = 0.0f;
+                        float distance_right    = 0.0f;
+                        const bool hit_left     = node_hit(view.nodes[node.offset], ray_simd_, distance_best, &distance_left);
+                        const bool hit_right    = node_hit(view.nodes[node.offset + 1], ray_simd_, distance_best, &distance_right);
+
+                        if (hit_left && hit_right)
+                        {
+                            const bool left_first = distance_left <= distance_right;
+                            if (stack_size < bvh_depth_max)
+                            {
+                                stack[stack_size++] = { node.offset + (left_first ? 1 : 0), left_first ? distance_right : distance_left };
+                            }
+                            node_index = node.offset + (left_first ? 0 : 1);
+                            continue;
+                        }
+
+                        if (hit_left || hit_right)
+                        {
+                            node_index = node.offset + (hit_left ? 0 : 1);
+                            continue;
+                        }
+                    }
+                }
+
+                if (stack_size == 0)
+                    break;
+
+                const StackEntry& entry = stack[--stack_size];
+                node_index  = entry.node;
+                visit       = entry.distance < distance_best;
+            }
+        }
+        else
+        {
+            // No bvh, every triangle is tested (still four at a time)
+            for (uint32_t first = 0; first < view.triangle_count; first += 4)
+            {
+                const uint32_t count = Helper::Min(4u, view.triangle_count - first);
+                const uint32_t triangles[4] = { first, first + 1, first + 2, first + 3 };
+                triangles_hit(view, triangles, count, ray_simd_, &distance_best, &triangle_best);
+            }
+        }
+
+        if (triangle && distance_best != Helper::INFINITY_)
+        {
+            *triangle = triangle_best;
+        }
+
+        return distance_best;
+    }
+
+    void intersect(const MeshBvhView& view, const Ray* rays, const uint32_t ray_count, float* distances)
+    {
+        if (!rays || !distances)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        for (uint32_t i = 0; i < ray_count; i++)
+        {
+            distances[i] = intersect(view, rays[i]);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <cstddef>
+#include "../RHI/RHI_Definition.h"
+#include "../Math/Vector3.h"
+//================================
+
+namespace Spartan
+{
+    namespace Math { class Ray; }
+
+    // Leaves are tested with one simd intersection, so they have up to four triangles
+    static const uint32_t bvh_leaf_triangles_max = 4;
+
+    // The deepest a bvh can get, so that traversal can use a fixed size stack
+    static const uint32_t bvh_depth_max = 64;
+
+    // A node of a bounding volume hierarchy over the triangles of a mesh (mesh space). An inner node's children are next to each other,
+    // at offset and offset + 1, a leaf has count triangles starting at offset (in the bvh's triangle list).
+    struct BvhNode
+    {
+        Math::Vector3 min   = Math::Vector3::Zero;
+        uint32_t offset     = 0;
+        Math::Vector3 max   = Math::Vector3::Zero;
+        uint32_t count      = 0;  // zero for inner nodes
+
+        bool IsLeaf() const { return count != 0; }
+    };
+
+    // Where the bvh of a submesh is in the model's node and triangle lists, the offsets in the nodes are relative to these
+    struct MeshBvh
+    {
+        uint32_t node_offset        = 0;
+        uint32_t node_count         = 0;
+        uint32_t triangle_offset    = 0;
+        uint32_t triangle_count     = 0;
+    };
+
+    // A bvh as it comes out of the builder, before it's appended to a model
+    struct MeshBvhData
+    {
+        std::vector<BvhNode> nodes;
+        std::vector<uint32_t> triangles; // triangle indices (the first index of triangle t is at 3 * t), in leaf order
+    };
+
+    // The geometry that a ray query runs against, straight from where the model keeps it (nothing is copied). Without nodes, all of the triangles are tested.
+    struct MeshBvhView
+    {
+        const BvhNode* nodes        = nullptr;
+        const uint32_t* triangles   = nullptr;
+        const std::byte* indices    = nullptr; // uint32_t, relative to the vertices (not necessarily aligned)
+        const std::byte* vertices   = nullptr; // RHI_Vertex_PosTexNorTan (not necessarily aligned)
+        uint32_t triangle_count     = 0;
+    };
+
+    namespace MeshBvhHelper
+    {
+        // Builds a bvh with the surface area heuristic (binned), the indices are left as they are
+        void build(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<uint32_t>& indices, MeshBvhData* bvh);
+
+        // Returns the distance along the ray (mesh space) to the nearest front facing triangle, or infinity. Doesn't allocate, so it can be called from any thread.
+        float intersect(const MeshBvhView& view, const Math::Ray& ray, uint32_t* triangle = nullptr);
+
+        // The same for a batch of rays (e.g. a spread of gameplay traces against one mesh)
+        void intersect(const MeshBvhView& view, const Math::Ray* rays, uint32_t ray_count, float* distances);
+    }
+}
@@ -0,0 +1,439 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "MeshLod.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../Threading/Threading.h"
+//=============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::MeshLodHelper
+{
+    // Boundary edges are weighted higher than the surface, as moving them opens up visible gaps
+    static const double boundary_weight = 10.0;
+
+    // Switching to a coarser level requires the projected error to drop below this fraction of the threshold
+    static const float hysteresis = 0.75f;
+
+    // The (area weighted) sum of squared distances to a set of planes
+    struct Quadric
+    {
+        double xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+        double yy = 0.0, yz = 0.0, yw = 0.0;
+        double zz = 0.0, zw = 0.0;
+        double ww = 0.0;
+        double weight = 0.0;
+
+        void AddPlane(const Vector3& normal, const float distance, const double w)
+        {
+            const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+
+            xx += w * a * a; xy += w * a * b; xz += w * a * c; xw += w * a * d;
+            yy += w * b * b; yz += w * b * c; yw += w * b * d;
+            zz += w * c * c; zw += w * c * d;
+            ww += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric& q)
+        {
+            xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+            yy += q.yy; yz += q.yz; yw += q.yw;
+            zz += q.zz; zw += q.zw;
+            ww += q.ww;
+            weight += q.weight;
+        }
+
+        // Mean squared distance of a point to the planes
+        double Error(const Vector3& p) const
+        {
+            if (weight <= 0.0)
+                return 0.0;
+
+            const double x = p.x, y = p.y, z = p.z;
+            const double error = xx * x * x + yy * y * y + zz * z * z + 2.0 * (xy * x * y + xz * x * z + yz * y * z + xw * x + yw * y + zw * z) + ww;
+            return Helper::Max(error, 0.0) / weight;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    static Vector3 vertex_position(const RHI_Vertex_PosTexNorTan& vertex)
+    {
+        return Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+    }
+
+    static bool is_degenerate(const uint32_t* triangle)
+    {
+        return triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2];
+    }
+
+    float simplify(const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices, const uint32_t target_index_count, vector<uint32_t>* indices_out)
+    {
+        if (!indices_out)
+            return 0.0f;
+
+        *indices_out = indices;
+        if (indices.size() <= target_index_count || vertices.empty())
+            return 0.0f;
+
+        const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+
+        // Vertices which share a position (uv and normal seams) are simplified as one, so that the seams don't crack open.
+        // Each position is represented by one of its vertices and its vertices (wedges) are contiguous in sorted.
+        vector<uint32_t> sorted(vertex_count);
+        iota(sorted.begin(), sorted.end(), 0);
+        sort(sorted.begin(), sorted.end(), [&vertices](const uint32_t a, const uint32_t b)
+        {
+            const float* pa = vertices[a].pos;
+            const float* pb = vertices[b].pos;
+            if (pa[0] != pb[0]) return pa[0] < pb[0];
+            if (pa[1] != pb[1]) return pa[1] < pb[1];
+            return pa[2] < pb[2];
+        });
+
+        vector<uint32_t> remap(vertex_count);
+        vector<uint32_t> wedge_index(vertex_count);
+        vector<uint32_t> wedge_offsets;
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            const float* p      = vertices[sorted[i]].pos;
+            const float* p_prev = vertices[sorted[i == 0 ? 0 : i - 1]].pos;
+            if (i == 0 || p[0] != p_prev[0] || p[1] != p_prev[1] || p[2] != p_prev[2])
+            {
+                wedge_index[sorted[i]] = static_cast<uint32_t>(wedge_offsets.size());
+                wedge_offsets.emplace_back(i);
+            }
+
+            remap[sorted[i]] = sorted[wedge_offsets.back()];
+        }
+        wedge_offsets.emplace_back(vertex_count);
+
+        vector<Vector3> positions(vertex_count);
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            positions[i] = vertex_position(vertices[i]);
+        }
+
+        // Triangles in terms of representative vertices (tris), and in terms of the actual vertices to output (corners)
+        vector<uint32_t> tris;
+        vector<uint32_t> corners;
+        tris.reserve(indices.size());
+        corners.reserve(indices.size());
+        for (uint32_t i = 0; i + 2 < static_cast<uint32_t>(indices.size()); i += 3)
+        {
+            const uint32_t triangle[3] = { remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] };
+            if (is_degenerate(triangle))
+                continue;
+
+            tris.insert(tris.end(), triangle, triangle + 3);
+            corners.insert(corners.end(), indices.begin() + i, indices.begin() + i + 3);
+        }
+
+        // Quadrics of the triangle planes
+        vector<Quadric> quadrics(vertex_count);
+        vector<Vector3> face_normals(tris.size() / 3, Vector3::Zero);
+        for (uint32_t t = 0; t < static_cast<uint32_t>(tris.size() / 3); t++)
+        {
+            const uint32_t* triangle    = &tris[t * 3];
+            const Vector3& p0           = positions[triangle[0]];
+            Vector3 normal              = Vector3::Cross(positions[triangle[1]] - p0, positions[triangle[2]] - p0);
+            const float length          = normal.Length();
+            if (length <= 0.0f)
+                continue;
+
+            normal /= length;
+            face_normals[t] = normal;
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                quadrics[triangle[i]].AddPlane(normal, -Vector3::Dot(normal, p0), length * 0.5);
+            }
+        }
+
+        // Quadrics of the boundary edges (edges used by a single triangle), a plane perpendicular to the triangle keeps the edge in place
+        {
+            vector<pair<uint64_t, uint32_t>> edges;
+            edges.reserve(tris.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(tris.size()); i++)
+            {
+                const uint32_t a = tris[i];
+                const uint32_t b = tris[(i % 3 == 2) ? i - 2 : i + 1];
+                edges.emplace_back((static_cast<uint64_t>(Helper::Min(a, b)) << 32) | Helper::Max(a, b), i);
+            }
+            sort(edges.begin(), edges.end());
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(edges.size()); i++)
+            {
+                const bool shared = (i > 0 && edges[i - 1].first == edges[i].first) || (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+                if (shared)
+                    continue;
+
+                const uint32_t a        = static_cast<uint32_t>(edges[i].first >> 32);
+                const uint32_t b        = static_cast<uint32_t>(edges[i].first & 0xFFFFFFFF);
+                const Vector3 edge      = positions[b] - positions[a];
+                const Vector3 normal    = Vector3::Cross(edge, face_normals[edges[i].second / 3]).Normalized();
+                const double weight     = static_cast<double>(edge.LengthSquared()) * boundary_weight;
+
+                quadrics[a].AddPlane(normal, -Vector3::Dot(normal, positions[a]), weight);
+                quadrics[b].AddPlane(normal, -Vector3::Dot(normal, positions[a]), weight);
+            }
+        }
+
+        // Returns true if moving a vertex would flip any of the triangles around it
+        vector<uint32_t> adjacency_offsets(vertex_count + 1);
+        vector<uint32_t> adjacency;
+        const auto flips = [&](const uint32_t from, const uint32_t to)
+        {
+            for (uint32_t i = adjacency_offsets[from]; i < adjacency_offsets[from + 1]; i++)
+            {
+                const uint32_t* triangle = &tris[adjacency[i] * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    continue; // this one collapses
+
+                const Vector3& p0 = positions[triangle[0]];
+                const Vector3& p1 = positions[triangle[1]];
+                const Vector3& p2 = positions[triangle[2]];
+                const Vector3& q0 = positions[triangle[0] == from ? to : triangle[0]];
+                const Vector3& q1 = positions[triangle[1] == from ? to : triangle[1]];
+                const Vector3& q2 = positions[triangle[2] == from ? to : triangle[2]];
+
+                // Rotating a triangle by more than ~75 degrees counts as flipping, which also avoids slivers
+                const Vector3 normal_before = Vector3::Cross(p1 - p0, p2 - p0);
+                const Vector3 normal_after  = Vector3::Cross(q1 - q0, q2 - q0);
+                if (Vector3::Dot(normal_before, normal_after) <= 0.25f * normal_before.Length() * normal_after.Length())
+                    return true;
+            }
+
+            return false;
+        };
+
+        // Returns the vertex at a position whose attributes are the closest to the ones of a given vertex
+        const auto wedge_match = [&](const uint32_t vertex, const uint32_t representative)
+        {
+            const RHI_Vertex_PosTexNorTan& v = vertices[vertex];
+            const uint32_t wedge    = wedge_index[representative];
+            uint32_t match          = representative;
+            float match_score       = numeric_limits<float>::max();
+            for (uint32_t i = wedge_offsets[wedge]; i < wedge_offsets[wedge + 1]; i++)
+            {
+                const RHI_Vertex_PosTexNorTan& candidate = vertices[sorted[i]];
+                const float du      = candidate.tex[0] - v.tex[0];
+                const float dv      = candidate.tex[1] - v.tex[1];
+                const float dn      = 1.0f - (candidate.nor[0] * v.nor[0] + candidate.nor[1] * v.nor[1] + candidate.nor[2] * v.nor[2]);
+                const float score   = du * du + dv * dv + dn;
+                if (score < match_score)
+                {
+                    match_score = score;
+                    match       = sorted[i];
+                }
+            }
+
+            return match;
+        };
+
+        vector<uint32_t> collapse_target(vertex_count);
+        iota(collapse_target.begin(), collapse_target.end(), 0);
+        vector<bool> locked(vertex_count);
+        vector<Collapse> collapses;
+        double error_max = 0.0;
+
+        // Every pass collapses the cheapest edges which don't touch each other, until the target is reached
+        while (tris.size() > target_index_count)
+        {
+            // Vertex to triangle adjacency
+            fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (const uint32_t vertex : tris)
+            {
+                adjacency_offsets[vertex + 1]++;
+            }
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                adjacency_offsets[i + 1] += adjacency_offsets[i];
+            }
+            adjacency.resize(tris.size());
+            {
+                vector<uint32_t> cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (uint32_t i = 0; i < static_cast<uint32_t>(tris.size()); i++)
+                {
+                    adjacency[cursors[tris[i]]++] = i / 3;
+                }
+            }
+
+            // One candidate per edge, in the cheaper direction
+            collapses.clear();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(tris.size()); i++)
+            {
+                const uint32_t a = tris[i];
+                const uint32_t b = tris[(i % 3 == 2) ? i - 2 : i + 1];
+
+                Quadric quadric = quadrics[a];
+                quadric.Add(quadrics[b]);
+                const double error_a_to_b = quadric.Error(positions[b]);
+                const double error_b_to_a = quadric.Error(positions[a]);
+
+                collapses.push_back(error_a_to_b <= error_b_to_a ? Collapse{ a, b, error_a_to_b } : Collapse{ b, a, error_b_to_a });
+            }
+            sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            fill(locked.begin(), locked.end(), false);
+            const uint32_t triangles_to_remove  = static_cast<uint32_t>(tris.size() - target_index_count) / 3;
+            uint32_t triangles_removed          = 0;
+            bool collapsed                      = false;
+            for (const Collapse& collapse : collapses)
+            {
+                if (locked[collapse.from] || locked[collapse.to] || flips(collapse.from, collapse.to))
+                    continue;
+
+                // The vertices of the affected triangles are locked, so the flip tests of this pass stay valid
+                for (uint32_t i = adjacency_offsets[collapse.from]; i < adjacency_offsets[collapse.from + 1]; i++)
+                {
+                    const uint32_t* triangle = &tris[adjacency[i] * 3];
+                    triangles_removed += (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) ? 1 : 0;
+                    locked[triangle[0]] = locked[triangle[1]] = locked[triangle[2]] = true;
+                }
+
+                collapse_target[collapse.from] = collapse.to;
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                error_max = Helper::Max(error_max, collapse.error);
+                collapsed = true;
+
+                if (triangles_removed >= triangles_to_remove)
+                    break;
+            }
+
+            if (!collapsed)
+                break;
+
+            // Apply the collapses and drop the triangles which degenerated
+            uint32_t write = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(tris.size()); i += 3)
+            {
+                uint32_t triangle[3];
+                uint32_t triangle_corners[3];
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    triangle[j]         = collapse_target[tris[i + j]];
+                    triangle_corners[j] = triangle[j] == tris[i + j] ? corners[i + j] : wedge_match(corners[i + j], triangle[j]);
+                }
+
+                if (is_degenerate(triangle))
+                    continue;
+
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    tris[write + j]     = triangle[j];
+                    corners[write + j]  = triangle_corners[j];
+                }
+                write += 3;
+            }
+            tris.resize(write);
+            corners.resize(write);
+        }
+
+        *indices_out = move(corners);
+        return static_cast<float>(Helper::Sqrt(error_max));
+    }
+
+    void build_chain(Threading* threading, const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices, const uint32_t lod_count, vector<uint32_t>* indices_lods, vector<MeshLod>* lods)
+    {
+        // Meshes with only a few triangles are cheap enough as they are
+        if (!indices_lods || !lods || lod_count < 2 || indices.size() < 3 * 256)
+            return;
+
+        // The levels are independent (each one is simplified from the full detail mesh) so they are spread across threads
+        const uint32_t level_count  = lod_count - 1;
+        const uint32_t index_count  = static_cast<uint32_t>(indices.size());
+        vector<vector<uint32_t>> levels_indices(level_count);
+        vector<float> levels_error(level_count, 0.0f);
+
+        const auto simplify_level = [&](const uint32_t level)
+        {
+            const uint32_t target_index_count = ((index_count / 3) >> (level + 1)) * 3;
+            levels_error[level] = simplify(vertices, indices, target_index_count, &levels_indices[level]);
+        };
+
+        if (threading)
+        {
+            threading->ParallelFor(level_count, simplify_level);
+        }
+        else
+        {
+            for (uint32_t level = 0; level < level_count; level++)
+            {
+                simplify_level(level);
+            }
+        }
+
+        // Keep the levels which simplified meaningfully, with errors that increase along the chain
+        uint32_t index_count_previous   = index_count;
+        float error_previous            = 0.0f;
+        for (uint32_t level = 0; level < level_count; level++)
+        {
+            const vector<uint32_t>& level_indices = levels_indices[level];
+            if (level_indices.empty() || level_indices.size() > index_count_previous * 3 / 4)
+                continue;
+
+            MeshLod lod;
+            lod.index_offset    = static_cast<uint32_t>(indices_lods->size());
+            lod.index_count     = static_cast<uint32_t>(level_indices.size());
+            lod.error           = Helper::Max(levels_error[level], error_previous);
+            lods->emplace_back(lod);
+            indices_lods->insert(indices_lods->end(), level_indices.begin(), level_indices.end());
+
+            index_count_previous    = lod.index_count;
+            error_previous          = lod.error;
+        }
+    }
+
+    uint32_t select(const MeshLod* lods, const uint32_t lod_count, const float error_to_pixels, const float threshold_pixels, const uint32_t lod_current)
+    {
+        if (!lods)
+            return 0;
+
+        // The coarsest level with an acceptable error
+        uint32_t lod = 0;
+        while (lod < lod_count && lods[lod].error * error_to_pixels <= threshold_pixels)
+        {
+            lod++;
+        }
+
+        // Only become coarser than the current level once the error is comfortably acceptable
+        while (lod > lod_current && lods[lod - 1].error * error_to_pixels > threshold_pixels * hysteresis)
+        {
+            lod--;
+        }
+
+        return lod;
+    }
+}
@@ -0,0 +1,62 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../RHI/RHI_Definition.h"
+//================================
+
+namespace Spartan
+{
+    class Threading;
+
+    // A lower level of detail of a mesh, it shares the mesh's vertices and only has its own indices
+    struct MeshLod
+    {
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+        float error             = 0.0f; // the largest deviation from the full detail mesh (model space distance)
+    };
+
+    namespace MeshLodHelper
+    {
+        // Collapses edges (quadric error metrics) until the index count drops to the target, returns the error (model space distance)
+        float simplify(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<uint32_t>& indices, uint32_t target_index_count, std::vector<uint32_t>* indices_out);
+
+        // Simplifies the levels of a LOD chain in parallel, every level has half the triangles of the previous one.
+        // The indices of all the levels are appended to indices_lods (excluding the full detail level) and the index offsets of the levels are relative to it.
+        void build_chain(
+            Threading* threading,
+            const std::vector<RHI_Vertex_PosTexNorTan>& vertices,
+            const std::vector<uint32_t>& indices,
+            uint32_t lod_count,
+            std::vector<uint32_t>* indices_lods,
+            std::vector<MeshLod>* lods
+        );
+
+        // Returns the level to render (0 is the full detail mesh and 1 is the first entry in lods), based on the error that each level would project on the screen.
+        // Switching to a coarser level requires the error to be well below the threshold, so that objects near the switching distance don't flicker between levels.
+        uint32_t select(const MeshLod* lods, uint32_t lod_count, float error_to_pixels, float threshold_pixels, uint32_t lod_current);
+    }
+}
@@ -0,0 +1,424 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =================
+#include "Spartan.h"
+#include "MeshOptimizer.h"
+#include "../RHI/RHI_Vertex.h"
+//============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::MeshOptimizer
+{
+    static const uint32_t invalid_index = numeric_limits<uint32_t>::max();
+
+    // A cluster may be up to this much less cache efficient than the hard cluster it's split from
+    static const float cluster_acmr_threshold = 1.05f;
+
+    static Vector3 vertex_position(const RHI_Vertex_PosTexNorTan& vertex)
+    {
+        return Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+    }
+
+    // Simulates a FIFO cache, a vertex is a hit if it was transformed within the last vertex_cache_size misses
+    static bool cache_miss(vector<uint32_t>& cache_time, uint32_t& time, const uint32_t vertex)
+    {
+        if (time - cache_time[vertex] > vertex_cache_size)
+        {
+            cache_time[vertex] = time++;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Hard clusters (where Tipsify had to restart with a cold cache) tend to be large, a connected mesh is a single one. So they are split wherever the
+    // cache efficiency so far is close to the cluster's overall efficiency (Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+    static void split_clusters(const vector<uint32_t>& indices, const uint32_t vertex_count, vector<uint32_t>* cluster_offsets)
+    {
+        const vector<uint32_t> hard_offsets = *cluster_offsets;
+        cluster_offsets->clear();
+
+        vector<uint32_t> cache_time(vertex_count, 0);
+        uint32_t time = vertex_cache_size + 1;
+
+        for (uint32_t cluster = 0; cluster < static_cast<uint32_t>(hard_offsets.size()); cluster++)
+        {
+            const uint32_t start    = hard_offsets[cluster];
+            const uint32_t end      = cluster + 1 < hard_offsets.size() ? hard_offsets[cluster + 1] : static_cast<uint32_t>(indices.size());
+
+            // Efficiency of the whole cluster, starting with a cold cache
+            time += vertex_cache_size + 1;
+            uint32_t misses = 0;
+            for (uint32_t i = start; i < end; i++)
+            {
+                misses += cache_miss(cache_time, time, indices[i]) ? 1 : 0;
+            }
+            const float acmr = static_cast<float>(misses) / static_cast<float>((end - start) / 3);
+
+            // Split
+            time += vertex_cache_size + 1;
+            cluster_offsets->emplace_back(start);
+            uint32_t cluster_misses     = 0;
+            uint32_t cluster_triangles  = 0;
+            for (uint32_t i = start; i < end; i += 3)
+            {
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    cluster_misses += cache_miss(cache_time, time, indices[i + j]) ? 1 : 0;
+                }
+                cluster_triangles++;
+
+                if (i + 3 < end && static_cast<float>(cluster_misses) <= cluster_acmr_threshold * acmr * static_cast<float>(cluster_triangles))
+                {
+                    cluster_offsets->emplace_back(i + 3);
+                    cluster_misses      = 0;
+                    cluster_triangles   = 0;
+
+                    // Once reordered, the cluster can't count on what's in the cache
+                    time += vertex_cache_size + 1;
+                }
+            }
+        }
+    }
+
+    Statistics analyze(const vector<uint32_t>& indices, const uint32_t vertex_count)
+    {
+        Statistics statistics;
+        statistics.triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+        vector<uint32_t> cache_time(vertex_count, 0);
+        vector<bool> referenced(vertex_count, false);
+        uint32_t time = vertex_cache_size + 1;
+        for (const uint32_t index : indices)
+        {
+            if (index >= vertex_count)
+                continue;
+
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                statistics.vertex_count++;
+            }
+
+            statistics.cache_miss_count += cache_miss(cache_time, time, index) ? 1 : 0;
+        }
+
+        return statistics;
+    }
+
+    void optimize_vertex_cache(vector<uint32_t>* indices, const uint32_t vertex_count, vector<uint32_t>* cluster_offsets)
+    {
+        if (!indices || indices->size() < 3 || vertex_count == 0)
+            return;
+
+        const vector<uint32_t> input    = *indices;
+        const uint32_t triangle_count   = static_cast<uint32_t>(input.size() / 3);
+
+        // Vertex to triangle adjacency, and how many of the triangles of each vertex are yet to be emitted
+        vector<uint32_t> live(vertex_count, 0);
+        for (uint32_t i = 0; i < triangle_count * 3; i++)
+        {
+            live[input[i]]++;
+        }
+        vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            adjacency_offsets[i + 1] = adjacency_offsets[i] + live[i];
+        }
+        vector<uint32_t> adjacency(triangle_count * 3);
+        {
+            vector<uint32_t> cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (uint32_t i = 0; i < triangle_count * 3; i++)
+            {
+                adjacency[cursors[input[i]]++] = i / 3;
+            }
+        }
+
+        vector<uint32_t> cache_time(vertex_count, 0);
+        uint32_t time = vertex_cache_size + 1;
+        vector<bool> emitted(triangle_count, false);
+        vector<uint32_t> dead_ends;
+        vector<uint32_t> candidates;
+        uint32_t cursor = 0;
+
+        indices->clear();
+        if (cluster_offsets)
+        {
+            cluster_offsets->assign(1, 0);
+        }
+
+        // Fan around a vertex, emitting all of its remaining triangles
+        uint32_t fanning = input[0];
+        while (fanning != invalid_index)
+        {
+            candidates.clear();
+            for (uint32_t i = adjacency_offsets[fanning]; i < adjacency_offsets[fanning + 1]; i++)
+            {
+                const uint32_t triangle = adjacency[i];
+                if (emitted[triangle])
+                    continue;
+
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    const uint32_t vertex = input[triangle * 3 + j];
+                    indices->emplace_back(vertex);
+                    dead_ends.emplace_back(vertex);
+                    candidates.emplace_back(vertex);
+                    live[vertex]--;
+                    cache_miss(cache_time, time, vertex);
+                }
+
+                emitted[triangle] = true;
+            }
+
+            // Continue with the candidate which has been in the cache the longest, as long as its remaining triangles can be emitted before it gets evicted
+            uint32_t next           = invalid_index;
+            int64_t next_priority   = -1;
+            for (const uint32_t vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (time - cache_time[vertex] + 2 * live[vertex] <= vertex_cache_size)
+                {
+                    priority = time - cache_time[vertex];
+                }
+
+                if (priority > next_priority)
+                {
+                    next_priority   = priority;
+                    next            = vertex;
+                }
+            }
+
+            // Dead end, continue with a recently used vertex
+            while (next == invalid_index && !dead_ends.empty())
+            {
+                const uint32_t vertex = dead_ends.back();
+                dead_ends.pop_back();
+                if (live[vertex] > 0)
+                {
+                    next = vertex;
+                }
+            }
+
+            // Nothing recent is left, continue in input order with a cold cache (a hard cluster boundary)
+            if (next == invalid_index)
+            {
+                while (cursor < vertex_count && live[cursor] == 0)
+                {
+                    cursor++;
+                }
+
+                if (cursor < vertex_count)
+                {
+                    next = cursor;
+
+                    if (cluster_offsets)
+                    {
+                        cluster_offsets->emplace_back(static_cast<uint32_t>(indices->size()));
+                    }
+                }
+            }
+
+            fanning = next;
+        }
+
+        if (cluster_offsets)
+        {
+            split_clusters(*indices, vertex_count, cluster_offsets);
+        }
+    }
+
+    void optimize_vertex_cache_ranges(vector<uint32_t>* indices, const uint32_t vertex_count, const vector<uint32_t>& range_offsets)
+    {
+        if (!indices)
+            return;
+
+        // Each range is optimized with its own (compact) vertex numbering, so that the cost is proportional to the range and not to the whole mesh
+        vector<uint32_t> vertex_local(vertex_count, invalid_index);
+        vector<uint32_t> vertex_global;
+        vector<uint32_t> range;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(range_offsets.size()); i++)
+        {
+            const uint32_t start    = range_offsets[i];
+            const uint32_t end      = i + 1 < range_offsets.size() ? range_offsets[i + 1] : static_cast<uint32_t>(indices->size());
+
+            range.assign(indices->begin() + start, indices->begin() + end);
+            vertex_global.clear();
+            for (uint32_t& index : range)
+            {
+                if (vertex_local[index] == invalid_index)
+                {
+                    vertex_local[index] = static_cast<uint32_t>(vertex_global.size());
+                    vertex_global.emplace_back(index);
+                }
+
+                index = vertex_local[index];
+            }
+
+            optimize_vertex_cache(&range, static_cast<uint32_t>(vertex_global.size()));
+
+            for (uint32_t j = 0; j < static_cast<uint32_t>(range.size()); j++)
+            {
+                (*indices)[start + j] = vertex_global[range[j]];
+            }
+
+            for (const uint32_t vertex : vertex_global)
+            {
+                vertex_local[vertex] = invalid_index;
+            }
+        }
+    }
+
+    void optimize_overdraw(const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t>* indices, const vector<uint32_t>& cluster_offsets)
+    {
+        if (!indices || cluster_offsets.size() < 2)
+            return;
+
+        struct Cluster
+        {
+            uint32_t offset;
+            uint32_t count;
+            Vector3 center;
+            Vector3 normal;
+            float sort_key;
+        };
+
+        const vector<uint32_t>& input = *indices;
+
+        // Area weighted center and normal of each cluster, and of the whole mesh
+        vector<Cluster> clusters(cluster_offsets.size());
+        Vector3 mesh_center = Vector3::Zero;
+        float mesh_area     = 0.0f;
+        for (uint32_t c = 0; c < static_cast<uint32_t>(clusters.size()); c++)
+        {
+            Cluster& cluster    = clusters[c];
+            cluster.offset      = cluster_offsets[c];
+            cluster.count       = (c + 1 < cluster_offsets.size() ? cluster_offsets[c + 1] : static_cast<uint32_t>(input.size())) - cluster.offset;
+            cluster.center      = Vector3::Zero;
+            cluster.normal      = Vector3::Zero;
+
+            float cluster_area = 0.0f;
+            for (uint32_t i = cluster.offset; i < cluster.offset + cluster.count; i += 3)
+            {
+                const Vector3 p0        = vertex_position(vertices[input[i + 0]]);
+                const Vector3 p1        = vertex_position(vertices[input[i + 1]]);
+                const Vector3 p2        = vertex_position(vertices[input[i + 2]]);
+                const Vector3 normal    = Vector3::Cross(p1 - p0, p2 - p0); // its length is twice the area
+                const float area        = normal.Length() * 0.5f;
+
+                cluster.center  += (p0 + p1 + p2) * (area / 3.0f);
+                cluster.normal  += normal;
+                cluster_area    += area;
+            }
+
+            mesh_center += cluster.center;
+            mesh_area   += cluster_area;
+
+            if (cluster_area > 0.0f)
+            {
+                cluster.center /= cluster_area;
+            }
+            cluster.normal.Normalize();
+        }
+
+        if (mesh_area > 0.0f)
+        {
+            mesh_center /= mesh_area;
+        }
+
+        // Clusters which are far out and face away from the center come first
+        for (Cluster& cluster : clusters)
+        {
+            cluster.sort_key = Vector3::Dot(cluster.center - mesh_center, cluster.normal);
+        }
+        stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+        vector<uint32_t> output;
+        output.reserve(input.size());
+        for (const Cluster& cluster : clusters)
+        {
+            output.insert(output.end(), input.begin() + cluster.offset, input.begin() + cluster.offset + cluster.count);
+        }
+
+        *indices = move(output);
+    }
+
+    void optimize_vertex_fetch(vector<RHI_Vertex_PosTexNorTan>* vertices, vector<uint32_t>* indices, vector<uint32_t>* vertex_remap)
+    {
+        if (!vertices || !indices)
+            return;
+
+        // Number the vertices in the order of their first use, unused vertices go last
+        vector<uint32_t> remap(vertices->size(), invalid_index);
+        uint32_t vertex_next = 0;
+        for (const uint32_t index : *indices)
+        {
+            if (remap[index] == invalid_index)
+            {
+                remap[index] = vertex_next++;
+            }
+        }
+        for (uint32_t& vertex : remap)
+        {
+            if (vertex == invalid_index)
+            {
+                vertex = vertex_next++;
+            }
+        }
+
+        vector<RHI_Vertex_PosTexNorTan> output(vertices->size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(vertices->size()); i++)
+        {
+            output[remap[i]] = (*vertices)[i];
+        }
+        for (uint32_t& index : *indices)
+        {
+            index = remap[index];
+        }
+
+        *vertices = move(output);
+
+        if (vertex_remap)
+        {
+            *vertex_remap = move(remap);
+        }
+    }
+
+    void optimize(vector<RHI_Vertex_PosTexNorTan>* vertices, vector<uint32_t>* indices, vector<uint32_t>* remap)
+    {
+        if (!vertices || !indices || vertices->empty() || indices->size() < 3)
+            return;
+
+        vector<uint32_t> cluster_offsets;
+        optimize_vertex_cache(indices, static_cast<uint32_t>(vertices->size()), &cluster_offsets);
+        optimize_overdraw(*vertices, indices, cluster_offsets);
+        optimize_vertex_fetch(vertices, indices, remap);
+    }
+}
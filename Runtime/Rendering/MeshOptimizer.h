@@ -0,0 +1,77 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../RHI/RHI_Definition.h"
+//================================
+
+namespace Spartan
+{
+    // Index and vertex reordering, so that the gpu transforms, shades and fetches as little as possible
+    namespace MeshOptimizer
+    {
+        // The size of the post-transform vertex cache that is optimized for (modelled as a FIFO)
+        static const uint32_t vertex_cache_size = 16;
+
+        // Vertex cache statistics of an index buffer
+        struct Statistics
+        {
+            uint32_t triangle_count     = 0;
+            uint32_t vertex_count       = 0; // unique vertices referenced by the indices
+            uint32_t cache_miss_count   = 0;
+
+            // Average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large grids, 3.0 is the worst)
+            float GetAcmr() const { return triangle_count == 0 ? 0.0f : static_cast<float>(cache_miss_count) / static_cast<float>(triangle_count); }
+
+            // Average transform to vertex ratio, how many times each vertex gets transformed (1.0 is ideal)
+            float GetAtvr() const { return vertex_count == 0 ? 0.0f : static_cast<float>(cache_miss_count) / static_cast<float>(vertex_count); }
+
+            void Add(const Statistics& statistics)
+            {
+                triangle_count      += statistics.triangle_count;
+                vertex_count        += statistics.vertex_count;
+                cache_miss_count    += statistics.cache_miss_count;
+            }
+        };
+
+        Statistics analyze(const std::vector<uint32_t>& indices, uint32_t vertex_count);
+
+        // Reorders the triangles for the vertex cache (Tipsify), cluster_offsets receives the index offsets of the clusters that optimize_overdraw() can reorder
+        void optimize_vertex_cache(std::vector<uint32_t>* indices, uint32_t vertex_count, std::vector<uint32_t>* cluster_offsets = nullptr);
+
+        // Reorders the triangles of each range (e.g. a meshlet or a level of detail) for the vertex cache, without moving any triangles between ranges
+        void optimize_vertex_cache_ranges(std::vector<uint32_t>* indices, uint32_t vertex_count, const std::vector<uint32_t>& range_offsets);
+
+        // Draws the clusters which face away from the center of the mesh first, as they are the most likely to occlude the rest of the mesh
+        void optimize_overdraw(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<uint32_t>* indices, const std::vector<uint32_t>& cluster_offsets);
+
+        // Reorders the vertices in the order that the indices first reference them, so that the vertex fetches are mostly sequential.
+        // The remap receives where each vertex went, for data that is kept next to the vertices (e.g. bone weights).
+        void optimize_vertex_fetch(std::vector<RHI_Vertex_PosTexNorTan>* vertices, std::vector<uint32_t>* indices, std::vector<uint32_t>* remap = nullptr);
+
+        // Runs all of the above, in the order that they have to run in
+        void optimize(std::vector<RHI_Vertex_PosTexNorTan>* vertices, std::vector<uint32_t>* indices, std::vector<uint32_t>* remap = nullptr);
+    }
+}
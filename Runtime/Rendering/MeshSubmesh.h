@@ -0,0 +1,42 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include "../Math/BoundingBox.h"
+//==============================
+
+namespace Spartan
+{
+    // A part of a model which was appended as a whole (e.g. one imported mesh), it's the unit that geometry streaming loads and evicts.
+    // The indices of its lower levels of detail were appended after the full detail ones, so they have a range of their own.
+    struct MeshSubmesh
+    {
+        Math::BoundingBox aabb;             // model space
+        uint32_t index_offset       = 0;
+        uint32_t index_count        = 0;
+        uint32_t vertex_offset      = 0;
+        uint32_t vertex_count       = 0;
+        uint32_t lod_index_offset   = 0;
+        uint32_t lod_index_count    = 0;
+    };
+}
@@ -0,0 +1,287 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =============
+#include "Spartan.h"
+#include "Meshlet.h"
+#include "../RHI/RHI_Vertex.h"
+//========================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::MeshletHelper
+{
+    static Vector3 vertex_position(const RHI_Vertex_PosTexNorTan& vertex)
+    {
+        return Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+    }
+
+    static void compute_bounds(const vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t* indices, vector<Vector3>& normals, Meshlet& meshlet)
+    {
+        // Bounding sphere, centered on the bounding box of the triangles
+        Vector3 min = Vector3::Infinity;
+        Vector3 max = Vector3::InfinityNeg;
+        for (uint32_t i = 0; i < meshlet.index_count; i++)
+        {
+            const Vector3 position = vertex_position(vertices[indices[i]]);
+            min = Vector3(Helper::Min(min.x, position.x), Helper::Min(min.y, position.y), Helper::Min(min.z, position.z));
+            max = Vector3(Helper::Max(max.x, position.x), Helper::Max(max.y, position.y), Helper::Max(max.z, position.z));
+        }
+
+        meshlet.center = (min + max) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (uint32_t i = 0; i < meshlet.index_count; i++)
+        {
+            meshlet.radius = Helper::Max(meshlet.radius, Vector3::Distance(meshlet.center, vertex_position(vertices[indices[i]])));
+        }
+
+        // Normal cone, the axis is the average of the face normals (clockwise winding) and the spread is the widest normal
+        normals.clear();
+        Vector3 axis = Vector3::Zero;
+        for (uint32_t i = 0; i < meshlet.index_count; i += 3)
+        {
+            const Vector3 p0 = vertex_position(vertices[indices[i + 0]]);
+            const Vector3 p1 = vertex_position(vertices[indices[i + 1]]);
+            const Vector3 p2 = vertex_position(vertices[indices[i + 2]]);
+
+            const Vector3 normal    = Vector3::Cross(p1 - p0, p2 - p0);
+            const float length      = normal.Length();
+            if (length <= Helper::EPSILON)
+                continue; // degenerate
+
+            normals.emplace_back(normal / length);
+            axis += normals.back();
+        }
+
+        meshlet.cone_axis   = Vector3::Zero;
+        meshlet.cone_cutoff = 1.0f;
+
+        const float axis_length = axis.Length();
+        if (normals.empty() || axis_length <= Helper::EPSILON)
+            return;
+
+        axis /= axis_length;
+        float min_dot = 1.0f;
+        for (const Vector3& normal : normals)
+        {
+            min_dot = Helper::Min(min_dot, Vector3::Dot(normal, axis));
+        }
+
+        // Cones wider than ~85 degrees hardly ever get culled, so they are left disabled
+        meshlet.cone_axis = axis;
+        if (min_dot > 0.1f)
+        {
+            meshlet.cone_cutoff = Helper::Sqrt(1.0f - min_dot * min_dot);
+        }
+    }
+
+    void build(const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t>* indices, vector<Meshlet>* meshlets)
+    {
+        if (!indices || !meshlets || indices->size() < 3)
+            return;
+
+        const vector<uint32_t>& indices_in  = *indices;
+        const uint32_t vertex_count         = static_cast<uint32_t>(vertices.size());
+        const uint32_t triangle_count       = static_cast<uint32_t>(indices_in.size() / 3);
+
+        // Vertex to triangle adjacency
+        vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (uint32_t i = 0; i < triangle_count * 3; i++)
+        {
+            adjacency_offsets[indices_in[i] + 1]++;
+        }
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            adjacency_offsets[i + 1] += adjacency_offsets[i];
+        }
+        vector<uint32_t> adjacency(triangle_count * 3);
+        {
+            vector<uint32_t> cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (uint32_t i = 0; i < triangle_count * 3; i++)
+            {
+                adjacency[cursors[indices_in[i]]++] = i / 3;
+            }
+        }
+
+        vector<uint32_t> indices_out;
+        indices_out.reserve(indices_in.size());
+        vector<bool> emitted(triangle_count, false);
+        vector<uint32_t> vertex_meshlet(vertex_count, numeric_limits<uint32_t>::max()); // the last meshlet that a vertex was added to
+        vector<uint32_t> meshlet_vertices;
+        meshlet_vertices.reserve(meshlet_max_vertices);
+        vector<Vector3> normals;
+        normals.reserve(meshlet_max_triangles);
+
+        Meshlet meshlet;
+        uint32_t meshlet_index      = 0;
+        uint32_t triangle_cursor    = 0;
+
+        const auto new_vertex_count = [&](const uint32_t triangle)
+        {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                count += vertex_meshlet[indices_in[triangle * 3 + i]] != meshlet_index ? 1 : 0;
+            }
+            return count;
+        };
+
+        const auto flush = [&]()
+        {
+            if (meshlet.index_count == 0)
+                return;
+
+            compute_bounds(vertices, &indices_out[meshlet.index_offset], normals, meshlet);
+            meshlets->emplace_back(meshlet);
+
+            meshlet_vertices.clear();
+            meshlet.index_offset = static_cast<uint32_t>(indices_out.size());
+            meshlet.index_count  = 0;
+            meshlet_index++;
+        };
+
+        for (uint32_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+        {
+            // Grow the meshlet with the neighbouring triangle which adds the fewest vertices
+            uint32_t triangle   = numeric_limits<uint32_t>::max();
+            uint32_t best_cost  = numeric_limits<uint32_t>::max();
+            for (const uint32_t vertex : meshlet_vertices)
+            {
+                for (uint32_t i = adjacency_offsets[vertex]; i < adjacency_offsets[vertex + 1] && best_cost != 0; i++)
+                {
+                    const uint32_t candidate = adjacency[i];
+                    if (emitted[candidate])
+                        continue;
+
+                    const uint32_t cost = new_vertex_count(candidate);
+                    if (cost < best_cost)
+                    {
+                        best_cost   = cost;
+                        triangle    = candidate;
+                    }
+                }
+
+                if (best_cost == 0)
+                    break;
+            }
+
+            // No connected triangles left, continue in index order which tends to be spatially coherent
+            if (triangle == numeric_limits<uint32_t>::max())
+            {
+                while (emitted[triangle_cursor])
+                {
+                    triangle_cursor++;
+                }
+                triangle = triangle_cursor;
+            }
+
+            // Start a new meshlet if this triangle doesn't fit
+            if (static_cast<uint32_t>(meshlet_vertices.size()) + new_vertex_count(triangle) > meshlet_max_vertices || meshlet.index_count / 3 + 1 > meshlet_max_triangles)
+            {
+                flush();
+            }
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const uint32_t vertex = indices_in[triangle * 3 + i];
+                if (vertex_meshlet[vertex] != meshlet_index)
+                {
+                    vertex_meshlet[vertex] = meshlet_index;
+                    meshlet_vertices.emplace_back(vertex);
+                }
+                indices_out.emplace_back(vertex);
+            }
+
+            emitted[triangle] = true;
+            meshlet.index_count += 3;
+        }
+        flush();
+
+        *indices = move(indices_out);
+    }
+
+    void cull(const Meshlet* meshlets, const uint32_t meshlet_count, const Matrix& transform, const MeshletView& view, vector<MeshletRange>* ranges)
+    {
+        if (!meshlets || !view.frustum || !ranges)
+            return;
+
+        // Spheres scale with the largest axis, while cones are only valid under uniform scaling which doesn't mirror the winding
+        const Vector3 scale         = transform.GetScale().Abs();
+        const float scale_max       = Helper::Max3(scale.x, scale.y, scale.z);
+        const float determinant     =
+            transform.m00 * (transform.m11 * transform.m22 - transform.m12 * transform.m21) -
+            transform.m01 * (transform.m10 * transform.m22 - transform.m12 * transform.m20) +
+            transform.m02 * (transform.m10 * transform.m21 - transform.m11 * transform.m20);
+        const bool cone_culling     =
+            view.backface_culling &&
+            determinant > 0.0f &&
+            Helper::Equals(scale.x, scale.y, scale_max * 0.01f) &&
+            Helper::Equals(scale.x, scale.z, scale_max * 0.01f);
+
+        for (uint32_t i = 0; i < meshlet_count; i++)
+        {
+            const Meshlet& meshlet  = meshlets[i];
+            const Vector3 center    = meshlet.center * transform;
+            const float radius      = meshlet.radius * scale_max;
+
+            if (!view.frustum->IsVisible(center, radius, view.ignore_depth_planes))
+                continue;
+
+            if (cone_culling && meshlet.cone_cutoff < 1.0f)
+            {
+                const Vector3& a    = meshlet.cone_axis;
+                const Vector3 axis  = Vector3(
+                    a.x * transform.m00 + a.y * transform.m10 + a.z * transform.m20,
+                    a.x * transform.m01 + a.y * transform.m11 + a.z * transform.m21,
+                    a.x * transform.m02 + a.y * transform.m12 + a.z * transform.m22
+                ).Normalized();
+
+                bool back_facing = false;
+                if (view.orthographic)
+                {
+                    back_facing = Vector3::Dot(view.direction, axis) >= meshlet.cone_cutoff;
+                }
+                else
+                {
+                    const Vector3 to_center = center - view.position;
+                    back_facing = Vector3::Dot(to_center, axis) >= meshlet.cone_cutoff * to_center.Length() + radius;
+                }
+
+                if (back_facing)
+                    continue;
+            }
+
+            // Merge with the previous range if contiguous
+            if (!ranges->empty() && ranges->back().index_offset + ranges->back().index_count == meshlet.index_offset)
+            {
+                ranges->back().index_count += meshlet.index_count;
+            }
+            else
+            {
+                ranges->push_back({ meshlet.index_offset, meshlet.index_count });
+            }
+        }
+    }
+}
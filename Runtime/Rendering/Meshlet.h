@@ -0,0 +1,80 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../RHI/RHI_Definition.h"
+#include "../Math/Vector3.h"
+//================================
+
+namespace Spartan
+{
+    namespace Math
+    {
+        class Matrix;
+        class Frustum;
+    }
+
+    // Meshlet size limits, small enough to be culled tightly and large enough to keep the draw count low
+    static const uint32_t meshlet_max_vertices  = 64;
+    static const uint32_t meshlet_max_triangles = 124;
+
+    // A cluster of neighbouring triangles, whose indices are contiguous in the model's index buffer
+    struct Meshlet
+    {
+        Math::Vector3 center    = Math::Vector3::Zero;  // bounding sphere (model space)
+        float radius            = 0.0f;
+        Math::Vector3 cone_axis = Math::Vector3::Zero;  // average facing direction of the triangles (model space)
+        float cone_cutoff       = 1.0f;                 // sine of the cone's spread, 1.0 means that the cone can't be used for culling
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+    };
+
+    // A contiguous range of indices, made up of consecutive visible meshlets
+    struct MeshletRange
+    {
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+    };
+
+    // The view meshlets are culled against
+    struct MeshletView
+    {
+        const Math::Frustum* frustum    = nullptr;
+        Math::Vector3 position          = Math::Vector3::Zero;  // perspective views
+        Math::Vector3 direction         = Math::Vector3::Zero;  // orthographic views, e.g. directional light cascades
+        bool orthographic               = false;
+        bool ignore_depth_planes        = false;                // keeps shadow casters which are behind the light's near plane
+        bool backface_culling           = true;                 // has to match the rasterizer state of the pass
+    };
+
+    namespace MeshletHelper
+    {
+        // Reorders the triangles of a mesh into meshlets and appends them (index offsets are relative to the first index of the mesh)
+        void build(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<uint32_t>* indices, std::vector<Meshlet>* meshlets);
+
+        // Culls meshlets against a view and appends the surviving index ranges, consecutive visible meshlets are merged into a single range
+        void cull(const Meshlet* meshlets, uint32_t meshlet_count, const Math::Matrix& transform, const MeshletView& view, std::vector<MeshletRange>* ranges);
+    }
+}
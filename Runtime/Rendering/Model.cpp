@@ -23,16 +23,19 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Model.h"
 #include "Mesh.h"
+#include "MeshBvh.h"
 #include "Renderer.h"
+#include "GeometryStreamer.h"
+#include "GeometryAllocator.h"
 #include "../IO/FileStream.h"
+#include "../IO/FileMapping.h"
 #include "../Core/Stopwatch.h"
+#include "../Threading/Threading.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ModelImporter.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
-#include "../RHI/RHI_VertexBuffer.h"
-#include "../RHI/RHI_IndexBuffer.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_Vertex.h"
 //===========================================
@@ -44,6 +47,35 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    // Native model files start with these, files that were written before the header existed start with the resource path's length instead (version 0).
+    // Every version appends to the previous one, so a file has the fields of its own version and of all the older ones, in this order:
+    // Version 0: resource path, normalized scale, indices, vertices (full precision).
+    // Version 1: header, vertex compression, submesh table (after the normalized scale), meshlets, levels of detail (after the vertices).
+    //            The submesh table has the bounds and the index and vertex ranges of every submesh, so that any of them can be loaded on its own.
+    // Version 2: skeleton, bone weights, animations.
+    // Version 3: a bvh per submesh, older files get theirs built when they are loaded.
+    // Fields that a file doesn't have are left at their defaults, see Clear().
+    static const uint32_t model_file_magic      = 0x444D5053; // "SPMD"
+    static const uint32_t model_file_version    = 3;
+
+    // Geometry in a mapped file isn't necessarily aligned, so vertices are copied out of it one at a time
+    static RHI_Vertex_PosTexNorTan vertex_at(const byte* vertices, const uint32_t index)
+    {
+        RHI_Vertex_PosTexNorTan vertex;
+        memcpy(&vertex, vertices + static_cast<uint64_t>(index) * sizeof(RHI_Vertex_PosTexNorTan), sizeof(RHI_Vertex_PosTexNorTan));
+        return vertex;
+    }
+
+    static Vector3 scale_inverse(const Vector3& scale)
+    {
+        return Vector3
+        (
+            scale.x != 0.0f ? 1.0f / scale.x : 0.0f,
+            scale.y != 0.0f ? 1.0f / scale.y : 0.0f,
+            scale.z != 0.0f ? 1.0f / scale.z : 0.0f
+        );
+    }
+
     Model::Model(Context* context) : IResource(context, ResourceType::Model)
     {
         m_resource_manager    = m_context->GetSubsystem<ResourceCache>();
@@ -58,13 +90,24 @@ namespace Spartan
 
     void Model::Clear()
     {
+        GeometryStreamStop();
+        GeometryFree();
         m_root_entity.reset();
-        m_vertex_buffer.reset();
-        m_index_buffer.reset();
         m_mesh->Clear();
         m_aabb.Undefine();
         m_normalized_scale = 1.0f;
-        m_is_animated = false;
+        m_bones.clear();
+        m_bone_weights.clear();
+        m_animations.clear();
+        m_vertex_position_offset = Vector3::Zero;
+        m_vertex_position_scale = Vector3::One;
+        m_file_mapping.reset();
+        m_mapped_indices        = nullptr;
+        m_mapped_vertices       = nullptr;
+        m_mapped_index_count    = 0;
+        m_mapped_vertex_count   = 0;
+        m_mapped_version        = 0;
+        m_vertex_compression    = false;
     }
 
     bool Model::LoadFromFile(const string& file_path)
@@ -80,17 +123,83 @@ namespace Spartan
         // Load engine format
         if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
         {
-            // Deserialize
-            auto file = make_unique<FileStream>(file_path, FileStream_Read);
-            if (!file->IsOpen())
+            // Deserialize, the file is mapped so that the indices and vertices go from it straight to the gpu buffers (without reading them into memory first)
+            m_file_mapping = make_shared<FileMapping>(file_path);
+            if (!m_file_mapping->IsOpen())
                 return false;
 
+            FileMapping* file = m_file_mapping.get();
+            m_mapped_version = file->ReadAs<uint32_t>() == model_file_magic ? file->ReadAs<uint32_t>() : 0;
+            if (m_mapped_version == 0)
+            {
+                file->SetPosition(0);
+            }
+            else if (m_mapped_version > model_file_version)
+            {
+                LOG_ERROR("\"%s\" was written by a newer version of the engine", file_path.c_str());
+                Clear();
+                return false;
+            }
+
             SetResourceFilePath(file->ReadAs<string>());
             file->Read(&m_normalized_scale);
-            file->Read(&m_mesh->Indices_Get());
-            file->Read(&m_mesh->Vertices_Get());
+            if (m_mapped_version >= 1)
+            {
+                file->Read(&m_vertex_compression);
+                file->Read(&m_mesh->Submeshes_Get());
+            }
+            // Every version has the indices and the vertices
+            m_mapped_indices    = file->ReadArray(sizeof(uint32_t), &m_mapped_index_count);
+            m_mapped_vertices   = file->ReadArray(sizeof(RHI_Vertex_PosTexNorTan), &m_mapped_vertex_count);
+            if (m_mapped_version >= 1)
+            {
+                file->Read(&m_mesh->Meshlets_Get());
+                file->Read(&m_mesh->Lods_Get());
+            }
+            if (m_mapped_version >= 2)
+            {
+                m_bones.resize(file->ReadAs<uint32_t>());
+                for (AnimationBone& bone : m_bones)
+                {
+                    bone.name = file->ReadAs<string>();
+                    file->Read(&bone.parent);
+                    file->Read(&bone.offset);
+                    file->Read(&bone.rest.position);
+                    file->Read(&bone.rest.rotation);
+                    file->Read(&bone.rest.scale);
+                }
+                file->Read(&m_bone_weights);
+
+                const uint32_t animation_count = file->ReadAs<uint32_t>();
+                for (uint32_t i = 0; i < animation_count && !file->HasError(); i++)
+                {
+                    auto animation = make_shared<Animation>(m_context);
+                    animation->Deserialize(file);
+                    m_animations.emplace_back(animation);
+                }
+            }
+            if (m_mapped_version >= 3)
+            {
+                file->Read(&m_mesh->BvhNodes_Get());
+                file->Read(&m_mesh->BvhTriangles_Get());
+                file->Read(&m_mesh->Bvhs_Get());
+            }
 
-            UpdateGeometry();
+            if (file->HasError())
+            {
+                LOG_ERROR("\"%s\" is truncated", file_path.c_str());
+                Clear();
+                return false;
+            }
+
+            GeometryBuildBvhs();
+
+            // With a submesh table, the geometry can be streamed in and out as the camera moves, instead of all of it being resident
+            const bool stream = m_context->GetSubsystem<Renderer>()->GetOption(Render_GeometryStreaming) && !m_mesh->Submeshes_Get().empty();
+            if (!stream || !GeometryStreamStart())
+            {
+                UpdateGeometry();
+            }
         }
         // Load foreign format
         else
@@ -115,11 +224,11 @@ namespace Spartan
             // Cpu
             m_size_cpu = !m_mesh ? 0 : m_mesh->GetMemoryUsage();
 
-            // Gpu
-            if (m_vertex_buffer && m_index_buffer)
+            // Gpu (the geometry of a streamed model is accounted for by the streamer)
+            if (m_geometry_allocation.IsValid())
             {
-                m_size_gpu = m_vertex_buffer->GetSizeGpu();
-                m_size_gpu += m_index_buffer->GetSizeGpu();
+                m_size_gpu = static_cast<uint64_t>(m_geometry_allocation.vertex_count) * m_geometry_allocation.heap->GetVertexStride();
+                m_size_gpu += static_cast<uint64_t>(m_geometry_allocation.index_count) * sizeof(uint32_t);
             }
         }
 
@@ -130,21 +239,64 @@ namespace Spartan
 
     bool Model::SaveToFile(const string& file_path)
     {
+        // Geometry that is still mapped hasn't been modified (modifying makes it resident), so a file of the current version would be written as it is
+        if (m_file_mapping && m_file_mapping->GetPath() == file_path)
+        {
+            if (m_mapped_version == model_file_version)
+                return true;
+
+            // The file that the geometry is mapped from is about to be overwritten
+            GeometryMakeResident();
+        }
+
+        // Any other file is written from a copy of the mapped geometry, so that the model can keep using (and streaming from) the mapping
+        vector<uint32_t> indices_mapped;
+        vector<RHI_Vertex_PosTexNorTan> vertices_mapped;
+        if (m_file_mapping)
+        {
+            GetGeometry(0, m_mapped_index_count, 0, m_mapped_vertex_count, &indices_mapped, &vertices_mapped);
+        }
+
         auto file = make_unique<FileStream>(file_path, FileStream_Write);
         if (!file->IsOpen())
             return false;
 
+        file->Write(model_file_magic);
+        file->Write(model_file_version);
         file->Write(GetResourceFilePath());
         file->Write(m_normalized_scale);
-        file->Write(m_mesh->Indices_Get());
-        file->Write(m_mesh->Vertices_Get());
+        file->Write(m_vertex_compression);
+        file->Write(m_mesh->Submeshes_Get());
+        file->Write(m_file_mapping ? indices_mapped : m_mesh->Indices_Get());
+        file->Write(m_file_mapping ? vertices_mapped : m_mesh->Vertices_Get());
+        file->Write(m_mesh->Meshlets_Get());
+        file->Write(m_mesh->Lods_Get());
+        file->Write(static_cast<uint32_t>(m_bones.size()));
+        for (const AnimationBone& bone : m_bones)
+        {
+            file->Write(bone.name);
+            file->Write(bone.parent);
+            file->Write(bone.offset);
+            file->Write(bone.rest.position);
+            file->Write(bone.rest.rotation);
+            file->Write(bone.rest.scale);
+        }
+        file->Write(m_bone_weights);
+        file->Write(static_cast<uint32_t>(m_animations.size()));
+        for (const shared_ptr<Animation>& animation : m_animations)
+        {
+            animation->Serialize(file.get());
+        }
+        file->Write(m_mesh->BvhNodes_Get());
+        file->Write(m_mesh->BvhTriangles_Get());
+        file->Write(m_mesh->Bvhs_Get());
 
         file->Close();
 
         return true;
     }
 
-    void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset) const
+    void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset, const MeshBvhData* bvh)
     {
         if (indices.empty() || vertices.empty())
         {
@@ -152,27 +304,347 @@ namespace Spartan
             return;
         }
 
+        GeometryMakeResident();
+
         // Append indices and vertices to the main mesh
-        m_mesh->Indices_Append(indices, index_offset);
-        m_mesh->Vertices_Append(vertices, vertex_offset);
+        MeshSubmesh submesh;
+        m_mesh->Indices_Append(indices, &submesh.index_offset);
+        m_mesh->Vertices_Append(vertices, &submesh.vertex_offset);
+
+        // Every append is a submesh
+        submesh.aabb            = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
+        submesh.index_count     = static_cast<uint32_t>(indices.size());
+        submesh.vertex_count    = static_cast<uint32_t>(vertices.size());
+        m_mesh->Submesh_Add(submesh);
+
+        // Every submesh has a bvh, for ray queries
+        if (bvh)
+        {
+            m_mesh->Bvh_Append(*bvh);
+        }
+        else
+        {
+            MeshBvhData bvh_built;
+            MeshBvhHelper::build(vertices, indices, &bvh_built);
+            m_mesh->Bvh_Append(bvh_built);
+        }
+
+        if (index_offset)
+        {
+            *index_offset = submesh.index_offset;
+        }
+
+        if (vertex_offset)
+        {
+            *vertex_offset = submesh.vertex_offset;
+        }
+    }
+
+    void Model::AppendMeshlets(const vector<Meshlet>& meshlets, const uint32_t index_offset, uint32_t* meshlet_offset) const
+    {
+        m_mesh->Meshlets_Append(meshlets, index_offset, meshlet_offset);
+    }
+
+    const vector<Meshlet>& Model::GetMeshlets() const
+    {
+        return m_mesh->Meshlets_Get();
+    }
+
+    void Model::AppendLods(const vector<uint32_t>& indices, const vector<MeshLod>& lods, uint32_t* lod_offset)
+    {
+        // The indices of the levels go after the existing ones
+        GeometryMakeResident();
+
+        m_mesh->Lods_Append(indices, lods, lod_offset);
+    }
+
+    const vector<MeshLod>& Model::GetLods() const
+    {
+        return m_mesh->Lods_Get();
+    }
+
+    void Model::SetLodError(const uint32_t lod_index, const float error)
+    {
+        GeometryMakeResident();
+
+        vector<MeshLod>& lods = m_mesh->Lods_Get();
+        if (lod_index >= lods.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        lods[lod_index].error = error;
+    }
+
+    const vector<MeshSubmesh>& Model::GetSubmeshes() const
+    {
+        return m_mesh->Submeshes_Get();
+    }
+
+    bool Model::GetSubmeshIndex(const uint32_t vertex_offset, uint32_t* submesh_index) const
+    {
+        // Submeshes are appended one after the other, so they are sorted by their vertex offset
+        const vector<MeshSubmesh>& submeshes = m_mesh->Submeshes_Get();
+        auto it = upper_bound(submeshes.begin(), submeshes.end(), vertex_offset, [](const uint32_t offset, const MeshSubmesh& submesh) { return offset < submesh.vertex_offset; });
+        if (it == submeshes.begin())
+            return false;
+
+        it--;
+        if (vertex_offset >= it->vertex_offset + it->vertex_count)
+            return false;
+
+        *submesh_index = static_cast<uint32_t>(it - submeshes.begin());
+        return true;
+    }
+
+    bool Model::GetSubmeshPlacement(const uint32_t vertex_offset, SubmeshPlacement* placement) const
+    {
+        // All of the geometry is in a single allocation, the levels of detail included
+        if (!m_is_streamed)
+        {
+            if (!m_geometry_allocation.IsValid())
+                return false;
+
+            placement->heap             = m_geometry_allocation.heap;
+            placement->index_delta      = m_geometry_allocation.index_offset;
+            placement->lod_index_delta  = m_geometry_allocation.index_offset;
+            placement->vertex_offset    = m_geometry_allocation.vertex_offset + vertex_offset;
+
+            return true;
+        }
+
+        // Not resident, there is nothing to draw
+        uint32_t submesh_index = 0;
+        if (!GetSubmeshIndex(vertex_offset, &submesh_index) || !m_submesh_allocations[submesh_index].IsValid())
+            return false;
+
+        // In the heap, the indices of the lower levels of detail follow the full detail ones
+        const MeshSubmesh& submesh              = m_mesh->Submeshes_Get()[submesh_index];
+        const GeometryAllocation& allocation    = m_submesh_allocations[submesh_index];
+        placement->heap                         = allocation.heap;
+        placement->index_delta                  = static_cast<int64_t>(allocation.index_offset) - submesh.index_offset;
+        placement->lod_index_delta              = static_cast<int64_t>(allocation.index_offset) + submesh.index_count - submesh.lod_index_offset;
+        placement->vertex_offset                = allocation.vertex_offset + (vertex_offset - submesh.vertex_offset);
+
+        return true;
+    }
+
+    void Model::GetSubmeshSource(const uint32_t submesh_index, SubmeshSource* source) const
+    {
+        if (!m_file_mapping || submesh_index >= m_mesh->Submeshes_Get().size() || !source)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        const MeshSubmesh& submesh              = m_mesh->Submeshes_Get()[submesh_index];
+        source->file                            = m_file_mapping;
+        source->indices                         = m_mapped_indices + static_cast<uint64_t>(submesh.index_offset) * sizeof(uint32_t);
+        source->lod_indices                     = m_mapped_indices + static_cast<uint64_t>(submesh.lod_index_offset) * sizeof(uint32_t);
+        source->vertices                        = m_mapped_vertices + static_cast<uint64_t>(submesh.vertex_offset) * sizeof(RHI_Vertex_PosTexNorTan);
+        source->index_count                     = submesh.index_count;
+        source->lod_index_count                 = submesh.lod_index_count;
+        source->vertex_count                    = submesh.vertex_count;
+        source->vertex_compression              = m_vertex_compression;
+        source->vertex_position_offset          = m_vertex_position_offset;
+        source->vertex_position_scale_inverse   = scale_inverse(m_vertex_position_scale);
+    }
+
+    void Model::SetSubmeshAllocation(const uint32_t submesh_index, const GeometryAllocation& allocation)
+    {
+        if (submesh_index >= m_submesh_allocations.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        m_submesh_allocations[submesh_index] = allocation;
     }
 
     void Model::GetGeometry(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
     {
-        m_mesh->GetGeometry(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
+        if (!m_file_mapping)
+        {
+            m_mesh->GetGeometry(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
+            return;
+        }
+
+        // Copy the requested range out of the mapped file, for the few users which need geometry on the cpu (e.g. picking and physics), either output can be null
+        if ((!indices && !vertices) || index_offset + index_count > m_mapped_index_count || vertex_offset + vertex_count > m_mapped_vertex_count)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        if (indices)
+        {
+            indices->resize(index_count);
+            memcpy(indices->data(), m_mapped_indices + static_cast<uint64_t>(index_offset) * sizeof(uint32_t), static_cast<uint64_t>(index_count) * sizeof(uint32_t));
+        }
+
+        if (vertices)
+        {
+            vertices->resize(vertex_count);
+            memcpy(vertices->data(), m_mapped_vertices + static_cast<uint64_t>(vertex_offset) * sizeof(RHI_Vertex_PosTexNorTan), static_cast<uint64_t>(vertex_count) * sizeof(RHI_Vertex_PosTexNorTan));
+        }
     }
 
     void Model::UpdateGeometry()
     {
-        if (m_mesh->Indices_Count() == 0 || m_mesh->Vertices_Count() == 0)
+        // All of the geometry goes into a single allocation
+        GeometryStreamStop();
+
+        // The geometry is either in the mapped file or in the mesh
+        const byte* indices     = m_file_mapping ? m_mapped_indices         : reinterpret_cast<const byte*>(m_mesh->Indices_Get().data());
+        const byte* vertices    = m_file_mapping ? m_mapped_vertices        : reinterpret_cast<const byte*>(m_mesh->Vertices_Get().data());
+        const uint32_t index_count  = m_file_mapping ? m_mapped_index_count     : m_mesh->Indices_Count();
+        const uint32_t vertex_count = m_file_mapping ? m_mapped_vertex_count    : m_mesh->Vertices_Count();
+
+        if (index_count == 0 || vertex_count == 0)
         {
             LOG_ERROR_INVALID_PARAMETER();
             return;
         }
 
-        GeometryCreateBuffers();
+        // The bounding box comes first as the normalized scale and the vertex compression depend on it
+        {
+            Vector3 min = Vector3::Infinity;
+            Vector3 max = Vector3::InfinityNeg;
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                const RHI_Vertex_PosTexNorTan vertex = vertex_at(vertices, i);
+                min = Vector3(Helper::Min(min.x, vertex.pos[0]), Helper::Min(min.y, vertex.pos[1]), Helper::Min(min.z, vertex.pos[2]));
+                max = Vector3(Helper::Max(max.x, vertex.pos[0]), Helper::Max(max.y, vertex.pos[1]), Helper::Max(max.z, vertex.pos[2]));
+            }
+            m_aabb = BoundingBox(min, max);
+        }
         m_normalized_scale    = GeometryComputeNormalizedScale();
-        m_aabb                = BoundingBox(m_mesh->Vertices_Get().data(), static_cast<uint32_t>(m_mesh->Vertices_Get().size()));
+        GeometryUpload(indices, index_count, vertices, vertex_count);
+    }
+
+    bool Model::UpdateVertices(const uint32_t submesh_index, const vector<RHI_Vertex_PosTexNorTan>& vertices, const MeshBvhData* bvh)
+    {
+        GeometryMakeResident();
+
+        vector<MeshSubmesh>& submeshes = m_mesh->Submeshes_Get();
+        if (submesh_index >= submeshes.size() || vertices.size() != submeshes[submesh_index].vertex_count)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        MeshSubmesh& submesh = submeshes[submesh_index];
+        copy(vertices.begin(), vertices.end(), m_mesh->Vertices_Get().begin() + submesh.vertex_offset);
+        submesh.aabb = BoundingBox(vertices.data(), submesh.vertex_count);
+
+        // The bvh is built from the new positions
+        if (bvh)
+        {
+            m_mesh->Bvh_Replace(submesh_index, *bvh);
+        }
+        else
+        {
+            const vector<uint32_t>& indices_all = m_mesh->Indices_Get();
+            const vector<uint32_t> indices(indices_all.begin() + submesh.index_offset, indices_all.begin() + submesh.index_offset + submesh.index_count);
+
+            MeshBvhData bvh_built;
+            MeshBvhHelper::build(vertices, indices, &bvh_built);
+            m_mesh->Bvh_Replace(submesh_index, bvh_built);
+        }
+
+        // Without an allocation (e.g. the geometry was never updated), the whole thing has to be uploaded
+        shared_ptr<GeometryAllocator> geometry_allocator = m_geometry_allocator.lock();
+        if (!geometry_allocator || !m_geometry_allocation.IsValid())
+        {
+            UpdateGeometry();
+            return true;
+        }
+
+        // Compressed positions are relative to the bounding box of the model, if the vertices went outside of it, everything has to be compressed again
+        const bool inside_aabb = m_aabb.IsInside(submesh.aabb) == Inside;
+        if (!inside_aabb)
+        {
+            UpdateGeometry();
+            return true;
+        }
+
+        if (m_vertex_compression)
+        {
+            const Vector3 position_scale_inverse = scale_inverse(m_vertex_position_scale);
+
+            vector<RHI_Vertex_PosTexNorTanPacked> vertices_packed;
+            vertices_packed.reserve(vertices.size());
+            for (const RHI_Vertex_PosTexNorTan& vertex : vertices)
+            {
+                vertices_packed.emplace_back(vertex, m_vertex_position_offset, position_scale_inverse);
+            }
+
+            return geometry_allocator->UpdateVertices(m_geometry_allocation, submesh.vertex_offset, submesh.vertex_count, vertices_packed.data());
+        }
+
+        return geometry_allocator->UpdateVertices(m_geometry_allocation, submesh.vertex_offset, submesh.vertex_count, vertices.data());
+    }
+
+    void Model::AppendBoneWeights(const vector<BoneWeights>& weights, const uint32_t vertex_offset)
+    {
+        if (weights.empty())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // The vertices in between (of submeshes without bones) follow no bone
+        BoneWeights weights_none;
+        weights_none.indices[0] = static_cast<uint16_t>(m_bones.size());
+        weights_none.weights[0] = 1.0f;
+
+        const uint64_t vertex_end = static_cast<uint64_t>(vertex_offset) + weights.size();
+        if (m_bone_weights.size() < vertex_end)
+        {
+            m_bone_weights.resize(vertex_end, weights_none);
+        }
+
+        copy(weights.begin(), weights.end(), m_bone_weights.begin() + vertex_offset);
+    }
+
+    const byte* Model::GetIndexData() const
+    {
+        return m_file_mapping ? m_mapped_indices : reinterpret_cast<const byte*>(m_mesh->Indices_Get().data());
+    }
+
+    const byte* Model::GetVertexData() const
+    {
+        return m_file_mapping ? m_mapped_vertices : reinterpret_cast<const byte*>(m_mesh->Vertices_Get().data());
+    }
+
+    bool Model::GetBvhView(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, MeshBvhView* view) const
+    {
+        const byte* indices     = GetIndexData();
+        const byte* vertices    = GetVertexData();
+        if (!indices || !vertices || index_count < 3 || !view)
+            return false;
+
+        view->nodes             = nullptr;
+        view->triangles         = nullptr;
+        view->indices           = indices + static_cast<uint64_t>(index_offset) * sizeof(uint32_t);
+        view->vertices          = vertices + static_cast<uint64_t>(vertex_offset) * sizeof(RHI_Vertex_PosTexNorTan);
+        view->triangle_count    = index_count / 3;
+
+        // The bvh only applies to the whole submesh
+        uint32_t submesh_index = 0;
+        if (GetSubmeshIndex(vertex_offset, &submesh_index) && submesh_index < m_mesh->Bvhs_Get().size())
+        {
+            const MeshSubmesh& submesh  = m_mesh->Submeshes_Get()[submesh_index];
+            const MeshBvh& bvh          = m_mesh->Bvhs_Get()[submesh_index];
+            if (submesh.index_offset == index_offset && submesh.index_count == index_count && submesh.vertex_offset == vertex_offset && bvh.node_count != 0)
+            {
+                view->nodes     = m_mesh->BvhNodes_Get().data() + bvh.node_offset;
+                view->triangles = m_mesh->BvhTriangles_Get().data() + bvh.triangle_offset;
+            }
+        }
+
+        return true;
     }
 
     void Model::AddMaterial(shared_ptr<Material>& material, const shared_ptr<Entity>& entity) const
@@ -211,6 +683,7 @@ namespace Spartan
             // Load texture
             auto generate_mipmaps = true;
             texture = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+            texture->SetContent(Material::GetTextureContent(texture_type));
             texture->LoadFromFile(file_path);
 
             // Set the texture to the provided material
@@ -218,45 +691,195 @@ namespace Spartan
         }
     }
 
-    bool Model::GeometryCreateBuffers()
+    bool Model::GeometryUpload(const byte* indices, const uint32_t index_count, const byte* vertices, const uint32_t vertex_count)
     {
-        auto success = true;
+        // The previous geometry is freed once the gpu is done with it
+        GeometryFree();
 
-        // Get geometry
-        const auto indices    = m_mesh->Indices_Get();
-        const auto vertices    = m_mesh->Vertices_Get();
+        if (index_count == 0 || vertex_count == 0)
+        {
+            LOG_ERROR("Failed to upload the geometry of \"%s\". Provided indices or vertices are empty", GetResourceName().c_str());
+            return false;
+        }
 
-        if (!indices.empty())
+        shared_ptr<GeometryAllocator> geometry_allocator = m_context->GetSubsystem<Renderer>()->GetGeometryAllocator();
+        if (!geometry_allocator)
         {
-            m_index_buffer = make_shared<RHI_IndexBuffer>(m_rhi_device);
-            if (!m_index_buffer->Create(indices))
+            LOG_ERROR_INVALID_INTERNALS();
+            return false;
+        }
+
+        GeometryComputeVertexPositionTransform();
+
+        GeometryAllocation allocation;
+        if (!geometry_allocator->Allocate(m_vertex_compression, vertex_count, index_count, &allocation))
+        {
+            LOG_ERROR("Failed to allocate the geometry of \"%s\".", GetResourceName().c_str());
+            return false;
+        }
+
+        // The heap is written straight from the given memory (the mesh or the mapped file), unless the vertices have to be compressed first
+        bool updated = false;
+        if (m_vertex_compression)
+        {
+            const Vector3 position_scale_inverse = scale_inverse(m_vertex_position_scale);
+
+            vector<RHI_Vertex_PosTexNorTanPacked> vertices_packed;
+            vertices_packed.reserve(vertex_count);
+            for (uint32_t i = 0; i < vertex_count; i++)
             {
-                LOG_ERROR("Failed to create index buffer for \"%s\".", GetResourceName().c_str());
-                success = false;
+                vertices_packed.emplace_back(vertex_at(vertices, i), m_vertex_position_offset, position_scale_inverse);
             }
+
+            updated = geometry_allocator->Update(allocation, vertices_packed.data(), reinterpret_cast<const uint32_t*>(indices));
         }
         else
         {
-            LOG_ERROR("Failed to create index buffer for \"%s\". Provided indices are empty", GetResourceName().c_str());
-            success = false;
+            updated = geometry_allocator->Update(allocation, vertices, reinterpret_cast<const uint32_t*>(indices));
+        }
+
+        if (!updated)
+        {
+            LOG_ERROR("Failed to upload the geometry of \"%s\".", GetResourceName().c_str());
+            geometry_allocator->Free(allocation);
+            return false;
+        }
+
+        m_geometry_allocator    = geometry_allocator;
+        m_geometry_allocation   = allocation;
+
+        return true;
+    }
+
+    void Model::GeometryFree()
+    {
+        if (!m_geometry_allocation.IsValid())
+            return;
+
+        if (shared_ptr<GeometryAllocator> geometry_allocator = m_geometry_allocator.lock())
+        {
+            geometry_allocator->Free(m_geometry_allocation);
+        }
+
+        m_geometry_allocator.reset();
+        m_geometry_allocation = GeometryAllocation();
+    }
+
+    void Model::GeometryComputeVertexPositionTransform()
+    {
+        // Positions are quantized relative to the bounding box, the shaders get the offset and scale to restore them
+        m_vertex_position_offset = m_vertex_compression ? m_aabb.GetMin()  : Vector3::Zero;
+        m_vertex_position_scale  = m_vertex_compression ? m_aabb.GetSize() : Vector3::One;
+    }
+
+    void Model::GeometryMakeResident()
+    {
+        if (!m_file_mapping)
+            return;
+
+        // Streaming needs the mapping, the model gets an allocation of its own once the geometry is updated
+        GeometryStreamStop();
+
+        vector<uint32_t>& indices = m_mesh->Indices_Get();
+        indices.resize(m_mapped_index_count);
+        memcpy(indices.data(), m_mapped_indices, static_cast<uint64_t>(m_mapped_index_count) * sizeof(uint32_t));
+
+        vector<RHI_Vertex_PosTexNorTan>& vertices = m_mesh->Vertices_Get();
+        vertices.resize(m_mapped_vertex_count);
+        memcpy(vertices.data(), m_mapped_vertices, static_cast<uint64_t>(m_mapped_vertex_count) * sizeof(RHI_Vertex_PosTexNorTan));
+
+        m_file_mapping.reset();
+        m_mapped_indices        = nullptr;
+        m_mapped_vertices       = nullptr;
+        m_mapped_index_count    = 0;
+        m_mapped_vertex_count   = 0;
+        m_mapped_version        = 0;
+
+        m_size_cpu = m_mesh->GetMemoryUsage();
+    }
+
+    void Model::GeometryBuildBvhs()
+    {
+        // Files from before version 3 don't have them
+        const vector<MeshSubmesh>& submeshes = m_mesh->Submeshes_Get();
+        if (m_mesh->Bvhs_Get().size() == submeshes.size())
+            return;
+
+        const Stopwatch timer;
+
+        m_mesh->BvhNodes_Get().clear();
+        m_mesh->BvhTriangles_Get().clear();
+        m_mesh->Bvhs_Get().clear();
+
+        vector<MeshBvhData> bvhs(submeshes.size());
+        m_context->GetSubsystem<Threading>()->ParallelFor(static_cast<uint32_t>(submeshes.size()), [this, &submeshes, &bvhs](const uint32_t i)
+        {
+            vector<uint32_t> indices;
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            GetGeometry(submeshes[i].index_offset, submeshes[i].index_count, submeshes[i].vertex_offset, submeshes[i].vertex_count, &indices, &vertices);
+            MeshBvhHelper::build(vertices, indices, &bvhs[i]);
+        });
+
+        for (const MeshBvhData& bvh : bvhs)
+        {
+            m_mesh->Bvh_Append(bvh);
         }
 
-        if (!vertices.empty())
+        LOG_INFO("Building the bvhs of %d submeshes took %.1f ms (re-save the model to store them)", static_cast<int>(submeshes.size()), static_cast<float>(timer.GetElapsedTimeMs()));
+    }
+
+    bool Model::GeometryStreamStart()
+    {
+        shared_ptr<GeometryStreamer> geometry_streamer = m_context->GetSubsystem<Renderer>()->GetGeometryStreamer();
+        if (!geometry_streamer || !m_file_mapping)
+            return false;
+
+        // The bounding box comes from the submesh table, so that none of the vertices have to be paged in
         {
-            m_vertex_buffer = make_shared<RHI_VertexBuffer>(m_rhi_device);
-            if (!m_vertex_buffer->Create(vertices))
+            Vector3 min = Vector3::Infinity;
+            Vector3 max = Vector3::InfinityNeg;
+            for (const MeshSubmesh& submesh : m_mesh->Submeshes_Get())
             {
-                LOG_ERROR("Failed to create vertex buffer for \"%s\".", GetResourceName().c_str());
-                success = false;
+                const Vector3& submesh_min = submesh.aabb.GetMin();
+                const Vector3& submesh_max = submesh.aabb.GetMax();
+                min = Vector3(Helper::Min(min.x, submesh_min.x), Helper::Min(min.y, submesh_min.y), Helper::Min(min.z, submesh_min.z));
+                max = Vector3(Helper::Max(max.x, submesh_max.x), Helper::Max(max.y, submesh_max.y), Helper::Max(max.z, submesh_max.z));
             }
+            m_aabb = BoundingBox(min, max);
         }
-        else
+        m_normalized_scale = GeometryComputeNormalizedScale();
+        GeometryComputeVertexPositionTransform();
+
+        // Nothing is resident until the streamer uploads it
+        GeometryFree();
+        m_submesh_allocations.assign(m_mesh->Submeshes_Get().size(), GeometryAllocation());
+        m_is_streamed = true;
+
+        if (!geometry_streamer->Register(this))
+        {
+            m_submesh_allocations.clear();
+            m_is_streamed = false;
+            return false;
+        }
+
+        m_geometry_streamer = geometry_streamer;
+
+        return true;
+    }
+
+    void Model::GeometryStreamStop()
+    {
+        if (!m_is_streamed)
+            return;
+
+        if (shared_ptr<GeometryStreamer> geometry_streamer = m_geometry_streamer.lock())
         {
-            LOG_ERROR("Failed to create vertex buffer for \"%s\". Provided vertices are empty", GetResourceName().c_str());
-            success = false;
+            geometry_streamer->Unregister(this);
         }
 
-        return success;
+        m_geometry_streamer.reset();
+        m_submesh_allocations.clear();
+        m_is_streamed = false;
     }
 
     float Model::GeometryComputeNormalizedScale() const
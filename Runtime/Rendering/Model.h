@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <vector>
 #include "Material.h"
+#include "Animation.h"
+#include "GeometryHeap.h"
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/BoundingBox.h"
@@ -35,6 +37,15 @@ namespace Spartan
     class ResourceCache;
     class Entity;
     class Mesh;
+    class FileMapping;
+    class GeometryStreamer;
+    class GeometryAllocator;
+    struct Meshlet;
+    struct MeshLod;
+    struct MeshSubmesh;
+    struct SubmeshSource;
+    struct MeshBvhData;
+    struct MeshBvhView;
     namespace Math{ class BoundingBox; }
 
     class SPARTAN_CLASS Model : public IResource, public std::enable_shared_from_this<Model>
@@ -54,9 +65,10 @@ namespace Spartan
         void AppendGeometry(
             const std::vector<uint32_t>& indices,
             const std::vector<RHI_Vertex_PosTexNorTan>& vertices,
-            uint32_t* index_offset  = nullptr,
-            uint32_t* vertex_offset = nullptr
-        ) const;
+            uint32_t* index_offset      = nullptr,
+            uint32_t* vertex_offset     = nullptr,
+            const MeshBvhData* bvh      = nullptr  // built here if it's not passed in
+        );
         void GetGeometry(
             uint32_t index_offset,
             uint32_t index_count,
@@ -66,34 +78,98 @@ namespace Spartan
             std::vector<RHI_Vertex_PosTexNorTan>* vertices
         ) const;
         void UpdateGeometry();
+        bool UpdateVertices(uint32_t submesh_index, const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const MeshBvhData* bvh = nullptr); // same vertex count, same indices
+        void AppendMeshlets(const std::vector<Meshlet>& meshlets, uint32_t index_offset, uint32_t* meshlet_offset = nullptr) const;
+        const std::vector<Meshlet>& GetMeshlets() const;
+        void AppendLods(const std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, uint32_t* lod_offset = nullptr);
+        const std::vector<MeshLod>& GetLods() const;
+        void SetLodError(uint32_t lod_index, float error);
+        const std::vector<MeshSubmesh>& GetSubmeshes() const; // one per AppendGeometry()
+        bool GetSubmeshIndex(uint32_t vertex_offset, uint32_t* submesh_index) const;
         const auto& GetAabb() const { return m_aabb; }
         const auto& GetMesh() const { return m_mesh; }
 
+        // Where all of the geometry is in the geometry heaps (see GeometryAllocator), invalid for streamed models
+        const auto& GetGeometryAllocation() const { return m_geometry_allocation; }
+
+        // Vertex compression (the gpu gets RHI_Vertex_PosTexNorTanPacked vertices, has to be set before the geometry is created)
+        void SetVertexCompression(const bool vertex_compression)    { m_vertex_compression = vertex_compression; }
+        bool IsVertexCompressed()                             const { return m_vertex_compression; }
+        const auto& GetVertexPositionOffset()                 const { return m_vertex_position_offset; }
+        const auto& GetVertexPositionScale()                  const { return m_vertex_position_scale; }
+
+        // Streaming (see GeometryStreamer), the gpu buffers of a streamed model only have the submeshes that are near the camera in them
+        bool IsStreamed() const { return m_is_streamed; }
+        bool GetSubmeshPlacement(uint32_t vertex_offset, SubmeshPlacement* placement) const;
+        void GetSubmeshSource(uint32_t submesh_index, SubmeshSource* source) const;
+        void SetSubmeshAllocation(uint32_t submesh_index, const GeometryAllocation& allocation);
+
         // Add resources to the model
         void SetRootEntity(const std::shared_ptr<Entity>& entity) { m_root_entity = entity; }
         void AddMaterial(std::shared_ptr<Material>& material, const std::shared_ptr<Entity>& entity) const;
         void AddTexture(std::shared_ptr<Material>& material, Material_Property texture_type, const std::string& file_path);
 
+        // Skinning (see Animator), the bone weights are per vertex and there are none for models without bones
+        void SetBones(const std::vector<AnimationBone>& bones)              { m_bones = bones; }
+        const auto& GetBones()                                        const { return m_bones; }
+        void AppendBoneWeights(const std::vector<BoneWeights>& weights, uint32_t vertex_offset);
+        const auto& GetBoneWeights()                                  const { return m_bone_weights; }
+        void AddAnimation(const std::shared_ptr<Animation>& animation)      { m_animations.emplace_back(animation); }
+        const auto& GetAnimations()                                   const { return m_animations; }
+        bool IsAnimated()                                             const { return !m_bones.empty(); }
+
+        // The indices and the vertices of all the submeshes, from the mapped file or the mesh (which means that they aren't necessarily aligned)
+        const std::byte* GetIndexData() const;
+        const std::byte* GetVertexData() const;
+
+        // Ray queries (see MeshBvhHelper), the view has the bvh of the submesh if the range is a whole submesh, otherwise its triangles are tested one by one
+        bool GetBvhView(uint32_t index_offset, uint32_t index_count, uint32_t vertex_offset, MeshBvhView* view) const;
+
         // Misc
-        bool IsAnimated()                           const { return m_is_animated; }
-        void SetAnimated(const bool is_animated)          { m_is_animated = is_animated; }
-        const RHI_IndexBuffer* GetIndexBuffer()     const { return m_index_buffer.get(); }
-        const RHI_VertexBuffer* GetVertexBuffer()   const { return m_vertex_buffer.get(); }
-        auto GetSharedPtr()                                  { return shared_from_this(); }
+        auto GetSharedPtr() { return shared_from_this(); }
 
     private:
         // Geometry
-        bool GeometryCreateBuffers();
+        bool GeometryUpload(const std::byte* indices, uint32_t index_count, const std::byte* vertices, uint32_t vertex_count);
+        void GeometryFree();
         float GeometryComputeNormalizedScale() const;
+        void GeometryComputeVertexPositionTransform();
+        void GeometryMakeResident();
+        void GeometryBuildBvhs();
+        bool GeometryStreamStart();
+        void GeometryStreamStop();
 
         // Misc
         std::weak_ptr<Entity> m_root_entity;
-        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
-        std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
         std::shared_ptr<Mesh> m_mesh;
         Math::BoundingBox m_aabb;
         float m_normalized_scale    = 1.0f;
-        bool m_is_animated            = false;
+        bool m_vertex_compression   = false;
+        Math::Vector3 m_vertex_position_offset  = Math::Vector3::Zero;
+        Math::Vector3 m_vertex_position_scale   = Math::Vector3::One;
+
+        // Skinning
+        std::vector<AnimationBone> m_bones;
+        std::vector<BoneWeights> m_bone_weights;
+        std::vector<std::shared_ptr<Animation>> m_animations;
+
+        // Models loaded from the engine format keep their indices and vertices in the mapped file instead of the mesh,
+        // they are only copied into the mesh if they have to be modified or saved (see GeometryMakeResident()).
+        std::shared_ptr<FileMapping> m_file_mapping;
+        const std::byte* m_mapped_indices       = nullptr;
+        const std::byte* m_mapped_vertices      = nullptr;
+        uint32_t m_mapped_index_count           = 0;
+        uint32_t m_mapped_vertex_count          = 0;
+        uint32_t m_mapped_version               = 0;
+
+        // Geometry heaps (the allocator belongs to the renderer, which can be gone by the time the model is destroyed)
+        std::weak_ptr<GeometryAllocator> m_geometry_allocator;
+        GeometryAllocation m_geometry_allocation;
+
+        // Streaming
+        std::weak_ptr<GeometryStreamer> m_geometry_streamer;
+        std::vector<GeometryAllocation> m_submesh_allocations;
+        bool m_is_streamed = false;
 
         // Dependencies
         ResourceCache* m_resource_manager;
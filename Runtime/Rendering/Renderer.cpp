@@ -23,6 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Renderer.h"
 #include "Model.h"
+#include "MeshLod.h"
+#include "MeshSubmesh.h"
+#include "GeometryStreamer.h"
+#include "TextureStreamer.h"
+#include "GeometryAllocator.h"
 #include "Font/Font.h"
 #include "../World/World.h"
 #include "../Display/Display.h"
@@ -30,12 +35,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Gizmos/Transform_Gizmo.h"
 #include "../Utilities/Sampling.h"
 #include "../Profiling/Profiler.h"
+#include "../Threading/Threading.h"
 #include "../Resource/ResourceCache.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
 #include "../World/Components/Camera.h"
 #include "../World/Components/Light.h"
+#include "../World/Components/Animator.h"
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_PipelineCache.h"
 #include "../RHI/RHI_ConstantBuffer.h"
@@ -75,6 +82,9 @@ namespace Spartan
         m_options |= Render_FilmGrain;
         m_options |= Render_ChromaticAberration;
         m_options |= Render_Ssgi;
+        m_options |= Render_MeshletCulling;
+        m_options |= Render_Lod;
+        m_options |= Render_TextureStreaming;
 
         // Option values
         m_option_values[Renderer_Option_Value::Anisotropy]          = 16.0f;
@@ -84,16 +94,19 @@ namespace Spartan
         m_option_values[Renderer_Option_Value::Sharpen_Strength]    = 1.0f;
         m_option_values[Renderer_Option_Value::Intensity]           = 0.1f;
         m_option_values[Renderer_Option_Value::Fog]                 = 0.1f;
+        m_option_values[Renderer_Option_Value::LodThreshold]        = 1.0f;
+        m_option_values[Renderer_Option_Value::GeometryStreamingBudget] = 256.0f; // MB
+        m_option_values[Renderer_Option_Value::TextureStreamingBudget]  = 512.0f; // MB
 
         // Subscribe to events
-        SUBSCRIBE_TO_EVENT(EventType::WorldResolved,    EVENT_HANDLER_VARIANT(RenderablesAcquire));
+        SUBSCRIBE_TO_EVENT(EventType::WorldResolved,    EVENT_HANDLER(RenderablesAcquire));
         SUBSCRIBE_TO_EVENT(EventType::WorldClear,       EVENT_HANDLER(Clear));
     }
 
     Renderer::~Renderer()
     {
         // Unsubscribe from events
-        UNSUBSCRIBE_FROM_EVENT(EventType::WorldResolved, EVENT_HANDLER_VARIANT(RenderablesAcquire));
+        UNSUBSCRIBE_FROM_EVENT(EventType::WorldResolved, EVENT_HANDLER(RenderablesAcquire));
 
         m_entities.clear();
         m_camera = nullptr;
@@ -107,6 +120,7 @@ namespace Spartan
         // Get required systems
         m_resource_cache    = m_context->GetSubsystem<ResourceCache>();
         m_profiler          = m_context->GetSubsystem<Profiler>();
+        m_world             = m_context->GetSubsystem<World>();
 
         // Resolution, viewport and swapchain default to whatever the window size is
         const WindowData& window_data = m_context->m_engine->GetWindowData();
@@ -133,6 +147,13 @@ namespace Spartan
         // Create descriptor set layout cache
         m_descriptor_set_layout_cache = make_shared<RHI_DescriptorSetLayoutCache>(m_rhi_device.get());
 
+        // Create geometry allocator and streamer (the geometry of all the models goes into the allocator's heaps)
+        m_geometry_allocator    = make_shared<GeometryAllocator>(m_rhi_device);
+        m_geometry_streamer     = make_shared<GeometryStreamer>(m_context, m_geometry_allocator);
+
+        // Create texture streamer
+        m_texture_streamer = make_shared<TextureStreamer>(m_context);
+
         // Create swap chain
         {
             m_swap_chain = make_shared<RHI_SwapChain>
@@ -293,8 +314,15 @@ namespace Spartan
                 m_buffer_frame_cpu.ssr_enabled                  = GetOption(Render_ScreenSpaceReflections) ? 1.0f : 0.0f;
                 m_buffer_frame_cpu.shadow_resolution            = GetOptionValue<float>(Renderer_Option_Value::ShadowResolution);
                 m_buffer_frame_cpu.frame                        = static_cast<uint32_t>(m_frame_num);
+                m_buffer_frame_cpu.irradiance_available         = m_environment_irradiance_available ? 1.0f : 0.0f;
+                m_buffer_frame_cpu.environment_irradiance       = m_environment_irradiance;
             }
 
+            m_geometry_allocator->Tick(m_frame_num);
+            RenderablesAnimate();
+            RenderablesStreamUpdate();
+            RenderablesLodUpdate();
+
             Pass_Main(cmd_list);
 
             DrawDebugTick(delta_time);
@@ -422,8 +450,12 @@ namespace Spartan
     bool Renderer::UpdateFrameBuffer(RHI_CommandList* cmd_list)
     {
         // Update directional light intensity, just grab the first one
-        for (const auto& entity : m_entities[Renderer_Object_Light])
+        for (const EntityHandle& handle : m_entities[Renderer_Object_Light])
         {
+            Entity* entity = m_world->EntityGet(handle);
+            if (!entity)
+                continue;
+
             if (Light* light = entity->GetComponent<Light>())
             {
                 if (light->GetLightType() == LightType::Directional)
@@ -536,7 +568,7 @@ namespace Spartan
         return cmd_list->SetConstantBuffer(4, RHI_Shader_Pixel, m_buffer_light_gpu);
     }
 
-    void Renderer::RenderablesAcquire(const Variant& entities_variant)
+    void Renderer::RenderablesAcquire()
     {
         SCOPED_TIME_BLOCK(m_profiler);
 
@@ -544,8 +576,7 @@ namespace Spartan
         m_entities.clear();
         m_camera = nullptr;
 
-        vector<shared_ptr<Entity>> entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
-        for (const auto& entity : entities)
+        for (const shared_ptr<Entity>& entity : m_world->EntityGetAll())
         {
             if (!entity || !entity->IsActive())
                 continue;
@@ -554,6 +585,7 @@ namespace Spartan
             Renderable* renderable  = entity->GetComponent<Renderable>();
             Light* light            = entity->GetComponent<Light>();
             Camera* camera          = entity->GetComponent<Camera>();
+            Animator* animator      = entity->GetComponent<Animator>();
 
             if (renderable)
             {
@@ -564,46 +596,235 @@ namespace Spartan
                     is_transparent = material->GetColorAlbedo().w < 1.0f;
                 }
 
-                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity.get());
+                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity->GetHandle());
             }
 
             if (light)
             {
-                m_entities[Renderer_Object_Light].emplace_back(entity.get());
+                m_entities[Renderer_Object_Light].emplace_back(entity->GetHandle());
             }
 
             if (camera)
             {
-                m_entities[Renderer_Object_Camera].emplace_back(entity.get());
+                m_entities[Renderer_Object_Camera].emplace_back(entity->GetHandle());
                 m_camera = camera->GetPtrShared<Camera>();
             }
+
+            if (animator)
+            {
+                m_entities[Renderer_Object_Animator].emplace_back(entity->GetHandle());
+            }
         }
 
         RenderablesSort(&m_entities[Renderer_Object_Opaque]);
         RenderablesSort(&m_entities[Renderer_Object_Transparent]);
     }
 
-    void Renderer::RenderablesSort(vector<Entity*>* renderables)
+    void Renderer::RenderablesSort(vector<EntityHandle>* renderables)
     {
         if (!m_camera || renderables->size() <= 2)
             return;
 
-        auto comparison_op = [this](Entity* entity)
+        const Vector3 camera_position = m_camera->GetTransform()->GetPosition();
+
+        auto comparison_op = [this, &camera_position](const EntityHandle& handle)
         {
+            Entity* entity = m_world->EntityGet(handle);
+            if (!entity)
+                return 0.0f;
+
             auto renderable = entity->GetRenderable();
             if (!renderable)
                 return 0.0f;
 
-            return (renderable->GetAabb().GetCenter() - m_camera->GetTransform()->GetPosition()).LengthSquared();
+            return (renderable->GetAabb().GetCenter() - camera_position).LengthSquared();
         };
 
         // Sort by depth (front to back)
-        sort(renderables->begin(), renderables->end(), [&comparison_op](Entity* a, Entity* b)
+        sort(renderables->begin(), renderables->end(), [&comparison_op](const EntityHandle& a, const EntityHandle& b)
         {
             return comparison_op(a) < comparison_op(b);
         });
     }
 
+    void Renderer::RenderablesAnimate()
+    {
+        const vector<EntityHandle>& animators = m_entities[Renderer_Object_Animator];
+        if (animators.empty())
+            return;
+
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        // Every animator skins its own renderables into its own geometry, so they can run in parallel
+        m_context->GetSubsystem<Threading>()->ParallelFor(static_cast<uint32_t>(animators.size()), [this, &animators](const uint32_t i)
+        {
+            if (Entity* entity = m_world->EntityGet(animators[i]))
+            {
+                if (Animator* animator = entity->GetComponent<Animator>())
+                {
+                    animator->Animate(m_frame_num);
+                }
+            }
+        });
+    }
+
+    void Renderer::RenderablesLodUpdate()
+    {
+        // Converts a model space error into pixels at a distance of one unit (the projected error falls off with distance)
+        const bool orthographic         = m_camera->GetProjectionType() == Projection_Orthographic;
+        const float pixels_per_unit     = orthographic ? 1.0f : (m_resolution.y * 0.5f) / Helper::Tan(m_camera->GetFovVerticalRad() * 0.5f);
+        const float threshold           = m_option_values[Renderer_Option_Value::LodThreshold];
+        const Vector3 camera_position   = m_camera->GetTransform()->GetPosition();
+
+        for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            for (const EntityHandle& handle : m_entities[object_type])
+            {
+                Entity* entity = m_world->EntityGet(handle);
+                if (!entity)
+                    continue;
+
+                Renderable* renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
+
+                const Model* model          = renderable->GeometryModel();
+                const uint32_t lod_offset   = renderable->GeometryLodOffset();
+                const uint32_t lod_count    = renderable->GeometryLodCount();
+                // Skinned geometry only has its full detail indices in its own heap range
+                if (!GetOption(Render_Lod) || !model || lod_count == 0 || renderable->IsSkinned() || lod_offset + lod_count > static_cast<uint32_t>(model->GetLods().size()))
+                {
+                    renderable->SetLodIndex(0);
+                    continue;
+                }
+
+                // The distance is measured to the bounding sphere, so that large objects don't lose detail up close
+                const BoundingBox& aabb     = renderable->GetAabb();
+                const float distance        = Helper::Max((aabb.GetCenter() - camera_position).Length() - aabb.GetExtents().Length(), m_camera->GetNearPlane());
+                const Vector3 scale         = entity->GetTransform()->GetScale().Abs();
+                const float error_to_pixels = Helper::Max3(scale.x, scale.y, scale.z) * pixels_per_unit / (orthographic ? 1.0f : distance);
+
+                renderable->SetLodIndex(MeshLodHelper::select(&model->GetLods()[lod_offset], lod_count, error_to_pixels, threshold, renderable->GetLodIndex()));
+            }
+        }
+    }
+
+    void Renderer::RenderablesStreamUpdate()
+    {
+        const Vector3 camera_position = m_camera->GetTransform()->GetPosition();
+
+        // Converts a size in world units into pixels at a distance of one unit, like it's done for the levels of detail
+        const bool orthographic     = m_camera->GetProjectionType() == Projection_Orthographic;
+        const float pixels_per_unit = orthographic ? 1.0f : (m_resolution.y * 0.5f) / Helper::Tan(m_camera->GetFovVerticalRad() * 0.5f);
+
+        // Every renderable of a streamed model requests its submesh, the nearest requests get loaded first.
+        // The visible ones also measure how much of the screen their material covers, which decides the mips that its textures need.
+        m_material_screen_sizes.clear();
+        for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            for (const EntityHandle& handle : m_entities[object_type])
+            {
+                Entity* entity = m_world->EntityGet(handle);
+                if (!entity)
+                    continue;
+
+                Renderable* renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
+
+                // The distance is measured to the bounding sphere, like it is for the levels of detail
+                const BoundingBox& aabb = renderable->GetAabb();
+                const float distance    = Helper::Max((aabb.GetCenter() - camera_position).Length() - aabb.GetExtents().Length(), 0.0f);
+
+                Model* model = renderable->GeometryModel();
+                uint32_t submesh_index = 0;
+                if (model && model->IsStreamed() && model->GetSubmeshIndex(renderable->GeometryVertexOffset(), &submesh_index))
+                {
+                    m_geometry_streamer->Request(model, submesh_index, distance);
+                }
+
+                // The textures are assumed to span the bounding sphere once per uv tile
+                Material* material = renderable->GetMaterial();
+                if (material && m_camera->IsInViewFrustrum(renderable))
+                {
+                    const float screen_size     = aabb.GetExtents().Length() * 2.0f * pixels_per_unit / (orthographic ? 1.0f : Helper::Max(distance, m_camera->GetNearPlane()));
+                    const Vector2& tiling       = material->GetTiling();
+                    float& material_screen_size = m_material_screen_sizes[material];
+                    material_screen_size        = Helper::Max(material_screen_size, screen_size / Helper::Max(Helper::Max(tiling.x, tiling.y), Helper::EPSILON));
+                }
+            }
+        }
+
+        const uint64_t geometry_budget = static_cast<uint64_t>(m_option_values[Renderer_Option_Value::GeometryStreamingBudget]) * 1024 * 1024;
+        m_geometry_streamer->Tick(geometry_budget);
+
+        // The streamed textures of every visible material are requested with the size that the material covers on screen
+        for (const auto& it : m_material_screen_sizes)
+        {
+            for (const auto& texture : it.first->GetTextures())
+            {
+                if (texture.second && texture.second->IsStreamed())
+                {
+                    m_texture_streamer->Request(texture.second.get(), it.second);
+                }
+            }
+        }
+
+        const uint64_t texture_budget = static_cast<uint64_t>(m_option_values[Renderer_Option_Value::TextureStreamingBudget]) * 1024 * 1024;
+        m_texture_streamer->Tick(texture_budget);
+    }
+
+    void Renderer::RenderableDraw(RHI_CommandList* cmd_list, const Renderable* renderable, const SubmeshPlacement& placement, const Matrix& transform, const MeshletView& view)
+    {
+        // The placement is where the renderable's geometry is in the bound heap (see Renderable::GeometryPlacement())
+        const Model* model = renderable->GeometryModel();
+
+        // Lower levels of detail are drawn whole (the meshlets cover the full detail geometry only)
+        const uint32_t lod_index = renderable->GetLodIndex();
+        if (model && lod_index != 0 && renderable->GeometryLodOffset() + lod_index <= static_cast<uint32_t>(model->GetLods().size()))
+        {
+            const MeshLod& lod = model->GetLods()[renderable->GeometryLodOffset() + lod_index - 1];
+            cmd_list->DrawIndexed(lod.index_count, static_cast<uint32_t>(lod.index_offset + placement.lod_index_delta), placement.vertex_offset);
+            return;
+        }
+
+        // The bounds of the meshlets are those of the bind pose, which skinned geometry moves away from
+        const uint32_t meshlet_offset   = renderable->GeometryMeshletOffset();
+        const uint32_t meshlet_count    = renderable->GeometryMeshletCount();
+        const bool has_meshlets         = model && !renderable->IsSkinned() && meshlet_count != 0 && meshlet_offset + meshlet_count <= static_cast<uint32_t>(model->GetMeshlets().size());
+
+        // Draw everything if there is nothing to cull
+        if (!GetOption(Render_MeshletCulling) || !has_meshlets || !view.frustum)
+        {
+            cmd_list->DrawIndexed(renderable->GeometryIndexCount(), static_cast<uint32_t>(renderable->GeometryIndexOffset() + placement.index_delta), placement.vertex_offset);
+            return;
+        }
+
+        // Draw the visible meshlets, consecutive ones are merged into a single draw
+        m_meshlet_ranges.clear();
+        MeshletHelper::cull(&model->GetMeshlets()[meshlet_offset], meshlet_count, transform, view, &m_meshlet_ranges);
+        for (const MeshletRange& range : m_meshlet_ranges)
+        {
+            cmd_list->DrawIndexed(range.index_count, static_cast<uint32_t>(range.index_offset + placement.index_delta), placement.vertex_offset);
+        }
+    }
+
+    MeshletView Renderer::GetCameraMeshletView() const
+    {
+        MeshletView view;
+
+        if (m_camera)
+        {
+            view.frustum                = &m_camera->GetFrustum();
+            view.position               = m_camera->GetTransform()->GetPosition();
+            view.direction              = m_camera->GetTransform()->GetForward();
+            view.orthographic           = m_camera->GetProjectionType() == Projection_Orthographic;
+            view.ignore_depth_planes    = true; // renderables are already culled against them, the side planes are what's left to gain
+        }
+
+        return view;
+    }
+
     void Renderer::Clear()
     {
         // Flush to remove references to entity resources that will be deallocated
@@ -622,6 +843,20 @@ namespace Spartan
     void Renderer::SetEnvironmentTexture(const shared_ptr<RHI_Texture>& texture)
     {
         m_render_targets[RendererRt::Brdf_Prefiltered_Environment] = texture;
+        m_environment_irradiance_available = false;
+    }
+
+    void Renderer::SetEnvironmentIrradiance(const Vector3* coefficients)
+    {
+        if (coefficients)
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_environment_irradiance.size()); i++)
+            {
+                m_environment_irradiance[i] = Vector4(coefficients[i].x, coefficients[i].y, coefficients[i].z, 0.0f);
+            }
+        }
+
+        m_environment_irradiance_available = coefficients != nullptr;
     }
 
     void Renderer::SetOption(Renderer_Option option, bool enable)
@@ -653,6 +888,10 @@ namespace Spartan
         {
             value = Helper::Clamp(value, static_cast<float>(m_resolution_shadow_min), static_cast<float>(RHI_Context::texture_2d_dimension_max));
         }
+        else if (option == Renderer_Option_Value::GeometryStreamingBudget || option == Renderer_Option_Value::TextureStreamingBudget)
+        {
+            value = Helper::Max(value, 16.0f);
+        }
 
         if (m_option_values[option] == value)
             return;
@@ -663,10 +902,14 @@ namespace Spartan
         if (option == Renderer_Option_Value::ShadowResolution)
         {
             const auto& light_entities = m_entities[Renderer_Object_Light];
-            for (const auto& light_entity : light_entities)
+            for (const EntityHandle& handle : light_entities)
             {
+                Entity* light_entity = m_world->EntityGet(handle);
+                if (!light_entity)
+                    continue;
+
                 auto light = light_entity->GetComponent<Light>();
-                if (light->GetShadowsEnabled())
+                if (light && light->GetShadowsEnabled())
                 {
                     light->CreateShadowMap();
                 }
@@ -28,17 +28,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderer_ConstantBuffers.h"
 #include "Renderer_Enums.h"
 #include "Material.h"
+#include "Meshlet.h"
 #include "../Core/ISubsystem.h"
 #include "../Math/Rectangle.h"
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Viewport.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../World/EntityHandle.h"
 //===================================
 
 namespace Spartan
 {
     // Forward declarations
     class Entity;
+    class Renderable;
     class Camera;
     class Light;
     class ResourceCache;
@@ -47,6 +50,11 @@ namespace Spartan
     class Grid;
     class Transform_Gizmo;
     class Profiler;
+    class World;
+    class GeometryStreamer;
+    class TextureStreamer;
+    class GeometryAllocator;
+    struct SubmeshPlacement;
 
     namespace Math
     {
@@ -111,6 +119,8 @@ namespace Spartan
         // Environment
         const std::shared_ptr<RHI_Texture>& GetEnvironmentTexture();
         void SetEnvironmentTexture(const std::shared_ptr<RHI_Texture>& texture);
+        // The diffuse irradiance of the environment texture as 9 spherical harmonics, or null to sample the texture's last mip instead
+        void SetEnvironmentIrradiance(const Math::Vector3* coefficients);
 
         // Options
         uint64_t GetOptions()                           const { return m_options; }
@@ -152,6 +162,9 @@ namespace Spartan
         const auto& GetCamera()                                     const { return m_camera; }
         auto IsInitialized()                                        const { return m_initialized; }
         auto GetShaders()                                           const { return m_shaders; }
+        const auto& GetGeometryStreamer()                           const { return m_geometry_streamer; }
+        const auto& GetGeometryAllocator()                          const { return m_geometry_allocator; }
+        const auto& GetTextureStreamer()                            const { return m_texture_streamer; }
         uint32_t GetMaxResolution() const;
         void Clear();
 
@@ -215,8 +228,13 @@ namespace Spartan
         bool UpdateLightBuffer(RHI_CommandList* cmd_list, const Light* light);
 
         // Misc
-        void RenderablesAcquire(const Variant& renderables);
-        void RenderablesSort(std::vector<Entity*>* renderables);
+        void RenderablesAcquire();
+        void RenderablesSort(std::vector<EntityHandle>* renderables);
+        void RenderablesLodUpdate();
+        void RenderablesAnimate();
+        void RenderablesStreamUpdate();
+        void RenderableDraw(RHI_CommandList* cmd_list, const Renderable* renderable, const SubmeshPlacement& placement, const Math::Matrix& transform, const MeshletView& view);
+        MeshletView GetCameraMeshletView() const;
 
         // Render textures
         std::unordered_map<RendererRt, std::shared_ptr<RHI_Texture>> m_render_targets;
@@ -297,6 +315,8 @@ namespace Spartan
         bool m_is_odd_frame                         = false;
         bool m_brdf_specular_lut_rendered           = false;
         bool m_update_ortho_proj                    = true;
+        bool m_environment_irradiance_available     = false;
+        std::array<Math::Vector4, 9> m_environment_irradiance;
         std::atomic<bool> m_is_allowed_to_render    = true;
         std::atomic<bool> m_is_rendering            = false;
 
@@ -332,12 +352,18 @@ namespace Spartan
         //========================================================
 
         // Entities and material references
-        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities;
+        std::unordered_map<Renderer_Object_Type, std::vector<EntityHandle>> m_entities;
         std::array<Material*, m_max_material_instances> m_material_instances;
+        std::vector<MeshletRange> m_meshlet_ranges;
+        std::shared_ptr<GeometryStreamer> m_geometry_streamer;
+        std::shared_ptr<GeometryAllocator> m_geometry_allocator;
+        std::shared_ptr<TextureStreamer> m_texture_streamer;
+        std::unordered_map<Material*, float> m_material_screen_sizes;
         std::shared_ptr<Camera> m_camera;
 
         // Dependencies
         Profiler* m_profiler            = nullptr;
         ResourceCache* m_resource_cache = nullptr;
+        World* m_world                  = nullptr;
     };
 }
@@ -64,11 +64,15 @@ namespace Spartan
 
         float shadow_resolution;
         float fog;
-        Math::Vector2 padding;
+        float irradiance_available;
+        float padding;
 
         Math::Vector2 taa_jitter_offset_previous;
         Math::Vector2 taa_jitter_offset;
 
+        // Diffuse irradiance of the environment as spherical harmonics (see EnvironmentBake::project_irradiance())
+        std::array<Math::Vector4, 9> environment_irradiance;
+
         bool operator==(const BufferFrame& rhs) const
         {
             return
@@ -97,8 +101,10 @@ namespace Spartan
                 ssr_enabled                 == rhs.ssr_enabled &&
                 shadow_resolution           == rhs.shadow_resolution &&
                 fog                         == rhs.fog &&
+                irradiance_available        == rhs.irradiance_available &&
                 taa_jitter_offset_previous  == rhs.taa_jitter_offset_previous &&
-                taa_jitter_offset           == rhs.taa_jitter_offset;
+                taa_jitter_offset           == rhs.taa_jitter_offset &&
+                environment_irradiance      == rhs.environment_irradiance;
         }
         bool operator!=(const BufferFrame& rhs) const { return !(*this == rhs); }
     };
@@ -149,6 +155,12 @@ namespace Spartan
         float is_transparent_pass;
         float padding;
 
+        Math::Vector3 vertex_position_offset;
+        float padding2;
+
+        Math::Vector3 vertex_position_scale;
+        float padding3;
+
         bool operator==(const BufferUber& rhs) const
         {
             return
@@ -168,7 +180,9 @@ namespace Spartan
                 blur_direction      == rhs.blur_direction       &&
                 mip_index           == rhs.mip_index            &&
                 is_transparent_pass == rhs.is_transparent_pass  &&
-                resolution          == rhs.resolution;
+                resolution          == rhs.resolution           &&
+                vertex_position_offset  == rhs.vertex_position_offset   &&
+                vertex_position_scale   == rhs.vertex_position_scale;
         }
 
         bool operator!=(const BufferUber& rhs) const { return !(*this == rhs); }
@@ -90,8 +90,10 @@ namespace Spartan
     enum class RendererShader : uint8_t
     {
         Gbuffer_V,
+        Gbuffer_Packed_V,
         Gbuffer_P,
         Depth_V,
+        Depth_Packed_V,
         Depth_P,
         Quad_V,
         Texture_P,
@@ -133,6 +135,7 @@ namespace Spartan
         SsrTrace_C,
         Reflections_P,
         Entity_V,
+        Entity_Packed_V,
         Entity_Transform_P,
         BlurBox_P,
         BlurGaussian_P,
@@ -199,7 +202,11 @@ namespace Spartan
         Render_ChromaticAberration      = 1 << 21,
         Render_Dithering                = 1 << 22,
         Render_ReverseZ                 = 1 << 23,
-        Render_DepthPrepass             = 1 << 24
+        Render_DepthPrepass             = 1 << 24,
+        Render_MeshletCulling           = 1 << 25,
+        Render_Lod                      = 1 << 26,
+        Render_GeometryStreaming        = 1 << 27, // affects models that are loaded after it's enabled
+        Render_TextureStreaming         = 1 << 28  // affects textures that are loaded after it's enabled
     };
 
     // Renderer/graphics options values
@@ -211,7 +218,10 @@ namespace Spartan
         Gamma,
         Intensity,
         Sharpen_Strength,
-        Fog
+        Fog,
+        LodThreshold,
+        GeometryStreamingBudget,
+        TextureStreamingBudget
     };
 
     // Tonemapping
@@ -229,6 +239,7 @@ namespace Spartan
         Renderer_Object_Opaque,
         Renderer_Object_Transparent,
         Renderer_Object_Light,
-        Renderer_Object_Camera
+        Renderer_Object_Camera,
+        Renderer_Object_Animator
     };
 }
@@ -35,6 +35,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_PipelineState.h"
 #include "../RHI/RHI_Texture.h"
 #include "../RHI/RHI_SwapChain.h"
+#include "../World/World.h"
 #include "../World/Entity.h"
 #include "../World/Components/Camera.h"
 #include "../World/Components/Light.h"
@@ -166,8 +167,9 @@ namespace Spartan
         // Transparent objects, read the opaque depth but don't write their own, instead, they write their color information using a pixel shader.
 
         // Acquire shader
-        RHI_Shader* shader_v = m_shaders[RendererShader::Depth_V].get();
-        RHI_Shader* shader_p = m_shaders[RendererShader::Depth_P].get();
+        RHI_Shader* shader_v        = m_shaders[RendererShader::Depth_V].get();
+        RHI_Shader* shader_v_packed = m_shaders[RendererShader::Depth_Packed_V].get();
+        RHI_Shader* shader_p        = m_shaders[RendererShader::Depth_P].get();
         if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
             return;
 
@@ -182,7 +184,11 @@ namespace Spartan
         const auto& entities_light = m_entities[Renderer_Object_Light];
         for (uint32_t light_index = 0; light_index < entities_light.size(); light_index++)
         {
-            const Light* light = entities_light[light_index]->GetComponent<Light>();
+            Entity* entity_light = m_world->EntityGet(entities_light[light_index]);
+            if (!entity_light)
+                continue;
+
+            const Light* light = entity_light->GetComponent<Light>();
 
             // Skip some obvious cases
             if (!light || !light->GetShadowsEnabled())
@@ -200,8 +206,6 @@ namespace Spartan
 
             // Set render state
             static RHI_PipelineState pso;
-            pso.shader_vertex                    = shader_v;
-            pso.vertex_buffer_stride             = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
             pso.shader_pixel                     = transparent_pass ? shader_p : nullptr;
             pso.blend_state                      = transparent_pass ? m_blend_alpha.get() : m_blend_disabled.get();
             pso.depth_stencil_state              = transparent_pass ? m_depth_stencil_r_off.get() : m_depth_stencil_rw_off.get();
@@ -224,6 +228,14 @@ namespace Spartan
 
                 const Matrix& view_projection = light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
 
+                // Meshlets are culled against the cascade/face, directional lights also keep casters behind the near plane (see pancaking below)
+                MeshletView meshlet_view;
+                meshlet_view.frustum                = &light->GetFrustum(array_index);
+                meshlet_view.position               = light->GetTransform()->GetPosition();
+                meshlet_view.direction              = light->GetDirection();
+                meshlet_view.orthographic           = light->GetLightType() == LightType::Directional;
+                meshlet_view.ignore_depth_planes    = meshlet_view.orthographic;
+
                 // Set appropriate rasterizer state
                 if (light->GetLightType() == LightType::Directional)
                 {
@@ -237,72 +249,107 @@ namespace Spartan
                     pso.rasterizer_state = m_rasterizer_light_point_spot.get();
                 }
 
-                // State tracking
-                bool render_pass_active     = false;
-                uint32_t m_set_material_id  = 0;
-
-                for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
+                // Render each vertex format with its own vertex shader
+                bool render_pass_cleared = false;
+                for (const bool vertex_packed : { false, true })
                 {
-                    Entity* entity = entities[entity_index];
-
-                    // Acquire renderable component
-                    Renderable* renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
-
-                    // Skip meshes that don't cast shadows
-                    if (!renderable->GetCastShadows())
-                        continue;
-
-                    // Acquire geometry
-                    Model* model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                    if (vertex_packed && !shader_v_packed->IsCompiled())
                         continue;
 
-                    // Acquire material
-                    Material* material = renderable->GetMaterial();
-                    if (!material)
-                        continue;
-
-                    // Skip objects outside of the view frustum
-                    if (!light->IsInViewFrustrum(renderable, array_index))
-                        continue;
+                    // Set vertex format
+                    pso.shader_vertex           = vertex_packed ? shader_v_packed : shader_v;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(vertex_packed ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
 
-                    if (!render_pass_active)
+                    // Preserve what the previous vertex format has rendered
+                    if (render_pass_cleared)
                     {
-                        render_pass_active = cmd_list->BeginRenderPass(pso);
+                        pso.clear_color[0] = rhi_color_load;
+                        pso.clear_depth    = rhi_depth_load;
                     }
 
-                    // Bind material
-                    if (transparent_pass && m_set_material_id != material->GetId())
+                    // State tracking
+                    bool render_pass_active         = false;
+                    uint32_t m_set_material_id      = 0;
+                    const GeometryHeap* bound_heap  = nullptr;
+
+                    for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
                     {
-                        // Bind material textures
-                        RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
-                        cmd_list->SetTexture(RendererBindingsSrv::tex, tex_albedo ? tex_albedo : m_default_tex_white.get());
+                        Entity* entity = m_world->EntityGet(entities[entity_index]);
+                        if (!entity)
+                            continue;
+
+                        // Acquire renderable component
+                        Renderable* renderable = entity->GetRenderable();
+                        if (!renderable)
+                            continue;
+
+                        // Skip meshes that don't cast shadows
+                        if (!renderable->GetCastShadows())
+                            continue;
+
+                        // Acquire geometry
+                        Model* model = renderable->GeometryModel();
+                        SubmeshPlacement placement;
+                        if (!model || !renderable->GeometryPlacement(&placement))
+                            continue;
+
+                        // Skip geometry of the other vertex format
+                        if (model->IsVertexCompressed() != vertex_packed)
+                            continue;
+
+                        // Acquire material
+                        Material* material = renderable->GetMaterial();
+                        if (!material)
+                            continue;
+
+                        // Skip objects outside of the view frustum
+                        if (!light->IsInViewFrustrum(renderable, array_index))
+                            continue;
+
+                        if (!render_pass_active)
+                        {
+                            render_pass_active  = cmd_list->BeginRenderPass(pso);
+                            render_pass_cleared = true;
+                        }
 
-                        // Update uber buffer with material properties
-                        m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
-                        m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
-                        m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
+                        // Bind material
+                        if (transparent_pass && m_set_material_id != material->GetId())
+                        {
+                            // Bind material textures
+                            RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
+                            cmd_list->SetTexture(RendererBindingsSrv::tex, tex_albedo ? tex_albedo : m_default_tex_white.get());
 
-                        m_set_material_id = material->GetId();
-                    }
+                            // Update uber buffer with material properties
+                            m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
+                            m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
+                            m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
 
-                    // Bind geometry
-                    cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                            m_set_material_id = material->GetId();
+                        }
 
-                    // Update uber buffer with cascade transform
-                    m_buffer_uber_cpu.transform = entity->GetTransform()->GetMatrix() * view_projection;
-                    if (!UpdateUberBuffer(cmd_list))
-                        continue;
+                        // Bind geometry, models that share a heap are drawn without rebinding
+                        if (bound_heap != placement.heap)
+                        {
+                            cmd_list->SetBufferIndex(placement.heap->GetIndexBuffer().get());
+                            cmd_list->SetBufferVertex(placement.heap->GetVertexBuffer().get());
+                            bound_heap = placement.heap;
+                        }
 
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                }
+                        // Update uber buffer with cascade transform
+                        const Matrix& transform                     = entity->GetTransform()->GetMatrix();
+                        m_buffer_uber_cpu.transform                 = transform * view_projection;
+                        m_buffer_uber_cpu.vertex_position_offset    = model->GetVertexPositionOffset();
+                        m_buffer_uber_cpu.vertex_position_scale     = model->GetVertexPositionScale();
+                        if (!UpdateUberBuffer(cmd_list))
+                            continue;
+
+                        RenderableDraw(cmd_list, renderable, placement, transform, meshlet_view);
+                    }
 
-                if (render_pass_active)
-                {
-                    cmd_list->EndRenderPass();
+                    if (render_pass_active)
+                    {
+                        cmd_list->EndRenderPass();
+                    }
                 }
             }
         }
@@ -314,9 +361,10 @@ namespace Spartan
         // just their depth information into a depth map.
 
         // Acquire required resources/data
-        const auto& shader_depth    = m_shaders[RendererShader::Depth_V];
-        const auto& tex_depth       = m_render_targets[RendererRt::Gbuffer_Depth];
-        const auto& entities        = m_entities[Renderer_Object_Opaque];
+        const auto& shader_depth        = m_shaders[RendererShader::Depth_V];
+        const auto& shader_depth_packed = m_shaders[RendererShader::Depth_Packed_V];
+        const auto& tex_depth           = m_render_targets[RendererRt::Gbuffer_Depth];
+        const auto& entities            = m_entities[Renderer_Object_Opaque];
 
         // Ensure the shader has compiled
         if (!shader_depth->IsCompiled())
@@ -324,63 +372,91 @@ namespace Spartan
 
         // Set render state
         static RHI_PipelineState pso;
-        pso.shader_vertex                = shader_depth.get();
         pso.shader_pixel                 = nullptr;
         pso.rasterizer_state             = m_rasterizer_cull_back_solid.get();
         pso.blend_state                  = m_blend_disabled.get();
         pso.depth_stencil_state          = m_depth_stencil_rw_off.get();
         pso.render_target_depth_texture  = tex_depth.get();
-        pso.clear_depth                  = GetClearDepth();
         pso.viewport                     = tex_depth->GetViewport();
         pso.primitive_topology           = RHI_PrimitiveTopology_TriangleList;
         pso.pass_name                    = "Pass_DepthPrePass";
 
-        // Record commands
-        if (cmd_list->BeginRenderPass(pso))
-        { 
-            if (!entities.empty())
+        // Meshlets are culled against the camera (the g-buffer pass culls identically, so the depth matches)
+        const MeshletView meshlet_view = GetCameraMeshletView();
+
+        // Render each vertex format with its own vertex shader, the first render pass always runs so that the depth gets cleared
+        for (const bool vertex_packed : { false, true })
+        {
+            if (vertex_packed && !shader_depth_packed->IsCompiled())
+                continue;
+
+            pso.shader_vertex           = vertex_packed ? shader_depth_packed.get() : shader_depth.get();
+            pso.vertex_buffer_stride    = static_cast<uint32_t>(vertex_packed ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
+            pso.clear_depth             = vertex_packed ? rhi_depth_load : GetClearDepth();
+
+            // Variables that help reduce state changes
+            bool render_pass_active         = !vertex_packed && cmd_list->BeginRenderPass(pso);
+            const GeometryHeap* bound_heap  = nullptr;
+
+            // Draw opaque
+            for (const EntityHandle& handle : entities)
             {
-                // Variables that help reduce state changes
-                uint32_t currently_bound_geometry = 0;
+                Entity* entity = m_world->EntityGet(handle);
+                if (!entity)
+                    continue;
 
-                // Draw opaque
-                for (const auto& entity : entities)
-                {
-                    // Get renderable
-                    Renderable* renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
+                // Get renderable
+                Renderable* renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
 
-                    // Get geometry
-                    Model* model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+                // Get geometry
+                Model* model = renderable->GeometryModel();
+                SubmeshPlacement placement;
+                if (!model || !renderable->GeometryPlacement(&placement))
+                    continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!m_camera->IsInViewFrustrum(renderable))
-                        continue;
+                // Skip geometry of the other vertex format
+                if (model->IsVertexCompressed() != vertex_packed)
+                    continue;
 
-                    // Bind geometry
-                    if (currently_bound_geometry != model->GetId())
-                    {
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                        currently_bound_geometry = model->GetId();
-                    }
+                // Skip objects outside of the view frustum
+                if (!m_camera->IsInViewFrustrum(renderable))
+                    continue;
 
-                    // Update uber buffer with entity transform
-                    if (Transform* transform = entity->GetTransform())
-                    {
-                        // Update uber buffer with cascade transform
-                        m_buffer_uber_cpu.transform = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                        UpdateUberBuffer(cmd_list);
-                    }
+                if (!render_pass_active)
+                {
+                    render_pass_active = cmd_list->BeginRenderPass(pso);
+                    if (!render_pass_active)
+                        break;
+                }
+
+                // Bind geometry, models that share a heap are drawn without rebinding
+                if (bound_heap != placement.heap)
+                {
+                    cmd_list->SetBufferIndex(placement.heap->GetIndexBuffer().get());
+                    cmd_list->SetBufferVertex(placement.heap->GetVertexBuffer().get());
+                    bound_heap = placement.heap;
+                }
 
-                    // Draw    
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                // Update uber buffer with entity transform
+                if (Transform* transform = entity->GetTransform())
+                {
+                    // Update uber buffer with cascade transform
+                    m_buffer_uber_cpu.transform                 = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
+                    m_buffer_uber_cpu.vertex_position_offset    = model->GetVertexPositionOffset();
+                    m_buffer_uber_cpu.vertex_position_scale     = model->GetVertexPositionScale();
+                    UpdateUberBuffer(cmd_list);
                 }
+
+                // Draw    
+                RenderableDraw(cmd_list, renderable, placement, entity->GetTransform()->GetMatrix(), meshlet_view);
+            }
+
+            if (render_pass_active)
+            {
+                cmd_list->EndRenderPass();
             }
-            cmd_list->EndRenderPass();
         }
     }
 
@@ -393,6 +469,7 @@ namespace Spartan
         RHI_Texture* tex_velocity     = m_render_targets[RendererRt::Gbuffer_Velocity].get();
         RHI_Texture* tex_depth        = m_render_targets[RendererRt::Gbuffer_Depth].get();
         RHI_Shader* shader_v          = m_shaders[RendererShader::Gbuffer_V].get();
+        RHI_Shader* shader_v_packed   = m_shaders[RendererShader::Gbuffer_Packed_V].get();
         ShaderGBuffer* shader_p       = static_cast<ShaderGBuffer*>(m_shaders[RendererShader::Gbuffer_P].get());
 
         // Validate that the shader has compiled
@@ -401,7 +478,6 @@ namespace Spartan
 
         // Set render state
         RHI_PipelineState pso;
-        pso.shader_vertex                   = shader_v;
         pso.blend_state                     = m_blend_disabled.get();
         pso.rasterizer_state                = GetOption(Render_Debug_Wireframe) ? m_rasterizer_cull_back_wireframe.get() : m_rasterizer_cull_back_solid.get();
         pso.depth_stencil_state             = is_transparent_pass ? m_depth_stencil_rw_w.get() : (GetOption(Render_DepthPrepass) ? m_depth_stencil_r_off.get() : m_depth_stencil_rw_off.get());
@@ -417,146 +493,172 @@ namespace Spartan
         pso.clear_depth                     = (is_transparent_pass || GetOption(Render_DepthPrepass)) ? rhi_depth_load : GetClearDepth();
         pso.clear_stencil                   = !is_transparent_pass ? 0 : rhi_stencil_dont_care;
         pso.viewport                        = tex_albedo->GetViewport();
-        pso.vertex_buffer_stride            = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
         pso.primitive_topology              = RHI_PrimitiveTopology_TriangleList;
 
+        // Meshlets are culled against the camera
+        const MeshletView meshlet_view = GetCameraMeshletView();
+
         bool cleared = false;
         uint32_t material_index = 0;
         uint32_t material_bound_id = 0;
         m_material_instances.fill(nullptr);
 
-        // Iterate through all the G-Buffer shader variations
-        for (const auto& it : ShaderGBuffer::GetVariations())
+        // Iterate through the vertex formats, each one has its own vertex shader
+        for (const bool vertex_packed : { false, true })
         {
-            // Skip the shader until it compiles or the users spots a compilation error
-            if (!it.second->IsCompiled())
+            if (vertex_packed && !shader_v_packed->IsCompiled())
                 continue;
 
-            // Set pixel shader
-            pso.shader_pixel = static_cast<RHI_Shader*>(it.second.get());
-
-            // Set pass name
-            pso.pass_name = is_transparent_pass ? "GBuffer_Transparent" : "GBuffer_Opaque";
+            pso.shader_vertex           = vertex_packed ? shader_v_packed : shader_v;
+            pso.vertex_buffer_stride    = static_cast<uint32_t>(vertex_packed ? sizeof(RHI_Vertex_PosTexNorTanPacked) : sizeof(RHI_Vertex_PosTexNorTan));
 
-            bool render_pass_active = false;
-            auto& entities = m_entities[is_transparent_pass ? Renderer_Object_Transparent : Renderer_Object_Opaque];
-
-            // Record commands
-            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+            // Iterate through all the G-Buffer shader variations
+            for (const auto& it : ShaderGBuffer::GetVariations())
             {
-                Entity* entity = entities[i];
-
-                // Get renderable
-                Renderable* renderable = entity->GetRenderable();
-                if (!renderable)
+                // Skip the shader until it compiles or the users spots a compilation error
+                if (!it.second->IsCompiled())
                     continue;
 
-                // Get material
-                Material* material = renderable->GetMaterial();
-                if (!material)
-                    continue;
+                // Set pixel shader
+                pso.shader_pixel = static_cast<RHI_Shader*>(it.second.get());
 
-                // Skip objects with different shader requirements
-                if (!static_cast<ShaderGBuffer*>(pso.shader_pixel)->IsSuitable(material->GetFlags()))
-                    continue;
+                // Set pass name
+                pso.pass_name = is_transparent_pass ? "GBuffer_Transparent" : "GBuffer_Opaque";
 
-                // Skip transparent objects that won't contribute
-                if (material->GetColorAlbedo().w == 0 && is_transparent_pass)
-                    continue;
+                bool render_pass_active         = false;
+                const GeometryHeap* bound_heap  = nullptr;
+                auto& entities = m_entities[is_transparent_pass ? Renderer_Object_Transparent : Renderer_Object_Opaque];
 
-                // Get geometry
-                Model* model = renderable->GeometryModel();
-                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                    continue;
+                // Record commands
+                for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+                {
+                    Entity* entity = m_world->EntityGet(entities[i]);
+                    if (!entity)
+                        continue;
 
-                // Skip objects outside of the view frustum
-                if (!m_camera->IsInViewFrustrum(renderable))
-                    continue;
+                    // Get renderable
+                    Renderable* renderable = entity->GetRenderable();
+                    if (!renderable)
+                        continue;
 
-                if (!render_pass_active)
-                {
-                    // Reset clear values after the first render pass
-                    if (cleared)
-                    {
-                        pso.ResetClearValues();
-                    }
+                    // Get material
+                    Material* material = renderable->GetMaterial();
+                    if (!material)
+                        continue;
 
-                    render_pass_active = cmd_list->BeginRenderPass(pso);
+                    // Skip objects with different shader requirements
+                    if (!static_cast<ShaderGBuffer*>(pso.shader_pixel)->IsSuitable(material->GetFlags()))
+                        continue;
 
-                    cleared = true;
-                }
+                    // Skip transparent objects that won't contribute
+                    if (material->GetColorAlbedo().w == 0 && is_transparent_pass)
+                        continue;
 
-                // Set geometry (will only happen if not already set)
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                    // Get geometry
+                    Model* model = renderable->GeometryModel();
+                    SubmeshPlacement placement;
+                    if (!model || !renderable->GeometryPlacement(&placement))
+                        continue;
 
-                // Bind material
-                const bool firs_run       = material_index == 0;
-                const bool new_material   = material_bound_id != material->GetId();
-                if (firs_run || new_material)
-                {
-                    material_bound_id = material->GetId();
+                    // Skip geometry of the other vertex format
+                    if (model->IsVertexCompressed() != vertex_packed)
+                        continue;
 
-                    // Keep track of used material instances (they get mapped to shaders)
-                    if (material_index + 1 < m_material_instances.size())
+                    // Skip objects outside of the view frustum
+                    if (!m_camera->IsInViewFrustrum(renderable))
+                        continue;
+
+                    if (!render_pass_active)
                     {
-                        // Advance index (0 is reserved for the sky)
-                        material_index++;
+                        // Reset clear values after the first render pass
+                        if (cleared)
+                        {
+                            pso.ResetClearValues();
+                        }
+
+                        render_pass_active = cmd_list->BeginRenderPass(pso);
 
-                        // Keep reference
-                        m_material_instances[material_index] = material;
+                        cleared = true;
                     }
-                    else
+
+                    // Set geometry, models that share a heap are drawn without rebinding
+                    if (bound_heap != placement.heap)
                     {
-                        LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
+                        cmd_list->SetBufferIndex(placement.heap->GetIndexBuffer().get());
+                        cmd_list->SetBufferVertex(placement.heap->GetVertexBuffer().get());
+                        bound_heap = placement.heap;
                     }
 
-                    // Bind material textures
-                    cmd_list->SetTexture(RendererBindingsSrv::material_albedo,      material->GetTexture_Ptr(Material_Color));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_roughness,   material->GetTexture_Ptr(Material_Roughness));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_metallic,    material->GetTexture_Ptr(Material_Metallic));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_normal,      material->GetTexture_Ptr(Material_Normal));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_height,      material->GetTexture_Ptr(Material_Height));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_occlusion,   material->GetTexture_Ptr(Material_Occlusion));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_emission,    material->GetTexture_Ptr(Material_Emission));
-                    cmd_list->SetTexture(RendererBindingsSrv::material_mask,        material->GetTexture_Ptr(Material_Mask));
+                    // Bind material
+                    const bool firs_run       = material_index == 0;
+                    const bool new_material   = material_bound_id != material->GetId();
+                    if (firs_run || new_material)
+                    {
+                        material_bound_id = material->GetId();
+
+                        // Keep track of used material instances (they get mapped to shaders)
+                        if (material_index + 1 < m_material_instances.size())
+                        {
+                            // Advance index (0 is reserved for the sky)
+                            material_index++;
+
+                            // Keep reference
+                            m_material_instances[material_index] = material;
+                        }
+                        else
+                        {
+                            LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
+                        }
+
+                        // Bind material textures
+                        cmd_list->SetTexture(RendererBindingsSrv::material_albedo,      material->GetTexture_Ptr(Material_Color));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_roughness,   material->GetTexture_Ptr(Material_Roughness));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_metallic,    material->GetTexture_Ptr(Material_Metallic));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_normal,      material->GetTexture_Ptr(Material_Normal));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_height,      material->GetTexture_Ptr(Material_Height));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_occlusion,   material->GetTexture_Ptr(Material_Occlusion));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_emission,    material->GetTexture_Ptr(Material_Emission));
+                        cmd_list->SetTexture(RendererBindingsSrv::material_mask,        material->GetTexture_Ptr(Material_Mask));
                 
-                    // Update uber buffer with material properties
-                    m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
-                    m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
-                    m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
-                    m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
-                    m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
-                    m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
-                    m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
-                    m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
-
-                    // Update constant buffer
-                    UpdateUberBuffer(cmd_list);
-                }
+                        // Update uber buffer with material properties
+                        m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
+                        m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
+                        m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
+                        m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
+                        m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
+                        m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
+                        m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
+                        m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+
+                        // Update constant buffer
+                        UpdateUberBuffer(cmd_list);
+                    }
                 
-                // Update uber buffer with entity transform
-                if (Transform* transform = entity->GetTransform())
-                {
-                    m_buffer_uber_cpu.transform             = transform->GetMatrix();
-                    m_buffer_uber_cpu.transform_previous    = transform->GetMatrixPrevious();
+                    // Update uber buffer with entity transform
+                    if (Transform* transform = entity->GetTransform())
+                    {
+                        m_buffer_uber_cpu.transform                 = transform->GetMatrix();
+                        m_buffer_uber_cpu.transform_previous        = transform->GetMatrixPrevious();
+                        m_buffer_uber_cpu.vertex_position_offset    = model->GetVertexPositionOffset();
+                        m_buffer_uber_cpu.vertex_position_scale     = model->GetVertexPositionScale();
 
-                    // Save matrix for velocity computation
-                    transform->SetWvpLastFrame(m_buffer_uber_cpu.transform);
+                        // Save matrix for velocity computation
+                        transform->SetWvpLastFrame(m_buffer_uber_cpu.transform);
 
-                    // Update object buffer
-                    if (!UpdateUberBuffer(cmd_list))
-                        continue;
-                }
+                        // Update object buffer
+                        if (!UpdateUberBuffer(cmd_list))
+                            continue;
+                    }
                 
-                // Render
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                m_profiler->m_renderer_meshes_rendered++;
-            }
+                    // Render
+                    RenderableDraw(cmd_list, renderable, placement, entity->GetTransform()->GetMatrix(), meshlet_view);
+                    m_profiler->m_renderer_meshes_rendered++;
+                }
 
-            if (render_pass_active)
-            {
-                cmd_list->EndRenderPass();
+                if (render_pass_active)
+                {
+                    cmd_list->EndRenderPass();
+                }
             }
         }
     }
@@ -789,7 +891,7 @@ namespace Spartan
     void Renderer::Pass_Light(RHI_CommandList* cmd_list, const bool is_transparent_pass /*= false*/)
     {
         // Acquire lights
-        const vector<Entity*>& entities = m_entities[Renderer_Object_Light];
+        const vector<EntityHandle>& entities = m_entities[Renderer_Object_Light];
         if (entities.empty())
             return;
 
@@ -808,8 +910,12 @@ namespace Spartan
         pso.pass_name = is_transparent_pass ? "Pass_Light_Transparent" : "Pass_Light_Opaque";
 
         // Iterate through all the light entities
-        for (const auto& entity : entities)
+        for (const EntityHandle& handle : entities)
         {
+            Entity* entity = m_world->EntityGet(handle);
+            if (!entity)
+                continue;
+
             if (Light* light = entity->GetComponent<Light>())
             {
                 if (light->GetIntensity() != 0)
@@ -1901,11 +2007,12 @@ namespace Spartan
             if (draw_lights)
             {
                 auto& lights = m_entities[Renderer_Object_Light];
-                for (const auto& entity : lights)
+                for (const EntityHandle& handle : lights)
                 {
-                    Light* light = entity->GetComponent<Light>();
+                    Entity* entity = m_world->EntityGet(handle);
+                    Light* light   = entity ? entity->GetComponent<Light>() : nullptr;
 
-                    if (light->GetLightType() == LightType::Spot)
+                    if (light && light->GetLightType() == LightType::Spot)
                     {
                         Vector3 start = light->GetTransform()->GetPosition();
                         Vector3 end = light->GetTransform()->GetForward() * light->GetRange();
@@ -1917,17 +2024,19 @@ namespace Spartan
             // AABBs
             if (draw_aabb)
             {
-                for (const auto& entity : m_entities[Renderer_Object_Opaque])
+                for (const EntityHandle& handle : m_entities[Renderer_Object_Opaque])
                 {
-                    if (auto renderable = entity->GetRenderable())
+                    Entity* entity = m_world->EntityGet(handle);
+                    if (auto renderable = entity ? entity->GetRenderable() : nullptr)
                     {
                         DrawDebugBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
                     }
                 }
 
-                for (const auto& entity : m_entities[Renderer_Object_Transparent])
+                for (const EntityHandle& handle : m_entities[Renderer_Object_Transparent])
                 {
-                    if (auto renderable = entity->GetRenderable())
+                    Entity* entity = m_world->EntityGet(handle);
+                    if (auto renderable = entity ? entity->GetRenderable() : nullptr)
                     {
                         DrawDebugBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
                     }
@@ -2040,11 +2149,15 @@ namespace Spartan
         pso.pass_name                        = "Pass_Icons";
 
         // For each light
-        for (const auto& entity : lights)
+        for (const EntityHandle& handle : lights)
         {
+            // The entity can be null if it just got removed and our buffer doesn't update till the next frame
+            Entity* entity = m_world->EntityGet(handle);
+            if (!entity)
+                continue;
+
             if (cmd_list->BeginRenderPass(pso))
             {
-                // Light can be null if it just got removed and our buffer doesn't update till the next frame
                 if (Light* light = entity->GetComponent<Light>())
                 {
                     auto position_light_world       = entity->GetTransform()->GetPosition();
@@ -2114,6 +2227,11 @@ namespace Spartan
         // Transform
         if (m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed))
         {
+            // The handle's geometry is in a geometry heap, like that of any other model
+            const GeometryAllocation& geometry = m_gizmo_transform->GetHandle().GetGeometry();
+            if (!geometry.IsValid())
+                return;
+
             // Set render state
             static RHI_PipelineState pso;
             pso.shader_vertex                    = shader_gizmo_transform_v.get();
@@ -2121,7 +2239,7 @@ namespace Spartan
             pso.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
             pso.blend_state                      = m_blend_alpha.get();
             pso.depth_stencil_state              = m_depth_stencil_off_off.get();
-            pso.vertex_buffer_stride             = m_gizmo_transform->GetVertexBuffer()->GetStride();
+            pso.vertex_buffer_stride             = geometry.heap->GetVertexStride();
             pso.render_target_color_textures[0]  = tex_out;
             pso.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
             pso.viewport                         = tex_out->GetViewport();
@@ -2134,9 +2252,9 @@ namespace Spartan
                 m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Right);
                 UpdateUberBuffer(cmd_list);
             
-                cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
+                cmd_list->SetBufferIndex(geometry.heap->GetIndexBuffer().get());
+                cmd_list->SetBufferVertex(geometry.heap->GetVertexBuffer().get());
+                cmd_list->DrawIndexed(geometry.index_count, geometry.index_offset, geometry.vertex_offset);
                 cmd_list->EndRenderPass();
             }
             
@@ -2148,9 +2266,9 @@ namespace Spartan
                 m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Up);
                 UpdateUberBuffer(cmd_list);
 
-                cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
+                cmd_list->SetBufferIndex(geometry.heap->GetIndexBuffer().get());
+                cmd_list->SetBufferVertex(geometry.heap->GetVertexBuffer().get());
+                cmd_list->DrawIndexed(geometry.index_count, geometry.index_offset, geometry.vertex_offset);
                 cmd_list->EndRenderPass();
             }
             
@@ -2162,9 +2280,9 @@ namespace Spartan
                 m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Forward);
                 UpdateUberBuffer(cmd_list);
 
-                cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
+                cmd_list->SetBufferIndex(geometry.heap->GetIndexBuffer().get());
+                cmd_list->SetBufferVertex(geometry.heap->GetVertexBuffer().get());
+                cmd_list->DrawIndexed(geometry.index_count, geometry.index_offset, geometry.vertex_offset);
                 cmd_list->EndRenderPass();
             }
             
@@ -2178,9 +2296,9 @@ namespace Spartan
                     m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::One);
                     UpdateUberBuffer(cmd_list);
 
-                    cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                    cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
+                    cmd_list->SetBufferIndex(geometry.heap->GetIndexBuffer().get());
+                    cmd_list->SetBufferVertex(geometry.heap->GetVertexBuffer().get());
+                    cmd_list->DrawIndexed(geometry.index_count, geometry.index_offset, geometry.vertex_offset);
                     cmd_list->EndRenderPass();
                 }
             }
@@ -2204,13 +2322,14 @@ namespace Spartan
             if (!material)
                 return;
 
-            // Get geometry
+            // Get geometry (streamed geometry can only be outlined while it's resident)
             const Model* model = renderable->GeometryModel();
-            if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+            SubmeshPlacement placement;
+            if (!model || !renderable->GeometryPlacement(&placement))
                 return;
 
             // Acquire shaders
-            const auto& shader_v = m_shaders[RendererShader::Entity_V];
+            const auto& shader_v = m_shaders[model->IsVertexCompressed() ? RendererShader::Entity_Packed_V : RendererShader::Entity_V];
             const auto& shader_p = m_shaders[RendererShader::Entity_Outline_P];
             if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
                 return;
@@ -2225,7 +2344,7 @@ namespace Spartan
             pso.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
             pso.blend_state                              = m_blend_alpha.get();
             pso.depth_stencil_state                      = m_depth_stencil_r_off.get();
-            pso.vertex_buffer_stride                     = model->GetVertexBuffer()->GetStride();
+            pso.vertex_buffer_stride                     = placement.heap->GetVertexStride();
             pso.render_target_color_textures[0]          = tex_out;
             pso.render_target_depth_texture              = tex_depth;
             pso.render_target_depth_texture_read_only    = true;
@@ -2239,16 +2358,18 @@ namespace Spartan
                  // Update uber buffer with entity transform
                 if (Transform* transform = entity->GetTransform())
                 {
-                    m_buffer_uber_cpu.transform     = transform->GetMatrix();
-                    m_buffer_uber_cpu.resolution    = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
+                    m_buffer_uber_cpu.transform                 = transform->GetMatrix();
+                    m_buffer_uber_cpu.resolution                = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
+                    m_buffer_uber_cpu.vertex_position_offset    = model->GetVertexPositionOffset();
+                    m_buffer_uber_cpu.vertex_position_scale     = model->GetVertexPositionScale();
                     UpdateUberBuffer(cmd_list);
                 }
 
                 cmd_list->SetTexture(RendererBindingsSrv::gbuffer_depth, tex_depth);
                 cmd_list->SetTexture(RendererBindingsSrv::gbuffer_normal, tex_normal);
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                cmd_list->SetBufferVertex(placement.heap->GetVertexBuffer().get());
+                cmd_list->SetBufferIndex(placement.heap->GetIndexBuffer().get());
+                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), static_cast<uint32_t>(renderable->GeometryIndexOffset() + placement.index_delta), placement.vertex_offset);
                 cmd_list->EndRenderPass();
             }
         }
@@ -190,6 +190,11 @@ namespace Spartan
         m_shaders[RendererShader::Gbuffer_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[RendererShader::Gbuffer_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
 
+        // G-Buffer - Compressed vertices
+        m_shaders[RendererShader::Gbuffer_Packed_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[RendererShader::Gbuffer_Packed_V]->AddDefine("VERTEX_PACKED");
+        m_shaders[RendererShader::Gbuffer_Packed_V]->CompileAsync<RHI_Vertex_PosTexNorTanPacked>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+
         // Quad
         {
             // Vertex
@@ -204,6 +209,9 @@ namespace Spartan
         // Depth Vertex
         m_shaders[RendererShader::Depth_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[RendererShader::Depth_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[RendererShader::Depth_Packed_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[RendererShader::Depth_Packed_V]->AddDefine("VERTEX_PACKED");
+        m_shaders[RendererShader::Depth_Packed_V]->CompileAsync<RHI_Vertex_PosTexNorTanPacked>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
         m_shaders[RendererShader::Depth_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[RendererShader::Depth_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
 
@@ -356,6 +364,11 @@ namespace Spartan
         m_shaders[RendererShader::Entity_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[RendererShader::Entity_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
 
+        // Entity - Compressed vertices
+        m_shaders[RendererShader::Entity_Packed_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[RendererShader::Entity_Packed_V]->AddDefine("VERTEX_PACKED");
+        m_shaders[RendererShader::Entity_Packed_V]->CompileAsync<RHI_Vertex_PosTexNorTanPacked>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
+
         // Entity - Transform
         m_shaders[RendererShader::Entity_Transform_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[RendererShader::Entity_Transform_P]->AddDefine("TRANSFORM");
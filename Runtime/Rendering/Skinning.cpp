@@ -0,0 +1,257 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "Skinning.h"
+#include "Model.h"
+#include "Animation.h"
+#include "../Core/Stopwatch.h"
+#include "../Threading/Threading.h"
+#include "../RHI/RHI_Vertex.h"
+#include <xmmintrin.h>
+//=================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan::Skinning
+{
+    // Only x, y and z are normalized (w is zero for directions), with a step of Newton-Raphson on top of the estimate
+    static inline __m128 normalize3(const __m128 v)
+    {
+        const __m128 squared        = _mm_mul_ps(v, v);
+        const __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(squared, squared, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 2, 2, 2)));
+        const __m128 clamped        = _mm_max_ps(length_squared, _mm_set1_ps(1e-12f));
+        const __m128 estimate       = _mm_rsqrt_ps(clamped);
+        const __m128 refined        = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(clamped, estimate), estimate)));
+
+        return _mm_mul_ps(v, refined);
+    }
+
+    static inline __m128 transform_direction(const float x, const float y, const float z, const __m128 row0, const __m128 row1, const __m128 row2)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(x), row0), _mm_mul_ps(_mm_set1_ps(y), row1)), _mm_mul_ps(_mm_set1_ps(z), row2));
+    }
+
+    static inline void store3(const __m128 v, float* destination)
+    {
+        alignas(16) float values[4];
+        _mm_store_ps(values, v);
+        destination[0] = values[0];
+        destination[1] = values[1];
+        destination[2] = values[2];
+    }
+
+    void blend(const BoneTransform* pose_a, const BoneTransform* pose_b, const float weight, const uint32_t bone_count, BoneTransform* pose)
+    {
+        for (uint32_t i = 0; i < bone_count; i++)
+        {
+            const Quaternion& a = pose_a[i].rotation;
+            const Quaternion& b = pose_b[i].rotation;
+
+            // Along the shortest path, q and -q are the same rotation
+            const float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+            Quaternion rotation
+            (
+                a.x + (b.x * sign - a.x) * weight,
+                a.y + (b.y * sign - a.y) * weight,
+                a.z + (b.z * sign - a.z) * weight,
+                a.w + (b.w * sign - a.w) * weight
+            );
+            rotation.Normalize();
+
+            pose[i].position    = Helper::Lerp(pose_a[i].position, pose_b[i].position, weight);
+            pose[i].scale       = Helper::Lerp(pose_a[i].scale, pose_b[i].scale, weight);
+            pose[i].rotation    = rotation;
+        }
+    }
+
+    void compute_bone_matrices(const AnimationBone* bones, const uint32_t bone_count, const BoneTransform* pose, Matrix* bone_matrices)
+    {
+        // Parents come before their children, so theirs are always ready
+        for (uint32_t i = 0; i < bone_count; i++)
+        {
+            const Matrix local  = Matrix(pose[i].position, pose[i].rotation, pose[i].scale);
+            const int32_t parent = bones[i].parent;
+            bone_matrices[i]    = parent >= 0 ? local * bone_matrices[parent] : local;
+        }
+    }
+
+    void compute_palette(const AnimationBone* bones, const uint32_t bone_count, const Matrix* bone_matrices, const Matrix& mesh_inverse, Matrix* palette)
+    {
+        for (uint32_t i = 0; i < bone_count; i++)
+        {
+            palette[i] = Matrix::Transpose(bones[i].offset * bone_matrices[i] * mesh_inverse);
+        }
+        palette[bone_count] = Matrix::Identity;
+    }
+
+    void skin(const byte* vertices, const BoneWeights* weights, const uint32_t vertex_count, const Matrix* palette, RHI_Vertex_PosTexNorTan* output, BoundingBox* aabb)
+    {
+        __m128 position_min = _mm_set1_ps(numeric_limits<float>::max());
+        __m128 position_max = _mm_set1_ps(-numeric_limits<float>::max());
+
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            RHI_Vertex_PosTexNorTan vertex;
+            memcpy(&vertex, vertices + static_cast<uint64_t>(i) * sizeof(RHI_Vertex_PosTexNorTan), sizeof(RHI_Vertex_PosTexNorTan));
+            const BoneWeights& bone_weights = weights[i];
+
+            // Blend the matrices of the bones that the vertex follows, unused influences have a weight of zero
+            __m128 row0 = _mm_setzero_ps();
+            __m128 row1 = _mm_setzero_ps();
+            __m128 row2 = _mm_setzero_ps();
+            __m128 row3 = _mm_setzero_ps();
+            for (uint32_t k = 0; k < bone_influence_count; k++)
+            {
+                const float* matrix     = palette[bone_weights.indices[k]].Data();
+                const __m128 weight     = _mm_set1_ps(bone_weights.weights[k]);
+                row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(matrix + 0), weight));
+                row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(matrix + 4), weight));
+                row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(matrix + 8), weight));
+                row3 = _mm_add_ps(row3, _mm_mul_ps(_mm_loadu_ps(matrix + 12), weight));
+            }
+
+            const __m128 position   = _mm_add_ps(transform_direction(vertex.pos[0], vertex.pos[1], vertex.pos[2], row0, row1, row2), row3);
+            const __m128 normal     = normalize3(transform_direction(vertex.nor[0], vertex.nor[1], vertex.nor[2], row0, row1, row2));
+            const __m128 tangent    = normalize3(transform_direction(vertex.tan[0], vertex.tan[1], vertex.tan[2], row0, row1, row2));
+
+            position_min = _mm_min_ps(position_min, position);
+            position_max = _mm_max_ps(position_max, position);
+
+            RHI_Vertex_PosTexNorTan& skinned = output[i];
+            store3(position, skinned.pos);
+            store3(normal, skinned.nor);
+            store3(tangent, skinned.tan);
+            skinned.tex[0] = vertex.tex[0];
+            skinned.tex[1] = vertex.tex[1];
+        }
+
+        if (aabb)
+        {
+            Vector3 min;
+            Vector3 max;
+            store3(position_min, &min.x);
+            store3(position_max, &max.x);
+            *aabb = vertex_count != 0 ? BoundingBox(min, max) : BoundingBox();
+        }
+    }
+
+    void benchmark(Threading* threading, const Model* model, const uint32_t instance_count)
+    {
+        if (!threading || !model || instance_count == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        const vector<AnimationBone>& bones              = model->GetBones();
+        const vector<BoneWeights>& weights              = model->GetBoneWeights();
+        const vector<shared_ptr<Animation>>& animations = model->GetAnimations();
+        if (bones.empty() || animations.empty() || weights.empty())
+        {
+            LOG_ERROR("\"%s\" has no skeleton or no animations", model->GetResourceName().c_str());
+            return;
+        }
+
+        const Animation* animation      = animations.front().get();
+        const uint32_t bone_count       = static_cast<uint32_t>(bones.size());
+        const uint32_t vertex_count     = static_cast<uint32_t>(weights.size());
+        const byte* vertices            = model->GetVertexData();
+        const float duration            = Helper::Max(animation->GetDuration(), Helper::EPSILON);
+
+        // The stages of a single instance, the instances are spread over the animation (and half of them blend two points of it)
+        struct Scratch
+        {
+            vector<BoneTransform> pose;
+            vector<BoneTransform> pose_blend;
+            vector<Matrix> bone_matrices;
+            vector<Matrix> palette;
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+        };
+        const auto animate = [&](const uint32_t instance, Scratch& scratch, double* durations_ms)
+        {
+            const float time = fmod(static_cast<float>(instance) * 0.137f, duration);
+
+            Stopwatch timer;
+            scratch.pose.assign(bone_count, BoneTransform());
+            for (uint32_t i = 0; i < bone_count; i++)
+            {
+                scratch.pose[i] = bones[i].rest;
+            }
+            animation->Sample(time, scratch.pose.data(), bone_count);
+            if (instance % 2 == 1)
+            {
+                scratch.pose_blend = scratch.pose;
+                animation->Sample(fmod(time + duration * 0.5f, duration), scratch.pose_blend.data(), bone_count);
+                blend(scratch.pose.data(), scratch.pose_blend.data(), 0.5f, bone_count, scratch.pose.data());
+            }
+            durations_ms[0] += timer.GetElapsedTimeMs();
+
+            timer.Start();
+            scratch.bone_matrices.resize(bone_count);
+            scratch.palette.resize(bone_count + 1);
+            compute_bone_matrices(bones.data(), bone_count, scratch.pose.data(), scratch.bone_matrices.data());
+            compute_palette(bones.data(), bone_count, scratch.bone_matrices.data(), Matrix::Identity, scratch.palette.data());
+            durations_ms[1] += timer.GetElapsedTimeMs();
+
+            timer.Start();
+            scratch.vertices.resize(vertex_count);
+            BoundingBox aabb;
+            skin(vertices, weights.data(), vertex_count, scratch.palette.data(), scratch.vertices.data(), &aabb);
+            durations_ms[2] += timer.GetElapsedTimeMs();
+        };
+
+        // The stages on a single thread
+        const uint32_t instance_count_serial = Helper::Min(instance_count, 64u);
+        double durations_ms[3] = { 0.0, 0.0, 0.0 };
+        {
+            Scratch scratch;
+            for (uint32_t i = 0; i < instance_count_serial; i++)
+            {
+                animate(i, scratch, durations_ms);
+            }
+        }
+
+        // All of the instances, in parallel like the renderer does it
+        const Stopwatch timer;
+        threading->ParallelFor(instance_count, [&animate](const uint32_t i)
+        {
+            thread_local Scratch scratch;
+            double durations_ignored_ms[3] = { 0.0, 0.0, 0.0 };
+            animate(i, scratch, durations_ignored_ms);
+        });
+        const double duration_parallel_ms = timer.GetElapsedTimeMs();
+
+        const double per_instance = 1.0 / static_cast<double>(instance_count_serial);
+        LOG_INFO("Skinning \"%s\" (%d bones, %d vertices, %d keys)", model->GetResourceName().c_str(), bone_count, vertex_count, animation->GetKeyCount());
+        LOG_INFO("Per instance: sampling and blending %.4f ms, bone matrices and palette %.4f ms, skinning %.4f ms (%.1f million vertices per second)",
+            durations_ms[0] * per_instance,
+            durations_ms[1] * per_instance,
+            durations_ms[2] * per_instance,
+            static_cast<double>(vertex_count) * instance_count_serial / (Helper::Max(durations_ms[2], 0.001) * 1000.0)
+        );
+        LOG_INFO("%d instances on %d threads: %.2f ms", instance_count, threading->GetThreadCount(), duration_parallel_ms);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../RHI/RHI_Definition.h"
+#include "../Math/Matrix.h"
+#include "../Math/BoundingBox.h"
+//================================
+
+namespace Spartan
+{
+    class Model;
+    class Threading;
+    struct BoneTransform;
+    struct AnimationBone;
+    struct BoneWeights;
+
+    // Cpu skinning, in stages that the Animator runs for each instance: poses are sampled (see Animation::Sample()) and blended,
+    // turned into the matrices of the bones and then into a palette for each mesh, which the vertices are transformed with.
+    namespace Skinning
+    {
+        // Blends two poses, a weight of zero is the first pose and a weight of one is the second (the result can be either of them)
+        void blend(const BoneTransform* pose_a, const BoneTransform* pose_b, float weight, uint32_t bone_count, BoneTransform* pose);
+
+        // Concatenates the transforms of the bones with their parents', which gives the bones in the space of the skeleton's root
+        void compute_bone_matrices(const AnimationBone* bones, uint32_t bone_count, const BoneTransform* pose, Math::Matrix* bone_matrices);
+
+        // The matrices that the vertices of a mesh are transformed with, mesh_inverse takes them back from the space of the skeleton's root to the mesh's.
+        // The palette has a matrix more than there are bones, the identity, for the vertices that no bone influences. The matrices are transposed
+        // so that their rows are contiguous in memory, which is what skin() wants.
+        void compute_palette(const AnimationBone* bones, uint32_t bone_count, const Math::Matrix* bone_matrices, const Math::Matrix& mesh_inverse, Math::Matrix* palette);
+
+        // Transforms the vertices (SSE), vertices don't have to be aligned as they can come straight from a mapped file.
+        // The bounding box of the skinned vertices is returned, as animated meshes can leave the bounds of their bind pose.
+        void skin(const std::byte* vertices, const BoneWeights* weights, uint32_t vertex_count, const Math::Matrix* palette, RHI_Vertex_PosTexNorTan* output, Math::BoundingBox* aabb);
+
+        // Animates instances of a model in parallel (without uploading them) and logs how long each stage takes
+        void benchmark(Threading* threading, const Model* model, uint32_t instance_count);
+    }
+}
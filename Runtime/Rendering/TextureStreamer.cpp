@@ -0,0 +1,261 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "TextureStreamer.h"
+#include "../RHI/RHI_Texture.h"
+#include "../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    // Limits that keep a burst of requests (e.g. a camera cut) from stalling a frame
+    static const uint32_t loads_in_flight_max       = 16;
+    static const uint64_t upload_size_per_frame_max = 64 * 1024 * 1024;
+
+    TextureStreamer::TextureStreamer(Context* context)
+    {
+        m_context = context;
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        // Loads in flight only hold on to their own data, so they can finish after the streamer is gone
+        lock_guard<mutex> lock(m_mutex);
+        m_loads.clear();
+        m_textures.clear();
+    }
+
+    bool TextureStreamer::Register(RHI_Texture* texture)
+    {
+        if (!texture || texture->GetMipOffsets().size() != texture->GetMipCount() || texture->GetMipResident() == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        StreamedTexture& streamed   = m_textures[texture];
+        streamed.registration       = ++m_registrations;
+        streamed.file_path          = texture->GetResourceFilePathNative();
+        streamed.mip_offsets        = texture->GetMipOffsets();
+        streamed.size               = Helper::Max(texture->GetWidth(), texture->GetHeight());
+        streamed.mip_tail           = texture->GetMipResident();
+        streamed.mip_resident       = texture->GetMipResident();
+        streamed.mip_wanted         = texture->GetMipResident();
+        streamed.screen_size        = 0.0f;
+        streamed.is_loading         = false;
+
+        // Sum the mips up from the smallest one, so that the size of any resident range is a lookup
+        const uint8_t mip_count = texture->GetMipCount();
+        streamed.mip_sizes.assign(mip_count, 0);
+        for (int32_t mip_index = mip_count - 1; mip_index >= 0; mip_index--)
+        {
+            const uint64_t mip_size     = rhi_format_mip_size(texture->GetFormat(), texture->GetWidth() >> mip_index, texture->GetHeight() >> mip_index, texture->GetBytesPerPixel());
+            streamed.mip_sizes[mip_index] = mip_size + (mip_index + 1 < mip_count ? streamed.mip_sizes[mip_index + 1] : 0);
+        }
+
+        m_size_resident += streamed.mip_sizes[streamed.mip_resident];
+
+        return true;
+    }
+
+    void TextureStreamer::Unregister(RHI_Texture* texture)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_textures.find(texture);
+        if (it == m_textures.end())
+            return;
+
+        // Loads of this texture are dropped when they complete, as the registration no longer matches
+        m_size_resident -= it->second.mip_sizes[it->second.mip_resident];
+        m_textures.erase(it);
+    }
+
+    void TextureStreamer::Request(RHI_Texture* texture, const float screen_size)
+    {
+        m_requests.push_back({ texture, screen_size });
+    }
+
+    void TextureStreamer::Tick(const uint64_t budget)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // Swap in the mips that finished loading
+        uint64_t upload_size = 0;
+        for (auto it = m_loads.begin(); it != m_loads.end();)
+        {
+            MipLoad& load = **it;
+            if (!load.is_done || upload_size >= upload_size_per_frame_max)
+            {
+                it++;
+                continue;
+            }
+
+            // The texture might have been destroyed (or loaded again) while its mips were loading
+            auto texture_it = m_textures.find(load.texture);
+            if (texture_it != m_textures.end() && texture_it->second.registration == load.registration)
+            {
+                StreamedTexture& streamed   = texture_it->second;
+                streamed.is_loading         = false;
+
+                // If the load failed, the texture keeps the mips it has
+                if (load.is_loaded && load.texture->SetMipResident(load.mip_index, load.mips))
+                {
+                    m_size_resident         -= streamed.mip_sizes[streamed.mip_resident];
+                    m_size_resident         += streamed.mip_sizes[load.mip_index];
+                    upload_size             += streamed.mip_sizes[load.mip_index];
+                    streamed.mip_resident   = load.mip_index;
+                }
+            }
+
+            it = m_loads.erase(it);
+        }
+
+        // Keep the largest request of every texture
+        for (const TextureRequest& request : m_requests)
+        {
+            auto texture_it = m_textures.find(request.texture);
+            if (texture_it != m_textures.end())
+            {
+                texture_it->second.screen_size = Helper::Max(texture_it->second.screen_size, request.screen_size);
+            }
+        }
+        m_requests.clear();
+
+        // Rank all the textures by how much of the screen they cover, the ones that weren't requested come last
+        m_candidates.clear();
+        for (auto& it : m_textures)
+        {
+            m_candidates.push_back({ it.first, &it.second });
+        }
+
+        sort(m_candidates.begin(), m_candidates.end(), [](const TextureCandidate& a, const TextureCandidate& b) { return a.streamed->screen_size > b.streamed->screen_size; });
+
+        // The mip tails are always resident, then the top ranked textures get the mips they need and the rest get less detail once the budget runs out
+        uint64_t size_wanted = 0;
+        for (const TextureCandidate& candidate : m_candidates)
+        {
+            size_wanted += candidate.streamed->mip_sizes[candidate.streamed->mip_tail];
+        }
+
+        for (const TextureCandidate& candidate : m_candidates)
+        {
+            StreamedTexture& streamed   = *candidate.streamed;
+            const uint64_t size_tail    = streamed.mip_sizes[streamed.mip_tail];
+
+            uint8_t mip_wanted = GetMipDesired(streamed);
+            while (mip_wanted < streamed.mip_tail && size_wanted + streamed.mip_sizes[mip_wanted] - size_tail > budget)
+            {
+                mip_wanted++;
+            }
+
+            streamed.mip_wanted = mip_wanted;
+            size_wanted         += streamed.mip_sizes[mip_wanted] - size_tail;
+        }
+
+        // Evict, starting from the bottom of the ranking, only as much as it takes to get back within the budget.
+        // The top mips are simply no longer sampled, so there is nothing to load.
+        for (auto it = m_candidates.rbegin(); it != m_candidates.rend() && m_size_resident > budget; it++)
+        {
+            StreamedTexture& streamed   = *it->streamed;
+            vector<vector<std::byte>> mips_none;
+            if (streamed.mip_resident >= streamed.mip_wanted || streamed.is_loading || !it->texture->SetMipResident(streamed.mip_wanted, mips_none))
+                continue;
+
+            m_size_resident         -= streamed.mip_sizes[streamed.mip_resident] - streamed.mip_sizes[streamed.mip_wanted];
+            streamed.mip_resident   = streamed.mip_wanted;
+        }
+
+        // Load, starting from the top of the ranking
+        for (const TextureCandidate& candidate : m_candidates)
+        {
+            StreamedTexture& streamed = *candidate.streamed;
+            if (streamed.mip_wanted >= streamed.mip_resident || streamed.is_loading)
+                continue;
+
+            if (!LoadStart(candidate, streamed.mip_wanted))
+                break;
+        }
+
+        // Start the next frame's ranking from scratch
+        m_texture_count = 0;
+        m_mips_resident = 0;
+        for (auto& it : m_textures)
+        {
+            it.second.screen_size = 0.0f;
+
+            m_texture_count++;
+            m_mips_resident += static_cast<uint32_t>(it.second.mip_sizes.size()) - it.second.mip_resident;
+        }
+    }
+
+    bool TextureStreamer::LoadStart(const TextureCandidate& candidate, const uint8_t mip_index)
+    {
+        if (m_loads.size() >= loads_in_flight_max)
+            return false;
+
+        auto load           = make_shared<MipLoad>();
+        load->texture       = candidate.texture;
+        load->registration  = candidate.streamed->registration;
+        load->mip_index     = mip_index;
+        load->mip_count     = candidate.streamed->mip_resident - mip_index;
+        load->file_path     = candidate.streamed->file_path;
+        load->mip_offsets   = candidate.streamed->mip_offsets;
+        candidate.streamed->is_loading = true;
+        m_loads.emplace_back(load);
+
+        m_context->GetSubsystem<Threading>()->AddTask([load]() { Load(load.get()); });
+
+        return true;
+    }
+
+    uint8_t TextureStreamer::GetMipDesired(const StreamedTexture& streamed)
+    {
+        // A texture that isn't on screen only needs its tail
+        if (streamed.screen_size <= 0.0f)
+            return streamed.mip_tail;
+
+        // The smallest mip that still has a texel for every pixel the texture covers
+        uint8_t mip_index = 0;
+        while (mip_index < streamed.mip_tail && static_cast<float>(streamed.size >> (mip_index + 1)) >= streamed.screen_size)
+        {
+            mip_index++;
+        }
+
+        return mip_index;
+    }
+
+    void TextureStreamer::Load(MipLoad* load)
+    {
+        // Only the mips above the resident one are read, the rest are already on the gpu
+        load->is_loaded = RHI_Texture::LoadMips(load->file_path, load->mip_offsets, load->mip_index, load->mip_count, &load->mips);
+        load->is_done   = true;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===========
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+//======================
+
+namespace Spartan
+{
+    class Context;
+    class RHI_Texture;
+
+    // Loads and evicts the mips of streamed textures (see RHI_Texture::IsStreamed()). Every frame, materials request their textures with the size
+    // they cover on screen, the textures that cover the most get the mips they need first and the rest get less detail, until it all fits in the budget.
+    // Mips are only evicted when the resident ones exceed the budget, so that a texture which goes out of view keeps its detail for when it's seen again.
+    // The gpu resource of a streamed texture holds the whole mip chain, the missing mips are read out of the texture file by a worker and uploaded into it,
+    // evicting only stops sampling the top mips. The budget caps the resident mips (what has been read and uploaded), not the allocation.
+    class TextureStreamer
+    {
+    public:
+        TextureStreamer(Context* context);
+        ~TextureStreamer();
+
+        // Textures register when they are loaded and unregister when they are destroyed (safe to call from any thread)
+        bool Register(RHI_Texture* texture);
+        void Unregister(RHI_Texture* texture);
+
+        // Every material that uses a streamed texture requests it, then Tick() loads and evicts based on the requests (main thread only)
+        void Request(RHI_Texture* texture, float screen_size);
+        void Tick(uint64_t budget);
+
+        // Stats
+        uint64_t GetSizeResident()  const { return m_size_resident; }
+        uint32_t GetTextureCount()  const { return m_texture_count; }
+        uint32_t GetMipsResident()  const { return m_mips_resident; }
+
+    private:
+        struct StreamedTexture
+        {
+            uint64_t registration   = 0;            // tells a texture apart from a later one which is allocated at the same address
+            std::string file_path;
+            std::vector<uint64_t> mip_offsets;
+            std::vector<uint64_t> mip_sizes;        // size of each mip along with all the smaller ones (bytes)
+            uint32_t size           = 0;            // the largest of the texture's dimensions (pixels)
+            uint8_t mip_tail        = 0;            // the mips from this one down are always resident
+            uint8_t mip_resident    = 0;
+            uint8_t mip_wanted      = 0;            // fit in the budget the last time the textures were ranked
+            float screen_size       = 0.0f;         // of the largest request this frame (pixels)
+            bool is_loading         = false;
+        };
+
+        struct MipLoad
+        {
+            RHI_Texture* texture    = nullptr;
+            uint64_t registration   = 0;
+            uint8_t mip_index       = 0;
+            uint8_t mip_count       = 0;            // from mip_index down to the resident mip when the load started
+            std::string file_path;
+            std::vector<uint64_t> mip_offsets;
+            std::vector<std::vector<std::byte>> mips;
+            bool is_loaded              = false;
+            std::atomic<bool> is_done   = false;
+        };
+
+        struct TextureRequest
+        {
+            RHI_Texture* texture    = nullptr;
+            float screen_size       = 0.0f;
+        };
+
+        struct TextureCandidate
+        {
+            RHI_Texture* texture        = nullptr;
+            StreamedTexture* streamed   = nullptr;
+        };
+
+        bool LoadStart(const TextureCandidate& candidate, uint8_t mip_index);
+        static uint8_t GetMipDesired(const StreamedTexture& streamed);
+        static void Load(MipLoad* load);
+
+        std::unordered_map<RHI_Texture*, StreamedTexture> m_textures;
+        std::vector<TextureRequest> m_requests;
+        std::vector<TextureCandidate> m_candidates;
+        std::vector<std::shared_ptr<MipLoad>> m_loads;
+        std::mutex m_mutex;
+        uint64_t m_registrations    = 0;
+        uint64_t m_size_resident    = 0;
+        uint32_t m_texture_count    = 0;
+        uint32_t m_mips_resident    = 0;
+
+        // Dependencies
+        Context* m_context = nullptr;
+    };
+}
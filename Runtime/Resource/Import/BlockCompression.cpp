@@ -0,0 +1,1094 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ================
+#include "Spartan.h"
+#include "BlockCompression.h"
+//===========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::BlockCompression
+{
+    // BC7 interpolation weights (out of 64) for 3 and 4 bit indices
+    static const int32_t weights_3[8]   = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    static const int32_t weights_4[16]  = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // BC7 partitions for two subsets, bit i is set when texel i belongs to the second subset
+    static const uint16_t partitions_2[64] =
+    {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+    };
+
+    // The texel of the second subset whose index is stored without its most significant bit (the first subset's is always texel 0)
+    static const uint8_t anchors_2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+    };
+
+    static const uint16_t mask_all = 0xffff;
+
+    // BC7 blocks are 128 bit streams, starting from the least significant bit of the first byte
+    class BitWriter
+    {
+    public:
+        void Write(const uint32_t value, const uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, m_position++)
+            {
+                if ((value >> i) & 1)
+                {
+                    m_bytes[m_position >> 3] |= static_cast<uint8_t>(1 << (m_position & 7));
+                }
+            }
+        }
+
+        void Store(std::byte* block) const { memcpy(block, m_bytes, sizeof(m_bytes)); }
+
+    private:
+        uint8_t m_bytes[16] = {};
+        uint32_t m_position = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const std::byte* block) { memcpy(m_bytes, block, sizeof(m_bytes)); }
+
+        uint32_t Read(const uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; i++, m_position++)
+            {
+                value |= ((m_bytes[m_position >> 3] >> (m_position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        uint8_t m_bytes[16] = {};
+        uint32_t m_position = 0;
+    };
+
+    static void load_block(const std::byte* rgba, const uint32_t width, const uint32_t height, const uint32_t block_x, const uint32_t block_y, uint8_t texels[16][4])
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                const uint32_t texel_x = min(block_x * 4 + x, width - 1);
+                const uint32_t texel_y = min(block_y * 4 + y, height - 1);
+                memcpy(texels[y * 4 + x], rgba + (static_cast<size_t>(texel_y) * width + texel_x) * 4, 4);
+            }
+        }
+    }
+
+    static void store_block(const uint8_t texels[16][4], const uint32_t width, const uint32_t height, const uint32_t block_x, const uint32_t block_y, std::byte* rgba)
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                const uint32_t texel_x = block_x * 4 + x;
+                const uint32_t texel_y = block_y * 4 + y;
+                if (texel_x < width && texel_y < height)
+                {
+                    memcpy(rgba + (static_cast<size_t>(texel_y) * width + texel_x) * 4, texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+
+    static uint32_t distance_squared(const uint8_t* texel, const int32_t* color, const uint32_t channels)
+    {
+        uint32_t distance = 0;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            const int32_t delta = static_cast<int32_t>(texel[c]) - color[c];
+            distance += static_cast<uint32_t>(delta * delta);
+        }
+        return distance;
+    }
+
+    // The line that best fits the texels of a subset (principal axis of their covariance, found with power iterations), the endpoints are where the texels project the furthest along it
+    static void endpoints_principal_axis(const uint8_t texels[16][4], const uint16_t mask, const uint32_t channels, float endpoint_0[4], float endpoint_1[4])
+    {
+        float mean[4]       = {};
+        float minimum[4]    = { 255.0f, 255.0f, 255.0f, 255.0f };
+        float maximum[4]    = {};
+        float count         = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (!((mask >> i) & 1))
+                continue;
+
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                mean[c]     += texels[i][c];
+                minimum[c]  = min(minimum[c], static_cast<float>(texels[i][c]));
+                maximum[c]  = max(maximum[c], static_cast<float>(texels[i][c]));
+            }
+            count++;
+        }
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            mean[c] /= count;
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (!((mask >> i) & 1))
+                continue;
+
+            for (uint32_t a = 0; a < channels; a++)
+            {
+                for (uint32_t b = 0; b < channels; b++)
+                {
+                    covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+                }
+            }
+        }
+
+        // Start from the diagonal of the bounding box, it's usually close already
+        float axis[4] = {};
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            axis[c] = maximum[c] - minimum[c];
+        }
+
+        for (uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            float product[4]    = {};
+            float length        = 0.0f;
+            for (uint32_t a = 0; a < channels; a++)
+            {
+                for (uint32_t b = 0; b < channels; b++)
+                {
+                    product[a] += covariance[a][b] * axis[b];
+                }
+                length = max(length, abs(product[a]));
+            }
+
+            if (length < 1e-6f)
+                break;
+
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                axis[c] = product[c] / length;
+            }
+        }
+
+        float axis_length_squared = 0.0f;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            axis_length_squared += axis[c] * axis[c];
+        }
+
+        float t_min = 0.0f;
+        float t_max = 0.0f;
+        if (axis_length_squared > 1e-12f)
+        {
+            t_min = numeric_limits<float>::max();
+            t_max = -numeric_limits<float>::max();
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                if (!((mask >> i) & 1))
+                    continue;
+
+                float t = 0.0f;
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    t += (texels[i][c] - mean[c]) * axis[c];
+                }
+                t /= axis_length_squared;
+
+                t_min = min(t_min, t);
+                t_max = max(t_max, t);
+            }
+        }
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            endpoint_0[c] = clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+            endpoint_1[c] = clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        }
+    }
+
+    // The endpoints which minimize the squared error of the texels, for the interpolation weights they ended up with (0 is endpoint_0 and 1 is endpoint_1)
+    static bool endpoints_least_squares(const uint8_t texels[16][4], const uint16_t mask, const float weights[16], const uint32_t channels, float endpoint_0[4], float endpoint_1[4])
+    {
+        float aa        = 0.0f;
+        float ab        = 0.0f;
+        float bb        = 0.0f;
+        float ax[4]     = {};
+        float bx[4]     = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (!((mask >> i) & 1))
+                continue;
+
+            const float a = 1.0f - weights[i];
+            const float b = weights[i];
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                ax[c] += a * texels[i][c];
+                bx[c] += b * texels[i][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (abs(determinant) < 1e-6f)
+            return false;
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            endpoint_0[c] = clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+            endpoint_1[c] = clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+        }
+
+        return true;
+    }
+
+    //= BC1 ==================================================================================================================================
+    static uint16_t color_pack_565(const float color[3])
+    {
+        const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    static void color_unpack_565(const uint16_t value, int32_t color[3])
+    {
+        const int32_t r = (value >> 11) & 31;
+        const int32_t g = (value >> 5) & 63;
+        const int32_t b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    static void color_palette(const uint16_t color_0, const uint16_t color_1, const bool four_colors, int32_t palette[4][4])
+    {
+        color_unpack_565(color_0, palette[0]);
+        color_unpack_565(color_1, palette[1]);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            if (four_colors)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        palette[3][3] = four_colors ? 255 : 0;
+    }
+
+    // Picks the closest of the four colors for each texel, the endpoints get ordered for the four color mode (BC3 always uses it)
+    static uint32_t color_fit(const uint8_t texels[16][4], uint16_t* color_0, uint16_t* color_1, uint32_t* indices)
+    {
+        if (*color_0 < *color_1)
+        {
+            swap(*color_0, *color_1);
+        }
+
+        int32_t palette[4][4];
+        color_palette(*color_0, *color_1, true, palette);
+
+        // When both endpoints are the same, the block decodes in the three color mode, where index 0 is still the first endpoint
+        const uint32_t palette_size = *color_0 == *color_1 ? 1 : 4;
+
+        uint32_t error  = 0;
+        *indices        = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t best_index     = 0;
+            uint32_t best_distance  = numeric_limits<uint32_t>::max();
+            for (uint32_t p = 0; p < palette_size; p++)
+            {
+                const uint32_t distance = distance_squared(texels[i], palette[p], 3);
+                if (distance < best_distance)
+                {
+                    best_distance   = distance;
+                    best_index      = p;
+                }
+            }
+
+            error       += best_distance;
+            *indices    |= best_index << (i * 2);
+        }
+
+        return error;
+    }
+
+    static void encode_color(const uint8_t texels[16][4], const Quality quality, std::byte* block)
+    {
+        float endpoint_0[4] = {};
+        float endpoint_1[4] = {};
+        if (quality == Quality::Fast)
+        {
+            // Inset the bounding box a little, the texels at its corners are outliers more often than not
+            float minimum[3] = { 255.0f, 255.0f, 255.0f };
+            float maximum[3] = {};
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    minimum[c] = min(minimum[c], static_cast<float>(texels[i][c]));
+                    maximum[c] = max(maximum[c], static_cast<float>(texels[i][c]));
+                }
+            }
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                const float inset = (maximum[c] - minimum[c]) / 16.0f;
+                endpoint_0[c] = maximum[c] - inset;
+                endpoint_1[c] = minimum[c] + inset;
+            }
+        }
+        else
+        {
+            endpoints_principal_axis(texels, mask_all, 3, endpoint_1, endpoint_0);
+        }
+
+        uint16_t color_0    = color_pack_565(endpoint_0);
+        uint16_t color_1    = color_pack_565(endpoint_1);
+        uint32_t indices    = 0;
+        uint32_t error      = color_fit(texels, &color_0, &color_1, &indices);
+
+        if (quality == Quality::High)
+        {
+            static const float index_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+            for (uint32_t iteration = 0; iteration < 2 && error != 0; iteration++)
+            {
+                float weights[16];
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    weights[i] = index_weights[(indices >> (i * 2)) & 3];
+                }
+
+                if (!endpoints_least_squares(texels, mask_all, weights, 3, endpoint_0, endpoint_1))
+                    break;
+
+                uint16_t refined_color_0    = color_pack_565(endpoint_0);
+                uint16_t refined_color_1    = color_pack_565(endpoint_1);
+                uint32_t refined_indices    = 0;
+                const uint32_t refined_error = color_fit(texels, &refined_color_0, &refined_color_1, &refined_indices);
+                if (refined_error >= error)
+                    break;
+
+                color_0 = refined_color_0;
+                color_1 = refined_color_1;
+                indices = refined_indices;
+                error   = refined_error;
+            }
+        }
+
+        memcpy(block, &color_0, 2);
+        memcpy(block + 2, &color_1, 2);
+        memcpy(block + 4, &indices, 4);
+    }
+
+    static void decode_color(const std::byte* block, const bool force_four_colors, uint8_t texels[16][4])
+    {
+        uint16_t color_0 = 0;
+        uint16_t color_1 = 0;
+        uint32_t indices = 0;
+        memcpy(&color_0, block, 2);
+        memcpy(&color_1, block + 2, 2);
+        memcpy(&indices, block + 4, 4);
+
+        int32_t palette[4][4];
+        color_palette(color_0, color_1, force_four_colors || color_0 > color_1, palette);
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                texels[i][c] = static_cast<uint8_t>(palette[(indices >> (i * 2)) & 3][c]);
+            }
+        }
+    }
+
+    //= BC4 ==================================================================================================================================
+    static void channel_palette(const int32_t value_0, const int32_t value_1, int32_t palette[8])
+    {
+        palette[0] = value_0;
+        palette[1] = value_1;
+        if (value_0 > value_1)
+        {
+            for (int32_t i = 2; i < 8; i++)
+            {
+                palette[i] = ((8 - i) * value_0 + (i - 1) * value_1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for (int32_t i = 2; i < 6; i++)
+            {
+                palette[i] = ((6 - i) * value_0 + (i - 1) * value_1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    static uint32_t channel_fit(const uint8_t values[16], const int32_t value_0, const int32_t value_1, uint64_t* indices)
+    {
+        int32_t palette[8];
+        channel_palette(value_0, value_1, palette);
+
+        uint32_t error  = 0;
+        *indices        = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t best_index     = 0;
+            uint32_t best_distance  = numeric_limits<uint32_t>::max();
+            for (uint32_t p = 0; p < 8; p++)
+            {
+                const int32_t delta     = static_cast<int32_t>(values[i]) - palette[p];
+                const uint32_t distance = static_cast<uint32_t>(delta * delta);
+                if (distance < best_distance)
+                {
+                    best_distance   = distance;
+                    best_index      = p;
+                }
+            }
+
+            error       += best_distance;
+            *indices    |= static_cast<uint64_t>(best_index) << (i * 3);
+        }
+
+        return error;
+    }
+
+    static void encode_channel(const uint8_t values[16], const Quality quality, std::byte* block)
+    {
+        uint8_t minimum = 255;
+        uint8_t maximum = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            minimum = min(minimum, values[i]);
+            maximum = max(maximum, values[i]);
+        }
+
+        // Eight interpolated values between the extremes
+        int32_t value_0     = maximum;
+        int32_t value_1     = minimum;
+        uint64_t indices    = 0;
+        uint32_t error      = channel_fit(values, value_0, value_1, &indices);
+
+        if (quality == Quality::High && error != 0)
+        {
+            // Six interpolated values between the extremes that aren't 0 or 255, which are stored exactly (e.g. masked out texels)
+            uint8_t inner_minimum = 255;
+            uint8_t inner_maximum = 0;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                if (values[i] != 0 && values[i] != 255)
+                {
+                    inner_minimum = min(inner_minimum, values[i]);
+                    inner_maximum = max(inner_maximum, values[i]);
+                }
+            }
+
+            if (inner_minimum <= inner_maximum)
+            {
+                uint64_t six_indices        = 0;
+                const uint32_t six_error    = channel_fit(values, inner_minimum, inner_maximum, &six_indices);
+                if (six_error < error)
+                {
+                    value_0 = inner_minimum;
+                    value_1 = inner_maximum;
+                    indices = six_indices;
+                    error   = six_error;
+                }
+            }
+
+            // Least squares endpoints for the eight value mode
+            if (value_0 > value_1)
+            {
+                uint8_t texels[16][4] = {};
+                float weights[16];
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    const uint32_t index = (indices >> (i * 3)) & 7;
+                    texels[i][0]    = values[i];
+                    weights[i]      = index == 0 ? 0.0f : index == 1 ? 1.0f : static_cast<float>(index - 1) / 7.0f;
+                }
+
+                float endpoint_0[4] = {};
+                float endpoint_1[4] = {};
+                if (endpoints_least_squares(texels, mask_all, weights, 1, endpoint_0, endpoint_1))
+                {
+                    const int32_t refined_value_0 = static_cast<int32_t>(endpoint_0[0] + 0.5f);
+                    const int32_t refined_value_1 = static_cast<int32_t>(endpoint_1[0] + 0.5f);
+                    if (refined_value_0 > refined_value_1)
+                    {
+                        uint64_t refined_indices        = 0;
+                        const uint32_t refined_error    = channel_fit(values, refined_value_0, refined_value_1, &refined_indices);
+                        if (refined_error < error)
+                        {
+                            value_0 = refined_value_0;
+                            value_1 = refined_value_1;
+                            indices = refined_indices;
+                            error   = refined_error;
+                        }
+                    }
+                }
+            }
+        }
+
+        block[0] = static_cast<std::byte>(value_0);
+        block[1] = static_cast<std::byte>(value_1);
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<std::byte>((indices >> (i * 8)) & 0xff);
+        }
+    }
+
+    static void decode_channel(const std::byte* block, uint8_t texels[16][4], const uint32_t channel)
+    {
+        int32_t palette[8];
+        channel_palette(static_cast<int32_t>(block[0]), static_cast<int32_t>(block[1]), palette);
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+        }
+    }
+
+    static void encode_channel(const uint8_t texels[16][4], const uint32_t channel, const Quality quality, std::byte* block)
+    {
+        uint8_t values[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            values[i] = texels[i][channel];
+        }
+
+        encode_channel(values, quality, block);
+    }
+
+    //= BC7 ==================================================================================================================================
+    // Endpoints have a number of bits per channel plus a p-bit (the least significant bit, shared by all channels), the result is expanded to 8 bits
+    static void bc7_quantize(const float endpoint[4], const uint32_t channels, const uint32_t bits, const uint32_t p_bit, uint32_t quantized[4], int32_t expanded[4])
+    {
+        const float scale           = static_cast<float>((1u << bits) - 1) / 255.0f;
+        const int32_t maximum       = (1 << (bits - 1)) - 1;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (c >= channels)
+            {
+                quantized[c] = 0;
+                expanded[c]  = 255;
+                continue;
+            }
+
+            quantized[c]        = static_cast<uint32_t>(clamp(static_cast<int32_t>(floor((endpoint[c] * scale - p_bit) * 0.5f + 0.5f)), 0, maximum));
+            const uint32_t full = (quantized[c] << 1) | p_bit;
+            expanded[c]         = static_cast<int32_t>((full << (8 - bits)) | (full >> (2 * bits - 8)));
+        }
+    }
+
+    static uint32_t bc7_fit(const uint8_t texels[16][4], const uint16_t mask, const int32_t endpoint_0[4], const int32_t endpoint_1[4], const uint32_t index_bits, const uint32_t channels, uint8_t indices[16])
+    {
+        const int32_t* weights      = index_bits == 4 ? weights_4 : weights_3;
+        const uint32_t palette_size = 1u << index_bits;
+
+        int32_t palette[16][4];
+        for (uint32_t p = 0; p < palette_size; p++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                palette[p][c] = ((64 - weights[p]) * endpoint_0[c] + weights[p] * endpoint_1[c] + 32) >> 6;
+            }
+        }
+
+        uint32_t error = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (!((mask >> i) & 1))
+                continue;
+
+            uint32_t best_index     = 0;
+            uint32_t best_distance  = numeric_limits<uint32_t>::max();
+            for (uint32_t p = 0; p < palette_size; p++)
+            {
+                const uint32_t distance = distance_squared(texels[i], palette[p], channels);
+                if (distance < best_distance)
+                {
+                    best_distance   = distance;
+                    best_index      = p;
+                }
+            }
+
+            error       += best_distance;
+            indices[i]  = static_cast<uint8_t>(best_index);
+        }
+
+        return error;
+    }
+
+    struct Bc7Subset
+    {
+        uint32_t quantized[2][4]    = {};
+        int32_t expanded[2][4]      = {};
+        uint32_t p_bits[2]          = {};
+        uint32_t error              = numeric_limits<uint32_t>::max();
+    };
+
+    // Quantizes a subset's endpoints and fits its indices, trying every p-bit (shared p-bits apply to both endpoints)
+    static void bc7_fit_subset(const uint8_t texels[16][4], const uint16_t mask, const float endpoint_0[4], const float endpoint_1[4], const uint32_t channels, const uint32_t bits, const bool shared_p_bit, const uint32_t index_bits, Bc7Subset* subset, uint8_t indices[16])
+    {
+        const uint32_t combinations = shared_p_bit ? 2 : 4;
+        for (uint32_t combination = 0; combination < combinations; combination++)
+        {
+            Bc7Subset candidate;
+            candidate.p_bits[0] = combination & 1;
+            candidate.p_bits[1] = shared_p_bit ? combination & 1 : combination >> 1;
+            bc7_quantize(endpoint_0, channels, bits, candidate.p_bits[0], candidate.quantized[0], candidate.expanded[0]);
+            bc7_quantize(endpoint_1, channels, bits, candidate.p_bits[1], candidate.quantized[1], candidate.expanded[1]);
+
+            uint8_t candidate_indices[16] = {};
+            candidate.error = bc7_fit(texels, mask, candidate.expanded[0], candidate.expanded[1], index_bits, 4, candidate_indices);
+            if (candidate.error < subset->error)
+            {
+                *subset = candidate;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    if ((mask >> i) & 1)
+                    {
+                        indices[i] = candidate_indices[i];
+                    }
+                }
+            }
+        }
+    }
+
+    // Least squares refinement of a subset's endpoints, against the weights of the indices it ended up with
+    static void bc7_refine_subset(const uint8_t texels[16][4], const uint16_t mask, const uint32_t channels, const uint32_t bits, const bool shared_p_bit, const uint32_t index_bits, Bc7Subset* subset, uint8_t indices[16])
+    {
+        const int32_t* weights = index_bits == 4 ? weights_4 : weights_3;
+
+        for (uint32_t iteration = 0; iteration < 2 && subset->error != 0; iteration++)
+        {
+            float texel_weights[16] = {};
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                texel_weights[i] = static_cast<float>(weights[indices[i]]) / 64.0f;
+            }
+
+            float endpoint_0[4] = {};
+            float endpoint_1[4] = {};
+            if (!endpoints_least_squares(texels, mask, texel_weights, channels, endpoint_0, endpoint_1))
+                return;
+
+            const uint32_t error = subset->error;
+            bc7_fit_subset(texels, mask, endpoint_0, endpoint_1, channels, bits, shared_p_bit, index_bits, subset, indices);
+            if (subset->error >= error)
+                return;
+        }
+    }
+
+    // The index of an anchor texel is stored without its most significant bit, so it has to be in the first half of the palette (reversing the endpoints mirrors the indices)
+    static void bc7_fix_anchor(const uint16_t mask, const uint32_t anchor, const uint32_t index_bits, Bc7Subset* subset, uint8_t indices[16])
+    {
+        const uint32_t index_max = (1u << index_bits) - 1;
+        if (indices[anchor] <= index_max / 2)
+            return;
+
+        swap(subset->quantized[0], subset->quantized[1]);
+        swap(subset->expanded[0], subset->expanded[1]);
+        swap(subset->p_bits[0], subset->p_bits[1]);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if ((mask >> i) & 1)
+            {
+                indices[i] = static_cast<uint8_t>(index_max - indices[i]);
+            }
+        }
+    }
+
+    // Mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each and 4 bit indices
+    static uint32_t bc7_encode_mode_6(const uint8_t texels[16][4], const Quality quality, BitWriter* writer)
+    {
+        float endpoint_0[4] = {};
+        float endpoint_1[4] = {};
+        endpoints_principal_axis(texels, mask_all, 4, endpoint_0, endpoint_1);
+
+        Bc7Subset subset;
+        uint8_t indices[16] = {};
+        bc7_fit_subset(texels, mask_all, endpoint_0, endpoint_1, 4, 8, false, 4, &subset, indices);
+        if (quality == Quality::High)
+        {
+            bc7_refine_subset(texels, mask_all, 4, 8, false, 4, &subset, indices);
+        }
+        bc7_fix_anchor(mask_all, 0, 4, &subset, indices);
+
+        writer->Write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            writer->Write(subset.quantized[0][c], 7);
+            writer->Write(subset.quantized[1][c], 7);
+        }
+        writer->Write(subset.p_bits[0], 1);
+        writer->Write(subset.p_bits[1], 1);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            writer->Write(indices[i], i == 0 ? 3 : 4);
+        }
+
+        return subset.error;
+    }
+
+    // Mode 1: two subsets, RGB 6.6.6 endpoints with a p-bit per subset and 3 bit indices, for opaque blocks
+    static uint32_t bc7_encode_mode_1(const uint8_t texels[16][4], BitWriter* writer)
+    {
+        // Estimate every partition with the bounding box of each subset, only the best one gets encoded properly
+        uint32_t partition  = 0;
+        float partition_error = numeric_limits<float>::max();
+        for (uint32_t p = 0; p < 64; p++)
+        {
+            float error = 0.0f;
+            for (uint32_t s = 0; s < 2; s++)
+            {
+                const uint16_t mask = s == 0 ? static_cast<uint16_t>(~partitions_2[p]) : partitions_2[p];
+
+                float minimum[3] = { 255.0f, 255.0f, 255.0f };
+                float maximum[3] = {};
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    if ((mask >> i) & 1)
+                    {
+                        for (uint32_t c = 0; c < 3; c++)
+                        {
+                            minimum[c] = min(minimum[c], static_cast<float>(texels[i][c]));
+                            maximum[c] = max(maximum[c], static_cast<float>(texels[i][c]));
+                        }
+                    }
+                }
+
+                const float direction[3]    = { maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] };
+                const float length_squared  = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    if (!((mask >> i) & 1))
+                        continue;
+
+                    float t = 0.0f;
+                    if (length_squared > 0.0f)
+                    {
+                        for (uint32_t c = 0; c < 3; c++)
+                        {
+                            t += (texels[i][c] - minimum[c]) * direction[c];
+                        }
+                        t = floor(clamp(t / length_squared, 0.0f, 1.0f) * 7.0f + 0.5f) / 7.0f;
+                    }
+
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        const float delta = texels[i][c] - (minimum[c] + direction[c] * t);
+                        error += delta * delta;
+                    }
+                }
+            }
+
+            if (error < partition_error)
+            {
+                partition_error = error;
+                partition       = p;
+            }
+        }
+
+        Bc7Subset subsets[2];
+        uint8_t indices[16] = {};
+        const uint16_t masks[2] = { static_cast<uint16_t>(~partitions_2[partition]), partitions_2[partition] };
+        for (uint32_t s = 0; s < 2; s++)
+        {
+            float endpoint_0[4] = {};
+            float endpoint_1[4] = {};
+            endpoints_principal_axis(texels, masks[s], 3, endpoint_0, endpoint_1);
+            bc7_fit_subset(texels, masks[s], endpoint_0, endpoint_1, 3, 7, true, 3, &subsets[s], indices);
+            bc7_refine_subset(texels, masks[s], 3, 7, true, 3, &subsets[s], indices);
+        }
+        bc7_fix_anchor(masks[0], 0, 3, &subsets[0], indices);
+        bc7_fix_anchor(masks[1], anchors_2[partition], 3, &subsets[1], indices);
+
+        writer->Write(1 << 1, 2);
+        writer->Write(partition, 6);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            for (uint32_t s = 0; s < 2; s++)
+            {
+                writer->Write(subsets[s].quantized[0][c], 6);
+                writer->Write(subsets[s].quantized[1][c], 6);
+            }
+        }
+        writer->Write(subsets[0].p_bits[0], 1);
+        writer->Write(subsets[1].p_bits[0], 1);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            writer->Write(indices[i], (i == 0 || i == anchors_2[partition]) ? 2 : 3);
+        }
+
+        return subsets[0].error + subsets[1].error;
+    }
+
+    static void encode_bc7(const uint8_t texels[16][4], const Quality quality, std::byte* block)
+    {
+        BitWriter mode_6;
+        const uint32_t mode_6_error = bc7_encode_mode_6(texels, quality, &mode_6);
+
+        bool is_opaque = true;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            is_opaque = is_opaque && texels[i][3] == 255;
+        }
+
+        if (quality == Quality::High && is_opaque && mode_6_error != 0)
+        {
+            BitWriter mode_1;
+            if (bc7_encode_mode_1(texels, &mode_1) < mode_6_error)
+            {
+                mode_1.Store(block);
+                return;
+            }
+        }
+
+        mode_6.Store(block);
+    }
+
+    static void decode_bc7(const std::byte* block, uint8_t texels[16][4])
+    {
+        BitReader reader(block);
+
+        uint32_t mode = 0;
+        while (mode < 8 && reader.Read(1) == 0)
+        {
+            mode++;
+        }
+
+        // Only the modes that the encoder writes are decoded
+        if (mode != 6 && mode != 1)
+        {
+            memset(texels, 0, 16 * 4);
+            return;
+        }
+
+        const bool is_mode_6            = mode == 6;
+        const uint32_t partition        = is_mode_6 ? 0 : reader.Read(6);
+        const uint32_t subset_count     = is_mode_6 ? 1 : 2;
+        const uint32_t channels         = is_mode_6 ? 4 : 3;
+        const uint32_t bits             = is_mode_6 ? 7 : 6;
+        const uint32_t index_bits       = is_mode_6 ? 4 : 3;
+        const uint16_t mask             = is_mode_6 ? 0 : partitions_2[partition];
+
+        uint32_t endpoints[4][4] = {};
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            for (uint32_t e = 0; e < subset_count * 2; e++)
+            {
+                endpoints[e][c] = reader.Read(bits);
+            }
+        }
+
+        for (uint32_t e = 0; e < subset_count * 2; e++)
+        {
+            const uint32_t p_bit = is_mode_6 ? reader.Read(1) : 0;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                endpoints[e][c] = (endpoints[e][c] << 1) | p_bit;
+            }
+        }
+
+        if (!is_mode_6)
+        {
+            for (uint32_t s = 0; s < 2; s++)
+            {
+                const uint32_t p_bit = reader.Read(1);
+                for (uint32_t e = s * 2; e < s * 2 + 2; e++)
+                {
+                    for (uint32_t c = 0; c < channels; c++)
+                    {
+                        endpoints[e][c] = endpoints[e][c] | p_bit;
+                    }
+                }
+            }
+        }
+
+        int32_t expanded[4][4] = {};
+        for (uint32_t e = 0; e < 4; e++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                expanded[e][c] = c < channels ? static_cast<int32_t>((endpoints[e][c] << (7 - bits)) | (endpoints[e][c] >> (2 * bits - 6))) : 255;
+            }
+        }
+
+        const int32_t* weights = index_bits == 4 ? weights_4 : weights_3;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t subset       = (mask >> i) & 1;
+            const bool is_anchor        = i == 0 || (!is_mode_6 && i == anchors_2[partition]);
+            const uint32_t index        = reader.Read(is_anchor ? index_bits - 1 : index_bits);
+            const int32_t* endpoint_0   = expanded[subset * 2];
+            const int32_t* endpoint_1   = expanded[subset * 2 + 1];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                texels[i][c] = static_cast<uint8_t>(((64 - weights[index]) * endpoint_0[c] + weights[index] * endpoint_1[c] + 32) >> 6);
+            }
+        }
+    }
+
+    //========================================================================================================================================
+
+    RHI_Format select_format(const RHI_Texture_Content content, const bool is_transparent, const bool is_grayscale, const Quality quality)
+    {
+        switch (content)
+        {
+            case RHI_Texture_Content::Color:
+                if (quality == Quality::High)
+                    return RHI_Format_BC7_Unorm;
+                return is_transparent ? RHI_Format_BC3_Unorm : RHI_Format_BC1_Unorm;
+
+            // Normal maps keep x and y, the shader reconstructs z, a grayscale one is a height map
+            case RHI_Texture_Content::Normal:
+                return is_grayscale ? RHI_Format_BC4_Unorm : RHI_Format_BC5_Unorm;
+
+            case RHI_Texture_Content::Channel:
+                return RHI_Format_BC4_Unorm;
+
+            default:
+                return RHI_Format_Undefined;
+        }
+    }
+
+    void encode(const RHI_Format format, const Quality quality, const std::byte* rgba, const uint32_t width, const uint32_t height, const uint32_t block_row_start, const uint32_t block_row_end, std::byte* blocks)
+    {
+        const uint32_t block_size   = rhi_format_block_size(format);
+        const uint32_t blocks_wide  = (width + 3) / 4;
+
+        uint8_t texels[16][4];
+        for (uint32_t block_y = block_row_start; block_y < block_row_end; block_y++)
+        {
+            for (uint32_t block_x = 0; block_x < blocks_wide; block_x++)
+            {
+                load_block(rgba, width, height, block_x, block_y, texels);
+                std::byte* block = blocks + (static_cast<size_t>(block_y) * blocks_wide + block_x) * block_size;
+
+                switch (format)
+                {
+                    case RHI_Format_BC1_Unorm:
+                        encode_color(texels, quality, block);
+                        break;
+                    case RHI_Format_BC3_Unorm:
+                        encode_channel(texels, 3, quality, block);
+                        encode_color(texels, quality, block + 8);
+                        break;
+                    case RHI_Format_BC4_Unorm:
+                        encode_channel(texels, 0, quality, block);
+                        break;
+                    case RHI_Format_BC5_Unorm:
+                        encode_channel(texels, 0, quality, block);
+                        encode_channel(texels, 1, quality, block + 8);
+                        break;
+                    case RHI_Format_BC7_Unorm:
+                        encode_bc7(texels, quality, block);
+                        break;
+                    default:
+                        LOG_ERROR("Unsupported format %s", rhi_format_to_string(format));
+                        return;
+                }
+            }
+        }
+    }
+
+    void decode(const RHI_Format format, const std::byte* blocks, const uint32_t width, const uint32_t height, std::byte* rgba)
+    {
+        const uint32_t block_size   = rhi_format_block_size(format);
+        const uint32_t blocks_wide  = (width + 3) / 4;
+        const uint32_t blocks_high  = (height + 3) / 4;
+
+        for (uint32_t block_y = 0; block_y < blocks_high; block_y++)
+        {
+            for (uint32_t block_x = 0; block_x < blocks_wide; block_x++)
+            {
+                const std::byte* block       = blocks + (static_cast<size_t>(block_y) * blocks_wide + block_x) * block_size;
+                uint8_t texels[16][4]   = {};
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    texels[i][3] = 255;
+                }
+
+                switch (format)
+                {
+                    case RHI_Format_BC1_Unorm:
+                        decode_color(block, false, texels);
+                        break;
+                    case RHI_Format_BC3_Unorm:
+                        decode_color(block + 8, true, texels);
+                        decode_channel(block, texels, 3);
+                        break;
+                    case RHI_Format_BC4_Unorm:
+                        decode_channel(block, texels, 0);
+                        break;
+                    case RHI_Format_BC5_Unorm:
+                        decode_channel(block, texels, 0);
+                        decode_channel(block + 8, texels, 1);
+                        break;
+                    case RHI_Format_BC7_Unorm:
+                        decode_bc7(block, texels);
+                        break;
+                    default:
+                        LOG_ERROR("Unsupported format %s", rhi_format_to_string(format));
+                        return;
+                }
+
+                store_block(texels, width, height, block_x, block_y, rgba);
+            }
+        }
+    }
+}
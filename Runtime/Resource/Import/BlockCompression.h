@@ -0,0 +1,52 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ========================
+#include <cstddef>
+#include "../../RHI/RHI_Definition.h"
+//===================================
+
+namespace Spartan
+{
+    // A cpu encoder for the block compressed formats, textures are encoded once when they are imported and then stay compressed on disk,
+    // in memory and on the gpu. Every 4x4 block is encoded on its own, so an image can be split into ranges of block rows which are encoded
+    // in parallel. BC7 uses modes 6 and 1 (smooth gradients with alpha and blocks with two distinct colors), the other modes add little for a lot of search.
+    namespace BlockCompression
+    {
+        enum class Quality
+        {
+            Fast,   // endpoints from the bounding box of each block, colors go to BC1/BC3
+            High    // endpoints from the principal axis of each block and refined, colors go to BC7
+        };
+
+        // The format for an 8 bit per channel image, based on what the texture holds (RHI_Format_Undefined if it shouldn't be compressed)
+        RHI_Format select_format(RHI_Texture_Content content, bool is_transparent, bool is_grayscale, Quality quality);
+
+        // Encodes the block rows [block_row_start, block_row_end) of an RGBA8 image, blocks holds the whole image (see rhi_format_mip_size()).
+        // Blocks which go past the edges of the image repeat the edge texels.
+        void encode(RHI_Format format, Quality quality, const std::byte* rgba, uint32_t width, uint32_t height, uint32_t block_row_start, uint32_t block_row_end, std::byte* blocks);
+
+        // Decodes blocks into an RGBA8 image (missing channels are 0 and alpha is 255), used to measure the error of the encoder
+        void decode(RHI_Format format, const std::byte* blocks, uint32_t width, uint32_t height, std::byte* rgba);
+    }
+}
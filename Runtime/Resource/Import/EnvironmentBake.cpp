@@ -0,0 +1,270 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===============
+#include "Spartan.h"
+#include "EnvironmentBake.h"
+//==========================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::EnvironmentBake
+{
+    // Enough for the GGX lobe to be smooth, since every sample reads from a mip that matches the solid angle it covers. Narrow lobes
+    // (the large mips, which are most of the work) read from detailed mips and need fewer samples.
+    static const uint32_t sample_count_narrow   = 32;
+    static const uint32_t sample_count          = 64;
+    static const float sample_roughness_narrow  = 0.5f;
+
+    // The largest value RGB9E5 can hold, (511 / 512) * 2^16
+    static const float rgb9e5_max = 65408.0f;
+
+    struct PrefilterSample
+    {
+        Vector3 direction; // in tangent space
+        float weight;
+        float mip;
+    };
+
+    // The inverse of direction_sphere_uv() in Common.hlsl
+    static Vector3 direction_from_uv(const float u, const float v)
+    {
+        const float theta       = v * Helper::PI;
+        const float sin_theta   = sin(theta);
+        const float phi         = (u >= 0.5f ? 2.0f * (1.0f - u) : 2.0f * u) * Helper::PI;
+        const float z           = sin_theta * sin(phi);
+
+        return Vector3(sin_theta * cos(phi), cos(theta), u >= 0.5f ? z : -z);
+    }
+
+    // The same mapping as direction_sphere_uv() in Common.hlsl
+    static void uv_from_direction(const Vector3& direction, float* u, float* v)
+    {
+        const float n = sqrt(direction.x * direction.x + direction.z * direction.z);
+        const float a = acos(Helper::Clamp(n > 0.0000001f ? direction.x / n : 0.0f, -1.0f, 1.0f)) * Helper::PI_INV;
+
+        *u = direction.z > 0.0f ? 1.0f - a * 0.5f : a * 0.5f;
+        *v = acos(Helper::Clamp(direction.y, -1.0f, 1.0f)) * Helper::PI_INV;
+    }
+
+    // Wraps horizontally (the environment goes all the way around) and clamps vertically (the poles)
+    static Vector3 sample_bilinear(const float* texels, const uint32_t width, const uint32_t height, const float u, const float v)
+    {
+        const float x       = u * width - 0.5f;
+        const float y       = Helper::Clamp(v * height - 0.5f, 0.0f, static_cast<float>(height - 1));
+        const float x_floor = floor(x);
+        const float y_floor = floor(y);
+        const float fx      = x - x_floor;
+        const float fy      = y - y_floor;
+
+        const uint32_t x0   = static_cast<uint32_t>(static_cast<int32_t>(x_floor) % static_cast<int32_t>(width) + static_cast<int32_t>(width)) % width;
+        const uint32_t x1   = (x0 + 1) % width;
+        const uint32_t y0   = static_cast<uint32_t>(y_floor);
+        const uint32_t y1   = min(y0 + 1, height - 1);
+
+        auto texel = [texels, width](const uint32_t tx, const uint32_t ty)
+        {
+            const float* t = texels + (static_cast<uint64_t>(ty) * width + tx) * 4;
+            return Vector3(t[0], t[1], t[2]);
+        };
+
+        const Vector3 top       = texel(x0, y0) * (1.0f - fx) + texel(x1, y0) * fx;
+        const Vector3 bottom    = texel(x0, y1) * (1.0f - fx) + texel(x1, y1) * fx;
+
+        return top * (1.0f - fy) + bottom * fy;
+    }
+
+    static Vector3 sample_trilinear(const vector<vector<byte>>& mips, const uint32_t width, const uint32_t height, const Vector3& direction, const float mip)
+    {
+        float u = 0.0f;
+        float v = 0.0f;
+        uv_from_direction(direction, &u, &v);
+
+        const uint32_t mip_0    = static_cast<uint32_t>(mip);
+        const uint32_t mip_1    = min(mip_0 + 1, static_cast<uint32_t>(mips.size() - 1));
+        const float blend       = mip - static_cast<float>(mip_0);
+
+        auto sample_mip = [&](const uint32_t mip_index)
+        {
+            return sample_bilinear(reinterpret_cast<const float*>(mips[mip_index].data()), max(width >> mip_index, 1u), max(height >> mip_index, 1u), u, v);
+        };
+
+        const Vector3 color = sample_mip(mip_0);
+        return blend > 0.0f && mip_1 != mip_0 ? color * (1.0f - blend) + sample_mip(mip_1) * blend : color;
+    }
+
+    static float radical_inverse(uint32_t bits)
+    {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    // Importance samples the GGX lobe around the normal (assuming that the view direction is the normal, like the split sum approximation does),
+    // every sample reads from the mip whose texels cover the sample's solid angle [Colbert & Krivanek 2007, "GPU-Based Importance Sampling"]
+    static vector<PrefilterSample> get_prefilter_samples(const float roughness, const uint32_t width, const uint32_t height, const uint32_t mip_count)
+    {
+        const float alpha               = roughness * roughness;
+        const float alpha_2             = alpha * alpha;
+        const float texel_solid_angle   = Helper::PI_4 / static_cast<float>(width * height);
+        const uint32_t count            = roughness < sample_roughness_narrow ? sample_count_narrow : sample_count;
+
+        vector<PrefilterSample> samples;
+        samples.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float phi         = Helper::PI_2 * static_cast<float>(i) / static_cast<float>(count);
+            const float xi          = radical_inverse(i);
+            const float cos_theta   = sqrt((1.0f - xi) / (1.0f + (alpha_2 - 1.0f) * xi));
+            const float sin_theta   = sqrt(1.0f - cos_theta * cos_theta);
+            const Vector3 half      = Vector3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta);
+            const Vector3 light     = Vector3(2.0f * half.z * half.x, 2.0f * half.z * half.y, 2.0f * half.z * half.z - 1.0f);
+
+            if (light.z <= 0.0f)
+                continue;
+
+            const float d                   = (cos_theta * cos_theta) * (alpha_2 - 1.0f) + 1.0f;
+            const float pdf                 = alpha_2 / (Helper::PI * d * d) * 0.25f;
+            const float sample_solid_angle  = 1.0f / (static_cast<float>(count) * pdf + 0.0001f);
+            const float mip                 = 0.5f * log2(sample_solid_angle / texel_solid_angle) + 1.0f;
+
+            samples.push_back({ light, light.z, Helper::Clamp(mip, 0.0f, static_cast<float>(mip_count - 1)) });
+        }
+
+        return samples;
+    }
+
+    void prefilter(const vector<vector<byte>>& source, const uint32_t width, const uint32_t height, const uint32_t mip_index, const uint32_t row, uint32_t* destination)
+    {
+        const uint32_t mip_width    = max(width >> mip_index, 1u);
+        const uint32_t mip_height   = max(height >> mip_index, 1u);
+
+        // A roughness of zero is a mirror, the environment as it is
+        if (mip_index == 0)
+        {
+            const float* texels = reinterpret_cast<const float*>(source[0].data()) + static_cast<uint64_t>(row) * width * 4;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                destination[x] = encode_rgb9e5(texels[x * 4 + 0], texels[x * 4 + 1], texels[x * 4 + 2]);
+            }
+
+            return;
+        }
+
+        const float roughness                   = min(sqrt(static_cast<float>(mip_index) / static_cast<float>(mip_roughness_max)), 1.0f);
+        const vector<PrefilterSample> samples   = get_prefilter_samples(roughness, width, height, static_cast<uint32_t>(source.size()));
+
+        for (uint32_t x = 0; x < mip_width; x++)
+        {
+            const Vector3 normal    = direction_from_uv((x + 0.5f) / mip_width, (row + 0.5f) / mip_height);
+            const Vector3 up        = abs(normal.y) < 0.999f ? Vector3::Up : Vector3::Right;
+            const Vector3 tangent   = Vector3::Cross(up, normal).Normalized();
+            const Vector3 bitangent = Vector3::Cross(normal, tangent);
+
+            Vector3 color   = Vector3::Zero;
+            float weight    = 0.0f;
+            for (const PrefilterSample& sample : samples)
+            {
+                const Vector3 direction = tangent * sample.direction.x + bitangent * sample.direction.y + normal * sample.direction.z;
+                color  += sample_trilinear(source, width, height, direction, sample.mip) * sample.weight;
+                weight += sample.weight;
+            }
+
+            color = weight > 0.0f ? color / weight : color;
+            destination[x] = encode_rgb9e5(color.x, color.y, color.z);
+        }
+    }
+
+    void project_irradiance(const byte* source, const uint32_t width, const uint32_t height, Vector3* coefficients)
+    {
+        for (uint32_t i = 0; i < sh_coefficient_count; i++)
+        {
+            coefficients[i] = Vector3::Zero;
+        }
+
+        const float* texels = reinterpret_cast<const float*>(source);
+        const float texel_solid_angle = (Helper::PI_2 / width) * (Helper::PI / height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const float v = (y + 0.5f) / height;
+
+            // Texels near the poles cover less of the sphere
+            const float solid_angle = texel_solid_angle * sin(v * Helper::PI);
+
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const Vector3 d     = direction_from_uv((x + 0.5f) / width, v);
+                const float* t      = texels + (static_cast<uint64_t>(y) * width + x) * 4;
+                const Vector3 color = Vector3(t[0], t[1], t[2]) * solid_angle;
+
+                coefficients[0] += color * 0.282095f;
+                coefficients[1] += color * (0.488603f * d.y);
+                coefficients[2] += color * (0.488603f * d.z);
+                coefficients[3] += color * (0.488603f * d.x);
+                coefficients[4] += color * (1.092548f * d.x * d.y);
+                coefficients[5] += color * (1.092548f * d.y * d.z);
+                coefficients[6] += color * (0.315392f * (3.0f * d.z * d.z - 1.0f));
+                coefficients[7] += color * (1.092548f * d.x * d.z);
+                coefficients[8] += color * (0.546274f * (d.x * d.x - d.y * d.y));
+            }
+        }
+
+        // Convolve with the cosine lobe and divide by pi [Ramamoorthi & Hanrahan 2001, "An Efficient Representation for Irradiance Environment Maps"]
+        const float band_scale[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+        for (uint32_t i = 0; i < sh_coefficient_count; i++)
+        {
+            coefficients[i] *= band_scale[i == 0 ? 0 : (i < 4 ? 1 : 2)];
+        }
+    }
+
+    uint32_t encode_rgb9e5(const float r, const float g, const float b)
+    {
+        // Negative values and NaNs become zero
+        const float rc      = r > 0.0f ? min(r, rgb9e5_max) : 0.0f;
+        const float gc      = g > 0.0f ? min(g, rgb9e5_max) : 0.0f;
+        const float bc      = b > 0.0f ? min(b, rgb9e5_max) : 0.0f;
+        const float max_c   = max(rc, max(gc, bc));
+
+        if (max_c <= 0.0f)
+            return 0;
+
+        // The exponent is biased by 15, the mantissas have 9 bits
+        int32_t exponent    = max(-16, static_cast<int32_t>(floor(log2(max_c)))) + 1 + 15;
+        float scale         = exp2(static_cast<float>(exponent - 15 - 9));
+        if (static_cast<uint32_t>(floor(max_c / scale + 0.5f)) == 512)
+        {
+            exponent++;
+            scale *= 2.0f;
+        }
+
+        const uint32_t rm = static_cast<uint32_t>(floor(rc / scale + 0.5f));
+        const uint32_t gm = static_cast<uint32_t>(floor(gc / scale + 0.5f));
+        const uint32_t bm = static_cast<uint32_t>(floor(bc / scale + 0.5f));
+
+        return rm | (gm << 9) | (bm << 18) | (static_cast<uint32_t>(exponent) << 27);
+    }
+}
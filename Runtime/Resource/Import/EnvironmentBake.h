@@ -0,0 +1,61 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "../../Math/Vector3.h"
+//=============================
+
+namespace Spartan
+{
+    // Turns an equirectangular HDR environment into what image based lighting samples: a mip chain where every mip is the environment
+    // convolved with the GGX lobe of a roughness (instead of a plain downsample), and the diffuse irradiance as spherical harmonics.
+    // Environments are RGBA with 32 bit float channels, prefiltered mips are packed as RGB9E5.
+    namespace EnvironmentBake
+    {
+        // The mip which the shaders sample for a roughness of 1 (g_envrionement_max_mip), mip m is filtered for a roughness of sqrt(m / mip_roughness_max)
+        static const uint32_t mip_roughness_max = 11;
+
+        // The number of irradiance coefficients (spherical harmonics up to the second band)
+        static const uint32_t sh_coefficient_count = 9;
+
+        // Prefilters one row of a mip, source is the environment's mip chain (which the filter reads from to avoid undersampling)
+        void prefilter(
+            const std::vector<std::vector<std::byte>>& source,
+            uint32_t width,
+            uint32_t height,
+            uint32_t mip_index,
+            uint32_t row,
+            uint32_t* destination
+        );
+
+        // Projects the irradiance of an environment onto spherical harmonics, the coefficients are divided by pi so
+        // that evaluating them for a normal gives the diffuse light of a white lambertian surface
+        void project_irradiance(const std::byte* source, uint32_t width, uint32_t height, Math::Vector3* coefficients);
+
+        // Packs a linear color into three 9 bit mantissas with a shared 5 bit exponent
+        uint32_t encode_rgb9e5(float r, float g, float b);
+    }
+}
@@ -22,9 +22,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =========================
 #include "Spartan.h"
 #include "ImageImporter.h"
+#include "MipChain.h"
+#include "TextureContainer.h"
 #define FREEIMAGE_LIB
 #include <FreeImage.h>
 #include <Utilities.h>
+#include "../../Core/Stopwatch.h"
+#include "../../IO/FileMapping.h"
 #include "../../Threading/Threading.h"
 #include "../../RHI/RHI_Texture2D.h"
 //====================================
@@ -37,23 +41,6 @@ namespace Spartan::freeimage_helper
 {
     static FREE_IMAGE_FILTER rescale_filter = FILTER_BOX;
 
-    // A struct that rescaling threads will work with
-    struct RescaleJob
-    {
-        uint32_t width           = 0;
-        uint32_t height          = 0;
-        uint32_t channel_count   = 0;
-        vector<std::byte>* data  = nullptr;
-        bool done                = false;
-
-        RescaleJob(const uint32_t width, const uint32_t height, const uint32_t channel_count)
-        {
-            this->width         = width;
-            this->height        = height;
-            this->channel_count = channel_count;
-        }
-    };
-
     inline uint32_t get_bytes_per_channel(FIBITMAP* bitmap)
     {
         if (!bitmap)
@@ -164,6 +151,10 @@ namespace Spartan
             return false;
         }
 
+        // DDS and KTX2 files already hold what the gpu needs, so they skip FreeImage, the mip generation and the compression
+        if (TextureContainer::is_container(file_path))
+            return LoadContainer(file_path, texture);
+
         // Acquire image format
         FREE_IMAGE_FORMAT format    = FreeImage_GetFileType(file_path.c_str(), 0);
         format                      = (format == FIF_UNKNOWN) ? FreeImage_GetFIFFromFilename(file_path.c_str()) : format;  // If the format is unknown, try to work it out from the file path
@@ -212,15 +203,15 @@ namespace Spartan
         std::vector<std::byte>& mip = texture->AddMip();
         GetBitsFromFibitmap(&mip, bitmap, image_width, image_height, image_channel_count);
 
+        // Free memory 
+        FreeImage_Unload(bitmap);
+
         // If the texture supports mipmaps, generate them
         if (generate_mipmaps)
         {
-            GenerateMipmaps(bitmap, texture, image_width, image_height, image_channel_count);
+            GenerateMipmaps(texture, image_width, image_height, image_channel_count, image_bytes_per_channel, image_is_grayscale);
         }
 
-        // Free memory 
-        FreeImage_Unload(bitmap);
-
         // Fill RHI_Texture with image properties
         texture->SetBitsPerChannel(image_bytes_per_channel * 8);
         texture->SetWidth(image_width);
@@ -230,6 +221,267 @@ namespace Spartan
         texture->SetFormat(image_format);
         texture->SetGrayscale(image_is_grayscale);
 
+        // Block compress textures which know what they hold, the top mip has to be made of whole 4x4 blocks
+        if (m_compression && texture->GetContent() != RHI_Texture_Content::Unknown)
+        {
+            const bool is_compressible = image_bytes_per_channel == 1 && image_channel_count == 4 && image_width % 4 == 0 && image_height % 4 == 0;
+            const RHI_Format compressed_format = is_compressible ? BlockCompression::select_format(texture->GetContent(), image_is_transparent, image_is_grayscale, m_compression_quality) : RHI_Format_Undefined;
+            if (compressed_format != RHI_Format_Undefined && !Compress(texture, compressed_format, m_compression_quality))
+            {
+                LOG_ERROR("Failed to compress \"%s\"", file_path.c_str());
+            }
+        }
+
+        return true;
+    }
+
+    bool ImageImporter::LoadHeightMap(const string& file_path, vector<float>* heights, uint32_t* width, uint32_t* height) const
+    {
+        if (!heights || !width || !height)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        if (!FileSystem::Exists(file_path))
+        {
+            LOG_ERROR("Path \"%s\" is invalid.", file_path.c_str());
+            return false;
+        }
+
+        // Raw files are rows of samples and nothing else, so they have to be square for the size to be known
+        const string extension = FileSystem::GetExtensionFromFilePath(file_path);
+        if (extension == ".r16" || extension == ".raw" || extension == ".r32")
+        {
+            FileMapping file(file_path);
+            if (!file.IsOpen())
+                return false;
+
+            const uint64_t bytes_per_sample = extension == ".r32" ? sizeof(float) : sizeof(uint16_t);
+            const uint64_t sample_count     = file.GetSize() / bytes_per_sample;
+            const uint32_t size             = static_cast<uint32_t>(sqrt(static_cast<double>(sample_count)) + 0.5);
+            if (size < 2 || static_cast<uint64_t>(size) * size * bytes_per_sample != file.GetSize())
+            {
+                LOG_ERROR("\"%s\" is not a square raw height map", file_path.c_str());
+                return false;
+            }
+
+            heights->resize(sample_count);
+            const std::byte* data = file.GetData();
+            for (uint64_t i = 0; i < sample_count; i++)
+            {
+                if (bytes_per_sample == sizeof(float))
+                {
+                    memcpy(&(*heights)[i], data + i * bytes_per_sample, sizeof(float));
+                }
+                else
+                {
+                    uint16_t sample = 0;
+                    memcpy(&sample, data + i * bytes_per_sample, sizeof(uint16_t));
+                    (*heights)[i] = static_cast<float>(sample) / 65535.0f;
+                }
+            }
+
+            *width  = size;
+            *height = size;
+            return true;
+        }
+
+        FREE_IMAGE_FORMAT format    = FreeImage_GetFileType(file_path.c_str(), 0);
+        format                      = (format == FIF_UNKNOWN) ? FreeImage_GetFIFFromFilename(file_path.c_str()) : format;
+        if (!FreeImage_FIFSupportsReading(format))
+        {
+            LOG_ERROR("Unsupported format");
+            return false;
+        }
+
+        FIBITMAP* bitmap = FreeImage_Load(format, file_path.c_str());
+        if (!bitmap)
+        {
+            LOG_ERROR("Failed to load \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        // One float per texel, integer formats are scaled to [0, 1] and colour ones are reduced to their luminance (the same thing for a grayscale image)
+        FIBITMAP* bitmap_float = FreeImage_ConvertToFloat(bitmap);
+        FreeImage_Unload(bitmap);
+        if (!bitmap_float)
+        {
+            LOG_ERROR("Failed to convert \"%s\" to floats", file_path.c_str());
+            return false;
+        }
+
+        *width  = FreeImage_GetWidth(bitmap_float);
+        *height = FreeImage_GetHeight(bitmap_float);
+        heights->resize(static_cast<uint64_t>(*width) * *height);
+
+        // FreeImage stores the rows from the bottom up, textures have them from the top down
+        for (uint32_t y = 0; y < *height; y++)
+        {
+            const float* row = reinterpret_cast<const float*>(FreeImage_GetScanLine(bitmap_float, *height - 1 - y));
+            memcpy(heights->data() + static_cast<uint64_t>(y) * *width, row, *width * sizeof(float));
+        }
+
+        FreeImage_Unload(bitmap_float);
+        return true;
+    }
+
+    bool ImageImporter::LoadContainer(const string& file_path, RHI_Texture* texture) const
+    {
+        FileMapping file(file_path);
+        if (!file.IsOpen())
+            return false;
+
+        TextureContainer::Description description;
+        if (!TextureContainer::parse(file.GetData(), file.GetSize(), &description))
+        {
+            LOG_ERROR("Failed to load \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        // The levels go to the mips as they are (supercompressed ones are inflated), each one on its own thread
+        vector<vector<std::byte>>& mips = texture->GetMips();
+        mips.resize(description.levels.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(mips.size()); i++)
+        {
+            mips[i].resize(description.levels[i].size_uncompressed);
+        }
+
+        atomic<bool> result = true;
+        m_context->GetSubsystem<Threading>()->ParallelFor(static_cast<uint32_t>(mips.size()), [&description, &mips, &result](const uint32_t i)
+        {
+            if (!TextureContainer::unpack(description.supercompression, description.levels[i], mips[i].data()))
+            {
+                result = false;
+            }
+        });
+
+        if (!result)
+        {
+            LOG_ERROR("Failed to inflate \"%s\"", file_path.c_str());
+            mips.clear();
+            return false;
+        }
+
+        // Fill RHI_Texture with image properties
+        texture->SetBitsPerChannel(description.bits_per_channel);
+        texture->SetWidth(description.width);
+        texture->SetHeight(description.height);
+        texture->SetChannelCount(description.channel_count);
+        texture->SetTransparency(description.is_transparent);
+        texture->SetFormat(description.format);
+        texture->SetGrayscale(description.channel_count == 1);
+
+        return true;
+    }
+
+    void ImageImporter::Benchmark(const string& file_path)
+    {
+        // Load the image without any compression or mips
+        RHI_Texture2D image(m_context, false);
+        if (!Load(file_path, &image, false))
+            return;
+
+        if (image.GetBytesPerChannel() != 1 || image.GetChannelCount() != 4)
+        {
+            LOG_ERROR("Only 8 bit RGBA images can be block compressed");
+            return;
+        }
+
+        const vector<std::byte> original    = image.GetMip(0);
+        const uint32_t width                = image.GetWidth();
+        const uint32_t height               = image.GetHeight();
+        const double pixel_count            = static_cast<double>(width) * static_cast<double>(height);
+
+        // The error is only measured on the channels that a format stores
+        static const RHI_Format formats[]       = { RHI_Format_BC1_Unorm, RHI_Format_BC3_Unorm, RHI_Format_BC4_Unorm, RHI_Format_BC5_Unorm, RHI_Format_BC7_Unorm };
+        static const uint32_t format_channels[] = { 3, 4, 1, 2, 4 };
+
+        LOG_INFO("Block compressing \"%s\" (%dx%d)", file_path.c_str(), width, height);
+        for (uint32_t format_index = 0; format_index < 5; format_index++)
+        {
+            for (const BlockCompression::Quality quality : { BlockCompression::Quality::Fast, BlockCompression::Quality::High })
+            {
+                RHI_Texture2D texture(m_context, false);
+                texture.SetWidth(width);
+                texture.SetHeight(height);
+                texture.SetData({ original });
+
+                const Stopwatch timer;
+                if (!Compress(&texture, formats[format_index], quality))
+                    return;
+                const double duration_ms = timer.GetElapsedTimeMs();
+
+                vector<std::byte> decoded(original.size());
+                BlockCompression::decode(formats[format_index], texture.GetMip(0).data(), width, height, decoded.data());
+
+                double error_squared = 0.0;
+                for (size_t texel = 0; texel < original.size(); texel += 4)
+                {
+                    for (uint32_t channel = 0; channel < format_channels[format_index]; channel++)
+                    {
+                        const double delta = static_cast<double>(to_integer<int>(original[texel + channel]) - to_integer<int>(decoded[texel + channel]));
+                        error_squared += delta * delta;
+                    }
+                }
+                const double mean_error_squared = error_squared / (pixel_count * format_channels[format_index]);
+                const double psnr               = mean_error_squared == 0.0 ? 99.0 : 10.0 * log10(255.0 * 255.0 / mean_error_squared);
+
+                LOG_INFO("%s (%s): %.2f ms, %.2f MPixels/s, %.2f dB",
+                    rhi_format_to_string(formats[format_index]),
+                    quality == BlockCompression::Quality::High ? "high" : "fast",
+                    duration_ms,
+                    pixel_count / (duration_ms * 1000.0),
+                    psnr
+                );
+            }
+        }
+    }
+
+    bool ImageImporter::Compress(RHI_Texture* texture, const RHI_Format format, const BlockCompression::Quality quality) const
+    {
+        // A job encodes a few rows of blocks of a mip, so that the large mips are spread across all threads as well
+        struct CompressJob
+        {
+            uint32_t mip_index;
+            uint32_t width;
+            uint32_t height;
+            uint32_t block_row_start;
+            uint32_t block_row_end;
+        };
+        static const uint32_t block_rows_per_job = 8;
+
+        vector<vector<std::byte>>& mips = texture->GetMips();
+        vector<vector<std::byte>> mips_compressed(mips.size());
+        vector<CompressJob> jobs;
+        for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(mips.size()); mip_index++)
+        {
+            const uint32_t width    = Math::Helper::Max(texture->GetWidth() >> mip_index, 1u);
+            const uint32_t height   = Math::Helper::Max(texture->GetHeight() >> mip_index, 1u);
+            if (mips[mip_index].size() != static_cast<size_t>(width) * height * 4)
+            {
+                LOG_ERROR("Mip %d is not an 8 bit RGBA image of %dx%d", mip_index, width, height);
+                return false;
+            }
+
+            mips_compressed[mip_index].resize(rhi_format_mip_size(format, width, height, 4));
+
+            const uint32_t block_rows = (height + 3) / 4;
+            for (uint32_t block_row = 0; block_row < block_rows; block_row += block_rows_per_job)
+            {
+                jobs.push_back({ mip_index, width, height, block_row, Math::Helper::Min(block_row + block_rows_per_job, block_rows) });
+            }
+        }
+
+        m_context->GetSubsystem<Threading>()->ParallelFor(static_cast<uint32_t>(jobs.size()), [&jobs, &mips, &mips_compressed, format, quality](const uint32_t i)
+        {
+            const CompressJob& job = jobs[i];
+            BlockCompression::encode(format, quality, mips[job.mip_index].data(), job.width, job.height, job.block_row_start, job.block_row_end, mips_compressed[job.mip_index].data());
+        });
+
+        mips.swap(mips_compressed);
+        texture->SetFormat(format);
+
         return true;
     }
 
@@ -257,64 +509,44 @@ namespace Spartan
         return true;
     }
 
-    void ImageImporter::GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels)
+    void ImageImporter::GenerateMipmaps(RHI_Texture* texture, uint32_t width, uint32_t height, const uint32_t channels, const uint32_t bytes_per_channel, const bool is_grayscale) const
     {
-        if (!texture)
+        if (!texture || texture->GetMips().empty())
         {
             LOG_ERROR_INVALID_PARAMETER();
             return;
         }
-    
-        // Create a RescaleJob for every mip that we need
-        vector<freeimage_helper::RescaleJob> jobs;
-        while (width > 1 && height > 1)
-        {
-            width    = Math::Helper::Max(width / 2, static_cast<uint32_t>(1));
-            height    = Math::Helper::Max(height / 2, static_cast<uint32_t>(1));
-            jobs.emplace_back(width, height, channels);
-            
-            // Resize the RHI_Texture vector accordingly
-            const auto size = width * height * channels;
-            std::vector<std::byte>& mip = texture->AddMip();
-            mip.reserve(size);
-            mip.resize(size);
-        }
 
-        // Pass data pointers (now that the RHI_Texture mip vector has been constructed)
-        for (uint32_t i = 0; i < jobs.size(); i++)
+        if (channels != 4 || (bytes_per_channel != 1 && bytes_per_channel != 4))
         {
-            // reminder: i + 1 because the 0 mip is the default image size
-            jobs[i].data = &texture->GetMip(i + 1);
+            LOG_ERROR("Mips can only be generated for RGBA images with 8 bit or 32 bit float channels");
+            return;
         }
 
-        // Parallelize mipmap generation using multiple threads (because FreeImage_Rescale() using FILTER_LANCZOS3 is expensive)
-        auto threading = m_context->GetSubsystem<Threading>();
-        for (auto& job : jobs)
+        // Colors are filtered in linear space and normals get renormalized (grayscale normal maps are height maps, so they are filtered as they are)
+        MipChain::Mode mode = MipChain::Mode::Linear;
+        mode = texture->GetContent() == RHI_Texture_Content::Color                   ? MipChain::Mode::Srgb   : mode;
+        mode = texture->GetContent() == RHI_Texture_Content::Normal && !is_grayscale ? MipChain::Mode::Normal : mode;
+
+        // Every mip is filtered from the previous one, in tiles which are spread across threads
+        Threading* threading = m_context->GetSubsystem<Threading>();
+        while (width > 1 && height > 1)
         {
-            threading->AddTask([this, &job, &bitmap]()
+            const uint32_t mip_width    = Math::Helper::Max(width / 2, static_cast<uint32_t>(1));
+            const uint32_t mip_height   = Math::Helper::Max(height / 2, static_cast<uint32_t>(1));
+
+            texture->AddMip().resize(static_cast<size_t>(mip_width) * mip_height * channels * bytes_per_channel);
+            vector<vector<std::byte>>& mips = texture->GetMips();
+            const std::byte* source         = mips[mips.size() - 2].data();
+            std::byte* destination          = mips[mips.size() - 1].data();
+
+            threading->ParallelFor(MipChain::get_tile_count(mip_width, mip_height), [&](const uint32_t tile_index)
             {
-                const auto bitmap_scaled = FreeImage_Rescale(bitmap, job.width, job.height, freeimage_helper::rescale_filter);
-                if (!GetBitsFromFibitmap(job.data, bitmap_scaled, job.width, job.height, job.channel_count))
-                {
-                    LOG_ERROR("Failed to create mip level %dx%d", job.width, job.height);
-                }
-                FreeImage_Unload(bitmap_scaled);
-                job.done = true;
+                MipChain::downsample(source, width, height, destination, mip_width, mip_height, bytes_per_channel, m_mip_filter, mode, tile_index);
             });
-        }
 
-        // Wait until all mipmaps have been generated
-        auto ready = false;
-        while (!ready)
-        {
-            ready = true;
-            for (const auto& job : jobs)
-            {
-                if (!job.done)
-                {
-                    ready = false;
-                }
-            }
+            width   = mip_width;
+            height  = mip_height;
         }
     }
 
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==============================
 #include <vector>
 #include <string>
+#include "MipChain.h"
+#include "BlockCompression.h"
 #include "../../RHI/RHI_Definition.h"
 #include "../../Core/Spartan_Definitions.h"
 //=========================================
@@ -42,13 +44,35 @@ namespace Spartan
 
         bool Load(const std::string& file_path, RHI_Texture* texture, bool generate_mipmaps = true);
 
+        // Reads a height map at its full precision (textures get 8 bits per channel), integer formats are normalized to [0, 1] and float ones are kept as they are.
+        // Besides the image formats (e.g. 16 bit PNG or EXR), headerless square files of 16 bit unsigned integers (.r16, .raw) or 32 bit floats (.r32) are read too.
+        bool LoadHeightMap(const std::string& file_path, std::vector<float>* heights, uint32_t* width, uint32_t* height) const;
+
+        // Textures which know what they hold (see RHI_Texture::SetContent()) are block compressed, in a format that suits it
+        void SetCompression(const bool compression)                                 { m_compression = compression; }
+        bool GetCompression()                                               const   { return m_compression; }
+        void SetCompressionQuality(const BlockCompression::Quality quality)         { m_compression_quality = quality; }
+        BlockCompression::Quality GetCompressionQuality()                   const   { return m_compression_quality; }
+
+        // The filter that mips are generated with
+        void SetMipFilter(const MipChain::Filter filter)                            { m_mip_filter = filter; }
+        MipChain::Filter GetMipFilter()                                     const   { return m_mip_filter; }
+
+        // Encodes an image in every block compressed format and quality, then logs the encoding speed and the error (peak signal to noise ratio)
+        void Benchmark(const std::string& file_path);
+
     private:    
+        bool LoadContainer(const std::string& file_path, RHI_Texture* texture) const;
+        bool Compress(RHI_Texture* texture, RHI_Format format, BlockCompression::Quality quality) const;
         bool GetBitsFromFibitmap(std::vector<std::byte>* data, FIBITMAP* bitmap, uint32_t width, uint32_t height, uint32_t channels) const;
-        void GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels);
+        void GenerateMipmaps(RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels, uint32_t bytes_per_channel, bool is_grayscale) const;
         FIBITMAP* ApplyBitmapCorrections(FIBITMAP* bitmap) const;
         FIBITMAP* _FreeImage_ConvertTo32Bits(FIBITMAP* bitmap) const;
         FIBITMAP* _FreeImage_Rescale(FIBITMAP* bitmap, uint32_t width, uint32_t height) const;
 
-        Context* m_context = nullptr;
+        MipChain::Filter m_mip_filter                       = MipChain::Filter::Kaiser;
+        bool m_compression                                  = true;
+        BlockCompression::Quality m_compression_quality     = BlockCompression::Quality::High;
+        Context* m_context                                  = nullptr;
     };
 }
@@ -0,0 +1,325 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========
+#include "Spartan.h"
+#include "MipChain.h"
+#include <xmmintrin.h>
+//====================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::MipChain
+{
+    // Small enough for a tile and the texels it reads to stay in the L2 cache
+    static const uint32_t tile_size = 64;
+
+    // Half widths of the kernels, in destination texels
+    static const float support_box      = 0.5f;
+    static const float support_kaiser   = 3.0f;
+    static const float support_lanczos  = 3.0f;
+    static const float kaiser_alpha     = 4.0f;
+
+    static float sinc(const float x)
+    {
+        if (abs(x) < 1e-5f)
+            return 1.0f;
+
+        const float pi_x = Math::Helper::PI * x;
+        return sin(pi_x) / pi_x;
+    }
+
+    // Modified Bessel function of the first kind (order 0), as a power series
+    static float bessel_i0(const float x)
+    {
+        float sum       = 1.0f;
+        float term      = 1.0f;
+        const float q   = x * x * 0.25f;
+        for (uint32_t k = 1; k < 32 && term > sum * 1e-8f; k++)
+        {
+            term *= q / static_cast<float>(k * k);
+            sum  += term;
+        }
+        return sum;
+    }
+
+    static float get_support(const Filter filter)
+    {
+        switch (filter)
+        {
+            case Filter::Kaiser:    return support_kaiser;
+            case Filter::Lanczos:   return support_lanczos;
+            default:                return support_box;
+        }
+    }
+
+    static float kernel(const Filter filter, const float x)
+    {
+        const float support = get_support(filter);
+        if (abs(x) > support)
+            return 0.0f;
+
+        switch (filter)
+        {
+            case Filter::Kaiser:
+            {
+                const float t = x / support;
+                return sinc(x) * bessel_i0(kaiser_alpha * sqrt(max(1.0f - t * t, 0.0f))) / bessel_i0(kaiser_alpha);
+            }
+            case Filter::Lanczos:
+                return sinc(x) * sinc(x / support);
+            default:
+                return 1.0f;
+        }
+    }
+
+    // The source texels (and their weights) that the destination texels [start, end) of an axis are filtered from
+    struct Axis
+    {
+        uint32_t tap_count  = 0;
+        int32_t index_min   = numeric_limits<int32_t>::max();
+        int32_t index_max   = 0;
+        vector<int32_t> indices;
+        vector<float> weights;
+
+        Axis(const Filter filter, const uint32_t source_size, const uint32_t destination_size, const uint32_t start, const uint32_t end)
+        {
+            const float scale           = static_cast<float>(source_size) / static_cast<float>(destination_size);
+            const float support_source  = get_support(filter) * scale;
+            tap_count                   = static_cast<uint32_t>(ceil(support_source * 2.0f)) + 1;
+
+            indices.resize((end - start) * tap_count);
+            weights.resize((end - start) * tap_count);
+            for (uint32_t i = start; i < end; i++)
+            {
+                const float center      = (static_cast<float>(i) + 0.5f) * scale;
+                const int32_t first     = static_cast<int32_t>(floor(center - support_source));
+                int32_t* tap_indices    = &indices[(i - start) * tap_count];
+                float* tap_weights      = &weights[(i - start) * tap_count];
+
+                float weight_sum = 0.0f;
+                for (uint32_t tap = 0; tap < tap_count; tap++)
+                {
+                    const int32_t index = first + static_cast<int32_t>(tap);
+                    tap_weights[tap]    = kernel(filter, (static_cast<float>(index) + 0.5f - center) / scale);
+                    tap_indices[tap]    = clamp(index, 0, static_cast<int32_t>(source_size) - 1); // the edge texels repeat
+                    weight_sum          += tap_weights[tap];
+                }
+
+                for (uint32_t tap = 0; tap < tap_count; tap++)
+                {
+                    tap_weights[tap] /= weight_sum;
+                    index_min = min(index_min, tap_indices[tap]);
+                    index_max = max(index_max, tap_indices[tap]);
+                }
+            }
+        }
+    };
+
+    // 8 bit to float conversion tables, for the color channels
+    struct Tables
+    {
+        float unorm[256];
+        float srgb_to_linear[256];
+        uint8_t linear_to_srgb[4096];
+
+        Tables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                const float value   = static_cast<float>(i) / 255.0f;
+                unorm[i]            = value;
+                srgb_to_linear[i]   = value <= 0.04045f ? value / 12.92f : pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < 4096; i++)
+            {
+                const float value   = static_cast<float>(i) / 4095.0f;
+                const float srgb    = value <= 0.0031308f ? value * 12.92f : 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+                linear_to_srgb[i]   = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    static const Tables& get_tables()
+    {
+        static const Tables tables;
+        return tables;
+    }
+
+    static void load_row(const std::byte* source, const uint32_t source_width, const uint32_t row, const int32_t column_min, const int32_t column_max, const uint32_t bytes_per_channel, const Mode mode, __m128* texels)
+    {
+        const __m128 normal_scale   = _mm_setr_ps(2.0f, 2.0f, 2.0f, 1.0f);
+        const __m128 normal_bias    = _mm_setr_ps(-1.0f, -1.0f, -1.0f, 0.0f);
+
+        if (bytes_per_channel == 1)
+        {
+            const Tables& tables    = get_tables();
+            const float* color      = mode == Mode::Srgb ? tables.srgb_to_linear : tables.unorm;
+            const uint8_t* texel    = reinterpret_cast<const uint8_t*>(source) + (static_cast<size_t>(row) * source_width + column_min) * 4;
+            for (int32_t column = column_min; column <= column_max; column++, texel += 4)
+            {
+                *texels++ = _mm_setr_ps(color[texel[0]], color[texel[1]], color[texel[2]], tables.unorm[texel[3]]);
+            }
+        }
+        else
+        {
+            const float* texel = reinterpret_cast<const float*>(source) + (static_cast<size_t>(row) * source_width + column_min) * 4;
+            for (int32_t column = column_min; column <= column_max; column++, texel += 4)
+            {
+                *texels++ = _mm_loadu_ps(texel);
+            }
+        }
+
+        if (mode == Mode::Normal)
+        {
+            texels -= column_max - column_min + 1;
+            for (int32_t column = column_min; column <= column_max; column++, texels++)
+            {
+                *texels = _mm_add_ps(_mm_mul_ps(*texels, normal_scale), normal_bias);
+            }
+        }
+    }
+
+    static void store_texel(std::byte* destination, const uint32_t destination_width, const uint32_t x, const uint32_t y, const uint32_t bytes_per_channel, const Mode mode, __m128 texel)
+    {
+        if (mode == Mode::Normal)
+        {
+            // Averaged normals get shorter, so bring them back to unit length before packing them again
+            alignas(16) float values[4];
+            _mm_store_ps(values, texel);
+            const float length_squared = values[0] * values[0] + values[1] * values[1] + values[2] * values[2];
+            const float scale          = length_squared > 1e-12f ? 1.0f / sqrt(length_squared) : 0.0f;
+            texel = _mm_mul_ps(texel, _mm_setr_ps(scale, scale, scale, 1.0f));
+            texel = _mm_add_ps(_mm_mul_ps(texel, _mm_setr_ps(0.5f, 0.5f, 0.5f, 1.0f)), _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.0f));
+        }
+
+        // The negative lobes of the sinc kernels can overshoot
+        texel = _mm_max_ps(texel, _mm_setzero_ps());
+
+        const size_t offset = (static_cast<size_t>(y) * destination_width + x) * 4;
+        if (bytes_per_channel == 1)
+        {
+            alignas(16) float values[4];
+            _mm_store_ps(values, _mm_min_ps(texel, _mm_set1_ps(1.0f)));
+
+            uint8_t* output = reinterpret_cast<uint8_t*>(destination) + offset;
+            if (mode == Mode::Srgb)
+            {
+                const Tables& tables = get_tables();
+                output[0] = tables.linear_to_srgb[static_cast<uint32_t>(values[0] * 4095.0f + 0.5f)];
+                output[1] = tables.linear_to_srgb[static_cast<uint32_t>(values[1] * 4095.0f + 0.5f)];
+                output[2] = tables.linear_to_srgb[static_cast<uint32_t>(values[2] * 4095.0f + 0.5f)];
+            }
+            else
+            {
+                output[0] = static_cast<uint8_t>(values[0] * 255.0f + 0.5f);
+                output[1] = static_cast<uint8_t>(values[1] * 255.0f + 0.5f);
+                output[2] = static_cast<uint8_t>(values[2] * 255.0f + 0.5f);
+            }
+            output[3] = static_cast<uint8_t>(values[3] * 255.0f + 0.5f);
+        }
+        else
+        {
+            _mm_storeu_ps(reinterpret_cast<float*>(destination) + offset, texel);
+        }
+    }
+
+    uint32_t get_tile_count(const uint32_t width, const uint32_t height)
+    {
+        return ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+    }
+
+    void downsample(
+        const std::byte* source,
+        const uint32_t source_width,
+        const uint32_t source_height,
+        std::byte* destination,
+        const uint32_t destination_width,
+        const uint32_t destination_height,
+        const uint32_t bytes_per_channel,
+        const Filter filter,
+        const Mode mode,
+        const uint32_t tile_index
+    )
+    {
+        if (!source || !destination || (bytes_per_channel != 1 && bytes_per_channel != 4) || tile_index >= get_tile_count(destination_width, destination_height))
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // Float images are linear already
+        const Mode mode_texels = (mode == Mode::Srgb && bytes_per_channel != 1) ? Mode::Linear : mode;
+
+        const uint32_t tiles_wide   = (destination_width + tile_size - 1) / tile_size;
+        const uint32_t x_start      = (tile_index % tiles_wide) * tile_size;
+        const uint32_t y_start      = (tile_index / tiles_wide) * tile_size;
+        const uint32_t x_end        = min(x_start + tile_size, destination_width);
+        const uint32_t y_end        = min(y_start + tile_size, destination_height);
+        const uint32_t tile_width   = x_end - x_start;
+
+        const Axis columns(filter, source_width, destination_width, x_start, x_end);
+        const Axis rows(filter, source_height, destination_height, y_start, y_end);
+
+        // Horizontal pass, every source row that the tile reads gets filtered down to the tile's width
+        vector<__m128> row(columns.index_max - columns.index_min + 1);
+        vector<__m128> filtered(static_cast<size_t>(rows.index_max - rows.index_min + 1) * tile_width);
+        for (int32_t y = rows.index_min; y <= rows.index_max; y++)
+        {
+            load_row(source, source_width, static_cast<uint32_t>(y), columns.index_min, columns.index_max, bytes_per_channel, mode_texels, row.data());
+
+            __m128* output = &filtered[static_cast<size_t>(y - rows.index_min) * tile_width];
+            for (uint32_t x = 0; x < tile_width; x++)
+            {
+                const int32_t* indices  = &columns.indices[x * columns.tap_count];
+                const float* weights    = &columns.weights[x * columns.tap_count];
+
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t tap = 0; tap < columns.tap_count; tap++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), row[indices[tap] - columns.index_min]));
+                }
+                output[x] = sum;
+            }
+        }
+
+        // Vertical pass
+        for (uint32_t y = y_start; y < y_end; y++)
+        {
+            const int32_t* indices  = &rows.indices[(y - y_start) * rows.tap_count];
+            const float* weights    = &rows.weights[(y - y_start) * rows.tap_count];
+
+            for (uint32_t x = 0; x < tile_width; x++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t tap = 0; tap < rows.tap_count; tap++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), filtered[static_cast<size_t>(indices[tap] - rows.index_min) * tile_width + x]));
+                }
+
+                store_texel(destination, destination_width, x_start + x, y, bytes_per_channel, mode_texels, sum);
+            }
+        }
+    }
+}
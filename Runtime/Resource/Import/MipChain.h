@@ -0,0 +1,67 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====
+#include <cstdint>
+#include <cstddef>
+//================
+
+namespace Spartan
+{
+    // Builds every mip from the one before it (instead of resampling the full resolution image for every mip). A mip is filtered in square
+    // tiles which fit in the cache and which are independent of each other, so they can be spread across threads. Texels are filtered as
+    // four floats at once (SSE), images are RGBA with 8 bit or 32 bit float channels.
+    namespace MipChain
+    {
+        enum class Filter
+        {
+            Box,        // 2x2 average, the fastest and the blurriest
+            Kaiser,     // Kaiser windowed sinc, sharp with little ringing
+            Lanczos     // Lanczos windowed sinc (3 lobes), the sharpest, rings a bit more
+        };
+
+        enum class Mode
+        {
+            Linear,     // texels are filtered as they are
+            Srgb,       // color channels are filtered in linear space (8 bit images only, alpha is always linear)
+            Normal      // texels are tangent space normals, which are renormalized after filtering
+        };
+
+        // The number of tiles that a mip of the given size is split into
+        uint32_t get_tile_count(uint32_t width, uint32_t height);
+
+        // Filters one tile of destination, which is a smaller version of source (usually half the size)
+        void downsample(
+            const std::byte* source,
+            uint32_t source_width,
+            uint32_t source_height,
+            std::byte* destination,
+            uint32_t destination_width,
+            uint32_t destination_height,
+            uint32_t bytes_per_channel,
+            Filter filter,
+            Mode mode,
+            uint32_t tile_index
+        );
+    }
+}
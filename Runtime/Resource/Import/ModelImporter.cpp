@@ -24,13 +24,21 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ModelImporter.h"
 #include "AssimpHelper.h"
 #include "../ProgressTracker.h"
-#include "../../RHI/RHI_Texture.h"
+#include "../ResourceCache.h"
+#include "../../RHI/RHI_Texture2D.h"
 #include "../../Rendering/Model.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Material.h"
+#include "../../Rendering/Meshlet.h"
+#include "../../Rendering/MeshLod.h"
+#include "../../Rendering/MeshBvh.h"
+#include "../../Rendering/MeshOptimizer.h"
+#include "../../Threading/Threading.h"
 #include "../../World/World.h"
 #include "../../World/Components/Renderable.h"
+#include "../../World/Components/Animator.h"
 #include "../../RHI/RHI_Vertex.h"
+#include <unordered_set>
 //============================================
 
 //= NAMESPACES ================
@@ -41,6 +49,47 @@ using namespace Assimp;
 
 namespace Spartan
 {
+    // A mesh converted from Assimp, ready to be appended to the model
+    struct ModelMesh
+    {
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        vector<Meshlet> meshlets;
+        vector<uint32_t> indices_lods;
+        vector<MeshLod> lods;
+        vector<BoneWeights> bone_weights; // empty for meshes without bones
+        MeshBvhData bvh;
+        BoundingBox aabb;
+        MeshOptimizer::Statistics statistics_imported;
+        MeshOptimizer::Statistics statistics_optimized;
+
+        // Where the geometry ended up in the model, nodes which instance the mesh share it
+        bool is_appended        = false;
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+        uint32_t vertex_offset  = 0;
+        uint32_t vertex_count   = 0;
+        uint32_t meshlet_offset = 0;
+        uint32_t meshlet_count  = 0;
+        uint32_t lod_offset     = 0;
+        uint32_t lod_count      = 0;
+    };
+
+    // A texture file, decoded once no matter how many materials use it
+    struct ModelTexture
+    {
+        string file_path;
+        shared_ptr<RHI_Texture2D> texture;
+        RHI_Texture_Content content = RHI_Texture_Content::Unknown;
+    };
+
+    struct ModelTextureSlot
+    {
+        shared_ptr<Material> material;
+        Material_Property type;
+        uint32_t texture_index;
+    };
+
     ModelImporter::ModelImporter(Context* context)
     {
         m_context    = context;
@@ -101,7 +150,6 @@ namespace Spartan
             aiProcess_GenSmoothNormals |
             aiProcess_JoinIdenticalVertices |
             aiProcess_OptimizeMeshes |              // reduce the number of meshes         
-            aiProcess_ImproveCacheLocality |        // re-order triangles for better vertex cache locality.
             aiProcess_RemoveRedundantMaterials |    // remove redundant/unreferenced materials.
             aiProcess_LimitBoneWeights |
             aiProcess_SplitLargeMeshes |
@@ -111,11 +159,12 @@ namespace Spartan
             aiProcess_FindDegenerates |             // convert degenerate primitives to proper lines or points.
             aiProcess_FindInvalidData |
             aiProcess_FindInstances |
-            aiProcess_ValidateDataStructure |
-            aiProcess_Debone;
+            aiProcess_ValidateDataStructure;
 
         // aiProcess_FixInfacingNormals - is not reliable and fails often.
         // aiProcess_OptimizeGraph      - works but because it merges as nodes as possible, you can't really click and select anything other than the entire thing.
+        // aiProcess_ImproveCacheLocality - the meshes are optimized by the engine instead (see MeshOptimizer), after which meshlet building would reorder them anyway.
+        // aiProcess_Debone             - meshes that follow a single bone lose it and get parented to the bone's node instead, which the animations don't move.
 
         // Read the 3D model file from disk
         if (const aiScene* scene = importer.ReadFile(file_path, importer_flags))
@@ -128,6 +177,42 @@ namespace Spartan
             params.scene            = scene;
             params.has_animation    = scene->mNumAnimations != 0;
 
+            // Only static geometry is compressed, animated geometry keeps full precision
+            params.model->SetVertexCompression(m_vertex_compression && !params.has_animation);
+
+            // Create the materials, this also gathers the textures that they need
+            params.materials.resize(scene->mNumMaterials);
+            for (uint32_t i = 0; i < scene->mNumMaterials; i++)
+            {
+                params.materials[i] = LoadMaterial(scene->mMaterials[i], params);
+            }
+
+            // The skeleton comes before the meshes, as their bone weights refer to it
+            ParseSkeleton(params);
+            params.model->SetBones(params.bones);
+
+            // Decode the textures and convert the meshes in parallel, the textures go first as they tend to take the longest
+            ProgressTracker::Get().SetStatus(ProgressType::ModelImporter, "Converting meshes and decoding textures...");
+            params.meshes.resize(scene->mNumMeshes);
+            const uint32_t texture_count = static_cast<uint32_t>(params.textures.size());
+            m_context->GetSubsystem<Threading>()->ParallelFor(texture_count + scene->mNumMeshes, [this, &params, texture_count](const uint32_t i)
+            {
+                if (i < texture_count)
+                {
+                    LoadTexture(&params.textures[i]);
+                }
+                else
+                {
+                    LoadMesh(params.scene->mMeshes[i - texture_count], params, &params.meshes[i - texture_count]);
+                }
+            });
+
+            // Assign the textures to the material slots that requested them
+            for (const ModelTextureSlot& slot : params.texture_slots)
+            {
+                LoadTextureSlot(slot, params);
+            }
+
             // Create root entity to match Assimp's root node
             const bool is_active = false;
             shared_ptr<Entity> new_entity = m_world->EntityCreate(is_active);
@@ -140,6 +225,28 @@ namespace Spartan
             ParseAnimations(params);
             // Update model geometry
             model->UpdateGeometry();
+
+            // Skinned models are animated by an animator on their root entity
+            if (!params.bones.empty())
+            {
+                new_entity->AddComponent<Animator>()->SetModel(params.model);
+            }
+
+            MeshOptimizer::Statistics statistics_imported;
+            MeshOptimizer::Statistics statistics_optimized;
+            for (const ModelMesh& mesh : params.meshes)
+            {
+                statistics_imported.Add(mesh.statistics_imported);
+                statistics_optimized.Add(mesh.statistics_optimized);
+            }
+
+            LOG_INFO("Vertex cache of \"%s\": ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                params.name.c_str(),
+                statistics_imported.GetAcmr(),
+                statistics_optimized.GetAcmr(),
+                statistics_imported.GetAtvr(),
+                statistics_optimized.GetAtvr()
+            );
         }
         else
         {
@@ -151,7 +258,7 @@ namespace Spartan
         return params.scene != nullptr;
     }
 
-    void ModelImporter::ParseNode(const aiNode* assimp_node, const ModelParams& params, Entity* parent_node, Entity* new_entity)
+    void ModelImporter::ParseNode(const aiNode* assimp_node, ModelParams& params, Entity* parent_node, Entity* new_entity)
     {
         if (parent_node) // parent node is already set
         {
@@ -182,12 +289,11 @@ namespace Spartan
         ProgressTracker::Get().IncrementJobsDone(ProgressType::ModelImporter);
     }
 
-    void ModelImporter::ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, const ModelParams& params)
+    void ModelImporter::ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, ModelParams& params)
     {
         for (uint32_t i = 0; i < assimp_node->mNumMeshes; i++)
         {
             auto entity = new_entity; // set the current entity
-            const auto assimp_mesh = params.scene->mMeshes[assimp_node->mMeshes[i]]; // get mesh
             string _name = assimp_node->mName.C_Str(); // get name
 
             // if this node has many meshes, then assign a new entity for each one of them
@@ -203,64 +309,160 @@ namespace Spartan
             entity->SetName(_name);
 
             // Process mesh
-            LoadMesh(assimp_mesh, entity, params);
+            AddMesh(assimp_node->mMeshes[i], entity, params);
             entity->SetActive(true);
         }
     }
 
+    // Whether a node or any of the nodes below it is a bone
+    static bool node_has_bones(const aiNode* node, const unordered_set<string>& bone_names)
+    {
+        if (bone_names.count(node->mName.C_Str()) != 0)
+            return true;
+
+        for (uint32_t i = 0; i < node->mNumChildren; i++)
+        {
+            if (node_has_bones(node->mChildren[i], bone_names))
+                return true;
+        }
+
+        return false;
+    }
+
+    static void node_add_bones(const aiNode* node, const int32_t parent, const unordered_set<string>& bone_names, ModelParams& params)
+    {
+        if (!node_has_bones(node, bone_names))
+            return;
+
+        const Matrix transform = AssimpHelper::ai_matrix4_x4_to_matrix(node->mTransformation);
+
+        AnimationBone bone;
+        bone.name           = node->mName.C_Str();
+        bone.parent         = parent;
+        bone.rest.position  = transform.GetTranslation();
+        bone.rest.rotation  = transform.GetRotation();
+        bone.rest.scale     = transform.GetScale();
+
+        const int32_t index = static_cast<int32_t>(params.bones.size());
+        params.bone_indices[bone.name] = static_cast<uint32_t>(index);
+        params.bones.emplace_back(bone);
+
+        for (uint32_t i = 0; i < node->mNumChildren; i++)
+        {
+            node_add_bones(node->mChildren[i], index, bone_names, params);
+        }
+    }
+
+    void ModelImporter::ParseSkeleton(ModelParams& params) const
+    {
+        // The nodes that the meshes' bones refer to
+        unordered_set<string> bone_names;
+        for (uint32_t i = 0; i < params.scene->mNumMeshes; i++)
+        {
+            const aiMesh* assimp_mesh = params.scene->mMeshes[i];
+            for (uint32_t j = 0; j < assimp_mesh->mNumBones; j++)
+            {
+                bone_names.insert(assimp_mesh->mBones[j]->mName.C_Str());
+            }
+        }
+
+        if (bone_names.empty())
+            return;
+
+        // The skeleton is every node on the way from the root to a bone, the root node is left out as its transform is the root entity's.
+        // Nodes are added before their children, which is the order that the bone matrices are computed in.
+        for (uint32_t i = 0; i < params.scene->mRootNode->mNumChildren; i++)
+        {
+            node_add_bones(params.scene->mRootNode->mChildren[i], -1, bone_names, params);
+        }
+
+        // The bind pose (meshes which share a bone are expected to have been bound with the same offset, which is the norm)
+        for (uint32_t i = 0; i < params.scene->mNumMeshes; i++)
+        {
+            const aiMesh* assimp_mesh = params.scene->mMeshes[i];
+            for (uint32_t j = 0; j < assimp_mesh->mNumBones; j++)
+            {
+                const auto it = params.bone_indices.find(assimp_mesh->mBones[j]->mName.C_Str());
+                if (it != params.bone_indices.end())
+                {
+                    params.bones[it->second].offset = AssimpHelper::ai_matrix4_x4_to_matrix(assimp_mesh->mBones[j]->mOffsetMatrix);
+                }
+            }
+        }
+
+        if (params.bones.size() >= numeric_limits<uint16_t>::max())
+        {
+            LOG_WARNING("\"%s\" has too many bones (%d), it won't be animated", params.name.c_str(), static_cast<uint32_t>(params.bones.size()));
+            params.bones.clear();
+            params.bone_indices.clear();
+        }
+    }
+
     void ModelImporter::ParseAnimations(const ModelParams& params)
     {
+        if (params.bones.empty())
+            return;
+
         for (uint32_t i = 0; i < params.scene->mNumAnimations; i++)
         {
-            const auto assimp_animation = params.scene->mAnimations[i];
+            const aiAnimation* assimp_animation = params.scene->mAnimations[i];
             auto animation = make_shared<Animation>(m_context);
 
+            // Keys are converted from ticks to seconds
+            const double ticks_per_second   = assimp_animation->mTicksPerSecond != 0.0 ? assimp_animation->mTicksPerSecond : 25.0;
+            const auto to_seconds           = [ticks_per_second](const double time) { return static_cast<float>(time / ticks_per_second); };
+
             // Basic properties
             animation->SetName(assimp_animation->mName.C_Str());
-            animation->SetDuration(assimp_animation->mDuration);
-            animation->SetTicksPerSec(assimp_animation->mTicksPerSecond != 0.0f ? assimp_animation->mTicksPerSecond : 25.0f);
+            animation->SetDuration(to_seconds(assimp_animation->mDuration));
 
             // Animation channels
+            uint32_t key_count_imported = 0;
             for (uint32_t j = 0; j < static_cast<uint32_t>(assimp_animation->mNumChannels); j++)
             {
-                const auto assimp_node_anim = assimp_animation->mChannels[j];
-                AnimationNode animation_node;
+                const aiNodeAnim* assimp_node_anim = assimp_animation->mChannels[j];
 
-                animation_node.name = assimp_node_anim->mNodeName.C_Str();
+                // Only the nodes of the skeleton are animated
+                const auto it = params.bone_indices.find(assimp_node_anim->mNodeName.C_Str());
+                if (it == params.bone_indices.end())
+                    continue;
 
                 // Position keys
-                for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumPositionKeys); k++)
+                vector<KeyVector> positions(assimp_node_anim->mNumPositionKeys);
+                for (uint32_t k = 0; k < static_cast<uint32_t>(positions.size()); k++)
                 {
-                    const auto time = assimp_node_anim->mPositionKeys[k].mTime;
-                    const auto value = AssimpHelper::to_vector3(assimp_node_anim->mPositionKeys[k].mValue);
-
-                    animation_node.positionFrames.emplace_back(KeyVector{ time, value });
+                    positions[k].time   = to_seconds(assimp_node_anim->mPositionKeys[k].mTime);
+                    positions[k].value  = AssimpHelper::to_vector3(assimp_node_anim->mPositionKeys[k].mValue);
                 }
 
                 // Rotation keys
-                for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumRotationKeys); k++)
+                vector<KeyQuaternion> rotations(assimp_node_anim->mNumRotationKeys);
+                for (uint32_t k = 0; k < static_cast<uint32_t>(rotations.size()); k++)
                 {
-                    const auto time = assimp_node_anim->mPositionKeys[k].mTime;
-                    const auto value = AssimpHelper::to_quaternion(assimp_node_anim->mRotationKeys[k].mValue);
-
-                    animation_node.rotationFrames.emplace_back(KeyQuaternion{ time, value });
+                    rotations[k].time   = to_seconds(assimp_node_anim->mRotationKeys[k].mTime);
+                    rotations[k].value  = AssimpHelper::to_quaternion(assimp_node_anim->mRotationKeys[k].mValue);
                 }
 
                 // Scaling keys
-                for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumScalingKeys); k++)
+                vector<KeyVector> scales(assimp_node_anim->mNumScalingKeys);
+                for (uint32_t k = 0; k < static_cast<uint32_t>(scales.size()); k++)
                 {
-                    const auto time = assimp_node_anim->mPositionKeys[k].mTime;
-                    const auto value = AssimpHelper::to_vector3(assimp_node_anim->mScalingKeys[k].mValue);
-
-                    animation_node.scaleFrames.emplace_back(KeyVector{ time, value });
+                    scales[k].time  = to_seconds(assimp_node_anim->mScalingKeys[k].mTime);
+                    scales[k].value = AssimpHelper::to_vector3(assimp_node_anim->mScalingKeys[k].mValue);
                 }
+
+                key_count_imported += static_cast<uint32_t>(positions.size() + rotations.size() + scales.size());
+                animation->AddChannel(assimp_node_anim->mNodeName.C_Str(), it->second, positions, rotations, scales);
             }
+
+            LOG_INFO("Keys of animation \"%s\": %d -> %d", animation->GetName().c_str(), key_count_imported, animation->GetKeyCount());
+            params.model->AddAnimation(animation);
         }
     }
 
-    void ModelImporter::LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params)
+    void ModelImporter::LoadMesh(const aiMesh* assimp_mesh, const ModelParams& params, ModelMesh* mesh) const
     {
-        if (!assimp_mesh || !entity_parent)
+        if (!assimp_mesh || !mesh)
         {
             LOG_ERROR_INVALID_PARAMETER();
             return;
@@ -270,8 +472,14 @@ namespace Spartan
         const uint32_t index_count  = assimp_mesh->mNumFaces * 3;
 
         // Vertices
-        vector<RHI_Vertex_PosTexNorTan> vertices = vector<RHI_Vertex_PosTexNorTan>(vertex_count);
+        vector<RHI_Vertex_PosTexNorTan>& vertices = mesh->vertices;
+        vertices.resize(vertex_count);
         {
+            const uint32_t uv_channel       = 0;
+            const bool has_normals          = assimp_mesh->mNormals != nullptr;
+            const bool has_tangents         = assimp_mesh->mTangents != nullptr;
+            const bool has_texture_coords   = assimp_mesh->HasTextureCoords(uv_channel);
+
             for (uint32_t i = 0; i < vertex_count; i++)
             {
                 auto& vertex = vertices[i];
@@ -283,7 +491,7 @@ namespace Spartan
                 vertex.pos[2] = pos.z;
 
                 // Normal
-                if (assimp_mesh->mNormals)
+                if (has_normals)
                 {
                     const auto& normal = assimp_mesh->mNormals[i];
                     vertex.nor[0] = normal.x;
@@ -292,7 +500,7 @@ namespace Spartan
                 }
 
                 // Tangent
-                if (assimp_mesh->mTangents)
+                if (has_tangents)
                 {
                     const auto& tangent = assimp_mesh->mTangents[i];
                     vertex.tan[0] = tangent.x;
@@ -301,8 +509,7 @@ namespace Spartan
                 }
 
                 // Texture coordinates
-                const uint32_t uv_channel = 0;
-                if (assimp_mesh->HasTextureCoords(uv_channel))
+                if (has_texture_coords)
                 {
                     const auto& tex_coords = assimp_mesh->mTextureCoords[uv_channel][i];
                     vertex.tex[0] = tex_coords.x;
@@ -312,7 +519,8 @@ namespace Spartan
         }
 
         // Indices
-        vector<uint32_t> indices = vector<uint32_t>(index_count);
+        vector<uint32_t>& indices = mesh->indices;
+        indices.resize(index_count);
         {
             // Get indices by iterating through each face of the mesh.
             for (uint32_t face_index = 0; face_index < assimp_mesh->mNumFaces; face_index++)
@@ -326,13 +534,92 @@ namespace Spartan
             }
         }
 
-        // Compute AABB (before doing move operation on vertices)
-        const auto aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
+        // Bones
+        LoadBones(assimp_mesh, params, mesh);
 
-        // Add the mesh to the model
-        uint32_t index_offset;
-        uint32_t vertex_offset;
-        params.model->AppendGeometry(move(indices), move(vertices), &index_offset, &vertex_offset);
+        // Optimize the vertex cache, overdraw and vertex fetch order (the bone weights follow their vertices)
+        mesh->statistics_imported = MeshOptimizer::analyze(indices, vertex_count);
+        vector<uint32_t> vertex_remap;
+        MeshOptimizer::optimize(&vertices, &indices, &vertex_remap);
+        if (!mesh->bone_weights.empty() && !vertex_remap.empty())
+        {
+            vector<BoneWeights> bone_weights(mesh->bone_weights.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(vertex_remap.size()); i++)
+            {
+                bone_weights[vertex_remap[i]] = mesh->bone_weights[i];
+            }
+            mesh->bone_weights = move(bone_weights);
+        }
+
+        // Split the mesh into meshlets (reorders the indices so that each meshlet's triangles are contiguous)
+        MeshletHelper::build(vertices, &indices, &mesh->meshlets);
+        {
+            // Restore the vertex cache order within each meshlet
+            vector<uint32_t> meshlet_offsets(mesh->meshlets.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(mesh->meshlets.size()); i++)
+            {
+                meshlet_offsets[i] = mesh->meshlets[i].index_offset;
+            }
+            MeshOptimizer::optimize_vertex_cache_ranges(&indices, vertex_count, meshlet_offsets);
+        }
+        mesh->statistics_optimized = MeshOptimizer::analyze(indices, vertex_count);
+
+        // The bvh is built here (in parallel with the other meshes) instead of when the mesh is appended to the model
+        MeshBvhHelper::build(vertices, indices, &mesh->bvh);
+
+        // Generate the levels of detail (skinned meshes keep full detail)
+        if (!params.has_animation)
+        {
+            MeshLodHelper::build_chain(m_context->GetSubsystem<Threading>(), vertices, indices, m_lod_count, &mesh->indices_lods, &mesh->lods);
+
+            vector<uint32_t> lod_offsets(mesh->lods.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(mesh->lods.size()); i++)
+            {
+                lod_offsets[i] = mesh->lods[i].index_offset;
+            }
+            MeshOptimizer::optimize_vertex_cache_ranges(&mesh->indices_lods, vertex_count, lod_offsets);
+        }
+
+        mesh->aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
+    }
+
+    void ModelImporter::AddMesh(const uint32_t mesh_index, Entity* entity_parent, ModelParams& params)
+    {
+        if (!entity_parent || mesh_index >= params.meshes.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // Add the mesh to the model, unless another node already did
+        ModelMesh& mesh = params.meshes[mesh_index];
+        if (!mesh.is_appended && !mesh.indices.empty() && !mesh.vertices.empty())
+        {
+            params.model->AppendGeometry(mesh.indices, mesh.vertices, &mesh.index_offset, &mesh.vertex_offset, &mesh.bvh);
+            params.model->AppendMeshlets(mesh.meshlets, mesh.index_offset, &mesh.meshlet_offset);
+            params.model->AppendLods(mesh.indices_lods, mesh.lods, &mesh.lod_offset);
+            if (!mesh.bone_weights.empty())
+            {
+                params.model->AppendBoneWeights(mesh.bone_weights, mesh.vertex_offset);
+            }
+
+            mesh.is_appended    = true;
+            mesh.index_count    = static_cast<uint32_t>(mesh.indices.size());
+            mesh.vertex_count   = static_cast<uint32_t>(mesh.vertices.size());
+            mesh.meshlet_count  = static_cast<uint32_t>(mesh.meshlets.size());
+            mesh.lod_count      = static_cast<uint32_t>(mesh.lods.size());
+
+            // The model has its own copy now
+            mesh.vertices       = vector<RHI_Vertex_PosTexNorTan>();
+            mesh.indices        = vector<uint32_t>();
+            mesh.meshlets       = vector<Meshlet>();
+            mesh.indices_lods   = vector<uint32_t>();
+            mesh.lods           = vector<MeshLod>();
+            mesh.bone_weights   = vector<BoneWeights>();
+        }
+
+        if (!mesh.is_appended)
+            return;
 
         // Add a renderable component to this entity
         auto renderable    = entity_parent->AddComponent<Renderable>();
@@ -340,69 +627,94 @@ namespace Spartan
         // Set the geometry
         renderable->GeometrySet(
             entity_parent->GetName(),
-            index_offset,
-            static_cast<uint32_t>(indices.size()),
-            vertex_offset,
-            static_cast<uint32_t>(vertices.size()),
-            aabb,
-            params.model
+            mesh.index_offset,
+            mesh.index_count,
+            mesh.vertex_offset,
+            mesh.vertex_count,
+            mesh.aabb,
+            params.model,
+            mesh.meshlet_offset,
+            mesh.meshlet_count,
+            mesh.lod_offset,
+            mesh.lod_count
         );
 
         // Material
-        if (params.scene->HasMaterials())
+        const aiMesh* assimp_mesh = params.scene->mMeshes[mesh_index];
+        if (assimp_mesh->mMaterialIndex < params.materials.size())
         {
-            // Get aiMaterial
-            const auto assimp_material = params.scene->mMaterials[assimp_mesh->mMaterialIndex];
-            // Convert it and add it to the model
-            shared_ptr<Material> material = LoadMaterial(assimp_material, params);
-            params.model->AddMaterial(material, entity_parent->GetPtrShared());
+            if (shared_ptr<Material>& material = params.materials[assimp_mesh->mMaterialIndex])
+            {
+                params.model->AddMaterial(material, entity_parent->GetPtrShared());
+            }
         }
-
-        // Bones
-        LoadBones(assimp_mesh, params);
     }
 
-    void ModelImporter::LoadBones(const aiMesh* assimp_mesh, const ModelParams& params)
+    void ModelImporter::LoadBones(const aiMesh* assimp_mesh, const ModelParams& params, ModelMesh* mesh) const
     {
-        // Maximum number of bones per mesh
-        // Must not be higher than same const in skinning shader
-        constexpr uint8_t MAX_BONES = 64;
-        // Maximum number of bones per vertex
-        constexpr uint8_t MAX_BONES_PER_VERTEX = 4;
-
-        //for (uint32_t i = 0; i < assimp_mesh->mNumBones; i++)
-        //{
-        //    uint32_t index = 0;
-
-        //    assert(assimp_mesh->mNumBones <= MAX_BONES);
-
-        //    string name = assimp_mesh->mBones[i]->mName.data;
-
-        //    if (boneMapping.find(name) == boneMapping.end())
-        //    {
-        //        // Bone not present, add new one
-        //        index = numBones;
-        //        numBones++;
-        //        BoneInfo bone;
-        //        boneInfo.push_back(bone);
-        //        boneInfo[index].offset = pMesh->mBones[i]->mOffsetMatrix;
-        //        boneMapping[name] = index;
-        //    }
-        //    else
-        //    {
-        //        index = boneMapping[name];
-        //    }
-
-        //    for (uint32_t j = 0; j < assimp_mesh->mBones[i]->mNumWeights; j++)
-        //    {
-        //        uint32_t vertexID = vertexOffset + pMesh->mBones[i]->mWeights[j].mVertexId;
-        //        Bones[vertexID].add(index, pMesh->mBones[i]->mWeights[j].mWeight);
-        //    }
-        //}
-        //boneTransforms.resize(numBones);
+        if (!assimp_mesh->HasBones() || params.bones.empty())
+            return;
+
+        vector<BoneWeights>& bone_weights = mesh->bone_weights;
+        bone_weights.assign(assimp_mesh->mNumVertices, BoneWeights());
+
+        for (uint32_t i = 0; i < assimp_mesh->mNumBones; i++)
+        {
+            const aiBone* assimp_bone = assimp_mesh->mBones[i];
+            const auto it = params.bone_indices.find(assimp_bone->mName.C_Str());
+            if (it == params.bone_indices.end())
+                continue;
+
+            for (uint32_t j = 0; j < assimp_bone->mNumWeights; j++)
+            {
+                const aiVertexWeight& assimp_weight = assimp_bone->mWeights[j];
+                if (assimp_weight.mVertexId >= assimp_mesh->mNumVertices)
+                    continue;
+
+                // Keep the strongest influences (assimp already limits them, but not every importer respects that)
+                BoneWeights& weights = bone_weights[assimp_weight.mVertexId];
+                uint32_t weakest = 0;
+                for (uint32_t k = 1; k < bone_influence_count; k++)
+                {
+                    if (weights.weights[k] < weights.weights[weakest])
+                    {
+                        weakest = k;
+                    }
+                }
+
+                if (assimp_weight.mWeight > weights.weights[weakest])
+                {
+                    weights.indices[weakest] = static_cast<uint16_t>(it->second);
+                    weights.weights[weakest] = assimp_weight.mWeight;
+                }
+            }
+        }
+
+        // Normalize, vertices that no bone influences stay where they are (the last matrix of the palette is the identity)
+        for (BoneWeights& weights : bone_weights)
+        {
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < bone_influence_count; k++)
+            {
+                sum += weights.weights[k];
+            }
+
+            if (sum <= 0.0f)
+            {
+                weights = BoneWeights();
+                weights.indices[0] = static_cast<uint16_t>(params.bones.size());
+                weights.weights[0] = 1.0f;
+                continue;
+            }
+
+            for (uint32_t k = 0; k < bone_influence_count; k++)
+            {
+                weights.weights[k] /= sum;
+            }
+        }
     }
 
-    shared_ptr<Material> ModelImporter::LoadMaterial(aiMaterial* assimp_material, const ModelParams& params)
+    shared_ptr<Material> ModelImporter::LoadMaterial(aiMaterial* assimp_material, ModelParams& params)
     {
         if (!assimp_material)
         {
@@ -429,7 +741,7 @@ namespace Spartan
         material->SetColorAlbedo(Vector4(color_diffuse.r, color_diffuse.g, color_diffuse.b, opacity.r));
 
         // TEXTURES
-        const auto load_mat_tex = [&params, &assimp_material, &material](const Material_Property type_spartan, const aiTextureType type_assimp_pbr, const aiTextureType type_assimp_legacy)
+        const auto load_mat_tex = [this, &params, &assimp_material, &material](const Material_Property type_spartan, const aiTextureType type_assimp_pbr, const aiTextureType type_assimp_legacy)
         {
             aiTextureType type_assimp   = assimp_material->GetTextureCount(type_assimp_pbr)     > 0 ? type_assimp_pbr       : aiTextureType_NONE;
             type_assimp                 = assimp_material->GetTextureCount(type_assimp_legacy)  > 0 ? type_assimp_legacy    : type_assimp;
@@ -442,34 +754,29 @@ namespace Spartan
                     const auto deduced_path = AssimpHelper::texture_validate_path(texture_path.data, params.file_path);
                     if (FileSystem::IsSupportedImageFile(deduced_path))
                     {
-                        params.model->AddTexture(material, type_spartan, AssimpHelper::texture_validate_path(texture_path.data, params.file_path));
+                        // The texture is decoded later on (in parallel), for now just note which slot it goes to
+                        auto it = params.texture_indices.find(deduced_path);
+                        if (it == params.texture_indices.end())
+                        {
+                            ModelTexture texture;
+                            texture.file_path   = deduced_path;
+                            texture.texture     = m_context->GetSubsystem<ResourceCache>()->GetByName<RHI_Texture2D>(FileSystem::GetFileNameNoExtensionFromFilePath(deduced_path));
+                            texture.content     = Material::GetTextureContent(type_spartan);
+                            params.textures.emplace_back(texture);
 
-                        if (type_assimp == aiTextureType_BASE_COLOR || type_assimp == aiTextureType_DIFFUSE)
+                            it = params.texture_indices.emplace(deduced_path, static_cast<uint32_t>(params.textures.size() - 1)).first;
+                        }
+                        else if (params.textures[it->second].content != Material::GetTextureContent(type_spartan))
                         {
-                            // FIX: materials that have a diffuse texture should not be tinted black/gray
-                            material->SetColorAlbedo(Vector4::One);
+                            // Used for different things, so keep all of its channels
+                            params.textures[it->second].content = RHI_Texture_Content::Color;
                         }
+                        params.texture_slots.emplace_back(ModelTextureSlot{ material, type_spartan, it->second });
 
-                        // Some models (or Assimp) pass a normal map as a height map
-                        // auto textureType others pass a height map as a normal map, we try to fix that.
-                        if (type_spartan == Material_Normal || type_spartan == Material_Height)
+                        if (type_assimp == aiTextureType_BASE_COLOR || type_assimp == aiTextureType_DIFFUSE)
                         {
-                            if (const auto texture = material->GetTexture_PtrShared(type_spartan))
-                            {
-                                auto proper_type = type_spartan;
-                                proper_type = (proper_type == Material_Normal && texture->GetGrayscale()) ? Material_Height : proper_type;
-                                proper_type = (proper_type == Material_Height && !texture->GetGrayscale()) ? Material_Normal : proper_type;
-
-                                if (proper_type != type_spartan)
-                                {
-                                    material->SetTextureSlot(type_spartan, shared_ptr<RHI_Texture>());
-                                    material->SetTextureSlot(proper_type, texture);
-                                }
-                            }
-                            else
-                            {
-                                LOG_ERROR("Failed to get texture");
-                            }
+                            // FIX: materials that have a diffuse texture should not be tinted black/gray
+                            material->SetColorAlbedo(Vector4::One);
                         }
                     }
                 }
@@ -489,4 +796,37 @@ namespace Spartan
 
         return material;
     }
+
+    void ModelImporter::LoadTexture(ModelTexture* texture) const
+    {
+        // Already cached by an earlier import
+        if (!texture || texture->texture)
+            return;
+
+        const bool generate_mipmaps = true;
+        shared_ptr<RHI_Texture2D> texture_loaded = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+        texture_loaded->SetContent(texture->content);
+        if (texture_loaded->LoadFromFile(texture->file_path))
+        {
+            texture->texture = texture_loaded;
+        }
+        else
+        {
+            LOG_ERROR("Failed to load \"%s\"", texture->file_path.c_str());
+        }
+    }
+
+    void ModelImporter::LoadTextureSlot(const ModelTextureSlot& slot, const ModelParams& params) const
+    {
+        const shared_ptr<RHI_Texture2D>& texture = params.textures[slot.texture_index].texture;
+        if (!texture)
+            return;
+
+        // Some models (or Assimp) pass a normal map as a height map, others pass a height map as a normal map, we try to fix that.
+        Material_Property type = slot.type;
+        type = (type == Material_Normal && texture->GetGrayscale())  ? Material_Height : type;
+        type = (type == Material_Height && !texture->GetGrayscale()) ? Material_Normal : type;
+
+        slot.material->SetTextureSlot(type, texture);
+    }
 }
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==============================
 #include <memory>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "../../Core/Spartan_Definitions.h"
 //=========================================
 
@@ -39,6 +41,10 @@ namespace Spartan
     class Entity;
     class Model;
     class World;
+    struct ModelMesh;
+    struct ModelTexture;
+    struct ModelTextureSlot;
+    struct AnimationBone;
 
     struct ModelParams
     {
@@ -51,6 +57,19 @@ namespace Spartan
         bool has_animation;
         Model* model            = nullptr;
         const aiScene* scene    = nullptr;
+
+        // Converted in parallel before any entities get created, indexed like the scene's meshes and materials
+        std::vector<ModelMesh> meshes;
+        std::vector<std::shared_ptr<Material>> materials;
+
+        // The skeleton, which the meshes' bone weights index into
+        std::vector<AnimationBone> bones;
+        std::unordered_map<std::string, uint32_t> bone_indices;
+
+        // Every texture file is decoded once, the slots remember which material property it goes to
+        std::vector<ModelTexture> textures;
+        std::vector<ModelTextureSlot> texture_slots;
+        std::unordered_map<std::string, uint32_t> texture_indices;
     };
 
     class SPARTAN_CLASS ModelImporter
@@ -61,16 +80,34 @@ namespace Spartan
 
         bool Load(Model* model, const std::string& file_path);
 
+        // Models imported while this is enabled store their vertices in a compressed format on the gpu (see RHI_Vertex_PosTexNorTanPacked)
+        void SetVertexCompression(const bool vertex_compression)    { m_vertex_compression = vertex_compression; }
+        bool GetVertexCompression()                           const { return m_vertex_compression; }
+
+        // The number of levels of detail generated for each mesh (including the full detail one), every level has half the triangles of the previous one
+        void SetLodCount(const uint32_t lod_count)                  { m_lod_count = lod_count; }
+        uint32_t GetLodCount()                                const { return m_lod_count; }
+
     private:
         // Parsing
-        void ParseNode(const aiNode* assimp_node, const ModelParams& params, Entity* parent_node = nullptr, Entity* new_entity = nullptr);
-        void ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, const ModelParams& params);
+        void ParseNode(const aiNode* assimp_node, ModelParams& params, Entity* parent_node = nullptr, Entity* new_entity = nullptr);
+        void ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, ModelParams& params);
+        void ParseSkeleton(ModelParams& params) const;
         void ParseAnimations(const ModelParams& params);
 
-        // Loading
-        void LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params);
-        void LoadBones(const aiMesh* assimp_mesh, const ModelParams& params);
-        std::shared_ptr<Material> LoadMaterial(aiMaterial* assimp_material, const ModelParams& params);
+        // Loading (LoadMesh() and LoadTexture() are safe to call from any thread)
+        void LoadMesh(const aiMesh* assimp_mesh, const ModelParams& params, ModelMesh* mesh) const;
+        void LoadBones(const aiMesh* assimp_mesh, const ModelParams& params, ModelMesh* mesh) const;
+        std::shared_ptr<Material> LoadMaterial(aiMaterial* assimp_material, ModelParams& params);
+        void LoadTexture(ModelTexture* texture) const;
+        void LoadTextureSlot(const ModelTextureSlot& slot, const ModelParams& params) const;
+
+        // Creation of the entities' components, from what was loaded
+        void AddMesh(uint32_t mesh_index, Entity* entity_parent, ModelParams& params);
+
+        // Options
+        bool m_vertex_compression = false;
+        uint32_t m_lod_count      = 4;
 
         // Dependencies
         Context* m_context;
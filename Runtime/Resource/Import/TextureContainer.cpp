@@ -0,0 +1,399 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ================
+#include "Spartan.h"
+#include "TextureContainer.h"
+#define FREEIMAGE_LIB
+#include <FreeImage.h>
+//===========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::TextureContainer
+{
+    struct FormatInfo
+    {
+        uint32_t id;                // a DXGI_FORMAT for DDS, a VkFormat for KTX2
+        RHI_Format format;
+        uint32_t bits_per_channel;
+        uint32_t channel_count;
+    };
+
+    // sRGB formats are read as UNORM, the shaders convert colors to linear themselves
+    static const FormatInfo formats_dxgi[] =
+    {
+        { 2,  RHI_Format_R32G32B32A32_Float,    32, 4 },
+        { 6,  RHI_Format_R32G32B32_Float,       32, 3 },
+        { 10, RHI_Format_R16G16B16A16_Float,    16, 4 },
+        { 11, RHI_Format_R16G16B16A16_Unorm,    16, 4 },
+        { 13, RHI_Format_R16G16B16A16_Snorm,    16, 4 },
+        { 16, RHI_Format_R32G32_Float,          32, 2 },
+        { 24, RHI_Format_R10G10B10A2_Unorm,     8,  4 },
+        { 28, RHI_Format_R8G8B8A8_Unorm,        8,  4 },
+        { 29, RHI_Format_R8G8B8A8_Unorm,        8,  4 },
+        { 34, RHI_Format_R16G16_Float,          16, 2 },
+        { 41, RHI_Format_R32_Float,             32, 1 },
+        { 42, RHI_Format_R32_Uint,              32, 1 },
+        { 49, RHI_Format_R8G8_Unorm,            8,  2 },
+        { 54, RHI_Format_R16_Float,             16, 1 },
+        { 57, RHI_Format_R16_Uint,              16, 1 },
+        { 61, RHI_Format_R8_Unorm,              8,  1 },
+        { 67, RHI_Format_R9G9B9E5_Float,        8,  4 },
+        { 71, RHI_Format_BC1_Unorm,             8,  4 },
+        { 72, RHI_Format_BC1_Unorm,             8,  4 },
+        { 77, RHI_Format_BC3_Unorm,             8,  4 },
+        { 78, RHI_Format_BC3_Unorm,             8,  4 },
+        { 80, RHI_Format_BC4_Unorm,             8,  1 },
+        { 83, RHI_Format_BC5_Unorm,             8,  2 },
+        { 98, RHI_Format_BC7_Unorm,             8,  4 },
+        { 99, RHI_Format_BC7_Unorm,             8,  4 }
+    };
+
+    static const FormatInfo formats_vk[] =
+    {
+        { 9,   RHI_Format_R8_Unorm,             8,  1 },
+        { 16,  RHI_Format_R8G8_Unorm,           8,  2 },
+        { 37,  RHI_Format_R8G8B8A8_Unorm,       8,  4 },
+        { 43,  RHI_Format_R8G8B8A8_Unorm,       8,  4 },
+        { 64,  RHI_Format_R10G10B10A2_Unorm,    8,  4 },
+        { 74,  RHI_Format_R16_Uint,             16, 1 },
+        { 76,  RHI_Format_R16_Float,            16, 1 },
+        { 83,  RHI_Format_R16G16_Float,         16, 2 },
+        { 91,  RHI_Format_R16G16B16A16_Unorm,   16, 4 },
+        { 92,  RHI_Format_R16G16B16A16_Snorm,   16, 4 },
+        { 97,  RHI_Format_R16G16B16A16_Float,   16, 4 },
+        { 98,  RHI_Format_R32_Uint,             32, 1 },
+        { 100, RHI_Format_R32_Float,            32, 1 },
+        { 103, RHI_Format_R32G32_Float,         32, 2 },
+        { 106, RHI_Format_R32G32B32_Float,      32, 3 },
+        { 109, RHI_Format_R32G32B32A32_Float,   32, 4 },
+        { 123, RHI_Format_R9G9B9E5_Float,       8,  4 },
+        { 131, RHI_Format_BC1_Unorm,            8,  4 },
+        { 132, RHI_Format_BC1_Unorm,            8,  4 },
+        { 133, RHI_Format_BC1_Unorm,            8,  4 },
+        { 134, RHI_Format_BC1_Unorm,            8,  4 },
+        { 137, RHI_Format_BC3_Unorm,            8,  4 },
+        { 138, RHI_Format_BC3_Unorm,            8,  4 },
+        { 139, RHI_Format_BC4_Unorm,            8,  1 },
+        { 141, RHI_Format_BC5_Unorm,            8,  2 },
+        { 145, RHI_Format_BC7_Unorm,            8,  4 },
+        { 146, RHI_Format_BC7_Unorm,            8,  4 }
+    };
+
+    // DDS
+    static const uint32_t dds_magic                 = 0x20534444; // "DDS "
+    static const uint32_t dds_header_size           = 124;
+    static const uint32_t dds_header_dx10_size      = 20;
+    static const uint32_t dds_flag_mip_count        = 0x20000;
+    static const uint32_t dds_pixel_alpha           = 0x1;
+    static const uint32_t dds_pixel_fourcc          = 0x4;
+    static const uint32_t dds_pixel_rgb             = 0x40;
+    static const uint32_t dds_pixel_luminance       = 0x20000;
+    static const uint32_t dds_caps2_cubemap         = 0x200;
+    static const uint32_t dds_caps2_volume          = 0x200000;
+    static const uint32_t dds_dimension_texture2d   = 3;
+    static const uint32_t dds_misc_texture_cube     = 0x4;
+    static const uint32_t dds_alpha_mode_opaque     = 3;
+
+    // KTX2
+    static const uint8_t ktx2_identifier[12]        = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    static const uint64_t ktx2_header_size          = 80;
+    static const uint64_t ktx2_level_size           = 24;
+
+    static constexpr uint32_t fourcc(const char a, const char b, const char c, const char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    template <typename T>
+    static T read(const std::byte* data, const uint64_t offset)
+    {
+        T value;
+        memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    static bool set_format(const FormatInfo* formats, const size_t format_count, const uint32_t id, Description* description)
+    {
+        for (size_t i = 0; i < format_count; i++)
+        {
+            if (formats[i].id == id)
+            {
+                description->format             = formats[i].format;
+                description->bits_per_channel   = formats[i].bits_per_channel;
+                description->channel_count      = formats[i].channel_count;
+                return true;
+            }
+        }
+
+        LOG_ERROR("Unsupported format (%d)", id);
+        return false;
+    }
+
+    static uint64_t get_level_size(const Description& description, const uint32_t level_index)
+    {
+        const uint32_t width    = max(description.width >> level_index, 1u);
+        const uint32_t height   = max(description.height >> level_index, 1u);
+        return rhi_format_mip_size(description.format, width, height, (description.bits_per_channel / 8) * description.channel_count);
+    }
+
+    static bool parse_dds(const std::byte* data, const uint64_t size, Description* description)
+    {
+        if (size < sizeof(uint32_t) + dds_header_size || read<uint32_t>(data, 4) != dds_header_size)
+        {
+            LOG_ERROR("Invalid DDS header");
+            return false;
+        }
+
+        // DDS_HEADER, after the magic
+        const uint32_t flags            = read<uint32_t>(data, 8);
+        const uint32_t height           = read<uint32_t>(data, 12);
+        const uint32_t width            = read<uint32_t>(data, 16);
+        const uint32_t depth            = read<uint32_t>(data, 24);
+        const uint32_t mip_count        = read<uint32_t>(data, 28);
+        const uint32_t pixel_flags      = read<uint32_t>(data, 80);
+        const uint32_t pixel_fourcc     = read<uint32_t>(data, 84);
+        const uint32_t pixel_bit_count  = read<uint32_t>(data, 88);
+        const uint32_t mask_r           = read<uint32_t>(data, 92);
+        const uint32_t mask_g           = read<uint32_t>(data, 96);
+        const uint32_t mask_b           = read<uint32_t>(data, 100);
+        const uint32_t mask_a           = read<uint32_t>(data, 104);
+        const uint32_t caps2            = read<uint32_t>(data, 112);
+        uint64_t offset                 = sizeof(uint32_t) + dds_header_size;
+
+        if ((caps2 & (dds_caps2_cubemap | dds_caps2_volume)) || depth > 1)
+        {
+            LOG_ERROR("Only 2D textures are supported");
+            return false;
+        }
+
+        description->width  = width;
+        description->height = height;
+
+        if ((pixel_flags & dds_pixel_fourcc) && pixel_fourcc == fourcc('D', 'X', '1', '0'))
+        {
+            if (size < offset + dds_header_dx10_size)
+            {
+                LOG_ERROR("Invalid DDS header");
+                return false;
+            }
+
+            const uint32_t dxgi_format  = read<uint32_t>(data, offset);
+            const uint32_t dimension    = read<uint32_t>(data, offset + 4);
+            const uint32_t misc_flags   = read<uint32_t>(data, offset + 8);
+            const uint32_t array_size   = read<uint32_t>(data, offset + 12);
+            const uint32_t alpha_mode   = read<uint32_t>(data, offset + 16) & 0x7;
+            offset += dds_header_dx10_size;
+
+            if (dimension != dds_dimension_texture2d || (misc_flags & dds_misc_texture_cube) || array_size > 1)
+            {
+                LOG_ERROR("Only 2D textures are supported");
+                return false;
+            }
+
+            if (!set_format(formats_dxgi, std::size(formats_dxgi), dxgi_format, description))
+                return false;
+
+            // BC7 and RGBA can be opaque as well, only BC3 (or an explicit alpha mode) says that the alpha is used
+            description->is_transparent = alpha_mode != dds_alpha_mode_opaque && (alpha_mode != 0 || description->format == RHI_Format_BC3_Unorm);
+        }
+        else if (pixel_flags & dds_pixel_fourcc)
+        {
+            switch (pixel_fourcc)
+            {
+                case fourcc('D', 'X', 'T', '1'): set_format(formats_dxgi, std::size(formats_dxgi), 71, description); break;
+                case fourcc('D', 'X', 'T', '5'): set_format(formats_dxgi, std::size(formats_dxgi), 77, description); break;
+                case fourcc('A', 'T', 'I', '1'):
+                case fourcc('B', 'C', '4', 'U'): set_format(formats_dxgi, std::size(formats_dxgi), 80, description); break;
+                case fourcc('A', 'T', 'I', '2'):
+                case fourcc('B', 'C', '5', 'U'): set_format(formats_dxgi, std::size(formats_dxgi), 83, description); break;
+                case 36:                         set_format(formats_dxgi, std::size(formats_dxgi), 11, description); break; // D3DFMT_A16B16G16R16
+                case 111:                        set_format(formats_dxgi, std::size(formats_dxgi), 54, description); break; // D3DFMT_R16F
+                case 112:                        set_format(formats_dxgi, std::size(formats_dxgi), 34, description); break; // D3DFMT_G16R16F
+                case 113:                        set_format(formats_dxgi, std::size(formats_dxgi), 10, description); break; // D3DFMT_A16B16G16R16F
+                case 114:                        set_format(formats_dxgi, std::size(formats_dxgi), 41, description); break; // D3DFMT_R32F
+                case 115:                        set_format(formats_dxgi, std::size(formats_dxgi), 16, description); break; // D3DFMT_G32R32F
+                case 116:                        set_format(formats_dxgi, std::size(formats_dxgi), 2,  description); break; // D3DFMT_A32B32G32R32F
+                default: break;
+            }
+
+            description->is_transparent = description->format == RHI_Format_BC3_Unorm;
+        }
+        // Uncompressed layouts, only the ones which need no swizzling
+        else if ((pixel_flags & dds_pixel_rgb) && pixel_bit_count == 32 && mask_r == 0x000000ff && mask_g == 0x0000ff00 && mask_b == 0x00ff0000)
+        {
+            set_format(formats_dxgi, std::size(formats_dxgi), 28, description);
+            description->is_transparent = (pixel_flags & dds_pixel_alpha) && mask_a == 0xff000000;
+        }
+        else if ((pixel_flags & (dds_pixel_rgb | dds_pixel_luminance)) && pixel_bit_count == 8 && mask_r == 0xff)
+        {
+            set_format(formats_dxgi, std::size(formats_dxgi), 61, description);
+        }
+
+        if (description->format == RHI_Format_Undefined)
+        {
+            LOG_ERROR("Unsupported DDS pixel format");
+            return false;
+        }
+
+        // The levels follow the headers, one after the other
+        const uint32_t level_count = (flags & dds_flag_mip_count) ? max(mip_count, 1u) : 1;
+        for (uint32_t level_index = 0; level_index < level_count; level_index++)
+        {
+            const uint64_t level_size = get_level_size(*description, level_index);
+            if (offset + level_size > size)
+            {
+                LOG_ERROR("The DDS file is truncated");
+                return false;
+            }
+
+            description->levels.push_back({ data + offset, level_size, level_size });
+            offset += level_size;
+        }
+
+        return true;
+    }
+
+    static bool parse_ktx2(const std::byte* data, const uint64_t size, Description* description)
+    {
+        if (size < ktx2_header_size)
+        {
+            LOG_ERROR("Invalid KTX2 header");
+            return false;
+        }
+
+        const uint32_t vk_format            = read<uint32_t>(data, 12);
+        const uint32_t width                = read<uint32_t>(data, 20);
+        const uint32_t height               = read<uint32_t>(data, 24);
+        const uint32_t depth                = read<uint32_t>(data, 28);
+        const uint32_t layer_count          = read<uint32_t>(data, 32);
+        const uint32_t face_count           = read<uint32_t>(data, 36);
+        const uint32_t level_count          = max(read<uint32_t>(data, 40), 1u);
+        const uint32_t supercompression     = read<uint32_t>(data, 44);
+
+        if (depth > 1 || layer_count > 1 || face_count != 1 || height == 0)
+        {
+            LOG_ERROR("Only 2D textures are supported");
+            return false;
+        }
+
+        switch (supercompression)
+        {
+            case 0: description->supercompression = Supercompression::None;         break;
+            case 1: description->supercompression = Supercompression::BasisLZ;      break;
+            case 2: description->supercompression = Supercompression::Zstandard;    break;
+            case 3: description->supercompression = Supercompression::Zlib;         break;
+            default: LOG_ERROR("Unknown supercompression scheme (%d)", supercompression); return false;
+        }
+
+        if (description->supercompression == Supercompression::BasisLZ || description->supercompression == Supercompression::Zstandard || vk_format == 0)
+        {
+            LOG_ERROR("Basis and Zstandard supercompressed files are not supported, they have to be converted to a block compressed format (zlib supercompression is fine)");
+            return false;
+        }
+
+        if (!set_format(formats_vk, std::size(formats_vk), vk_format, description))
+            return false;
+
+        description->width          = width;
+        description->height         = height;
+        description->is_transparent = description->format == RHI_Format_BC3_Unorm;
+
+        // The level index follows the header, it points to every level in the file
+        if (size < ktx2_header_size + ktx2_level_size * level_count)
+        {
+            LOG_ERROR("Invalid KTX2 level index");
+            return false;
+        }
+
+        for (uint32_t level_index = 0; level_index < level_count; level_index++)
+        {
+            const uint64_t entry                = ktx2_header_size + ktx2_level_size * level_index;
+            const uint64_t level_offset         = read<uint64_t>(data, entry);
+            const uint64_t level_size           = read<uint64_t>(data, entry + 8);
+            const uint64_t level_size_expected  = get_level_size(*description, level_index);
+            const uint64_t level_size_stored    = description->supercompression == Supercompression::None ? level_size : read<uint64_t>(data, entry + 16);
+
+            if (level_offset > size || level_size > size - level_offset || level_size_stored != level_size_expected)
+            {
+                LOG_ERROR("Invalid KTX2 level %d", level_index);
+                return false;
+            }
+
+            description->levels.push_back({ data + level_offset, level_size, level_size_expected });
+        }
+
+        return true;
+    }
+
+    bool is_container(const string& file_path)
+    {
+        const string extension = FileSystem::GetExtensionFromFilePath(file_path);
+        return extension == ".dds" || extension == ".DDS" || extension == ".ktx2" || extension == ".KTX2";
+    }
+
+    bool parse(const std::byte* data, const uint64_t size, Description* description)
+    {
+        if (!data || !description)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        *description = Description();
+
+        if (size >= sizeof(ktx2_identifier) && memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0)
+            return parse_ktx2(data, size, description);
+
+        if (size >= sizeof(uint32_t) && read<uint32_t>(data, 0) == dds_magic)
+            return parse_dds(data, size, description);
+
+        LOG_ERROR("Not a DDS or a KTX2 file");
+        return false;
+    }
+
+    bool unpack(const Supercompression supercompression, const Level& level, std::byte* destination)
+    {
+        if (supercompression == Supercompression::None)
+        {
+            memcpy(destination, level.data, level.size);
+            return true;
+        }
+
+        if (supercompression == Supercompression::Zlib)
+        {
+            const DWORD size = FreeImage_ZLibUncompress
+            (
+                reinterpret_cast<BYTE*>(destination),
+                static_cast<DWORD>(level.size_uncompressed),
+                reinterpret_cast<BYTE*>(const_cast<std::byte*>(level.data)),
+                static_cast<DWORD>(level.size)
+            );
+
+            return size == level.size_uncompressed;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ========================
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "../../RHI/RHI_Definition.h"
+//===================================
+
+namespace Spartan
+{
+    // Reads DDS and KTX2 files, which hold textures that are already in a gpu format (usually block compressed) and have their mips baked in.
+    // Nothing is decoded, a file is parsed where it's mapped and its levels go to the texture as they are. KTX2 files can be supercompressed,
+    // every level is compressed on its own, so they can be inflated in parallel. Only zlib is supported, as there is no Zstandard or Basis decoder.
+    namespace TextureContainer
+    {
+        enum class Supercompression
+        {
+            None,
+            BasisLZ,
+            Zstandard,
+            Zlib
+        };
+
+        struct Level
+        {
+            const std::byte* data       = nullptr;  // in the file
+            uint64_t size               = 0;        // in the file
+            uint64_t size_uncompressed  = 0;        // once inflated, the same as size if the file isn't supercompressed
+        };
+
+        struct Description
+        {
+            RHI_Format format                   = RHI_Format_Undefined;
+            uint32_t width                      = 0;
+            uint32_t height                     = 0;
+            uint32_t bits_per_channel           = 0;
+            uint32_t channel_count              = 0;
+            bool is_transparent                 = false;
+            Supercompression supercompression   = Supercompression::None;
+            std::vector<Level> levels;                  // the largest one first
+        };
+
+        // True if the file is a DDS or a KTX2 file (by its extension)
+        bool is_container(const std::string& file_path);
+
+        // Parses the file and validates that it holds a single 2D texture, in a format that the engine supports
+        bool parse(const std::byte* data, uint64_t size, Description* description);
+
+        // Copies a level to its destination (size_uncompressed bytes), inflating it if the file is supercompressed
+        bool unpack(Supercompression supercompression, const Level& level, std::byte* destination);
+    }
+}
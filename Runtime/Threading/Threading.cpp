@@ -99,6 +99,63 @@ namespace Spartan
         }
     }
 
+    void Threading::ParallelFor(const uint32_t count, const std::function<void(uint32_t)>& function, const std::function<void()>& function_caller /*= nullptr*/)
+    {
+        if (count == 0)
+        {
+            if (function_caller)
+            {
+                function_caller();
+            }
+
+            return;
+        }
+
+        // Shared with the tasks, as a task might only get a thread after all the work is done and this function has returned
+        struct Loop
+        {
+            std::function<void(uint32_t)> function;
+            uint32_t count              = 0;
+            atomic<uint32_t> next       = { 0 };
+            atomic<uint32_t> done       = { 0 };
+        };
+
+        shared_ptr<Loop> loop   = make_shared<Loop>();
+        loop->function          = function;
+        loop->count             = count;
+
+        const auto work = [loop]()
+        {
+            for (uint32_t i = loop->next++; i < loop->count; i = loop->next++)
+            {
+                loop->function(i);
+                loop->done++;
+            }
+        };
+
+        // The calling thread takes one of the calls, unless it's busy with its own work first
+        if (!m_threads.empty())
+        {
+            const uint32_t task_count = min(m_thread_count, function_caller ? count : count - 1);
+            for (uint32_t i = 0; i < task_count; i++)
+            {
+                AddTask(work);
+            }
+        }
+
+        if (function_caller)
+        {
+            function_caller();
+        }
+
+        work();
+
+        while (loop->done != count)
+        {
+            this_thread::yield();
+        }
+    }
+
     void Threading::ThreadLoop()
     {
         shared_ptr<Task> task;
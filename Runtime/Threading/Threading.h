@@ -112,6 +112,11 @@ namespace Spartan
             }
         }
 
+        // Calls function(i) for every i in [0, count) across the threads and returns once all calls are done. The calling thread takes part
+        // as well, so unlike waiting on AddTask(), this can't stall when all the threads are busy (e.g. the caller is a task itself).
+        // If function_caller is given, the calling thread runs it first (e.g. work that has to stay on the main thread) and then joins in.
+        void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& function, const std::function<void()>& function_caller = nullptr);
+
         // Get the number of threads used
         uint32_t GetThreadCount()           const { return m_thread_count; }
         // Get the maximum number of threads the hardware supports
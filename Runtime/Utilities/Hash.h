@@ -29,4 +29,16 @@ namespace Spartan::Utility::Hash
         std::hash<T> hasher;
         seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
+
+    // 64 bit FNV-1a, for keying data that was derived from a file by the file's contents
+    inline uint64_t hash_fnv1a(const std::byte* data, const uint64_t size)
+    {
+        uint64_t hash = 0xcbf29ce484222325;
+        for (uint64_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<uint64_t>(data[i]);
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
 }
@@ -0,0 +1,354 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================================
+#include "Spartan.h"
+#include "Animator.h"
+#include "Renderable.h"
+#include "Transform.h"
+#include "../Entity.h"
+#include "../World.h"
+#include "../../IO/FileStream.h"
+#include "../../Rendering/Model.h"
+#include "../../Rendering/Renderer.h"
+#include "../../Rendering/Skinning.h"
+#include "../../Rendering/GeometryAllocator.h"
+#include "../../Resource/ResourceCache.h"
+#include "../../RHI/RHI_Vertex.h"
+//============================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    static float time_advance(const Animation* animation, const float time, const float delta_time, const bool looping)
+    {
+        const float duration = animation->GetDuration();
+        if (duration <= 0.0f)
+            return 0.0f;
+
+        const float time_new = time + delta_time;
+        return looping ? fmod(fmod(time_new, duration) + duration, duration) : Helper::Clamp(time_new, 0.0f, duration);
+    }
+
+    Animator::Animator(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+    {
+
+    }
+
+    Animator::~Animator()
+    {
+        // The renderables might be gone already, only the geometry is released
+        SkinsDestroy(false);
+    }
+
+    void Animator::OnRemove()
+    {
+        SkinsDestroy(true);
+    }
+
+    void Animator::OnTick(const float delta_time)
+    {
+        // Animations only play in game mode, the editor shows the pose at the current time
+        if (!m_context->m_engine->EngineMode_IsSet(Engine_Game))
+            return;
+
+        if (!m_model || m_animation < 0)
+            return;
+
+        const vector<shared_ptr<Animation>>& animations = m_model->GetAnimations();
+        m_time = time_advance(animations[m_animation].get(), m_time, delta_time * m_speed, m_looping);
+
+        // The previous animation keeps playing while it fades out
+        if (m_animation_previous >= 0)
+        {
+            m_time_previous = time_advance(animations[m_animation_previous].get(), m_time_previous, delta_time * m_speed, m_looping);
+            m_blend_time    += delta_time;
+            if (m_blend_time >= m_blend_duration)
+            {
+                m_animation_previous = -1;
+            }
+        }
+    }
+
+    void Animator::Serialize(FileStream* stream)
+    {
+        stream->Write(m_model ? m_model->GetResourceName() : "");
+        stream->Write(m_animation);
+        stream->Write(m_time);
+        stream->Write(m_speed);
+        stream->Write(m_looping);
+    }
+
+    void Animator::Deserialize(FileStream* stream)
+    {
+        string model_name;
+        stream->Read(&model_name);
+        SetModel(m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(model_name).get());
+
+        const int32_t animation = stream->ReadAs<int>();
+        stream->Read(&m_time);
+        stream->Read(&m_speed);
+        stream->Read(&m_looping);
+
+        m_animation = m_model && animation < static_cast<int32_t>(m_model->GetAnimations().size()) ? animation : -1;
+    }
+
+    void Animator::SetModel(Model* model)
+    {
+        if (model == m_model)
+            return;
+
+        SkinsDestroy(true);
+
+        m_model                 = model;
+        m_animation             = m_model && !m_model->GetAnimations().empty() ? 0 : -1;
+        m_animation_previous    = -1;
+        m_time                  = 0.0f;
+        m_skins_dirty           = true;
+    }
+
+    bool Animator::Play(const uint32_t animation_index, const float blend_duration)
+    {
+        if (!m_model || animation_index >= m_model->GetAnimations().size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        if (static_cast<int32_t>(animation_index) == m_animation)
+            return true;
+
+        // Fade out of what is playing now, unless there is nothing to fade from
+        m_animation_previous    = blend_duration > 0.0f ? m_animation : -1;
+        m_time_previous         = m_time;
+        m_blend_time            = 0.0f;
+        m_blend_duration        = blend_duration;
+        m_animation             = static_cast<int32_t>(animation_index);
+        m_time                  = 0.0f;
+
+        return true;
+    }
+
+    bool Animator::Play(const string& animation_name, const float blend_duration)
+    {
+        if (m_model)
+        {
+            const vector<shared_ptr<Animation>>& animations = m_model->GetAnimations();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(animations.size()); i++)
+            {
+                if (animations[i]->GetName() == animation_name)
+                    return Play(i, blend_duration);
+            }
+        }
+
+        LOG_ERROR("There is no animation named \"%s\"", animation_name.c_str());
+        return false;
+    }
+
+    void Animator::Stop()
+    {
+        m_animation             = -1;
+        m_animation_previous    = -1;
+        m_time                  = 0.0f;
+    }
+
+    void Animator::Animate(const uint64_t frame)
+    {
+        if (!m_model || m_model->GetBones().empty())
+            return;
+
+        shared_ptr<GeometryAllocator> geometry_allocator = m_context->GetSubsystem<Renderer>()->GetGeometryAllocator();
+        if (!geometry_allocator)
+            return;
+
+        if (m_skins_dirty)
+        {
+            SkinsCreate();
+        }
+
+        if (m_skins.empty())
+            return;
+
+        // Scratch memory, reused by the animators that run on the same thread
+        thread_local vector<BoneTransform> pose;
+        thread_local vector<BoneTransform> pose_previous;
+        thread_local vector<Matrix> bone_matrices;
+        thread_local vector<Matrix> palette;
+        thread_local vector<RHI_Vertex_PosTexNorTan> vertices;
+
+        // Sample the pose, the bones which aren't animated keep their rest transform
+        const vector<AnimationBone>& bones                  = m_model->GetBones();
+        const vector<shared_ptr<Animation>>& animations     = m_model->GetAnimations();
+        const uint32_t bone_count                           = static_cast<uint32_t>(bones.size());
+        pose.resize(bone_count);
+        for (uint32_t i = 0; i < bone_count; i++)
+        {
+            pose[i] = bones[i].rest;
+        }
+
+        if (m_animation >= 0)
+        {
+            animations[m_animation]->Sample(m_time, pose.data(), bone_count);
+        }
+
+        if (m_animation_previous >= 0 && m_blend_duration > 0.0f)
+        {
+            pose_previous.resize(bone_count);
+            for (uint32_t i = 0; i < bone_count; i++)
+            {
+                pose_previous[i] = bones[i].rest;
+            }
+            animations[m_animation_previous]->Sample(m_time_previous, pose_previous.data(), bone_count);
+
+            Skinning::blend(pose_previous.data(), pose.data(), Helper::Saturate(m_blend_time / m_blend_duration), bone_count, pose.data());
+        }
+
+        bone_matrices.resize(bone_count);
+        palette.resize(bone_count + 1);
+        Skinning::compute_bone_matrices(bones.data(), bone_count, pose.data(), bone_matrices.data());
+
+        // Skin every renderable into the range of this frame, the ranges of the previous frames might still be in use by the gpu
+        World* world                            = m_context->GetSubsystem<World>();
+        const Matrix& root                      = GetTransform()->GetMatrix();
+        const uint32_t frame_index              = static_cast<uint32_t>(frame % GeometryAllocator::frames_in_flight);
+        const vector<BoneWeights>& bone_weights = m_model->GetBoneWeights();
+        const byte* vertex_data                 = m_model->GetVertexData();
+        for (const AnimatorSkin& skin : m_skins)
+        {
+            Entity* entity          = world->EntityGet(skin.entity);
+            Renderable* renderable  = entity ? entity->GetRenderable() : nullptr;
+            if (!renderable || renderable->GeometryModel() != m_model)
+            {
+                m_skins_dirty = true;
+                continue;
+            }
+
+            // The palette goes from the mesh's space to the root's (where the skeleton is) and back
+            const Matrix mesh_inverse = root * entity->GetTransform()->GetMatrix().Inverted();
+            Skinning::compute_palette(bones.data(), bone_count, bone_matrices.data(), mesh_inverse, palette.data());
+
+            const uint32_t vertex_offset = renderable->GeometryVertexOffset();
+            const uint32_t vertex_count  = renderable->GeometryVertexCount();
+            vertices.resize(vertex_count);
+            BoundingBox aabb;
+            Skinning::skin(vertex_data + static_cast<uint64_t>(vertex_offset) * sizeof(RHI_Vertex_PosTexNorTan), &bone_weights[vertex_offset], vertex_count, palette.data(), vertices.data(), &aabb);
+
+            if (!geometry_allocator->UpdateVertices(skin.allocation, frame_index * vertex_count, vertex_count, vertices.data()))
+                continue;
+
+            SubmeshPlacement placement;
+            placement.heap              = skin.allocation.heap;
+            placement.index_delta       = static_cast<int64_t>(skin.allocation.index_offset) - renderable->GeometryIndexOffset();
+            placement.lod_index_delta   = placement.index_delta; // unused, skinned geometry is drawn at full detail
+            placement.vertex_offset     = skin.allocation.vertex_offset + frame_index * vertex_count;
+            renderable->SkinSet(placement, aabb);
+        }
+    }
+
+    void Animator::SkinsCreate()
+    {
+        SkinsDestroy(true);
+        m_skins_dirty = false;
+
+        shared_ptr<GeometryAllocator> geometry_allocator = m_context->GetSubsystem<Renderer>()->GetGeometryAllocator();
+        if (!m_model || !geometry_allocator)
+            return;
+
+        // The vertices of submeshes without bones don't follow any of them
+        const vector<BoneWeights>& bone_weights = m_model->GetBoneWeights();
+        const uint16_t bone_none                = static_cast<uint16_t>(m_model->GetBones().size());
+
+        // Every renderable below the entity that has skinned vertices
+        vector<Transform*> transforms = { GetTransform() };
+        while (!transforms.empty())
+        {
+            Transform* transform = transforms.back();
+            transforms.pop_back();
+            transforms.insert(transforms.end(), transform->GetChildren().begin(), transform->GetChildren().end());
+
+            Entity* entity          = transform->GetEntity();
+            Renderable* renderable  = entity->GetRenderable();
+            if (!renderable || renderable->GeometryModel() != m_model)
+                continue;
+
+            const uint32_t vertex_offset    = renderable->GeometryVertexOffset();
+            const uint32_t vertex_count     = renderable->GeometryVertexCount();
+            if (vertex_count == 0 || static_cast<uint64_t>(vertex_offset) + vertex_count > bone_weights.size())
+                continue;
+
+            const auto weights_begin = bone_weights.begin() + vertex_offset;
+            if (all_of(weights_begin, weights_begin + vertex_count, [bone_none](const BoneWeights& weights) { return weights.indices[0] == bone_none; }))
+                continue;
+
+            vector<uint32_t> indices;
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            m_model->GetGeometry(renderable->GeometryIndexOffset(), renderable->GeometryIndexCount(), vertex_offset, vertex_count, &indices, &vertices);
+
+            AnimatorSkin skin;
+            skin.entity = entity->GetHandle();
+            if (!geometry_allocator->Allocate(false, vertex_count * GeometryAllocator::frames_in_flight, static_cast<uint32_t>(indices.size()), &skin.allocation))
+                continue;
+
+            // Every frame's range starts out with the bind pose
+            vector<RHI_Vertex_PosTexNorTan> vertices_frames;
+            vertices_frames.reserve(static_cast<size_t>(vertex_count) * GeometryAllocator::frames_in_flight);
+            for (uint32_t i = 0; i < GeometryAllocator::frames_in_flight; i++)
+            {
+                vertices_frames.insert(vertices_frames.end(), vertices.begin(), vertices.end());
+            }
+            geometry_allocator->Update(skin.allocation, vertices_frames.data(), indices.data());
+
+            m_skins.emplace_back(skin);
+        }
+    }
+
+    void Animator::SkinsDestroy(const bool clear_renderables)
+    {
+        shared_ptr<GeometryAllocator> geometry_allocator = m_context->GetSubsystem<Renderer>() ? m_context->GetSubsystem<Renderer>()->GetGeometryAllocator() : nullptr;
+        World* world = m_context->GetSubsystem<World>();
+
+        for (const AnimatorSkin& skin : m_skins)
+        {
+            if (geometry_allocator)
+            {
+                geometry_allocator->Free(skin.allocation);
+            }
+
+            if (clear_renderables && world)
+            {
+                if (Entity* entity = world->EntityGet(skin.entity))
+                {
+                    if (Renderable* renderable = entity->GetRenderable())
+                    {
+                        renderable->SkinClear();
+                    }
+                }
+            }
+        }
+
+        m_skins.clear();
+        m_skins_dirty = true;
+    }
+}
@@ -0,0 +1,95 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ============================
+#include "IComponent.h"
+#include <vector>
+#include "../EntityHandle.h"
+#include "../../Rendering/GeometryHeap.h"
+//=======================================
+
+namespace Spartan
+{
+    class Model;
+
+    // Plays the animations of a skinned model, from the model's root entity. Ticking only advances the time, the renderer samples the poses
+    // and skins the renderables below the entity (see Animate()), for all of the animators in parallel.
+    class SPARTAN_CLASS Animator : public IComponent
+    {
+    public:
+        Animator(Context* context, Entity* entity, uint32_t id = 0);
+        ~Animator();
+
+        //= IComponent ===============================
+        void OnRemove() override;
+        void OnTick(float delta_time) override;
+        void Serialize(FileStream* stream) override;
+        void Deserialize(FileStream* stream) override;
+        //============================================
+
+        // The model whose skeleton and animations are used, it starts playing its first animation
+        void SetModel(Model* model);
+        Model* GetModel() const { return m_model; }
+
+        // Crossfades from the current animation to another one of the model, over the blend duration (in seconds)
+        bool Play(uint32_t animation_index, float blend_duration = 0.2f);
+        bool Play(const std::string& animation_name, float blend_duration = 0.2f);
+        void Stop();
+        int32_t GetAnimationIndex() const { return m_animation; }
+
+        //= PROPERTIES ============================================
+        float GetTime() const                   { return m_time; }
+        void SetTime(const float time)          { m_time = time; }
+        float GetSpeed() const                  { return m_speed; }
+        void SetSpeed(const float speed)        { m_speed = speed; }
+        bool GetLooping() const                 { return m_looping; }
+        void SetLooping(const bool looping)     { m_looping = looping; }
+        //=========================================================
+
+        // Samples the pose and skins the renderables into the frame's range of their geometry (renderer, safe to call for different animators in parallel)
+        void Animate(uint64_t frame);
+
+    private:
+        void SkinsCreate();
+        void SkinsDestroy(bool clear_renderables);
+
+        // A copy of a renderable's indices, so that they are in the same heap as its vertices, of which there is a range for every frame in flight
+        struct AnimatorSkin
+        {
+            EntityHandle entity;
+            GeometryAllocation allocation;
+        };
+
+        Model* m_model                  = nullptr;
+        int32_t m_animation             = -1;
+        int32_t m_animation_previous    = -1;
+        float m_time                    = 0.0f;
+        float m_time_previous           = 0.0f;
+        float m_blend_time              = 0.0f;
+        float m_blend_duration          = 0.0f;
+        float m_speed                   = 1.0f;
+        bool m_looping                  = true;
+        std::vector<AnimatorSkin> m_skins;
+        bool m_skins_dirty              = true;
+    };
+}
@@ -182,91 +182,8 @@ namespace Spartan
         Vector3 ray_end     = Unproject(mouse_position_relative);
         m_ray               = Ray(ray_start, ray_end);
 
-        // Traces ray against all AABBs in the world
-        vector<RayHit> hits;
-        {
-            const auto& entities = m_context->GetSubsystem<World>()->EntityGetAll();
-            for (const auto& entity : entities)
-            {
-                // Make sure there entity has a renderable
-                if (!entity->HasComponent<Renderable>())
-                    continue;
-
-                // Get object oriented bounding box
-                const BoundingBox& aabb = entity->GetComponent<Renderable>()->GetAabb();
-
-                // Compute hit distance
-                float distance = m_ray.HitDistance(aabb);
-
-                // Don't store hit data if there was no hit
-                if (distance == Helper::INFINITY_)
-                    continue;
-
-                hits.emplace_back(
-                    entity,                                             // Entity
-                    m_ray.GetStart() + distance * m_ray.GetDirection(), // Position
-                    distance,                                           // Distance
-                    distance == 0.0f                                    // Inside
-                );
-            }
-
-            // Sort by distance (ascending)
-            std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) { return a.m_distance < b.m_distance; });
-        }
-
-        // Check if there are any hits
-        if (hits.empty())
-            return false;
-
-        // If there is a single hit, return that
-        if (hits.size() == 1)
-        {
-            picked = hits.front().m_entity;
-            return true;
-        }
-
-        // Draw picking ray
-        //m_renderer->DrawDebugLine(ray_start, ray_end, Vector4(0, 1, 0, 1), Vector4(0, 1, 0, 1), 5.0f, true);
-
-        // If there are more hits, perform triangle intersection
-        float distance_min = numeric_limits<float>::max();
-        for (RayHit& hit : hits)
-        {
-            // Get entity geometry
-            Renderable* renderable = hit.m_entity->GetRenderable();
-            vector<uint32_t> indicies;
-            vector<RHI_Vertex_PosTexNorTan> vertices;
-            renderable->GeometryGet(&indicies, &vertices);
-            if (indicies.empty()|| vertices.empty())
-            {
-                LOG_ERROR("Failed to get geometry of entity %s, skipping intersection test.");
-                continue;
-            }
-
-            // Compute matrix which can transform vertices to view space
-            Matrix vertex_transform = hit.m_entity->GetTransform()->GetMatrix();
-
-            // Go through each face
-            for (uint32_t i = 0; i < indicies.size(); i += 3)
-            {
-                Vector3 p1_world = Vector3(vertices[indicies[i]].pos) * vertex_transform;
-                Vector3 p2_world = Vector3(vertices[indicies[i + 1]].pos) * vertex_transform;
-                Vector3 p3_world = Vector3(vertices[indicies[i + 2]].pos) * vertex_transform;
-
-                float distance = m_ray.HitDistance(p1_world, p2_world, p3_world);
-                
-                if (distance < distance_min)
-                {
-                    // Draw min distance triangle
-                    //m_renderer->DrawDebugTriangle(p1_world, p2_world, p3_world, Vector4(1.0f, 0.0f, 0.0f, 1.0f), 5.0f, false);
-
-                    picked = hit.m_entity;
-                    distance_min = distance;
-                }
-            }
-        }
-
-        return picked != nullptr;
+        // Bounding boxes first, then the triangles (through the bvh of each mesh)
+        return m_context->GetSubsystem<World>()->Raycast(m_ray, &picked);
     }
 
     Vector2 Camera::Project(const Vector3& position_world) const
@@ -25,10 +25,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Transform.h"
 #include "RigidBody.h"
 #include "Renderable.h"
+#include "Terrain.h"
 #include "../Entity.h"
 #include "../../IO/FileStream.h"
+#include "../../Physics/Physics.h"
+#include "../../Physics/ShapeCache.h"
 #include "../../Physics/BulletPhysicsHelper.h"
-#include "../../RHI/RHI_Vertex.h"
 //============================================
 
 //= NAMESPACES ================
@@ -38,6 +40,103 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    static const int heightfield_accelerator_chunk_size = 16; // samples per side of the height ranges that rays skip over
+
+    // A heightfield over a block of the terrain's heights, which follows edits of the heights instead of being created again
+    ATTRIBUTE_ALIGNED16(class) HeightfieldShape : public btHeightfieldTerrainShape
+    {
+    public:
+        HeightfieldShape(const TerrainHeightBlock& block, const float height_min, const float height_max)
+            : btHeightfieldTerrainShape(block.width, block.height, block.heights, 1.0f, height_min, height_max, 1, PHY_FLOAT, false), m_block(block)
+        {
+            // The quads are split from their bottom right to their top left corner, like the chunks of the terrain
+            buildAccelerator(heightfield_accelerator_chunk_size);
+        }
+
+        // The rectangle is in samples of the block, its end is exclusive
+        void UpdateHeights(const int x_begin, const int y_begin, const int x_end, const int y_end)
+        {
+            // The range only grows, so that an edit doesn't have to go through the whole block
+            for (int y = y_begin; y < y_end; y++)
+            {
+                for (int x = x_begin; x < x_end; x++)
+                {
+                    const btScalar height = getRawHeightFieldValue(x, y);
+                    m_minHeight = btMin(m_minHeight, height);
+                    m_maxHeight = btMax(m_maxHeight, height);
+                }
+            }
+
+            // The shape is centered on its bounding box, see GetCenter()
+            m_localAabbMin.setY(m_minHeight);
+            m_localAabbMax.setY(m_maxHeight);
+            m_localOrigin = btScalar(0.5) * (m_localAabbMin + m_localAabbMax);
+
+            if (m_vboundsGrid.size() == 0)
+                return;
+
+            // The height ranges of the accelerator chunks with one of the samples, a chunk also has the first samples of the next chunks
+            const int chunk_size    = m_vboundsChunkSize;
+            const int chunk_x_begin = x_begin > 0 ? (x_begin - 1) / chunk_size : 0;
+            const int chunk_y_begin = y_begin > 0 ? (y_begin - 1) / chunk_size : 0;
+            const int chunk_x_end   = btMin((x_end - 1) / chunk_size + 1, m_vboundsGridWidth);
+            const int chunk_y_end   = btMin((y_end - 1) / chunk_size + 1, m_vboundsGridLength);
+            for (int chunk_y = chunk_y_begin; chunk_y < chunk_y_end; chunk_y++)
+            {
+                for (int chunk_x = chunk_x_begin; chunk_x < chunk_x_end; chunk_x++)
+                {
+                    const int x_first   = chunk_x * chunk_size;
+                    const int y_first   = chunk_y * chunk_size;
+                    const int x_last    = btMin(x_first + chunk_size, m_heightStickWidth - 1);
+                    const int y_last    = btMin(y_first + chunk_size, m_heightStickLength - 1);
+
+                    Range& range    = m_vboundsGrid[chunk_x + chunk_y * m_vboundsGridWidth];
+                    range.min       = getRawHeightFieldValue(x_first, y_first);
+                    range.max       = range.min;
+                    for (int y = y_first; y <= y_last; y++)
+                    {
+                        for (int x = x_first; x <= x_last; x++)
+                        {
+                            const btScalar height = getRawHeightFieldValue(x, y);
+                            range.min = btMin(range.min, height);
+                            range.max = btMax(range.max, height);
+                        }
+                    }
+                }
+            }
+        }
+
+        const TerrainHeightBlock& GetBlock() const { return m_block; }
+
+        // Where the shape goes in the space of the terrain
+        btVector3 GetCenter() const
+        {
+            return btVector3(
+                m_block.position.x + (m_block.width - 1) * 0.5f,
+                (m_minHeight + m_maxHeight) * 0.5f,
+                m_block.position.y + (m_block.height - 1) * 0.5f
+            );
+        }
+
+    private:
+        TerrainHeightBlock m_block;
+    };
+
+    static bool heightfield_block_equals(const TerrainHeightBlock& a, const TerrainHeightBlock& b)
+    {
+        return a.heights == b.heights && a.width == b.width && a.height == b.height && a.x == b.x && a.y == b.y;
+    }
+
+    static void heightfield_add(btCompoundShape* compound, const TerrainHeightBlock& block)
+    {
+        const auto range = minmax_element(block.heights, block.heights + static_cast<uint64_t>(block.width) * block.height);
+
+        // A child added after the compound was scaled has to be scaled by hand
+        HeightfieldShape* shape = new HeightfieldShape(block, *range.first, *range.second);
+        shape->setLocalScaling(compound->getLocalScaling());
+        compound->addChildShape(btTransform(btQuaternion::getIdentity(), shape->GetCenter() * compound->getLocalScaling()), shape);
+    }
+
     Collider::Collider(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
     {
         m_shapeType = ColliderShape_Box;
@@ -161,7 +260,24 @@ namespace Spartan
             m_shape->setLocalScaling(ToBtVector3(worldScale));
             break;
 
+        case ColliderShape_Heightfield:
+        {
+            if (!GetEntity()->GetComponent<Terrain>())
+            {
+                LOG_WARNING("Can't construct heightfield shape, there is no Terrain component attached.");
+                return;
+            }
+
+            // A tiled terrain can have no blocks until its tiles are streamed in
+            m_shape = new btCompoundShape();
+            m_shape->setLocalScaling(ToBtVector3(worldScale));
+            HeightfieldUpdateBlocks();
+            break;
+        }
+
         case ColliderShape_Mesh:
+        case ColliderShape_MeshConcave:
+        {
             // Get Renderable
             Renderable* renderable = GetEntity()->GetComponent<Renderable>();
             if (!renderable)
@@ -170,44 +286,48 @@ namespace Spartan
                 return;
             }
 
-            // Validate vertex count
-            if (renderable->GeometryVertexCount() >= m_vertexLimit)
+            // Validate vertex count, an optimized hull is simplified so it can come from any mesh
+            if (m_shapeType == ColliderShape_Mesh && !m_optimize && renderable->GeometryVertexCount() >= m_vertexLimit)
             {
                 LOG_WARNING("No user defined collider with more than %d vertices is allowed.", m_vertexLimit);
                 return;
             }
 
-            // Get geometry
-            vector<uint32_t> indices;
-            vector<RHI_Vertex_PosTexNorTan> vertices;
-            renderable->GeometryGet(&indices, &vertices);
+            if (m_shapeType == ColliderShape_MeshConcave)
+            {
+                if (const RigidBody* rigid_body = m_entity->GetComponent<RigidBody>())
+                {
+                    if (rigid_body->GetMass() != 0.0f)
+                    {
+                        LOG_WARNING("A concave mesh only collides properly when its rigid body has no mass.");
+                    }
+                }
+            }
 
-            if (vertices.empty())
+            // Every instance of the mesh (with the same scale) shares the shape
+            const MeshShape type = m_shapeType == ColliderShape_MeshConcave ? MeshShape::Concave : (m_optimize ? MeshShape::HullSimplified : MeshShape::Hull);
+            ShapeCache* shape_cache = m_context->GetSubsystem<Physics>()->GetShapeCache();
+            if (!shape_cache)
             {
-                LOG_WARNING("No vertices.");
+                LOG_ERROR("The physics have no shape cache.");
                 return;
             }
-
-            // Construct hull approximation
-            m_shape = new btConvexHullShape(
-                (btScalar*)&vertices[0],                                    // points
-                renderable->GeometryVertexCount(),                            // point count
-                static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)));    // stride
-
-            // Scaling has to be done before (potential) optimization
-            m_shape->setLocalScaling(ToBtVector3(worldScale));
-
-            // Optimize if requested
-            if (m_optimize)
+            m_shape = shape_cache->Acquire(renderable, type, worldScale);
+            if (!m_shape)
             {
-                auto hull = static_cast<btConvexHullShape*>(m_shape);
-                hull->optimizeConvexHull();
-                hull->initializePolyhedralFeatures();
+                LOG_WARNING("No vertices.");
+                return;
             }
+            m_shape_shared = true;
             break;
         }
+        }
 
-        m_shape->setUserPointer(this);
+        // A shared shape has no single collider to point to
+        if (!m_shape_shared)
+        {
+            m_shape->setUserPointer(this);
+        }
 
         RigidBody_SetShape(m_shape);
         RigidBody_SetCenterOfMass(m_center);
@@ -216,9 +336,99 @@ namespace Spartan
     void Collider::Shape_Release()
     {
         RigidBody_SetShape(nullptr);
+
+        if (m_shape_shared)
+        {
+            m_context->GetSubsystem<Physics>()->GetShapeCache()->Release(m_shape);
+            m_shape         = nullptr;
+            m_shape_shared  = false;
+            return;
+        }
+
+        // The children of a heightfield aren't deleted with it
+        if (m_shape && m_shape->isCompound())
+        {
+            btCompoundShape* compound = static_cast<btCompoundShape*>(m_shape);
+            for (int i = 0; i < compound->getNumChildShapes(); i++)
+            {
+                delete compound->getChildShape(i);
+            }
+        }
+
         sp_ptr_delete(m_shape);
     }
 
+    void Collider::HeightfieldUpdateBlocks()
+    {
+        if (m_shapeType != ColliderShape_Heightfield || !m_shape)
+            return;
+
+        // The shape is changed in place
+        m_context->GetSubsystem<Physics>()->WaitForSimulation();
+
+        vector<TerrainHeightBlock> blocks;
+        if (Terrain* terrain = GetEntity()->GetComponent<Terrain>())
+        {
+            terrain->GetHeightBlocks(blocks);
+        }
+
+        // The blocks that are gone, a child is removed by moving the last one in its place
+        btCompoundShape* compound = static_cast<btCompoundShape*>(m_shape);
+        for (int i = compound->getNumChildShapes() - 1; i >= 0; i--)
+        {
+            HeightfieldShape* shape = static_cast<HeightfieldShape*>(compound->getChildShape(i));
+            const bool is_resident  = any_of(blocks.begin(), blocks.end(), [shape](const TerrainHeightBlock& block) { return heightfield_block_equals(block, shape->GetBlock()); });
+            if (!is_resident)
+            {
+                compound->removeChildShapeByIndex(i);
+                delete shape;
+            }
+        }
+
+        // The blocks that are new
+        for (const TerrainHeightBlock& block : blocks)
+        {
+            bool is_present = false;
+            for (int i = 0; i < compound->getNumChildShapes() && !is_present; i++)
+            {
+                is_present = heightfield_block_equals(block, static_cast<HeightfieldShape*>(compound->getChildShape(i))->GetBlock());
+            }
+
+            if (!is_present)
+            {
+                heightfield_add(compound, block);
+            }
+        }
+    }
+
+    void Collider::HeightfieldUpdateHeights(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height)
+    {
+        if (m_shapeType != ColliderShape_Heightfield || !m_shape)
+            return;
+
+        // The shape is changed in place
+        m_context->GetSubsystem<Physics>()->WaitForSimulation();
+
+        // The rectangle is in samples of the terrain, so it's clipped to every block that it touches
+        btCompoundShape* compound = static_cast<btCompoundShape*>(m_shape);
+        for (int i = 0; i < compound->getNumChildShapes(); i++)
+        {
+            HeightfieldShape* shape         = static_cast<HeightfieldShape*>(compound->getChildShape(i));
+            const TerrainHeightBlock& block = shape->GetBlock();
+            const uint32_t x_begin          = Helper::Max(x, block.x);
+            const uint32_t y_begin          = Helper::Max(y, block.y);
+            const uint32_t x_end            = Helper::Min(x + width, block.x + block.width);
+            const uint32_t y_end            = Helper::Min(y + height, block.y + block.height);
+            if (x_begin >= x_end || y_begin >= y_end)
+                continue;
+
+            shape->UpdateHeights(x_begin - block.x, y_begin - block.y, x_end - block.x, y_end - block.y);
+
+            // The center follows the height range
+            compound->updateChildTransform(i, btTransform(btQuaternion::getIdentity(), shape->GetCenter() * compound->getLocalScaling()));
+        }
+    }
+
     void Collider::RigidBody_SetShape(btCollisionShape* shape) const
     {
         if (const auto& rigidBody = m_entity->GetComponent<RigidBody>())
@@ -41,6 +41,8 @@ namespace Spartan
         ColliderShape_Capsule,
         ColliderShape_Cone,
         ColliderShape_Mesh,
+        ColliderShape_Heightfield, // the heights of a Terrain on the same entity
+        ColliderShape_MeshConcave, // the triangles of the mesh, for static bodies only
     };
 
     class SPARTAN_CLASS Collider : public IComponent
@@ -74,6 +76,11 @@ namespace Spartan
         bool GetOptimize() const { return m_optimize; }
         void SetOptimize(bool optimize);
 
+        // Heightfield, the terrain calls these so that only what changed is updated. A heightfield is made of one child shape per
+        // height block (the whole grid, or every resident tile), which references the heights of the terrain instead of copying them.
+        void HeightfieldUpdateBlocks();
+        void HeightfieldUpdateHeights(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
     private:
         void Shape_Update();
         void Shape_Release();
@@ -86,5 +93,6 @@ namespace Spartan
         Math::Vector3 m_center;
         uint32_t m_vertexLimit = 100000;
         bool m_optimize = true;
+        bool m_shape_shared = false; // mesh shapes belong to the ShapeCache
     };
 }
@@ -216,6 +216,9 @@ namespace Spartan
         if (!m_constraint || m_bodyOther.expired())
             return;
 
+        // The constraint is changed in place
+        m_physics->WaitForSimulation();
+
         RigidBody* rigid_body_own   = m_entity->GetComponent<RigidBody>();
         RigidBody* rigid_body_other = !m_bodyOther.expired() ? m_bodyOther.lock()->GetComponent<RigidBody>() : nullptr;
         btRigidBody* bt_own_body    = rigid_body_own ? rigid_body_own->GetBtRigidBody() : nullptr;
@@ -360,6 +363,9 @@ namespace Spartan
         if (!m_constraint)
             return;
 
+        // The constraint is changed in place
+        m_physics->WaitForSimulation();
+
         switch (m_constraint->getConstraintType())
         {
             case HINGE_CONSTRAINT_TYPE:
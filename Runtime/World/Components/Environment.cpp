@@ -19,16 +19,20 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ============================
+//= INCLUDES =====================================
 #include "Spartan.h"
 #include "Environment.h"
 #include "../../IO/FileStream.h"
+#include "../../IO/FileMapping.h"
 #include "../../Threading/Threading.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Rendering/Renderer.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../RHI/RHI_TextureCube.h"
-//=======================================
+#include "../../Resource/Import/ImageImporter.h"
+#include "../../Resource/Import/EnvironmentBake.h"
+#include "../../Utilities/Hash.h"
+//================================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -37,6 +41,15 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    // Baked sky spheres, the prefiltered mips (RGB9E5) and the irradiance (spherical harmonics) of a source image
+    static const uint32_t environment_file_magic        = 0x56455053; // "SPEV"
+    static const uint32_t environment_file_version      = 1;
+    static const char* environment_file_extension       = ".environment";
+
+    // The irradiance is low frequency, so it's projected from a mip no wider than this
+    static const uint32_t environment_irradiance_size   = 256;
+    static_assert(EnvironmentBake::sh_coefficient_count == 9, "The irradiance handed to the renderer has 9 coefficients");
+
     Environment::Environment(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
     {
         m_environment_type = Environment_Sphere;
@@ -63,6 +76,11 @@ namespace Spartan
 
     void Environment::OnTick(float delta_time)
     {
+        if (m_irradiance_dirty.exchange(false))
+        {
+            m_context->GetSubsystem<Renderer>()->SetEnvironmentIrradiance(m_irradiance.data());
+        }
+
         if (!m_is_dirty)
             return;
 
@@ -168,15 +186,22 @@ namespace Spartan
     {
         LOG_INFO("Creating sky sphere...");
 
-        // Don't generate mipmaps as the Renderer will generate a prefiltered environment which is required for proper IBL
-        auto generate_mipmaps = true;
+        // A baked sky sphere is only valid for the exact image it was baked from
+        uint64_t source_hash = 0;
+        {
+            FileMapping source(file_path);
+            if (!source.IsOpen())
+            {
+                LOG_ERROR("Sky sphere creation failed, \"%s\" could not be opened", file_path.c_str());
+                return;
+            }
+
+            source_hash = Utility::Hash::hash_fnv1a(source.GetData(), source.GetSize());
+        }
 
-        // Skysphere
-        auto texture = make_shared<RHI_Texture2D>(GetContext(), generate_mipmaps);
-        if (texture->LoadFromFile(file_path))
+        const string file_path_baked = GetContext()->GetSubsystem<ResourceCache>()->GetProjectDirectory() + FileSystem::GetFileNameNoExtensionFromFilePath(file_path) + environment_file_extension;
+        if (LoadBaked(file_path_baked, file_path, source_hash) || Bake(file_path_baked, file_path, source_hash))
         {
-            // Set sky sphere to renderer
-            SetTexture(static_pointer_cast<RHI_Texture>(texture));
             LOG_INFO("Sky sphere has been created successfully");
         }
         else
@@ -184,4 +209,125 @@ namespace Spartan
             LOG_ERROR("Sky sphere creation failed");
         }
     }
+
+    bool Environment::LoadBaked(const string& file_path, const string& source_path, const uint64_t source_hash)
+    {
+        FileMapping file(file_path);
+        if (!file.IsOpen())
+            return false;
+
+        // A different source image (or an older bake) gets baked again
+        if (file.ReadAs<uint32_t>() != environment_file_magic || file.ReadAs<uint32_t>() != environment_file_version || file.ReadAs<uint64_t>() != source_hash)
+            return false;
+
+        const uint32_t width    = file.ReadAs<uint32_t>();
+        const uint32_t height   = file.ReadAs<uint32_t>();
+
+        Vector3 irradiance[EnvironmentBake::sh_coefficient_count];
+        for (Vector3& coefficient : irradiance)
+        {
+            file.Read(&coefficient);
+        }
+
+        vector<vector<std::byte>> mips(file.ReadAs<uint32_t>());
+        for (vector<std::byte>& mip : mips)
+        {
+            file.Read(&mip);
+        }
+
+        if (file.HasError() || mips.empty())
+            return false;
+
+        auto texture = make_shared<RHI_Texture2D>(GetContext(), width, height, RHI_Format_R9G9B9E5_Float, mips);
+        texture->SetResourceFilePath(source_path);
+        SetTexture(static_pointer_cast<RHI_Texture>(texture));
+        copy(begin(irradiance), end(irradiance), m_irradiance.begin());
+        m_irradiance_dirty = true;
+
+        return true;
+    }
+
+    bool Environment::Bake(const string& file_path, const string& source_path, const uint64_t source_hash)
+    {
+        LOG_INFO("Baking \"%s\"...", source_path.c_str());
+
+        // Decode the source with a plain mip chain, which the prefiltering reads from
+        auto source = make_shared<RHI_Texture2D>(GetContext(), true);
+        if (!m_context->GetSubsystem<ResourceCache>()->GetImageImporter()->Load(source_path, source.get(), true))
+            return false;
+
+        // Only HDR images are baked, anything else is used as it is
+        if (source->GetFormat() != RHI_Format_R32G32B32A32_Float)
+        {
+            auto texture = make_shared<RHI_Texture2D>(GetContext(), true);
+            if (!texture->LoadFromFile(source_path))
+                return false;
+
+            SetTexture(static_pointer_cast<RHI_Texture>(texture));
+            return true;
+        }
+
+        const vector<vector<std::byte>>& source_mips    = source->GetMips();
+        const uint32_t width                            = source->GetWidth();
+        const uint32_t height                           = source->GetHeight();
+        Threading* threading                            = m_context->GetSubsystem<Threading>();
+
+        // Prefilter every mip, a row at a time
+        vector<vector<std::byte>> mips(source_mips.size());
+        for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(mips.size()); mip_index++)
+        {
+            const uint32_t mip_width    = max(width >> mip_index, 1u);
+            const uint32_t mip_height   = max(height >> mip_index, 1u);
+            mips[mip_index].resize(static_cast<size_t>(mip_width) * mip_height * sizeof(uint32_t));
+            uint32_t* destination = reinterpret_cast<uint32_t*>(mips[mip_index].data());
+
+            threading->ParallelFor(mip_height, [&](const uint32_t row)
+            {
+                EnvironmentBake::prefilter(source_mips, width, height, mip_index, row, destination + static_cast<size_t>(row) * mip_width);
+            });
+        }
+
+        // Project the irradiance
+        uint32_t mip_irradiance = 0;
+        while (mip_irradiance + 1 < static_cast<uint32_t>(source_mips.size()) && (width >> mip_irradiance) > environment_irradiance_size)
+        {
+            mip_irradiance++;
+        }
+        Vector3 irradiance[EnvironmentBake::sh_coefficient_count];
+        EnvironmentBake::project_irradiance(source_mips[mip_irradiance].data(), max(width >> mip_irradiance, 1u), max(height >> mip_irradiance, 1u), irradiance);
+
+        // Save, if that fails the next load simply bakes again
+        {
+            FileStream file(file_path, FileStream_Write);
+            if (file.IsOpen())
+            {
+                file.Write(environment_file_magic);
+                file.Write(environment_file_version);
+                file.Write(source_hash);
+                file.Write(width);
+                file.Write(height);
+                for (const Vector3& coefficient : irradiance)
+                {
+                    file.Write(coefficient);
+                }
+                file.Write(static_cast<uint32_t>(mips.size()));
+                for (const vector<std::byte>& mip : mips)
+                {
+                    file.Write(mip);
+                }
+            }
+            else
+            {
+                LOG_WARNING("Failed to save \"%s\"", file_path.c_str());
+            }
+        }
+
+        auto texture = make_shared<RHI_Texture2D>(GetContext(), width, height, RHI_Format_R9G9B9E5_Float, mips);
+        texture->SetResourceFilePath(source_path);
+        SetTexture(static_pointer_cast<RHI_Texture>(texture));
+        copy(begin(irradiance), end(irradiance), m_irradiance.begin());
+        m_irradiance_dirty = true;
+
+        return true;
+    }
 }
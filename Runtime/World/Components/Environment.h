@@ -23,7 +23,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ========================
 #include "IComponent.h"
+#include <array>
+#include <atomic>
 #include "../../RHI/RHI_Definition.h"
+#include "../../Math/Vector3.h"
 //===================================
 
 namespace Spartan
@@ -55,8 +58,14 @@ namespace Spartan
         void SetFromTextureArray(const std::vector<std::string>& texturePaths);
         void SetFromTextureSphere(const std::string& texturePath);
 
+        // Sky spheres are prefiltered once and then loaded from a file in the project directory, which is keyed by a hash of the source image
+        bool LoadBaked(const std::string& file_path, const std::string& source_path, uint64_t source_hash);
+        bool Bake(const std::string& file_path, const std::string& source_path, uint64_t source_hash);
+
         std::vector<std::string> m_file_paths;
         Environment_Type m_environment_type;
         bool m_is_dirty = false;
+        std::array<Math::Vector3, 9> m_irradiance;
+        std::atomic<bool> m_irradiance_dirty = false; // loaded on a worker, handed to the renderer in OnTick() (it reads it every frame)
     };
 }
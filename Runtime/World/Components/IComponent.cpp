@@ -35,6 +35,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderable.h"
 #include "Transform.h"
 #include "Terrain.h"
+#include "Animator.h"
 #include "../Entity.h"
 //========================
 
@@ -60,6 +61,30 @@ namespace Spartan
         return m_entity->GetName();
     }
 
+    const vector<ComponentTickDescription>& IComponent::GetTickDescriptions()
+    {
+        // To make a new component type tick, describe what its OnTick() touches here (component types which are not listed, never tick).
+        // Types tick in the order listed, but types which don't write to what another type reads or writes, tick in parallel.
+        // Types which add to or remove from the physics world when they tick (e.g. constraints), tick on the main thread, as only it can wait for the physics steps.
+        static const vector<ComponentTickDescription> descriptions =
+        {
+            // type                         main_thread     access_read                                             access_write
+            { ComponentType::Script,        true,           ComponentAccess_All,                                    ComponentAccess_All },
+            { ComponentType::Terrain,       true,           ComponentAccess_None,                                   ComponentAccess_All },
+            { ComponentType::Camera,        true,           ComponentAccess_Input | ComponentAccess_Transform,      ComponentAccess_Transform | ComponentAccess_Camera },
+            { ComponentType::Light,         false,          ComponentAccess_Transform | ComponentAccess_Camera,     ComponentAccess_Rhi },
+            { ComponentType::Environment,   false,          ComponentAccess_None,                                   ComponentAccess_None },
+            { ComponentType::Animator,      false,          ComponentAccess_None,                                   ComponentAccess_None },
+            { ComponentType::RigidBody,     false,          ComponentAccess_Transform,                              ComponentAccess_Physics },
+            { ComponentType::SoftBody,      false,          ComponentAccess_Transform,                              ComponentAccess_Physics },
+            { ComponentType::Constraint,    true,           ComponentAccess_None,                                   ComponentAccess_Physics },
+            { ComponentType::AudioListener, false,          ComponentAccess_Transform,                              ComponentAccess_Audio },
+            { ComponentType::AudioSource,   false,          ComponentAccess_Transform,                              ComponentAccess_Audio }
+        };
+
+        return descriptions;
+    }
+
     template <typename T>
     inline constexpr ComponentType IComponent::TypeToEnum() { return ComponentType::Unknown; }
 
@@ -83,4 +108,5 @@ namespace Spartan
     REGISTER_COMPONENT(Environment,        ComponentType::Environment)
     REGISTER_COMPONENT(Terrain,         ComponentType::Terrain)
     REGISTER_COMPONENT(Transform,        ComponentType::Transform)
+    REGISTER_COMPONENT(Animator,         ComponentType::Animator)
 }
@@ -52,9 +52,31 @@ namespace Spartan
         Environment,
         Transform,
         Terrain,
+        Animator,
         Unknown
     };
 
+    // Engine data that a component can touch while ticking, used to figure out which component types can tick in parallel
+    enum ComponentAccess : uint32_t
+    {
+        ComponentAccess_None        = 0,
+        ComponentAccess_Transform   = 1UL << 0,
+        ComponentAccess_Camera      = 1UL << 1,
+        ComponentAccess_Physics     = 1UL << 2,
+        ComponentAccess_Audio       = 1UL << 3,
+        ComponentAccess_Rhi         = 1UL << 4,
+        ComponentAccess_Input       = 1UL << 5,
+        ComponentAccess_All         = 0xFFFFFFFF
+    };
+
+    struct ComponentTickDescription
+    {
+        ComponentType type      = ComponentType::Unknown;
+        bool main_thread        = false;                    // Does OnTick() have to run on the main thread ?
+        uint32_t access_read    = ComponentAccess_None;     // What OnTick() reads (besides the component itself)
+        uint32_t access_write   = ComponentAccess_None;     // What OnTick() writes (besides the component itself)
+    };
+
     struct Attribute
     {
         std::function<std::any()> getter;
@@ -88,10 +110,11 @@ namespace Spartan
         // Runs when the entity is being loaded
         virtual void Deserialize(FileStream* stream) {}
 
-        //= TYPE ===================================
+        //= TYPE ======================================================================
         template <typename T>
         static constexpr ComponentType TypeToEnum();
-        //==========================================
+        static const std::vector<ComponentTickDescription>& GetTickDescriptions();
+        //=============================================================================
 
         //= PROPERTIES ==========================================================================
         Transform* GetTransform()           const { return m_transform; }
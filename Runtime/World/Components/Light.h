@@ -122,6 +122,7 @@ namespace Spartan
         void CreateShadowMap();
 
         bool IsInViewFrustrum(Renderable* renderable, uint32_t index) const;
+        const Math::Frustum& GetFrustum(uint32_t index) const { return m_shadow_map.slices[index].frustum; }
 
     private:
         void ComputeViewMatrix();
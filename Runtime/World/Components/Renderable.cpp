@@ -19,7 +19,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ============================
+//= INCLUDES =============================
 #include "Spartan.h"
 #include "Renderable.h"
 #include "Transform.h"
@@ -28,8 +28,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Utilities/Geometry.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../Rendering/Model.h"
+#include "../../Rendering/MeshOptimizer.h"
+#include "../../Rendering/MeshBvh.h"
+#include "../../Math/Ray.h"
 #include "../../RHI/RHI_Vertex.h"
-//=======================================
+//========================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -76,6 +79,8 @@ namespace Spartan
         if (vertices.empty() || indices.empty())
             return;
 
+        MeshOptimizer::optimize(&vertices, &indices);
+
         model->AppendGeometry(indices, vertices, nullptr, nullptr);
         model->UpdateGeometry();
 
@@ -97,6 +102,10 @@ namespace Spartan
         m_geometryIndexCount    = 0;
         m_geometryVertexOffset  = 0;
         m_geometryVertexCount   = 0;
+        m_geometryMeshletOffset = 0;
+        m_geometryMeshletCount  = 0;
+        m_geometryLodOffset     = 0;
+        m_geometryLodCount      = 0;
         m_material_default      = false;
         m_cast_shadows          = true;
 
@@ -107,6 +116,10 @@ namespace Spartan
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryIndexCount,    uint32_t);
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryVertexOffset,  uint32_t);
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryVertexCount,   uint32_t);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryMeshletOffset, uint32_t);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryMeshletCount,  uint32_t);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryLodOffset,     uint32_t);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryLodCount,      uint32_t);
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryName,          string);
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_model,                 Model*);
         REGISTER_ATTRIBUTE_VALUE_VALUE(m_bounding_box,          BoundingBox);
@@ -121,6 +134,10 @@ namespace Spartan
         stream->Write(m_geometryIndexCount);
         stream->Write(m_geometryVertexOffset);
         stream->Write(m_geometryVertexCount);
+        stream->Write(m_geometryMeshletOffset);
+        stream->Write(m_geometryMeshletCount);
+        stream->Write(m_geometryLodOffset);
+        stream->Write(m_geometryLodCount);
         stream->Write(m_bounding_box);
         stream->Write(m_model ? m_model->GetResourceName() : "");
 
@@ -141,6 +158,10 @@ namespace Spartan
         m_geometryIndexCount    = stream->ReadAs<uint32_t>();
         m_geometryVertexOffset  = stream->ReadAs<uint32_t>();
         m_geometryVertexCount   = stream->ReadAs<uint32_t>();
+        m_geometryMeshletOffset = stream->ReadAs<uint32_t>();
+        m_geometryMeshletCount  = stream->ReadAs<uint32_t>();
+        m_geometryLodOffset     = stream->ReadAs<uint32_t>();
+        m_geometryLodCount      = stream->ReadAs<uint32_t>();
         stream->Read(&m_bounding_box);
         string model_name;
         stream->Read(&model_name);
@@ -167,7 +188,7 @@ namespace Spartan
         }
     }
 
-    void Renderable::GeometrySet(const string& name, const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, const BoundingBox& bounding_box, Model* model)
+    void Renderable::GeometrySet(const string& name, const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, const BoundingBox& bounding_box, Model* model, const uint32_t meshlet_offset /*= 0*/, const uint32_t meshlet_count /*= 0*/, const uint32_t lod_offset /*= 0*/, const uint32_t lod_count /*= 0*/)
     {
         // Terrible way to delete previous geometry in case it's a default one
         if (m_geometryName == "Default_Geometry")
@@ -180,6 +201,11 @@ namespace Spartan
         m_geometryIndexCount    = index_count;
         m_geometryVertexOffset  = vertex_offset;
         m_geometryVertexCount   = vertex_count;
+        m_geometryMeshletOffset = meshlet_offset;
+        m_geometryMeshletCount  = meshlet_count;
+        m_geometryLodOffset     = lod_offset;
+        m_geometryLodCount      = lod_count;
+        m_lod_index             = 0;
         m_bounding_box          = bounding_box;
         m_model                 = model;
     }
@@ -215,13 +241,77 @@ namespace Spartan
         // Updated if dirty
         if (m_last_transform != GetTransform()->GetMatrix() || !m_aabb.Defined())
         {
-            m_aabb = m_bounding_box.Transform(GetTransform()->GetMatrix());
+            m_aabb = (m_is_skinned ? m_skin_bounding_box : m_bounding_box).Transform(GetTransform()->GetMatrix());
             m_last_transform = GetTransform()->GetMatrix();
         }
 
         return m_aabb;
     }
 
+    bool Renderable::GeometryPlacement(SubmeshPlacement* placement) const
+    {
+        if (m_is_skinned)
+        {
+            *placement = m_skin_placement;
+            return true;
+        }
+
+        return m_model && m_model->GetSubmeshPlacement(m_geometryVertexOffset, placement);
+    }
+
+    void Renderable::SkinSet(const SubmeshPlacement& placement, const BoundingBox& aabb)
+    {
+        m_skin_placement    = placement;
+        m_skin_bounding_box = aabb;
+        m_is_skinned        = true;
+        m_aabb.Undefine();
+    }
+
+    void Renderable::SkinClear()
+    {
+        m_skin_placement    = SubmeshPlacement();
+        m_is_skinned        = false;
+        m_aabb.Undefine();
+    }
+
+    float Renderable::RayHitDistance(const Ray& ray) const
+    {
+        float distance = Helper::INFINITY_;
+        RayHitDistance(&ray, 1, &distance);
+        return distance;
+    }
+
+    void Renderable::RayHitDistance(const Ray* rays, const uint32_t ray_count, float* distances) const
+    {
+        if (!rays || !distances)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        MeshBvhView view;
+        const bool has_geometry = m_model && m_model->GetBvhView(m_geometryIndexOffset, m_geometryIndexCount, m_geometryVertexOffset, &view);
+
+        // The bvh is in the mesh's space, so the rays are brought into it (instead of the triangles into world space)
+        const Matrix& transform         = GetTransform()->GetMatrix();
+        const Matrix transform_inverse  = transform.Inverted();
+        for (uint32_t i = 0; i < ray_count; i++)
+        {
+            distances[i] = Helper::INFINITY_;
+            if (!has_geometry)
+                continue;
+
+            const Ray ray_local(rays[i].GetStart() * transform_inverse, rays[i].GetEnd() * transform_inverse);
+            const float distance_local = MeshBvhHelper::intersect(view, ray_local);
+            if (distance_local == Helper::INFINITY_)
+                continue;
+
+            // Scale doesn't have to be uniform, so the distance is measured again in world space
+            const Vector3 position  = (ray_local.GetStart() + ray_local.GetDirection() * distance_local) * transform;
+            distances[i]            = (position - rays[i].GetStart()).Length();
+        }
+    }
+
     // All functions (set/load) resolve to this
     shared_ptr<Material> Renderable::SetMaterial(const shared_ptr<Material>& material)
     {
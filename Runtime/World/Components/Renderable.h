@@ -21,12 +21,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ======================
+//= INCLUDES ============================
 #include "IComponent.h"
 #include <vector>
 #include "../../Math/BoundingBox.h"
 #include "../../Math/Matrix.h"
-//=================================
+#include "../../Rendering/GeometryHeap.h"
+//=======================================
 
 namespace Spartan
 {
@@ -37,6 +38,7 @@ namespace Spartan
     namespace Math
     {
         class Vector3;
+        class Ray;
     }
 
     enum Geometry_Type
@@ -68,7 +70,11 @@ namespace Spartan
             uint32_t vertex_offset,
             uint32_t vertex_count,
             const Math::BoundingBox& aabb, 
-            Model* model
+            Model* model,
+            uint32_t meshlet_offset = 0,
+            uint32_t meshlet_count  = 0,
+            uint32_t lod_offset     = 0,
+            uint32_t lod_count      = 0
         );
         void GeometryClear();
         void GeometrySet(Geometry_Type type);
@@ -77,11 +83,23 @@ namespace Spartan
         uint32_t GeometryIndexCount()               const { return m_geometryIndexCount; }
         uint32_t GeometryVertexOffset()             const { return m_geometryVertexOffset; }
         uint32_t GeometryVertexCount()              const { return m_geometryVertexCount; }
+        uint32_t GeometryMeshletOffset()            const { return m_geometryMeshletOffset; }
+        uint32_t GeometryMeshletCount()             const { return m_geometryMeshletCount; }
+        uint32_t GeometryLodOffset()                const { return m_geometryLodOffset; }
+        uint32_t GeometryLodCount()                 const { return m_geometryLodCount; }
         Geometry_Type GeometryType()                const { return m_geometry_type; }
         const std::string& GeometryName()           const { return m_geometryName; }
         Model* GeometryModel()                      const { return m_model; }
         const Math::BoundingBox& GetBoundingBox()   const { return m_bounding_box; }
         const Math::BoundingBox& GetAabb();
+
+        // Where the geometry is in the geometry heaps, which is the model's unless the renderable is skinned
+        bool GeometryPlacement(SubmeshPlacement* placement) const;
+
+        // World space distance to the nearest front facing triangle, or infinity. Runs against the model's bvh without copying
+        // any geometry, skinned geometry is tested in its bind pose. The batched version takes many rays at once.
+        float RayHitDistance(const Math::Ray& ray) const;
+        void RayHitDistance(const Math::Ray* rays, uint32_t ray_count, float* distances) const;
         //=====================================================================================================
 
         //= MATERIAL ====================================================================
@@ -100,6 +118,15 @@ namespace Spartan
         //= PROPERTIES ===================================================================
         void SetCastShadows(const bool cast_shadows)    { m_cast_shadows = cast_shadows; }
         auto GetCastShadows() const                     { return m_cast_shadows; }
+
+        // The level of detail that the renderer selected (0 is full detail), not serialized as it's updated every frame
+        void SetLodIndex(const uint32_t lod_index)      { m_lod_index = lod_index; }
+        uint32_t GetLodIndex() const                    { return m_lod_index; }
+
+        // Skinning (see Animator), skinned vertices are drawn from a range of their own and are bounded by the box of the current pose (in local space)
+        void SkinSet(const SubmeshPlacement& placement, const Math::BoundingBox& aabb);
+        void SkinClear();
+        bool IsSkinned() const                          { return m_is_skinned; }
         //================================================================================
 
     private:
@@ -108,11 +135,19 @@ namespace Spartan
         uint32_t m_geometryIndexCount;
         uint32_t m_geometryVertexOffset;
         uint32_t m_geometryVertexCount;
+        uint32_t m_geometryMeshletOffset;
+        uint32_t m_geometryMeshletCount;
+        uint32_t m_geometryLodOffset;
+        uint32_t m_geometryLodCount;
         Geometry_Type m_geometry_type;
         Math::BoundingBox m_bounding_box;
         Math::BoundingBox m_aabb;
         Math::Matrix m_last_transform   = Math::Matrix::Identity;
         bool m_cast_shadows             = true;
+        uint32_t m_lod_index            = 0;
+        bool m_is_skinned               = false;
+        SubmeshPlacement m_skin_placement;
+        Math::BoundingBox m_skin_bounding_box;
         bool m_material_default;
         Model* m_model          = nullptr;
         Material* m_material    = nullptr;
@@ -47,29 +47,49 @@ namespace Spartan
     class MotionState : public btMotionState
     {
     public:
-        MotionState(RigidBody* rigidBody) { m_rigidBody = rigidBody; }
+        MotionState(RigidBody* rigidBody, Physics* physics)
+        {
+            m_rigidBody = rigidBody;
+            m_physics   = physics;
+
+            SetEnginePose();
+            m_poses[0] = m_pose_engine;
+            m_poses[1] = m_pose_engine;
+        }
 
         // Update from engine, ENGINE -> BULLET
         void getWorldTransform(btTransform& worldTrans) const override
         {
-            const Vector3 lastPos        = m_rigidBody->GetTransform()->GetPosition();
-            const Quaternion lastRot    = m_rigidBody->GetTransform()->GetRotation();
-
-            worldTrans.setOrigin(ToBtVector3(lastPos + lastRot * m_rigidBody->GetCenterOfMass()));
-            worldTrans.setRotation(ToBtQuaternion(lastRot));
+            // Kinematic bodies are read during the steps, so it's from a copy of the transform (see RigidBody::PublishPose())
+            worldTrans.setOrigin(ToBtVector3(m_pose_engine.position + m_pose_engine.rotation * m_rigidBody->GetCenterOfMass()));
+            worldTrans.setRotation(ToBtQuaternion(m_pose_engine.rotation));
         }
 
         // Update from bullet, BULLET -> ENGINE
         void setWorldTransform(const btTransform& worldTrans) override
         {
+            // Called by the physics thread, for every body that moved during a step, the engine picks the poses up once the steps are done
             const Quaternion newWorldRot    = ToQuaternion(worldTrans.getRotation());
-            const Vector3 newWorldPos        = ToVector3(worldTrans.getOrigin()) - newWorldRot * m_rigidBody->GetCenterOfMass();
+            const Vector3 newWorldPos       = ToVector3(worldTrans.getOrigin()) - newWorldRot * m_rigidBody->GetCenterOfMass();
 
-            m_rigidBody->GetTransform()->SetPosition(newWorldPos);
-            m_rigidBody->GetTransform()->SetRotation(newWorldRot);
+            m_poses[0]  = m_poses[1];
+            m_poses[1]  = { newWorldPos, newWorldRot };
+            m_step      = m_physics->GetStepCount();
         }
+
+        void SetEnginePose()
+        {
+            m_pose_engine = { m_rigidBody->GetTransform()->GetPosition(), m_rigidBody->GetTransform()->GetRotation() };
+        }
+
+        // The poses of the previous and the current step, and the step they were set in
+        RigidBodyPose m_poses[2];
+        uint64_t m_step = 0;
+        RigidBodyPose m_pose_engine;
+
     private:
         RigidBody* m_rigidBody;
+        Physics* m_physics;
     };
 
     RigidBody::RigidBody(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
@@ -190,7 +210,10 @@ namespace Spartan
             return;
 
         m_friction = friction;
-        m_rigidBody->setFriction(friction);
+        if (!Defer([this, friction]() { m_rigidBody->setFriction(friction); }))
+        {
+            m_rigidBody->setFriction(friction);
+        }
     }
 
     void RigidBody::SetFrictionRolling(float frictionRolling)
@@ -199,7 +222,10 @@ namespace Spartan
             return;
 
         m_friction_rolling = frictionRolling;
-        m_rigidBody->setRollingFriction(frictionRolling);
+        if (!Defer([this, frictionRolling]() { m_rigidBody->setRollingFriction(frictionRolling); }))
+        {
+            m_rigidBody->setRollingFriction(frictionRolling);
+        }
     }
 
     void RigidBody::SetRestitution(float restitution)
@@ -208,7 +234,10 @@ namespace Spartan
             return;
 
         m_restitution = restitution;
-        m_rigidBody->setRestitution(restitution);
+        if (!Defer([this, restitution]() { m_rigidBody->setRestitution(restitution); }))
+        {
+            m_rigidBody->setRestitution(restitution);
+        }
     }
 
     void RigidBody::SetUseGravity(bool gravity)
@@ -243,6 +272,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, velocity, activate]() { SetLinearVelocity(velocity, activate); }))
+            return;
+
         m_rigidBody->setLinearVelocity(ToBtVector3(velocity));
         if (velocity != Vector3::Zero && activate)
         {
@@ -255,6 +287,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, velocity, activate]() { SetAngularVelocity(velocity, activate); }))
+            return;
+
         m_rigidBody->setAngularVelocity(ToBtVector3(velocity));
         if (velocity != Vector3::Zero && activate)
         {
@@ -267,6 +302,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, force, mode]() { ApplyForce(force, mode); }))
+            return;
+
         Activate();
 
         if (mode == Force)
@@ -284,6 +322,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, force, position, mode]() { ApplyForceAtPosition(force, position, mode); }))
+            return;
+
         Activate();
 
         if (mode == Force)
@@ -301,6 +342,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, torque, mode]() { ApplyTorque(torque, mode); }))
+            return;
+
         Activate();
 
         if (mode == Force)
@@ -331,7 +375,10 @@ namespace Spartan
             return;
 
         m_position_lock = lock;
-        m_rigidBody->setLinearFactor(ToBtVector3(Vector3::One - lock));
+        if (!Defer([this, lock]() { m_rigidBody->setLinearFactor(ToBtVector3(Vector3::One - lock)); }))
+        {
+            m_rigidBody->setLinearFactor(ToBtVector3(Vector3::One - lock));
+        }
     }
 
     void RigidBody::SetRotationLock(bool lock)
@@ -352,17 +399,28 @@ namespace Spartan
             return;
 
         m_rotation_lock = lock;
-        m_rigidBody->setAngularFactor(ToBtVector3(Vector3::One - lock));
+        if (!Defer([this, lock]() { m_rigidBody->setAngularFactor(ToBtVector3(Vector3::One - lock)); }))
+        {
+            m_rigidBody->setAngularFactor(ToBtVector3(Vector3::One - lock));
+        }
     }
 
     void RigidBody::SetCenterOfMass(const Vector3& centerOfMass)
     {
+        // The center of mass is read by the motion state during the steps
+        if (Defer([this, centerOfMass]() { SetCenterOfMass(centerOfMass); }))
+            return;
+
         m_center_of_mass = centerOfMass;
         SetPosition(GetPosition());
     }
 
     Vector3 RigidBody::GetPosition() const
     {
+        // Static bodies aren't moved by the physics thread (and aren't published)
+        if (m_rigidBody && m_physics->IsSimulating() && !m_rigidBody->isStaticObject())
+            return m_pose_current.position;
+
         if (m_rigidBody)
         {
             const btTransform& transform = m_rigidBody->getWorldTransform();
@@ -377,6 +435,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, position, activate]() { SetPosition(position, activate); }))
+            return;
+
         // Set position to world transform
         btTransform& transform_world = m_rigidBody->getWorldTransform();
         transform_world.setOrigin(ToBtVector3(position + ToQuaternion(transform_world.getRotation()) * m_center_of_mass));
@@ -386,6 +447,8 @@ namespace Spartan
         transform_world_interpolated.setOrigin(transform_world.getOrigin());
         m_rigidBody->setInterpolationWorldTransform(transform_world_interpolated);
 
+        Pose_Reset();
+
         if (activate)
         {
             Activate();
@@ -394,6 +457,9 @@ namespace Spartan
 
     Quaternion RigidBody::GetRotation() const
     {
+        if (m_rigidBody && m_physics->IsSimulating() && !m_rigidBody->isStaticObject())
+            return m_pose_current.rotation;
+
         return m_rigidBody ? ToQuaternion(m_rigidBody->getWorldTransform().getRotation()) : Quaternion::Identity;
     }
 
@@ -402,6 +468,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this, rotation, activate]() { SetRotation(rotation, activate); }))
+            return;
+
         // Set rotation to world transform
         const Vector3 oldPosition = GetPosition();
         btTransform& transform_world = m_rigidBody->getWorldTransform();
@@ -422,6 +491,8 @@ namespace Spartan
 
         m_rigidBody->updateInertiaTensor();
 
+        Pose_Reset();
+
         if (activate)
         {
             Activate();
@@ -433,6 +504,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this]() { ClearForces(); }))
+            return;
+
         m_rigidBody->clearForces();
     }
 
@@ -441,6 +515,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this]() { Activate(); }))
+            return;
+
         if (m_mass > 0.0f)
         {
             m_rigidBody->activate(true);
@@ -452,6 +529,9 @@ namespace Spartan
         if (!m_rigidBody)
             return;
 
+        if (Defer([this]() { Deactivate(); }))
+            return;
+
         m_rigidBody->setActivationState(WANTS_DEACTIVATION);
     }
 
@@ -492,6 +572,31 @@ namespace Spartan
         }
     }
 
+    void RigidBody::PublishPose(const uint64_t step)
+    {
+        MotionState* motion_state = static_cast<MotionState*>(m_rigidBody->getMotionState());
+
+        // A body that didn't move during the last step (e.g. it's asleep), is at rest where it was last
+        m_pose_previous = motion_state->m_step == step ? motion_state->m_poses[0] : motion_state->m_poses[1];
+        m_pose_current  = motion_state->m_poses[1];
+        m_is_active     = m_rigidBody->isActive();
+        m_pose_pending  = false;
+
+        // Kinematic bodies are moved by the engine
+        if (m_is_kinematic)
+        {
+            motion_state->SetEnginePose();
+        }
+    }
+
+    RigidBodyPose RigidBody::GetPoseInterpolated(const float alpha) const
+    {
+        if (m_pose_previous.position == m_pose_current.position && m_pose_previous.rotation == m_pose_current.rotation)
+            return m_pose_current;
+
+        return { Helper::Lerp(m_pose_previous.position, m_pose_current.position, alpha), Quaternion::Lerp(m_pose_previous.rotation, m_pose_current.rotation, alpha) };
+    }
+
     void RigidBody::Body_AddToWorld()
     {
         if (m_mass < 0.0f)
@@ -512,7 +617,7 @@ namespace Spartan
         // CONSTRUCTION
         {
             // Create a motion state (memory will be freed by the RigidBody)
-            const auto motion_state = new MotionState(this);
+            const auto motion_state = new MotionState(this, m_physics);
             
             // Info
             btRigidBody::btRigidBodyConstructionInfo constructionInfo(m_mass, motion_state, m_collision_shape, local_intertia);
@@ -649,6 +754,26 @@ namespace Spartan
 
     bool RigidBody::IsActivated() const
     {
-        return m_rigidBody->isActive();
+        return m_physics->IsSimulating() ? m_is_active : m_rigidBody->isActive();
+    }
+
+    bool RigidBody::Defer(function<void()>&& command) const
+    {
+        // A body that's in the world is only changed by the commands, which run right before the next steps (from whichever thread this is called)
+        if (!m_rigidBody || m_rigidBody->getWorldArrayIndex() == -1 || m_physics->IsExecutingCommands())
+            return false;
+
+        m_physics->AddCommand(m_rigidBody, move(command));
+        return true;
+    }
+
+    void RigidBody::Pose_Reset() const
+    {
+        // The body was moved to where it is, so there is nothing to interpolate from, and it's published even if it stays asleep
+        MotionState* motion_state   = static_cast<MotionState*>(m_rigidBody->getMotionState());
+        motion_state->m_poses[0]    = { GetPosition(), GetRotation() };
+        motion_state->m_poses[1]    = motion_state->m_poses[0];
+        motion_state->m_pose_engine = motion_state->m_poses[0];
+        m_pose_pending              = true;
     }
 }
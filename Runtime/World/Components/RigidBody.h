@@ -21,11 +21,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ==================
+//= INCLUDES =====================
 #include "IComponent.h"
 #include <vector>
+#include <functional>
 #include "../../Math/Vector3.h"
-//=============================
+#include "../../Math/Quaternion.h"
+//================================
 
 class btRigidBody;
 class btCollisionShape;
@@ -35,7 +37,6 @@ namespace Spartan
     class Entity;
     class Constraint;
     class Physics;
-    namespace Math { class Quaternion; }
 
     enum ForceMode
     {
@@ -43,6 +44,12 @@ namespace Spartan
         Impulse
     };
 
+    struct RigidBodyPose
+    {
+        Math::Vector3 position      = Math::Vector3::Zero;
+        Math::Quaternion rotation   = Math::Quaternion::Identity;
+    };
+
     class SPARTAN_CLASS RigidBody : public IComponent
     {
     public:
@@ -138,6 +145,11 @@ namespace Spartan
         void RemoveConstraint(Constraint* constraint);
         void SetShape(btCollisionShape* shape);
 
+        // Called by the physics while its thread is idle, see Physics::Tick()
+        void PublishPose(uint64_t step);
+        RigidBodyPose GetPoseInterpolated(float alpha) const;
+        bool IsPosePending() const { return m_is_active || m_pose_pending; }
+
     private:
         void Body_AddToWorld();
         void Body_Release();
@@ -146,6 +158,8 @@ namespace Spartan
         void Flags_UpdateKinematic() const;
         void Flags_UpdateGravity() const;
         bool IsActivated() const;
+        bool Defer(std::function<void()>&& command) const;
+        void Pose_Reset() const;
 
         float m_mass                    = 0.0f;
         float m_friction                = 0.0f;
@@ -163,5 +177,11 @@ namespace Spartan
         bool m_in_world                     = false;
         Physics* m_physics                  = nullptr;
         std::vector<Constraint*> m_constraints;
+
+        // The last two poses that the physics published, they are what the game sees while the world is being stepped
+        RigidBodyPose m_pose_previous;
+        RigidBodyPose m_pose_current;
+        bool m_is_active            = false;
+        mutable bool m_pose_pending = false;
     };
 }
@@ -105,6 +105,9 @@ namespace Spartan
         if (!m_soft_body)
             return;
 
+        if (Defer([this, position]() { SetPosition(position); }))
+            return;
+
         // Set position to world transform
         btTransform& worldTrans = m_soft_body->getWorldTransform();
         worldTrans.setOrigin(ToBtVector3(position + ToQuaternion(worldTrans.getRotation()) * m_center_of_mass));
@@ -122,6 +125,9 @@ namespace Spartan
         if (!m_soft_body)
             return;
 
+        if (Defer([this, rotation]() { SetRotation(rotation); }))
+            return;
+
         // Set rotation to world transform
         const Math::Vector3 oldPosition = GetPosition();
         btTransform& worldTrans = m_soft_body->getWorldTransform();
@@ -139,6 +145,9 @@ namespace Spartan
         if (!m_soft_body)
             return;
 
+        if (Defer([this]() { Activate(); }))
+            return;
+
         if (m_mass > 0.0f)
         {
             m_soft_body->activate(true);
@@ -257,4 +266,14 @@ namespace Spartan
         m_physics->RemoveBody(m_soft_body);
         m_in_world  = false;
     }
+
+    bool SoftBody::Defer(function<void()>&& command) const
+    {
+        // Like the rigid bodies, a body that's in the world is only changed by the commands, which run right before the next steps
+        if (!m_soft_body || m_soft_body->getWorldArrayIndex() == -1 || m_physics->IsExecutingCommands())
+            return false;
+
+        m_physics->AddCommand(m_soft_body, move(command));
+        return true;
+    }
 }
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =====================
+#include <functional>
 #include "IComponent.h"
 #include "..\..\Math\Vector3.h"
 #include "..\..\Math\Quaternion.h"
@@ -72,6 +73,7 @@ namespace Spartan
         void Body_Release();
         void Body_AddToWorld();
         void Body_RemoveFromWorld();
+        bool Defer(std::function<void()>&& command) const;
 
         Physics* m_physics              = nullptr;
         btSoftBody* m_soft_body         = nullptr;
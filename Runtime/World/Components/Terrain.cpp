@@ -19,19 +19,33 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ============================
+//= INCLUDES ===================================
 #include "Spartan.h"
 #include "Terrain.h"
 #include "Renderable.h"
+#include "Transform.h"
+#include "Collider.h"
 #include "..\Entity.h"
+#include "..\World.h"
 #include "..\..\RHI\RHI_Texture2D.h"
 #include "..\..\RHI\RHI_Vertex.h"
 #include "..\..\Rendering\Model.h"
 #include "..\..\IO\FileStream.h"
 #include "..\..\Resource\ResourceCache.h"
 #include "..\..\Rendering\Mesh.h"
+#include "..\..\Rendering\MeshOptimizer.h"
+#include "..\..\Rendering\MeshLod.h"
+#include "..\..\Rendering\MeshBvh.h"
+#include "..\..\Rendering\MeshSubmesh.h"
+#include "..\..\Rendering\Renderer.h"
 #include "..\..\Threading\Threading.h"
-//=======================================
+#include "..\..\Physics\Physics.h"
+#include "..\..\Core\Stopwatch.h"
+#include "..\..\Resource\Import\ImageImporter.h"
+#include "Camera.h"
+#include <array>
+#include <xmmintrin.h>
+//==============================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -40,6 +54,439 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    static const uint32_t chunk_quads       = 128;  // per side, chunks at the far end of the grid can be smaller
+    static const uint32_t chunk_lod_count   = 5;    // every level doubles the spacing of the previous one, down to 4x4 quads
+    static const float skirt_depth_min      = 0.5f;
+    static const uint32_t tile_loads_max    = 2;    // tiles that are loaded at the same time, the nearest ones go first
+
+    // A tile of a tiled height map, a worker loads its heights and builds the geometry of its chunks, then the main thread gives them entities
+    struct TerrainTile
+    {
+        std::string file_path;
+        uint32_t x = 0; // in tiles
+        uint32_t y = 0;
+        std::vector<TerrainChunk> chunks;
+        std::shared_ptr<Model> model;
+        std::vector<float> heights; // kept while the tile is resident, for the collider
+        std::vector<std::shared_ptr<Entity>> entities;
+        std::atomic<bool> is_loading = false;
+        bool has_failed = false; // it's not tried again
+    };
+
+    // A grid of heights and where it is in the terrain, which is either the whole height map or one of its tiles
+    struct HeightGrid
+    {
+        const float* heights    = nullptr;
+        uint32_t width          = 0;
+        uint32_t height         = 0;
+        uint32_t x              = 0; // the first sample, counted from the first sample of the terrain
+        uint32_t y              = 0;
+        Vector2 origin          = Vector2::Zero; // the position of the first sample of the terrain, on the X and Z axes
+        const float* apron      = nullptr; // tiles only, the heights with a ring of samples around them for the normals (see tile_apron())
+    };
+
+    // The neighbours of a tile, in the order of TileEdge::heights
+    enum TileSide : uint32_t { TileSide_Left, TileSide_Right, TileSide_Down, TileSide_Up, TileSide_Count };
+
+    // The samples of a neighbouring tile that are next to the ones the tiles share, the row or column that the normals along the shared edge need
+    struct TileEdge
+    {
+        std::string file_path;          // read by the worker that loads the tile, if the neighbour isn't resident
+        std::vector<float> heights;     // empty if there is no neighbour (the edge of the terrain)
+    };
+
+    // The estimate with a step of Newton-Raphson on top
+    static inline __m128 rsqrt_refined(const __m128 value)
+    {
+        const __m128 estimate = _mm_rsqrt_ps(value);
+        return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(value, estimate), estimate)));
+    }
+
+    static inline void normal_tangent_write(const float slope_x, const float slope_z, RHI_Vertex_PosTexNorTan& vertex)
+    {
+        const float normal_length_inverse  = 1.0f / sqrt(slope_x * slope_x + slope_z * slope_z + 1.0f);
+        const float tangent_length_inverse = 1.0f / sqrt(slope_x * slope_x + 1.0f);
+
+        vertex.nor[0] = -slope_x * normal_length_inverse;
+        vertex.nor[1] = normal_length_inverse;
+        vertex.nor[2] = -slope_z * normal_length_inverse;
+        vertex.tan[0] = tangent_length_inverse;
+        vertex.tan[1] = slope_x * tangent_length_inverse;
+        vertex.tan[2] = 0.0f;
+    }
+
+    // The normals and tangents of a row of the grid, from central differences of the heights (one sided at the borders). The surface is y = h(x, z) with a
+    // spacing of one, so the normal is (-dh/dx, 1, -dh/dz) and the tangent follows u, which increases along x, so it's (1, dh/dx, 0). Four vertices at a time.
+    // Only the columns from x_begin up to x_end are written (vertices[0] is column x_begin), which is how chunks get the same normals as their neighbours.
+    static void normals_tangents_row(const float* heights, const uint32_t width, const uint32_t height, const uint32_t y, const uint32_t x_begin, const uint32_t x_end, RHI_Vertex_PosTexNorTan* vertices)
+    {
+        const float* row        = heights + static_cast<uint64_t>(y) * width;
+        const float* row_up     = heights + static_cast<uint64_t>(y + 1 < height ? y + 1 : y) * width;
+        const float* row_down   = heights + static_cast<uint64_t>(y > 0 ? y - 1 : y) * width;
+        const float scale_z     = (y > 0 && y + 1 < height) ? 0.5f : 1.0f;
+
+        const auto write_scalar = [&](const uint32_t x)
+        {
+            const uint32_t x_left   = x > 0 ? x - 1 : x;
+            const uint32_t x_right  = x + 1 < width ? x + 1 : x;
+            const float scale_x     = x_right - x_left == 2 ? 0.5f : 1.0f;
+            normal_tangent_write((row[x_right] - row[x_left]) * scale_x, (row_up[x] - row_down[x]) * scale_z, vertices[x - x_begin]);
+        };
+
+        uint32_t x = x_begin;
+        if (x == 0)
+        {
+            write_scalar(x++);
+        }
+
+        const __m128 half       = _mm_set1_ps(0.5f);
+        const __m128 one        = _mm_set1_ps(1.0f);
+        const __m128 scale_z_4  = _mm_set1_ps(scale_z);
+        for (; x + 4 < width && x + 4 <= x_end; x += 4)
+        {
+            const __m128 slope_x    = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + x + 1), _mm_loadu_ps(row + x - 1)), half);
+            const __m128 slope_z    = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row_up + x), _mm_loadu_ps(row_down + x)), scale_z_4);
+            const __m128 slope_x_sq = _mm_mul_ps(slope_x, slope_x);
+            const __m128 normal_inv = rsqrt_refined(_mm_add_ps(_mm_add_ps(slope_x_sq, _mm_mul_ps(slope_z, slope_z)), one));
+            const __m128 tangent_inv = rsqrt_refined(_mm_add_ps(slope_x_sq, one));
+
+            alignas(16) float normal_x[4], normal_y[4], normal_z[4], tangent_x[4], tangent_y[4];
+            _mm_store_ps(normal_x, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), slope_x), normal_inv));
+            _mm_store_ps(normal_y, normal_inv);
+            _mm_store_ps(normal_z, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), slope_z), normal_inv));
+            _mm_store_ps(tangent_x, tangent_inv);
+            _mm_store_ps(tangent_y, _mm_mul_ps(slope_x, tangent_inv));
+
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                RHI_Vertex_PosTexNorTan& vertex = vertices[x - x_begin + lane];
+                vertex.nor[0] = normal_x[lane];
+                vertex.nor[1] = normal_y[lane];
+                vertex.nor[2] = normal_z[lane];
+                vertex.tan[0] = tangent_x[lane];
+                vertex.tan[1] = tangent_y[lane];
+                vertex.tan[2] = 0.0f;
+            }
+        }
+
+        for (; x < x_end; x++)
+        {
+            write_scalar(x);
+        }
+    }
+
+    // The rows (or the columns) of a chunk that a level of detail keeps, every stride-th one and the last one
+    static void lod_samples(const uint32_t quads, const uint32_t stride, vector<uint32_t>& samples)
+    {
+        samples.clear();
+        for (uint32_t i = 0; i < quads; i += stride)
+        {
+            samples.emplace_back(i);
+        }
+        samples.emplace_back(quads);
+    }
+
+    // The largest vertical distance between the full grid and a level of detail, which skips rows and columns but splits its quads the same way
+    static float lod_error(const float* heights, const uint32_t width, const TerrainChunk& chunk, const uint32_t stride)
+    {
+        thread_local vector<uint32_t> samples_x;
+        thread_local vector<uint32_t> samples_y;
+        lod_samples(chunk.quads_x, stride, samples_x);
+        lod_samples(chunk.quads_y, stride, samples_y);
+
+        const auto height_at = [heights, width, &chunk](const uint32_t x, const uint32_t y) { return heights[static_cast<uint64_t>(chunk.y + y) * width + chunk.x + x]; };
+
+        float error = 0.0f;
+        for (uint32_t j = 0; j + 1 < static_cast<uint32_t>(samples_y.size()); j++)
+        {
+            for (uint32_t i = 0; i + 1 < static_cast<uint32_t>(samples_x.size()); i++)
+            {
+                const uint32_t x0 = samples_x[i], x1 = samples_x[i + 1];
+                const uint32_t y0 = samples_y[j], y1 = samples_y[j + 1];
+
+                const float bottom_left     = height_at(x0, y0);
+                const float bottom_right    = height_at(x1, y0);
+                const float top_left        = height_at(x0, y1);
+                const float top_right       = height_at(x1, y1);
+
+                for (uint32_t y = y0; y <= y1; y++)
+                {
+                    for (uint32_t x = x0; x <= x1; x++)
+                    {
+                        // Which of the two triangles (split from bottom right to top left) the vertex is above
+                        const float u = static_cast<float>(x - x0) / static_cast<float>(x1 - x0);
+                        const float v = static_cast<float>(y - y0) / static_cast<float>(y1 - y0);
+                        const float height_level = (u + v <= 1.0f) ?
+                            bottom_left + u * (bottom_right - bottom_left) + v * (top_left - bottom_left) :
+                            top_right + (1.0f - u) * (top_left - top_right) + (1.0f - v) * (bottom_right - top_right);
+
+                        error = Helper::Max(error, Helper::Abs(height_at(x, y) - height_level));
+                    }
+                }
+            }
+        }
+
+        return error;
+    }
+
+    // The indices of a level of detail (a stride of one is the full grid), with the skirts around it. The vertices are the grid in rows, followed by
+    // the skirts of the bottom row, the top row, the left column and the right column. Skirts hang below the edges, to hide the cracks between
+    // neighbouring chunks which are at different levels.
+    static void chunk_indices(const TerrainChunk& chunk, const uint32_t stride, vector<uint32_t>& indices)
+    {
+        thread_local vector<uint32_t> samples_x;
+        thread_local vector<uint32_t> samples_y;
+        lod_samples(chunk.quads_x, stride, samples_x);
+        lod_samples(chunk.quads_y, stride, samples_y);
+
+        const uint32_t row_size     = chunk.quads_x + 1;
+        const uint32_t column_size  = chunk.quads_y + 1;
+        const auto vertex           = [row_size](const uint32_t x, const uint32_t y) { return y * row_size + x; };
+
+        for (uint32_t j = 0; j + 1 < static_cast<uint32_t>(samples_y.size()); j++)
+        {
+            for (uint32_t i = 0; i + 1 < static_cast<uint32_t>(samples_x.size()); i++)
+            {
+                const uint32_t index_bottom_left  = vertex(samples_x[i],     samples_y[j]);
+                const uint32_t index_bottom_right = vertex(samples_x[i + 1], samples_y[j]);
+                const uint32_t index_top_left     = vertex(samples_x[i],     samples_y[j + 1]);
+                const uint32_t index_top_right    = vertex(samples_x[i + 1], samples_y[j + 1]);
+
+                indices.insert(indices.end(), { index_bottom_right, index_bottom_left, index_top_left, index_bottom_right, index_top_left, index_top_right });
+            }
+        }
+
+        // An edge from a to b (a' and b' are below them) faces outwards when it's walked counter clockwise, as seen from above
+        const auto skirt = [&indices](const uint32_t a, const uint32_t b, const uint32_t a_skirt, const uint32_t b_skirt)
+        {
+            indices.insert(indices.end(), { a, b, a_skirt, b, b_skirt, a_skirt });
+        };
+
+        const uint32_t skirt_bottom = row_size * column_size;
+        const uint32_t skirt_top    = skirt_bottom + row_size;
+        const uint32_t skirt_left   = skirt_top + row_size;
+        const uint32_t skirt_right  = skirt_left + column_size;
+        for (uint32_t i = 0; i + 1 < static_cast<uint32_t>(samples_x.size()); i++)
+        {
+            const uint32_t x0 = samples_x[i], x1 = samples_x[i + 1];
+            skirt(vertex(x0, 0), vertex(x1, 0), skirt_bottom + x0, skirt_bottom + x1);
+            skirt(vertex(x1, chunk.quads_y), vertex(x0, chunk.quads_y), skirt_top + x1, skirt_top + x0);
+        }
+        for (uint32_t j = 0; j + 1 < static_cast<uint32_t>(samples_y.size()); j++)
+        {
+            const uint32_t y0 = samples_y[j], y1 = samples_y[j + 1];
+            skirt(vertex(0, y1), vertex(0, y0), skirt_left + y1, skirt_left + y0);
+            skirt(vertex(chunk.quads_x, y0), vertex(chunk.quads_x, y1), skirt_right + y0, skirt_right + y1);
+        }
+    }
+
+    // Neighbouring chunks share the vertices of their common edge
+    static void chunks_layout(const uint32_t width, const uint32_t height, vector<TerrainChunk>& chunks)
+    {
+        chunks.clear();
+        for (uint32_t y = 0; y < height - 1; y += chunk_quads)
+        {
+            for (uint32_t x = 0; x < width - 1; x += chunk_quads)
+            {
+                TerrainChunk& chunk = chunks.emplace_back();
+                chunk.x             = x;
+                chunk.y             = y;
+                chunk.quads_x       = Helper::Min(chunk_quads, width - 1 - x);
+                chunk.quads_y       = Helper::Min(chunk_quads, height - 1 - y);
+                chunk.submesh_index = static_cast<uint32_t>(chunks.size() - 1);
+                chunk.lod_count     = chunk_lod_count;
+            }
+        }
+    }
+
+    static void chunk_vertices(const HeightGrid& grid, const TerrainChunk& chunk, vector<RHI_Vertex_PosTexNorTan>& vertices, vector<float>& lod_errors)
+    {
+        // The levels only have an error if it's larger than the one of the previous level, as the renderer walks them in order
+        lod_errors.resize(chunk.lod_count);
+        for (uint32_t level = 0; level < chunk.lod_count; level++)
+        {
+            const float error_previous  = level > 0 ? lod_errors[level - 1] : 0.0f;
+            lod_errors[level]           = Helper::Max(error_previous, lod_error(grid.heights, grid.width, chunk, 2u << level));
+        }
+
+        // Neighbours are drawn at levels with a similar error on the screen, so twice the error of the coarsest level covers the gap to either of them
+        const float skirt_depth = (chunk.lod_count > 0 ? lod_errors.back() * 2.0f : 0.0f) + skirt_depth_min;
+
+        // The grid, with the texture repeating once per quad
+        const uint32_t row_size     = chunk.quads_x + 1;
+        const uint32_t column_size  = chunk.quads_y + 1;
+        vertices.resize(static_cast<uint64_t>(row_size) * column_size + 2 * row_size + 2 * column_size);
+        for (uint32_t j = 0; j < column_size; j++)
+        {
+            const uint32_t y = chunk.y + j;
+            for (uint32_t i = 0; i < row_size; i++)
+            {
+                const uint32_t x            = chunk.x + i;
+                const float x_terrain       = static_cast<float>(grid.x + x);
+                const float y_terrain       = static_cast<float>(grid.y + y);
+                const Vector3 position(grid.origin.x + x_terrain, grid.heights[static_cast<uint64_t>(y) * grid.width + x], grid.origin.y + y_terrain);
+                vertices[j * row_size + i]  = RHI_Vertex_PosTexNorTan(position, Vector2(x_terrain, y_terrain));
+            }
+
+            // The normals come from the whole grid (and the samples of the neighbouring tiles), so they match the ones of the neighbouring chunks
+            if (grid.apron)
+            {
+                normals_tangents_row(grid.apron, grid.width + 2, grid.height + 2, y + 1, chunk.x + 1, chunk.x + 1 + row_size, vertices.data() + j * row_size);
+            }
+            else
+            {
+                normals_tangents_row(grid.heights, grid.width, grid.height, y, chunk.x, chunk.x + row_size, vertices.data() + j * row_size);
+            }
+        }
+
+        // The skirts, with the normals of the edge they hang from
+        const auto skirt = [&vertices, skirt_depth](const uint32_t index_skirt, const uint32_t index_edge)
+        {
+            vertices[index_skirt]           = vertices[index_edge];
+            vertices[index_skirt].pos[1]    -= skirt_depth;
+        };
+
+        const uint32_t skirt_bottom = row_size * column_size;
+        const uint32_t skirt_top    = skirt_bottom + row_size;
+        const uint32_t skirt_left   = skirt_top + row_size;
+        const uint32_t skirt_right  = skirt_left + column_size;
+        for (uint32_t i = 0; i < row_size; i++)
+        {
+            skirt(skirt_bottom + i, i);
+            skirt(skirt_top + i, chunk.quads_y * row_size + i);
+        }
+        for (uint32_t j = 0; j < column_size; j++)
+        {
+            skirt(skirt_left + j, j * row_size);
+            skirt(skirt_right + j, j * row_size + chunk.quads_x);
+        }
+    }
+
+    // Builds the geometry of the chunks in parallel and appends it to the model (one submesh per chunk), the chunks get their level of detail offsets
+    static void chunks_build(Threading* threading, const HeightGrid& grid, vector<TerrainChunk>& chunks, Model* model, atomic<uint64_t>* progress)
+    {
+        struct ChunkGeometry
+        {
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            vector<uint32_t> indices;
+            vector<uint32_t> indices_lods;
+            vector<MeshLod> lods;
+            MeshBvhData bvh;
+        };
+
+        // Chunks are independent, only the vertex order has to stay as it is (a grid in rows followed by the skirts), so only the triangles get reordered
+        vector<ChunkGeometry> geometries(chunks.size());
+        threading->ParallelFor(static_cast<uint32_t>(chunks.size()), [&grid, &chunks, &geometries, progress](const uint32_t i)
+        {
+            const TerrainChunk& chunk   = chunks[i];
+            ChunkGeometry& geometry     = geometries[i];
+
+            vector<float> lod_errors;
+            chunk_vertices(grid, chunk, geometry.vertices, lod_errors);
+            const uint32_t vertex_count = static_cast<uint32_t>(geometry.vertices.size());
+
+            chunk_indices(chunk, 1, geometry.indices);
+            MeshOptimizer::optimize_vertex_cache_ranges(&geometry.indices, vertex_count, { 0 });
+
+            vector<uint32_t> lod_offsets;
+            for (uint32_t level = 0; level < chunk.lod_count; level++)
+            {
+                lod_offsets.emplace_back(static_cast<uint32_t>(geometry.indices_lods.size()));
+                chunk_indices(chunk, 2u << level, geometry.indices_lods);
+
+                MeshLod& lod        = geometry.lods.emplace_back();
+                lod.index_offset    = lod_offsets.back();
+                lod.index_count     = static_cast<uint32_t>(geometry.indices_lods.size()) - lod.index_offset;
+                lod.error           = lod_errors[level];
+            }
+            MeshOptimizer::optimize_vertex_cache_ranges(&geometry.indices_lods, vertex_count, lod_offsets);
+
+            MeshBvhHelper::build(geometry.vertices, geometry.indices, &geometry.bvh);
+
+            if (progress)
+            {
+                *progress += static_cast<uint64_t>(chunk.quads_x) * chunk.quads_y;
+            }
+        });
+
+        // Every chunk is a submesh of the same model, so all of them end up in a single allocation
+        for (uint32_t i = 0; i < static_cast<uint32_t>(chunks.size()); i++)
+        {
+            ChunkGeometry& geometry = geometries[i];
+            model->AppendGeometry(geometry.indices, geometry.vertices, nullptr, nullptr, &geometry.bvh);
+            model->AppendLods(geometry.indices_lods, geometry.lods, &chunks[i].lod_offset);
+            geometry = ChunkGeometry();
+        }
+        model->UpdateGeometry();
+    }
+
+    // The row or column of a neighbouring tile that is next to the samples it shares with the tile on the given side of it
+    static void tile_edge(const float* heights, const uint32_t width, const uint32_t height, const TileSide side, vector<float>* edge)
+    {
+        const bool is_column = side == TileSide_Left || side == TileSide_Right;
+        edge->resize(is_column ? height : width);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(edge->size()); i++)
+        {
+            switch (side)
+            {
+                case TileSide_Left:  (*edge)[i] = heights[static_cast<uint64_t>(i) * width + width - 2];   break;
+                case TileSide_Right: (*edge)[i] = heights[static_cast<uint64_t>(i) * width + 1];           break;
+                case TileSide_Down:  (*edge)[i] = heights[static_cast<uint64_t>(height - 2) * width + i];  break;
+                default:             (*edge)[i] = heights[static_cast<uint64_t>(width) + i];               break;
+            }
+        }
+    }
+
+    // The heights of a tile with a ring of samples around them, taken from the neighbours, so that the normals along the edges are central differences
+    // like everywhere else and match the ones of the neighbours. At the edges of the terrain the slope continues, which gives the same one sided differences
+    // as a grid that isn't tiled.
+    static void tile_apron(const vector<float>& heights, const uint32_t width, const uint32_t height, const array<TileEdge, TileSide_Count>& edges, vector<float>* apron)
+    {
+        const uint32_t apron_width = width + 2;
+        apron->assign(static_cast<uint64_t>(apron_width) * (height + 2), 0.0f);
+
+        const auto sample   = [&heights, width](const uint32_t x, const uint32_t y) { return heights[static_cast<uint64_t>(y) * width + x]; };
+        const auto at       = [apron, apron_width](const int32_t x, const int32_t y) -> float& { return (*apron)[static_cast<uint64_t>(y + 1) * apron_width + (x + 1)]; };
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            copy(heights.begin() + static_cast<uint64_t>(y) * width, heights.begin() + static_cast<uint64_t>(y + 1) * width, &at(0, y));
+
+            const vector<float>& left   = edges[TileSide_Left].heights;
+            const vector<float>& right  = edges[TileSide_Right].heights;
+            at(-1, y)                   = left.empty()  ? 2.0f * sample(0, y) - sample(1, y)                 : left[y];
+            at(width, y)                = right.empty() ? 2.0f * sample(width - 1, y) - sample(width - 2, y) : right[y];
+        }
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const vector<float>& down   = edges[TileSide_Down].heights;
+            const vector<float>& up     = edges[TileSide_Up].heights;
+            at(x, -1)                   = down.empty() ? 2.0f * sample(x, 0) - sample(x, 1)                    : down[x];
+            at(x, height)               = up.empty()   ? 2.0f * sample(x, height - 1) - sample(x, height - 2)  : up[x];
+        }
+    }
+
+    // Tiles are named <x>_<y>, anything can come before that
+    static bool tile_coordinates(const string& name, uint32_t* x, uint32_t* y)
+    {
+        const auto is_number = [](const string& text) { return !text.empty() && all_of(text.begin(), text.end(), [](const char c) { return c >= '0' && c <= '9'; }); };
+
+        const size_t split_y = name.rfind('_');
+        if (split_y == string::npos || split_y == 0)
+            return false;
+
+        const size_t split_x    = name.rfind('_', split_y - 1);
+        const string text_x     = name.substr(split_x == string::npos ? 0 : split_x + 1, split_x == string::npos ? split_y : split_y - split_x - 1);
+        const string text_y     = name.substr(split_y + 1);
+        if (!is_number(text_x) || !is_number(text_y))
+            return false;
+
+        *x = static_cast<uint32_t>(stoul(text_x));
+        *y = static_cast<uint32_t>(stoul(text_y));
+        return true;
+    }
+
     Terrain::Terrain(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
     {
         
@@ -50,11 +497,33 @@ namespace Spartan
         
     }
 
+    void Terrain::OnTick(float delta_time)
+    {
+        // The entities that drew these were removed during the previous tick
+        m_tile_models_retired.clear();
+
+        // Entities can only be created on the main thread, so the chunks of a terrain that was generated get them here
+        if (m_chunks_dirty.exchange(false))
+        {
+            UpdateFromChunks();
+        }
+
+        if (!m_tiles.empty())
+        {
+            TilesUpdate();
+        }
+    }
+
+    void Terrain::OnRemove()
+    {
+        TilesClear();
+    }
+
     void Terrain::Serialize(FileStream* stream)
     {
         const string no_path;
 
-        stream->Write(m_height_map ? m_height_map->GetResourceFilePathNative() : no_path);
+        stream->Write(m_height_map_path);
         stream->Write(m_model ? m_model->GetResourceName() : no_path);
         stream->Write(m_min_y);
         stream->Write(m_max_y);
@@ -63,18 +532,45 @@ namespace Spartan
     void Terrain::Deserialize(FileStream* stream)
     {
         ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
-        m_height_map    = resource_cache->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
-        m_model         = resource_cache->GetByName<Model>(stream->ReadAs<string>());
+        m_height_map_path   = stream->ReadAs<string>();
+        m_model             = resource_cache->GetByName<Model>(stream->ReadAs<string>());
         stream->Read(&m_min_y);
         stream->Read(&m_max_y);
 
-        UpdateFromModel(m_model);
+        // Tiles are streamed in again, they aren't saved
+        if (FileSystem::IsDirectory(m_height_map_path))
+        {
+            TilesScan();
+            return;
+        }
+
+        m_height_map = resource_cache->GetByPath<RHI_Texture2D>(m_height_map_path);
+
+        // The chunk entities are deserialized as children, only the heights and the chunk layout (for editing) have to be restored
+        if (m_model && !ChunksFromModel())
+        {
+            LOG_WARNING("The terrain was generated before it was split into chunks, generate it again to be able to edit it.");
+        }
+
+        ColliderUpdate();
     }
 
     void Terrain::SetHeightMap(const shared_ptr<RHI_Texture2D>& height_map)
     {
         // In order for the component to guarantee serialization/deserialization, we cache the height_map
-        m_height_map = m_context->GetSubsystem<ResourceCache>()->Cache<RHI_Texture2D>(height_map);
+        m_height_map        = m_context->GetSubsystem<ResourceCache>()->Cache<RHI_Texture2D>(height_map);
+        m_height_map_path   = m_height_map ? m_height_map->GetResourceFilePathNative() : string();
+    }
+
+    void Terrain::SetHeightMap(const string& path)
+    {
+        m_height_map.reset();
+        m_height_map_path = path;
+    }
+
+    uint32_t Terrain::GetTilesResident() const
+    {
+        return static_cast<uint32_t>(count_if(m_tiles.begin(), m_tiles.end(), [](const shared_ptr<TerrainTile>& tile) { return !tile->entities.empty(); }));
     }
 
     void Terrain::GenerateAsync()
@@ -85,63 +581,51 @@ namespace Spartan
             return;
         }
 
-        if (!m_height_map)
+        // A tiled terrain starts over, the tiles are streamed in with the current settings
+        TilesClear();
+        if (FileSystem::IsDirectory(m_height_map_path))
+        {
+            ChunksRemove();
+            m_chunks.clear();
+            m_heights.clear();
+            m_context->GetSubsystem<ResourceCache>()->Remove(m_model);
+            m_model.reset();
+            ColliderUpdate();
+
+            TilesScan();
+            return;
+        }
+
+        if (!m_height_map && m_height_map_path.empty())
         {
             LOG_WARNING("You need to assign a height map before trying to generate a terrain.");
 
+            ChunksRemove();
+            m_chunks.clear();
+            m_heights.clear();
             m_context->GetSubsystem<ResourceCache>()->Remove(m_model);
             m_model.reset();
-            if (Renderable* renderable = m_entity->AddComponent<Renderable>())
-            {
-                renderable->GeometryClear();
-            }
-            
+            ColliderUpdate();
+
             return;
         }
 
+        // The heights are about to be written by a worker, so the collider lets go of them until the chunks are created (see UpdateFromChunks())
+        m_is_generating = true;
+        ColliderUpdate();
+
         m_context->GetSubsystem<Threading>()->AddTask([this]()
         {
-            m_is_generating = true;
-
-            // Get height map data
-            const vector<std::byte> height_map_data = m_height_map->GetOrLoadMip(0);
-            if (height_map_data.empty())
+            // Read the height map
+            m_progress_desc         = "Generating heights...";
+            m_progress_jobs_done    = 0;
+            m_progress_job_count    = 1;
+            bool is_generated       = false;
+            if (GenerateHeights(m_heights))
             {
-                LOG_ERROR("Height map has no data");
-            }
-
-            // Deduce some stuff
-            m_height                            = m_height_map->GetHeight();
-            m_width                             = m_height_map->GetWidth();
-            m_vertex_count                      = m_height * m_width;
-            m_face_count                        = (m_height - 1) * (m_width - 1) * 2;
-            m_progress_jobs_done                = 0;
-            m_progress_job_count                = m_vertex_count * 2 + m_face_count + m_vertex_count * m_face_count;
-
-            // Pre-allocate memory for the calculations that follow
-            vector<Vector3> positions                 = vector<Vector3>(m_height * m_width);
-            vector<RHI_Vertex_PosTexNorTan> vertices  = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
-            vector<uint32_t> indices                  = vector<uint32_t>(m_face_count * 3);
-
-            // Read height map and construct positions
-            m_progress_desc = "Generating positions...";
-            if (GeneratePositions(positions, height_map_data))
-            {
-                // Compute the vertices (without the normals) and the indices
-                m_progress_desc = "Generating terrain vertices and indices...";
-                if (GenerateVerticesIndices(positions, indices, vertices))
-                {
-                    m_progress_desc = "Generating normals and tangents...";
-                    positions.clear();
-                    positions.shrink_to_fit();
-
-                    // Compute the normals by doing normal averaging (very expensive)
-                    if (GenerateNormalTangents(indices, vertices))
-                    {
-                        // Create a model and set it to the renderable component
-                        UpdateFromVertices(indices, vertices);
-                    }
-                }
+                // Split the grid into chunks, each with its own submesh and levels of detail
+                m_progress_desc = "Generating terrain chunks...";
+                is_generated    = GenerateChunks();
             }
 
             // Clear progress stats
@@ -149,286 +633,699 @@ namespace Spartan
             m_progress_job_count = 1;
             m_progress_desc.clear();
 
+            // Done before the chunks are flagged, so that the collider gets the heights when they are created
             m_is_generating = false;
+            m_chunks_dirty  = is_generated;
         });
     }
 
-    bool Terrain::GeneratePositions(vector<Vector3>& positions, const vector<std::byte>& height_map)
+    void Terrain::SetHeights(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const float* heights)
     {
-        if (height_map.empty())
+        if (m_is_generating)
         {
-            LOG_ERROR("Height map is empty");
-            return false;
+            LOG_WARNING("Terrain is being generated, please wait...");
+            return;
+        }
+
+        if (!m_tiles.empty())
+        {
+            LOG_WARNING("The heights of a tiled terrain come from its tiles, edit them instead.");
+            return;
+        }
+
+        if (!heights || !m_model || m_heights.empty() || width == 0 || height == 0 || x + width > m_width || y + height > m_height)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
         }
 
-        uint32_t index  = 0;
-        uint32_t k      = 0;
+        // The heightfield collider reads the heights while the world is being stepped
+        m_context->GetSubsystem<Physics>()->WaitForSimulation();
 
-        for (uint32_t y = 0; y < m_height; y++)
+        for (uint32_t row = 0; row < height; row++)
         {
-            for (uint32_t x = 0; x < m_width; x++)
+            copy(heights + static_cast<uint64_t>(row) * width, heights + static_cast<uint64_t>(row + 1) * width, m_heights.begin() + static_cast<uint64_t>(y + row) * m_width + x);
+        }
+
+        if (Collider* collider = m_entity->GetComponent<Collider>())
+        {
+            collider->HeightfieldUpdateHeights(x, y, width, height);
+        }
+
+        // The normals of the vertices around the rectangle change too, so any chunk which has one of them has to be regenerated
+        const uint32_t x_min = x > 0 ? x - 1 : 0;
+        const uint32_t y_min = y > 0 ? y - 1 : 0;
+        const uint32_t x_max = Helper::Min(x + width, m_width - 1);
+        const uint32_t y_max = Helper::Min(y + height, m_height - 1);
+
+        vector<const TerrainChunk*> chunks;
+        for (const TerrainChunk& chunk : m_chunks)
+        {
+            if (chunk.x <= x_max && chunk.x + chunk.quads_x >= x_min && chunk.y <= y_max && chunk.y + chunk.quads_y >= y_min)
             {
-                // Read height and scale it to a [0, 1] range
-                const float height = (static_cast<float>(height_map[k]) / 255.0f);
+                chunks.emplace_back(&chunk);
+            }
+        }
+
+        struct ChunkUpdate
+        {
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            vector<float> lod_errors;
+            MeshBvhData bvh;
+        };
+
+        // The topology doesn't change, so the bvhs are built with the indices that the chunks already have
+        HeightGrid grid;
+        grid.heights    = m_heights.data();
+        grid.width      = m_width;
+        grid.height     = m_height;
+        grid.origin     = Vector2(m_width * -0.5f, m_height * -0.5f);
+
+        vector<ChunkUpdate> updates(chunks.size());
+        m_context->GetSubsystem<Threading>()->ParallelFor(static_cast<uint32_t>(chunks.size()), [this, &grid, &chunks, &updates](const uint32_t i)
+        {
+            const TerrainChunk& chunk   = *chunks[i];
+            ChunkUpdate& update         = updates[i];
+            chunk_vertices(grid, chunk, update.vertices, update.lod_errors);
+
+            const MeshSubmesh& submesh = m_model->GetSubmeshes()[chunk.submesh_index];
+            vector<uint32_t> indices;
+            m_model->GetGeometry(submesh.index_offset, submesh.index_count, submesh.vertex_offset, submesh.vertex_count, &indices, nullptr);
+            MeshBvhHelper::build(update.vertices, indices, &update.bvh);
+        });
 
-                // Construct position
-                const uint32_t index  = y * m_width + x;
-                positions[index].x    = static_cast<float>(x) - m_width * 0.5f;     // center on the X axis
-                positions[index].z    = static_cast<float>(y) - m_height * 0.5f;    // center on the Z axis
-                positions[index].y    = Helper::Lerp(m_min_y, m_max_y, height);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(chunks.size()); i++)
+        {
+            const TerrainChunk& chunk   = *chunks[i];
+            const ChunkUpdate& update   = updates[i];
 
-                k += 4;
+            m_model->UpdateVertices(chunk.submesh_index, update.vertices, &update.bvh);
+            for (uint32_t level = 0; level < chunk.lod_count; level++)
+            {
+                m_model->SetLodError(chunk.lod_offset + level, update.lod_errors[level]);
+            }
 
-                // track progress
-                m_progress_jobs_done++;
+            // The bounding box that the chunk is culled with
+            if (Renderable* renderable = ChunkGetRenderable(chunk))
+            {
+                const MeshSubmesh& submesh = m_model->GetSubmeshes()[chunk.submesh_index];
+                renderable->GeometrySet(
+                    renderable->GeometryName(),
+                    submesh.index_offset,
+                    submesh.index_count,
+                    submesh.vertex_offset,
+                    submesh.vertex_count,
+                    submesh.aabb,
+                    m_model.get(),
+                    0,
+                    0,
+                    chunk.lod_offset,
+                    chunk.lod_count
+                );
             }
         }
+    }
 
-        return true;
+    void Terrain::GetHeightBlocks(vector<TerrainHeightBlock>& blocks) const
+    {
+        blocks.clear();
+
+        if (m_is_generating)
+            return;
+
+        const Vector2 origin = Vector2(m_width * -0.5f, m_height * -0.5f);
+
+        if (m_tiles.empty())
+        {
+            if (!m_heights.empty())
+            {
+                TerrainHeightBlock& block   = blocks.emplace_back();
+                block.heights               = m_heights.data();
+                block.width                 = m_width;
+                block.height                = m_height;
+                block.position              = origin;
+            }
+
+            return;
+        }
+
+        // The tiles that have their entities, the ones that are still loading can't be referenced yet
+        for (const shared_ptr<TerrainTile>& tile : m_tiles)
+        {
+            if (tile->entities.empty() || tile->heights.empty())
+                continue;
+
+            TerrainHeightBlock& block   = blocks.emplace_back();
+            block.heights               = tile->heights.data();
+            block.width                 = m_tile_width;
+            block.height                = m_tile_height;
+            block.x                     = tile->x * (m_tile_width - 1);
+            block.y                     = tile->y * (m_tile_height - 1);
+            block.position              = origin + Vector2(static_cast<float>(block.x), static_cast<float>(block.y));
+        }
     }
 
-    bool Terrain::GenerateVerticesIndices(const vector<Vector3>& positions, vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    bool Terrain::GenerateHeights(vector<float>& heights)
     {
-        if (positions.empty())
+        // The file keeps the full precision of the height map, the texture only has 8 bits per channel (unless it's a float one)
+        ImageImporter* importer = m_context->GetSubsystem<ResourceCache>()->GetImageImporter();
+        if (!FileSystem::IsFile(m_height_map_path) || !importer->LoadHeightMap(m_height_map_path, &heights, &m_width, &m_height))
+        {
+            if (!m_height_map)
+                return false;
+
+            const vector<std::byte> height_map = m_height_map->GetOrLoadMip(0);
+            const uint32_t bytes_per_channel    = m_height_map->GetBytesPerChannel();
+            const uint32_t bytes_per_texel      = bytes_per_channel * m_height_map->GetChannelCount();
+            m_width                             = m_height_map->GetWidth();
+            m_height                            = m_height_map->GetHeight();
+            const uint64_t texel_count          = static_cast<uint64_t>(m_width) * m_height;
+
+            if (height_map.size() < texel_count * bytes_per_texel || (bytes_per_channel != 1 && bytes_per_channel != 4))
+            {
+                LOG_ERROR("Height map is empty or in an unsupported format");
+                return false;
+            }
+
+            // The first channel, scaled to a [0, 1] range if it's an integer one
+            heights.resize(texel_count);
+            for (uint64_t index = 0; index < texel_count; index++)
+            {
+                const std::byte* texel = height_map.data() + index * bytes_per_texel;
+                if (bytes_per_channel == 4)
+                {
+                    memcpy(&heights[index], texel, sizeof(float));
+                }
+                else
+                {
+                    heights[index] = static_cast<float>(to_integer<uint8_t>(texel[0])) / 255.0f;
+                }
+            }
+        }
+
+        if (m_width < 2 || m_height < 2)
         {
-            LOG_ERROR("Positions are empty");
+            LOG_ERROR("The height map has to be at least 2x2");
             return false;
         }
 
-        uint32_t index      = 0;
-        uint32_t k          = 0;
-        uint32_t u_index    = 0;
-        uint32_t v_index    = 0;
+        m_vertex_count          = static_cast<uint64_t>(m_height) * m_width;
+        m_face_count            = static_cast<uint64_t>(m_height - 1) * (m_width - 1) * 2;
+        m_progress_job_count    = m_vertex_count + m_face_count / 2;
 
-        for (uint32_t y = 0; y < m_height - 1; y++)
+        for (float& height : heights)
         {
-            for (uint32_t x = 0; x < m_width - 1; x++)
+            height = Helper::Lerp(m_min_y, m_max_y, height);
+        }
+        m_progress_jobs_done += m_vertex_count;
+
+        return true;
+    }
+
+    bool Terrain::GenerateChunks()
+    {
+        chunks_layout(m_width, m_height, m_chunks);
+
+        const bool is_new = !m_model;
+        if (is_new)
+        {
+            m_model = make_shared<Model>(m_context);
+        }
+        else
+        {
+            m_model->Clear();
+        }
+
+        // Centered on the X and Z axes
+        HeightGrid grid;
+        grid.heights    = m_heights.data();
+        grid.width      = m_width;
+        grid.height     = m_height;
+        grid.origin     = Vector2(m_width * -0.5f, m_height * -0.5f);
+        chunks_build(m_context->GetSubsystem<Threading>(), grid, m_chunks, m_model.get(), &m_progress_jobs_done);
+
+        if (is_new)
+        {
+            // Set a file path so the model can be used by the resource cache
+            ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
+            m_model->SetResourceFilePath(resource_cache->GetProjectDirectory() + m_entity->GetName() + "_terrain_" + to_string(m_id) + string(EXTENSION_MODEL));
+            m_model = resource_cache->Cache(m_model);
+        }
+
+        return true;
+    }
+
+    void Terrain::Benchmark()
+    {
+        Threading* threading = m_context->GetSubsystem<Threading>();
+
+        for (uint32_t size = 1024; size <= 8192; size *= 2)
+        {
+            // Rolling hills, so that the slopes vary
+            vector<float> heights(static_cast<uint64_t>(size) * size);
+            for (uint32_t y = 0; y < size; y++)
             {
-                const uint32_t index_bottom_left  = y * m_width + x;
-                const uint32_t index_bottom_right = y * m_width + x + 1;
-                const uint32_t index_top_left     = (y + 1) * m_width + x;
-                const uint32_t index_top_right    = (y + 1) * m_width + x + 1;
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    heights[static_cast<uint64_t>(y) * size + x] = sin(x * 0.05f) * cos(y * 0.03f) * 10.0f;
+                }
+            }
 
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k]      = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
+            // The rows are written to a scratch row per thread, as the vertices of an 8K grid alone would take about 3 GB
+            const Stopwatch timer;
+            threading->ParallelFor(size, [&heights, size](const uint32_t y)
+            {
+                thread_local vector<RHI_Vertex_PosTexNorTan> row;
+                row.resize(size);
+                normals_tangents_row(heights.data(), size, size, y, 0, size, row.data());
+            });
+            const double duration_ms = timer.GetElapsedTimeMs();
+
+            const double vertex_count = static_cast<double>(size) * static_cast<double>(size);
+            LOG_INFO("Terrain normals and tangents, %dx%d: %.2f ms, %.2f ns per vertex", size, size, duration_ms, duration_ms * 1000000.0 / vertex_count);
+        }
+    }
 
-                // Bottom left of quad
-                index           = index_bottom_left;
-                indices[k + 1]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 1.0f));
+    void Terrain::UpdateFromChunks()
+    {
+        if (!m_model)
+            return;
 
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 2]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
+        ChunksRemove();
+        ChunksCreate(m_model.get(), m_chunks, m_entity->GetName() + "_chunk_", false);
+        ColliderUpdate();
+    }
 
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k + 3]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
+    void Terrain::ChunksCreate(Model* model, const vector<TerrainChunk>& chunks, const string& name, const bool is_transient, vector<shared_ptr<Entity>>* entities) const
+    {
+        // Every chunk is drawn (and culled) on its own, by a child entity
+        World* world = m_context->GetSubsystem<World>();
+        const vector<MeshSubmesh>& submeshes = model->GetSubmeshes();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(chunks.size()); i++)
+        {
+            const TerrainChunk& chunk   = chunks[i];
+            const MeshSubmesh& submesh  = submeshes[chunk.submesh_index];
+
+            shared_ptr<Entity> entity = world->EntityCreate();
+            entity->SetName(name + to_string(i));
+            entity->SetHierarchyVisibility(false);
+            entity->SetTransient(is_transient);
+            entity->GetTransform()->SetParent(m_entity->GetTransform());
+
+            if (Renderable* renderable = entity->AddComponent<Renderable>())
+            {
+                renderable->GeometrySet(
+                    "Terrain_Chunk",
+                    submesh.index_offset,
+                    submesh.index_count,
+                    submesh.vertex_offset,
+                    submesh.vertex_count,
+                    submesh.aabb,
+                    model,
+                    0,
+                    0,
+                    chunk.lod_offset,
+                    chunk.lod_count
+                );
+
+                renderable->UseDefaultMaterial();
+            }
+
+            if (entities)
+            {
+                entities->emplace_back(entity);
+            }
+        }
+    }
 
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 4]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
+    bool Terrain::ChunksFromModel()
+    {
+        m_chunks.clear();
+        m_heights.clear();
 
-                // Top right of quad
-                index           = index_top_right;
-                indices[k + 5]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 0.0f));
+        // The grid is centered, so its size is the size of the model (the skirts only go down)
+        const Vector3 size  = m_model->GetAabb().GetSize();
+        m_width             = static_cast<uint32_t>(Helper::Round(size.x)) + 1;
+        m_height            = static_cast<uint32_t>(Helper::Round(size.z)) + 1;
+        m_heights.resize(static_cast<uint64_t>(m_width) * m_height);
 
-                k += 6; // next quad
+        const vector<MeshSubmesh>& submeshes    = m_model->GetSubmeshes();
+        const bool has_lods                     = m_model->GetLods().size() == submeshes.size() * chunk_lod_count;
 
-                u_index++;
+        vector<uint32_t> indices;
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(submeshes.size()); i++)
+        {
+            const MeshSubmesh& submesh = submeshes[i];
+            m_model->GetGeometry(submesh.index_offset, submesh.index_count, submesh.vertex_offset, submesh.vertex_count, &indices, &vertices);
+            if (vertices.size() < 4)
+                break;
+
+            // The first row is as long as the vertices with the same z
+            uint32_t row_size = 1;
+            while (row_size < vertices.size() && vertices[row_size].pos[2] == vertices[0].pos[2])
+            {
+                row_size++;
+            }
 
-                // track progress
-                m_progress_jobs_done++;
+            // The grid is followed by two rows and two columns of skirts
+            const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+            if (vertex_count <= 2 * row_size || (vertex_count - 2 * row_size) % (row_size + 2) != 0)
+                break;
+            const uint32_t column_size = (vertex_count - 2 * row_size) / (row_size + 2);
+
+            TerrainChunk chunk;
+            chunk.x             = static_cast<uint32_t>(Helper::Round(vertices[0].pos[0] + m_width * 0.5f));
+            chunk.y             = static_cast<uint32_t>(Helper::Round(vertices[0].pos[2] + m_height * 0.5f));
+            chunk.quads_x       = row_size - 1;
+            chunk.quads_y       = column_size - 1;
+            chunk.submesh_index = i;
+            chunk.lod_offset    = has_lods ? i * chunk_lod_count : 0;
+            chunk.lod_count     = has_lods ? chunk_lod_count : 0;
+
+            // A vertex cache optimized grid (terrains from before the chunks) won't be in rows
+            const RHI_Vertex_PosTexNorTan& vertex_last = vertices[row_size * column_size - 1];
+            const bool is_grid =
+                chunk.x + chunk.quads_x < m_width && chunk.y + chunk.quads_y < m_height &&
+                vertex_last.pos[0] == vertices[0].pos[0] + chunk.quads_x &&
+                vertex_last.pos[2] == vertices[0].pos[2] + chunk.quads_y;
+            if (!is_grid)
+                break;
+
+            for (uint32_t j = 0; j < column_size; j++)
+            {
+                for (uint32_t k = 0; k < row_size; k++)
+                {
+                    m_heights[static_cast<uint64_t>(chunk.y + j) * m_width + chunk.x + k] = vertices[j * row_size + k].pos[1];
+                }
             }
-            u_index = 0;
-            v_index++;
+
+            m_chunks.emplace_back(chunk);
         }
 
+        if (m_chunks.size() != submeshes.size())
+        {
+            m_chunks.clear();
+            m_heights.clear();
+            m_width     = 0;
+            m_height    = 0;
+            return false;
+        }
+
+        m_vertex_count  = static_cast<uint64_t>(m_width) * m_height;
+        m_face_count    = static_cast<uint64_t>(m_height - 1) * (m_width - 1) * 2;
+
         return true;
     }
 
-    bool Terrain::GenerateNormalTangents(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    void Terrain::ChunksRemove()
+    {
+        // Terrains from before the chunks were drawn by a renderable on the terrain entity itself
+        if (m_entity->HasComponent<Renderable>())
+        {
+            m_entity->RemoveComponent<Renderable>();
+        }
+
+        if (!m_model)
+            return;
+
+        // Removing an entity detaches it from its parent, so iterate over a copy
+        World* world = m_context->GetSubsystem<World>();
+        const vector<Transform*> children = m_entity->GetTransform()->GetChildren();
+        for (Transform* child : children)
+        {
+            Entity* entity = child->GetEntity();
+            Renderable* renderable = entity ? entity->GetComponent<Renderable>() : nullptr;
+            if (renderable && renderable->GeometryModel() == m_model.get())
+            {
+                world->EntityRemove(entity->GetPtrShared());
+            }
+        }
+    }
+
+    Renderable* Terrain::ChunkGetRenderable(const TerrainChunk& chunk) const
+    {
+        const uint32_t vertex_offset = m_model->GetSubmeshes()[chunk.submesh_index].vertex_offset;
+
+        for (Transform* child : m_entity->GetTransform()->GetChildren())
+        {
+            Entity* entity = child->GetEntity();
+            Renderable* renderable = entity ? entity->GetComponent<Renderable>() : nullptr;
+            if (renderable && renderable->GeometryModel() == m_model.get() && renderable->GeometryVertexOffset() == vertex_offset)
+                return renderable;
+        }
+
+        return nullptr;
+    }
+
+    bool Terrain::TilesScan()
     {
-        if (indices.empty())
+        TilesClear();
+
+        uint32_t tile_count_x = 0;
+        uint32_t tile_count_y = 0;
+        for (const string& file_path : FileSystem::GetFilesInDirectory(m_height_map_path))
         {
-            LOG_ERROR("Indices are empty");
+            uint32_t x = 0;
+            uint32_t y = 0;
+            if (!tile_coordinates(FileSystem::GetFileNameNoExtensionFromFilePath(file_path), &x, &y))
+                continue;
+
+            shared_ptr<TerrainTile> tile = m_tiles.emplace_back(make_shared<TerrainTile>());
+            tile->file_path = file_path;
+            tile->x         = x;
+            tile->y         = y;
+            tile_count_x    = Helper::Max(tile_count_x, x + 1);
+            tile_count_y    = Helper::Max(tile_count_y, y + 1);
+        }
+
+        if (m_tiles.empty())
+        {
+            LOG_ERROR("\"%s\" has no tiles, they have to be named <x>_<y>", m_height_map_path.c_str());
             return false;
         }
 
-        if (vertices.empty())
+        // All the tiles have the size of the first one
+        vector<float> heights;
+        if (!m_context->GetSubsystem<ResourceCache>()->GetImageImporter()->LoadHeightMap(m_tiles.front()->file_path, &heights, &m_tile_width, &m_tile_height) || m_tile_width < 2 || m_tile_height < 2)
         {
-            LOG_ERROR("Vertices are empty");
+            m_tiles.clear();
             return false;
         }
 
-        // Normals are computed by normal averaging, which can be crazy slow
-        uint32_t face_count     = static_cast<uint32_t>(indices.size()) / 3;
-        uint32_t vertex_count   = static_cast<uint32_t>(vertices.size());
+        // Neighbouring tiles share their edge samples
+        m_width         = tile_count_x * (m_tile_width - 1) + 1;
+        m_height        = tile_count_y * (m_tile_height - 1) + 1;
+        m_vertex_count  = static_cast<uint64_t>(m_width) * m_height;
+        m_face_count    = static_cast<uint64_t>(m_height - 1) * (m_width - 1) * 2;
+
+        return true;
+    }
+
+    void Terrain::TilesUpdate()
+    {
+        const shared_ptr<Camera>& camera = m_context->GetSubsystem<Renderer>()->GetCamera();
+        if (!camera)
+            return;
 
-        // Compute face normals and tangents
-        vector<Vector3> face_normals(face_count);
-        vector<Vector3> face_tangents(face_count);
+        // The camera in the space of the terrain, where the tiles are laid out from the centered first sample
+        const Vector3 camera_position   = camera->GetTransform()->GetPosition() * m_entity->GetTransform()->GetMatrix().Inverted();
+        const Vector2 origin            = Vector2(m_width * -0.5f, m_height * -0.5f);
+        const float tile_size_x         = static_cast<float>(m_tile_width - 1);
+        const float tile_size_y         = static_cast<float>(m_tile_height - 1);
+        const float distance_out        = m_streaming_distance * 1.25f;
+
+        const auto distance_to = [&](const TerrainTile& tile)
         {
-            for (uint32_t i = 0; i < face_count; ++i)
+            const float min_x   = origin.x + tile.x * tile_size_x;
+            const float min_y   = origin.y + tile.y * tile_size_y;
+            const float delta_x = Helper::Max(Helper::Max(min_x - camera_position.x, camera_position.x - (min_x + tile_size_x)), 0.0f);
+            const float delta_y = Helper::Max(Helper::Max(min_y - camera_position.z, camera_position.z - (min_y + tile_size_y)), 0.0f);
+            return sqrt(delta_x * delta_x + delta_y * delta_y);
+        };
+
+        World* world = m_context->GetSubsystem<World>();
+        vector<pair<float, TerrainTile*>> candidates;
+        vector<vector<float>> heights_evicted; // alive until the collider has let go of them
+        bool is_resident_dirty = false;
+        uint32_t loads_pending = 0;
+        for (const shared_ptr<TerrainTile>& tile : m_tiles)
+        {
+            if (tile->is_loading || tile->has_failed)
             {
-                Vector3 edge_a;
-                Vector3 edge_b;
+                loads_pending += tile->is_loading ? 1 : 0;
+                continue;
+            }
 
-                // Normal
-                {
-                    // Get the vector describing one edge of our triangle (edge 0, 1)
-                    edge_a = Vector3(
-                        vertices[indices[(i * 3)]].pos[0] - vertices[indices[(i * 3) + 1]].pos[0],
-                        vertices[indices[(i * 3)]].pos[1] - vertices[indices[(i * 3) + 1]].pos[1],
-                        vertices[indices[(i * 3)]].pos[2] - vertices[indices[(i * 3) + 1]].pos[2]
-                    );
-
-                    // Get the vector describing another edge of our triangle (edge 2,1)
-                    edge_b = Vector3(
-                        vertices[indices[(i * 3) + 1]].pos[0] - vertices[indices[(i * 3) + 2]].pos[0],
-                        vertices[indices[(i * 3) + 1]].pos[1] - vertices[indices[(i * 3) + 2]].pos[1],
-                        vertices[indices[(i * 3) + 1]].pos[2] - vertices[indices[(i * 3) + 2]].pos[2]
-                    );
-
-                    // Cross multiply the two edge vectors to get the unnormalized face normal
-                    face_normals[i] = Vector3::Cross(edge_a, edge_b);
-                }
+            const float distance = distance_to(*tile);
 
-                // Tangent
+            // Too far, the chunks go (a tile that was loaded but never got its entities goes too)
+            if (tile->model && distance > distance_out)
+            {
+                for (const shared_ptr<Entity>& entity : tile->entities)
                 {
-                    // find first texture coordinate edge 2d vector
-                    const float tcU1 = vertices[indices[(i * 3)]].tex[0] - vertices[indices[(i * 3) + 1]].tex[0];
-                    const float tcV1 = vertices[indices[(i * 3)]].tex[1] - vertices[indices[(i * 3) + 1]].tex[1];
-
-                    // find second texture coordinate edge 2d vector
-                    const float tcU2 = vertices[indices[(i * 3) + 1]].tex[0] - vertices[indices[(i * 3) + 2]].tex[0];
-                    const float tcV2 = vertices[indices[(i * 3) + 1]].tex[1] - vertices[indices[(i * 3) + 2]].tex[1];
-
-                    // find tangent using both tex coord edges and position edges
-                    face_tangents[i].x = (tcV1 * edge_a.x - tcV2 * edge_b.x * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].y = (tcV1 * edge_a.y - tcV2 * edge_b.y * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].z = (tcV1 * edge_a.z - tcV2 * edge_b.z * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
+                    world->EntityRemove(entity);
                 }
+                tile->entities.clear();
+                tile->chunks.clear();
+                m_tile_models_retired.emplace_back(move(tile->model));
+                heights_evicted.emplace_back(move(tile->heights));
+                tile->heights.clear();
+                is_resident_dirty = true;
+                continue;
+            }
 
-                // track progress
-                m_progress_jobs_done++;
+            // Loaded, the chunks get their entities
+            if (tile->model && tile->entities.empty())
+            {
+                ChunksCreate(tile->model.get(), tile->chunks, m_entity->GetName() + "_tile_" + to_string(tile->x) + "_" + to_string(tile->y) + "_chunk_", true, &tile->entities);
+                is_resident_dirty = true;
+                continue;
+            }
+
+            if (!tile->model && distance <= m_streaming_distance)
+            {
+                candidates.emplace_back(distance, tile.get());
             }
         }
 
-        
-        // Compute vertex normals and tangents (normals averaging) - This is very expensive show we split it into multiple threads below
-        const auto compute_vertex_normals_tangents = [this, &face_normals , &face_tangents, &vertices, &indices, &vertex_count, &face_count](uint32_t i_start, uint32_t i_end)
+        if (is_resident_dirty)
+        {
+            ColliderUpdate();
+        }
+
+        // The nearest tiles are loaded first, a few at a time
+        sort(candidates.begin(), candidates.end(), [](const pair<float, TerrainTile*>& a, const pair<float, TerrainTile*>& b) { return a.first < b.first; });
+
+        Threading* threading    = m_context->GetSubsystem<Threading>();
+        ImageImporter* importer = m_context->GetSubsystem<ResourceCache>()->GetImageImporter();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(candidates.size()) && loads_pending < tile_loads_max; i++, loads_pending++)
         {
-            Vector3 normal_sum  = Vector3::Zero;
-            Vector3 tangent_sum = Vector3::Zero;
-            float faces_using   = 0;
+            shared_ptr<TerrainTile> tile;
+            for (const shared_ptr<TerrainTile>& tile_candidate : m_tiles)
+            {
+                if (tile_candidate.get() == candidates[i].second)
+                {
+                    tile = tile_candidate;
+                    break;
+                }
+            }
+
+            // The task holds on to the tile, so a tile that is cleared while loading, is simply dropped when it finishes
+            HeightGrid grid;
+            grid.width      = m_tile_width;
+            grid.height     = m_tile_height;
+            grid.x          = tile->x * (m_tile_width - 1);
+            grid.y          = tile->y * (m_tile_height - 1);
+            grid.origin     = origin;
+
+            // The edges of the neighbours that are resident are copied now, the worker reads the rest from their files
+            array<TileEdge, TileSide_Count> edges;
+            for (const shared_ptr<TerrainTile>& neighbour : m_tiles)
+            {
+                TileSide side = TileSide_Count;
+                side = (neighbour->x + 1 == tile->x && neighbour->y == tile->y) ? TileSide_Left  : side;
+                side = (neighbour->x == tile->x + 1 && neighbour->y == tile->y) ? TileSide_Right : side;
+                side = (neighbour->x == tile->x && neighbour->y + 1 == tile->y) ? TileSide_Down  : side;
+                side = (neighbour->x == tile->x && neighbour->y == tile->y + 1) ? TileSide_Up    : side;
+                if (side == TileSide_Count || neighbour->has_failed)
+                    continue;
+
+                if (!neighbour->is_loading && !neighbour->heights.empty())
+                {
+                    tile_edge(neighbour->heights.data(), m_tile_width, m_tile_height, side, &edges[side].heights);
+                }
+                else
+                {
+                    edges[side].file_path = neighbour->file_path;
+                }
+            }
 
-            for (uint32_t i = i_start; i < i_end; ++i)
+            tile->is_loading = true;
+            threading->AddTask([context = m_context, threading, importer, tile, grid, edges = move(edges), min_y = m_min_y, max_y = m_max_y]() mutable
             {
-                // Check which triangles use this vertex
-                for (uint32_t j = 0; j < face_count; ++j)
+                vector<float> heights;
+                uint32_t width  = 0;
+                uint32_t height = 0;
+                if (importer->LoadHeightMap(tile->file_path, &heights, &width, &height) && width == grid.width && height == grid.height)
                 {
-                    if (indices[j * 3] == i || indices[(j * 3) + 1] == i || indices[(j * 3) + 2] == i)
+                    for (float& value : heights)
                     {
-                        // If a face is using the vertex, accumulate the face normal/tangent
-                        normal_sum  += face_normals[j];
-                        tangent_sum += face_tangents[j];
-                        faces_using++;
+                        value = Helper::Lerp(min_y, max_y, value);
                     }
+                    grid.heights = heights.data();
 
-                    // Track progress but only every time the inner loop (face_count) finished.
-                    // This is because different threads increment the progress tracker which is also an atomic so it locks and unlocks.
-                    if (j == face_count < 1)
+                    // A neighbour that can't be read counts as the edge of the terrain
+                    for (uint32_t side = 0; side < TileSide_Count; side++)
                     {
-                        m_progress_jobs_done += face_count;
+                        TileEdge& edge = edges[side];
+                        if (edge.file_path.empty())
+                            continue;
+
+                        vector<float> heights_neighbour;
+                        uint32_t width_neighbour    = 0;
+                        uint32_t height_neighbour   = 0;
+                        if (importer->LoadHeightMap(edge.file_path, &heights_neighbour, &width_neighbour, &height_neighbour) && width_neighbour == width && height_neighbour == height)
+                        {
+                            tile_edge(heights_neighbour.data(), width, height, static_cast<TileSide>(side), &edge.heights);
+                            for (float& value : edge.heights)
+                            {
+                                value = Helper::Lerp(min_y, max_y, value);
+                            }
+                        }
                     }
-                }
-
-                // Compute actual normal
-                normal_sum /= faces_using;
-                normal_sum.Normalize();
 
-                // Compute actual tangent
-                tangent_sum /= faces_using;
-                tangent_sum.Normalize();
+                    vector<float> apron;
+                    tile_apron(heights, width, height, edges, &apron);
+                    grid.apron = apron.data();
 
-                // Write normal to vertex
-                vertices[i].nor[0] = normal_sum.x;
-                vertices[i].nor[1] = normal_sum.y;
-                vertices[i].nor[2] = normal_sum.z;
-
-                // Write tangent to vertex
-                vertices[i].tan[0] = tangent_sum.x;
-                vertices[i].tan[1] = tangent_sum.y;
-                vertices[i].tan[2] = tangent_sum.z;
-
-                // Reset
-                normal_sum  = Vector3::Zero;
-                tangent_sum = Vector3::Zero;
-                faces_using = 0;
-            }
-        };
-
-        m_context->GetSubsystem<Threading>()->AddTaskLoop(compute_vertex_normals_tangents, vertex_count);
+                    shared_ptr<Model> model = make_shared<Model>(context);
+                    chunks_layout(width, height, tile->chunks);
+                    chunks_build(threading, grid, tile->chunks, model.get(), nullptr);
+                    tile->heights   = move(heights);
+                    tile->model     = model;
+                }
+                else
+                {
+                    LOG_ERROR("Failed to load the tile \"%s\", tiles have to be %dx%d", tile->file_path.c_str(), grid.width, grid.height);
+                    tile->has_failed = true;
+                }
 
-        return true;
+                tile->is_loading = false;
+            });
+        }
     }
 
-    void Terrain::UpdateFromModel(const shared_ptr<Model>& model) const
+    void Terrain::TilesClear()
     {
-        if (!model)
-        {
-            LOG_ERROR_INVALID_PARAMETER();
+        if (m_tiles.empty())
             return;
-        }
 
-        if (Renderable* renderable = m_entity->AddComponent<Renderable>())
+        // The heights of the tiles stay alive until the collider has let go of them
+        vector<shared_ptr<TerrainTile>> tiles = move(m_tiles);
+        m_tiles.clear();
+        ColliderUpdate();
+
+        World* world = m_context->GetSubsystem<World>();
+        for (const shared_ptr<TerrainTile>& tile : tiles)
         {
-            renderable->GeometrySet(
-                "Terrain",
-                0,                                  // index offset
-                model->GetMesh()->Indices_Count(),  // index count
-                0,                                  // vertex offset
-                model->GetMesh()->Vertices_Count(), // vertex count
-                model->GetAabb(),
-                model.get()
-            );
+            for (const shared_ptr<Entity>& entity : tile->entities)
+            {
+                world->EntityRemove(entity);
+            }
 
-            renderable->UseDefaultMaterial();
+            if (tile->model)
+            {
+                m_tile_models_retired.emplace_back(tile->model);
+            }
         }
     }
 
-    void Terrain::UpdateFromVertices(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    void Terrain::ColliderUpdate() const
     {
-        // Add vertices and indices into a model struct (and cache that)
-        if (!m_model)
+        if (Collider* collider = m_entity->GetComponent<Collider>())
         {
-            // Create new model
-            m_model = make_shared<Model>(m_context);
-
-            // Set geometry
-            m_model->AppendGeometry(indices, vertices);
-            m_model->UpdateGeometry();
-
-            // Set a file path so the model can be used by the resource cache
-            ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
-            m_model->SetResourceFilePath(resource_cache->GetProjectDirectory() + m_entity->GetName() + "_terrain_" + to_string(m_id) + string(EXTENSION_MODEL));
-            m_model = resource_cache->Cache(m_model);
-        }
-        else
-        {
-            // Update with new geometry
-            m_model->Clear();
-            m_model->AppendGeometry(indices, vertices);
-            m_model->UpdateGeometry();
+            collider->HeightfieldUpdateBlocks();
         }
-
-        UpdateFromModel(m_model);
     }
 }
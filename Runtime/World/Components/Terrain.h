@@ -25,15 +25,38 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "IComponent.h"
 #include <atomic>
 #include "../../RHI/RHI_Definition.h"
+#include "../../Math/Vector2.h"
 //===================================
 
 namespace Spartan
 {
     class Model;
-    namespace Math
+    class Renderable;
+    struct TerrainTile;
+
+    // A square of the height grid, with a submesh (and levels of detail) of its own which is drawn by a child entity of the terrain
+    struct TerrainChunk
+    {
+        uint32_t x              = 0; // the first vertex in the grid
+        uint32_t y              = 0;
+        uint32_t quads_x        = 0;
+        uint32_t quads_y        = 0;
+        uint32_t submesh_index  = 0;
+        uint32_t lod_offset     = 0;
+        uint32_t lod_count      = 0;
+    };
+
+    // A rectangle of heights (the whole grid or a tile) that stays where it is in memory for as long as it's returned by Terrain::GetHeightBlocks(),
+    // so that the physics can reference it instead of copying it
+    struct TerrainHeightBlock
     {
-        class Vector3;
-    }
+        const float* heights    = nullptr; // rows of width heights
+        uint32_t width          = 0;
+        uint32_t height         = 0;
+        uint32_t x              = 0; // the first sample, counted from the first sample of the terrain
+        uint32_t y              = 0;
+        Math::Vector2 position  = Math::Vector2::Zero; // of the first sample, on the X and Z axes of the terrain
+    };
 
     class SPARTAN_CLASS Terrain : public IComponent
     {
@@ -43,6 +66,8 @@ namespace Spartan
 
         //= IComponent ===============================
         void OnInitialize() override;
+        void OnTick(float delta_time) override;
+        void OnRemove() override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
         //============================================
@@ -50,6 +75,18 @@ namespace Spartan
         const auto& GetHeightMap() const { return m_height_map; }
         void SetHeightMap(const std::shared_ptr<RHI_Texture2D>& height_map);
 
+        // A height map file (see ImageImporter::LoadHeightMap(), 16 bit and float formats keep their precision) or a directory of tiles. Tiles are height maps
+        // of the same size named <x>_<y> (e.g. tile_0_3.r16), which share their edge samples with their neighbours and are streamed in around the camera.
+        const auto& GetHeightMapPath() const { return m_height_map_path; }
+        void SetHeightMap(const std::string& path);
+        bool IsTiled() const { return !m_tiles.empty(); }
+
+        // Tiles within this distance of the camera are streamed in, and the ones that get a quarter further than that are streamed out
+        float GetStreamingDistance() const                  { return m_streaming_distance; }
+        void SetStreamingDistance(const float distance)     { m_streaming_distance = distance; }
+        uint32_t GetTileCount() const                       { return static_cast<uint32_t>(m_tiles.size()); }
+        uint32_t GetTilesResident() const;
+
         float GetMinY() const { return m_min_y; }
         void SetMinY(float min_z)   { m_min_y = min_z; }
 
@@ -61,12 +98,33 @@ namespace Spartan
 
         void GenerateAsync();
 
+        // The height grid (rows of GetWidth() heights), which is kept around so that it can be edited
+        const auto& GetHeights()    const { return m_heights; }
+        uint32_t GetWidth()         const { return m_width; }
+        uint32_t GetHeight()        const { return m_height; }
+        const auto& GetChunks()     const { return m_chunks; }
+
+        // Sets a rectangle of the height grid (rows of width heights) and only regenerates the chunks that it touches
+        void SetHeights(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const float* heights);
+
+        // The heights that are resident, a heightfield collider on the same entity is told when these change (see Collider::HeightfieldUpdateBlocks())
+        void GetHeightBlocks(std::vector<TerrainHeightBlock>& blocks) const;
+
+        // Times the normal and tangent generation for heightmaps from 1K to 8K, the time per vertex should stay the same as the size grows
+        void Benchmark();
+
     private:
-        bool GeneratePositions(std::vector<Math::Vector3>& positions, const std::vector<std::byte>& height_map);
-        bool GenerateVerticesIndices(const std::vector<Math::Vector3>& positions, std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        bool GenerateNormalTangents(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        void UpdateFromModel(const std::shared_ptr<Model>& model) const;
-        void UpdateFromVertices(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+        bool GenerateHeights(std::vector<float>& heights);
+        bool GenerateChunks();
+        void UpdateFromChunks();
+        bool ChunksFromModel();
+        void ChunksCreate(Model* model, const std::vector<TerrainChunk>& chunks, const std::string& name, bool is_transient, std::vector<std::shared_ptr<Entity>>* entities = nullptr) const;
+        void ChunksRemove();
+        Renderable* ChunkGetRenderable(const TerrainChunk& chunk) const;
+        bool TilesScan();
+        void TilesUpdate();
+        void TilesClear();
+        void ColliderUpdate() const;
 
         uint32_t m_width                            = 0;
         uint32_t m_height                           = 0;
@@ -74,12 +132,23 @@ namespace Spartan
         float m_max_y                               = 30.0f;
         float m_vertex_density                      = 1.0f;
         bool m_is_generating                        = false;
+        std::atomic<bool> m_chunks_dirty            = false; // the chunk entities are created on the main thread (see OnTick())
         uint64_t m_vertex_count                     = 0;
         uint64_t m_face_count                       = 0;
         std::atomic<uint64_t> m_progress_jobs_done  = 0;
         uint64_t m_progress_job_count               = 1; // avoid devision by zero in GetProgress()
         std::string m_progress_desc;
         std::shared_ptr<RHI_Texture2D> m_height_map;
+        std::string m_height_map_path;
         std::shared_ptr<Model> m_model;
+        std::vector<float> m_heights;
+        std::vector<TerrainChunk> m_chunks;
+
+        // Tiles
+        float m_streaming_distance                  = 1000.0f;
+        uint32_t m_tile_width                       = 0; // samples, including the ones that are shared with the neighbours
+        uint32_t m_tile_height                      = 0;
+        std::vector<std::shared_ptr<TerrainTile>> m_tiles;
+        std::vector<std::shared_ptr<Model>> m_tile_models_retired; // until the entities that drew them are gone
     };
 }
@@ -87,6 +87,17 @@ namespace Spartan
     }
 
     void Transform::UpdateTransform()
+    {
+        UpdateMatrices();
+
+        // Update children
+        for (const auto& child : m_children)
+        {
+            child->UpdateTransform();
+        }
+    }
+
+    void Transform::UpdateMatrices()
     {
         // Compute local transform
         m_matrixLocal = Matrix(m_positionLocal, m_rotationLocal, m_scaleLocal);
@@ -100,11 +111,19 @@ namespace Spartan
         {
             m_matrix = m_matrixLocal * GetParentTransformMatrix();
         }
-        
-        // Update children
+    }
+
+    void Transform::UpdateTransformOutsideBatch()
+    {
+        // Transforms of the batch are updated by their own write, which comes after this one's (as they are deeper)
+        if (m_is_in_batch)
+            return;
+
+        UpdateMatrices();
+
         for (const auto& child : m_children)
         {
-            child->UpdateTransform();
+            child->UpdateTransformOutsideBatch();
         }
     }
 
@@ -189,6 +208,68 @@ namespace Spartan
         }    
     }
 
+    void Transform::SetPositionsAndRotations(vector<TransformWrite>& writes)
+    {
+        // A transform with a parent needs the parent's matrix to be up to date, so it goes after every write which could change it.
+        // The depth of each transform is found once up front, rather than walking its parents on every comparison.
+        vector<pair<uint32_t, TransformWrite>> writes_depth;
+        writes_depth.reserve(writes.size());
+        for (const TransformWrite& write : writes)
+        {
+            uint32_t depth = 0;
+            for (const Transform* parent = write.transform->GetParent(); parent; parent = parent->GetParent())
+            {
+                depth++;
+            }
+            writes_depth.emplace_back(depth, write);
+        }
+
+        const auto writes_parented = partition(writes_depth.begin(), writes_depth.end(), [](const pair<uint32_t, TransformWrite>& write) { return write.first == 0; });
+        if (writes_parented != writes_depth.end())
+        {
+            sort(writes_parented, writes_depth.end(), [](const pair<uint32_t, TransformWrite>& a, const pair<uint32_t, TransformWrite>& b) { return a.first < b.first; });
+        }
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(writes.size()); i++)
+        {
+            writes[i] = writes_depth[i].second;
+        }
+
+        for (const TransformWrite& write : writes)
+        {
+            write.transform->m_is_in_batch = true;
+        }
+
+        // Each transform only updates itself and its children which aren't in the batch, by then, the parent it depends on is up to date
+        for (const TransformWrite& write : writes)
+        {
+            Transform* transform = write.transform;
+
+            if (!transform->HasParent())
+            {
+                transform->m_positionLocal = write.position;
+                transform->m_rotationLocal = write.rotation;
+            }
+            else
+            {
+                transform->m_positionLocal = write.position * transform->GetParent()->GetMatrix().Inverted();
+                transform->m_rotationLocal = write.rotation * transform->GetParent()->GetRotation().Inverse();
+            }
+
+            transform->UpdateMatrices();
+
+            for (Transform* child : transform->m_children)
+            {
+                child->UpdateTransformOutsideBatch();
+            }
+        }
+
+        for (const TransformWrite& write : writes)
+        {
+            write.transform->m_is_in_batch = false;
+        }
+    }
+
     Vector3 Transform::GetUp() const
     {
         return GetRotationLocal() * Vector3::Up;
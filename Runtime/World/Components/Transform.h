@@ -33,6 +33,14 @@ namespace Spartan
 {
     class RHI_Device;
     class RHI_ConstantBuffer;
+    class Transform;
+
+    struct TransformWrite
+    {
+        Transform* transform = nullptr;
+        Math::Vector3 position;
+        Math::Quaternion rotation;
+    };
 
     class SPARTAN_CLASS Transform : public IComponent
     {
@@ -74,6 +82,11 @@ namespace Spartan
         void Rotate(const Math::Quaternion& delta);
         //=========================================
 
+        // Sets the world position and rotation of many transforms at once (e.g. the rigid bodies after a physics step), every one of them is updated once.
+        // The writes are reordered, the ones of transforms without a parent go first, the rest follow from the top of their hierarchy down, and only
+        // the children which aren't written to themselves, are updated along with their parent.
+        static void SetPositionsAndRotations(std::vector<TransformWrite>& writes);
+
         //= DIRECTIONS ===================
         Math::Vector3 GetUp()       const;
         Math::Vector3 GetDown()     const;
@@ -110,6 +123,8 @@ namespace Spartan
 
     private:
         Math::Matrix GetParentTransformMatrix() const;
+        void UpdateMatrices();
+        void UpdateTransformOutsideBatch();
 
         // local
         Math::Vector3 m_positionLocal;
@@ -122,6 +137,7 @@ namespace Spartan
 
         Transform* m_parent; // the parent of this transform
         std::vector<Transform*> m_children; // the children of this transform
+        bool m_is_in_batch = false; // written to by SetPositionsAndRotations()
 
         Math::Matrix m_matrix_previous;
     };
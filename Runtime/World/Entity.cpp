@@ -36,6 +36,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Components/AudioSource.h"
 #include "Components/AudioListener.h"
 #include "Components/Terrain.h"
+#include "Components/Animator.h"
 #include "../IO/FileStream.h"
 //===================================
 
@@ -139,18 +140,6 @@ namespace Spartan
         }
     }
 
-    void Entity::Tick(float delta_time)
-    {
-        if (!m_is_active)
-            return;
-
-        // call component Update()
-        for (const auto& component : m_components)
-        {
-            component->OnTick(delta_time);
-        }
-    }
-
     void Entity::Serialize(FileStream* stream)
     {
         // BASIC DATA
@@ -179,6 +168,7 @@ namespace Spartan
         // CHILDREN
         {
             auto children = GetTransform()->GetChildren();
+            children.erase(remove_if(children.begin(), children.end(), [](Transform* child) { return child->GetEntity() && child->GetEntity()->IsTransient(); }), children.end());
 
             // Children count
             stream->Write(static_cast<uint32_t>(children.size()));
@@ -295,6 +285,7 @@ namespace Spartan
             case ComponentType::Environment:    return AddComponent<Environment>(id);
             case ComponentType::Transform:        return AddComponent<Transform>(id);
             case ComponentType::Terrain:           return AddComponent<Terrain>(id);
+            case ComponentType::Animator:          return AddComponent<Animator>(id);
             case ComponentType::Unknown:        return nullptr;
             default:                            return nullptr;
         }
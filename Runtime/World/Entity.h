@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =====================
 #include <vector>
+#include "EntityHandle.h"
 #include "../Core/EventSystem.h"
 #include "Components/IComponent.h"
 //================================
@@ -42,7 +43,6 @@ namespace Spartan
         void Clone();
         void Start();
         void Stop();
-        void Tick(float delta_time);
         void Serialize(FileStream* stream);
         void Deserialize(FileStream* stream, Transform* parent);
 
@@ -55,6 +55,10 @@ namespace Spartan
 
         bool IsVisibleInHierarchy() const                               { return m_hierarchy_visibility; }
         void SetHierarchyVisibility(const bool hierarchy_visibility)    { m_hierarchy_visibility = hierarchy_visibility; }
+
+        // Transient entities are created at runtime (e.g. the streamed tiles of a terrain) and are not saved with the world
+        bool IsTransient() const                                        { return m_is_transient; }
+        void SetTransient(const bool is_transient)                      { m_is_transient = is_transient; }
         //================================================================================================================
 
         // Adds a component of type T
@@ -168,6 +172,10 @@ namespace Spartan
         void MarkForDestruction()           { m_destruction_pending = true; }
         bool IsPendingDestruction() const   { return m_destruction_pending; }
 
+        // Handle (assigned by the world)
+        const EntityHandle& GetHandle() const           { return m_handle; }
+        void SetHandle(const EntityHandle& handle)      { m_handle = handle; }
+
         // Direct access for performance critical usage (not safe)
         Transform* GetTransform() const         { return m_transform; }
         Renderable* GetRenderable() const       { return m_renderable; }
@@ -179,9 +187,11 @@ namespace Spartan
         std::string m_name          = "Entity";
         bool m_is_active            = true;
         bool m_hierarchy_visibility = true;
+        bool m_is_transient         = false;
         Transform* m_transform      = nullptr;
         Renderable* m_renderable    = nullptr;
         bool m_destruction_pending  = false;
+        EntityHandle m_handle;
         
         // Components
         std::vector<std::shared_ptr<IComponent>> m_components;
@@ -0,0 +1,50 @@
+/*
+Copyright(c) 2016-2021 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==
+#include <cstdint>
+//=============
+
+namespace Spartan
+{
+    // A weak reference to an entity which is cheap to copy (no reference counting) and safe to hold on to.
+    // The index points to a slot in the world's entity table, the generation of that slot changes every time
+    // an entity is removed, so a handle to a removed entity simply resolves to nullptr (see World::EntityGet()).
+    struct EntityHandle
+    {
+        EntityHandle() = default;
+        EntityHandle(const uint32_t index, const uint32_t generation) : index(index), generation(generation) {}
+
+        // Packs the handle into 64 bits, e.g. to use it as a key
+        uint64_t ToUint64() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+
+        // A generation of zero is never given out, so a default constructed handle is always null
+        bool IsNull() const { return generation == 0; }
+
+        bool operator==(const EntityHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+        bool operator!=(const EntityHandle& rhs) const { return !(*this == rhs); }
+
+        uint32_t index      = 0;
+        uint32_t generation = 0;
+    };
+}
@@ -19,11 +19,12 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==========================
+//= INCLUDES ===========================
 #include "Spartan.h"
 #include "World.h"
 #include "Entity.h"
 #include "Components/Transform.h"
+#include "Components/Renderable.h"
 #include "Components/Camera.h"
 #include "Components/Light.h"
 #include "Components/Environment.h"
@@ -33,9 +34,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
+#include "../Physics/Physics.h"
 #include "../Input/Input.h"
 #include "../RHI/RHI_Device.h"
-//=====================================
+#include "../Threading/Threading.h"
+#include "../Math/Ray.h"
+//======================================
 
 //= NAMESPACES ================
 using namespace std;
@@ -47,19 +51,21 @@ namespace Spartan
     World::World(Context* context) : ISubsystem(context)
     {
         // Subscribe to events
-        SUBSCRIBE_TO_EVENT(EventType::WorldResolve, [this](Variant) { m_resolve = true; });
+        SUBSCRIBE_TO_EVENT(EventType::WorldResolve, [this](Variant) { m_resolve = true; m_tick_groups_dirty = true; });
     }
 
     World::~World()
     {
         m_input     = nullptr;
         m_profiler  = nullptr;
+        m_threading = nullptr;
     }
 
     bool World::Initialize()
     {
         m_input     = m_context->GetSubsystem<Input>();
         m_profiler  = m_context->GetSubsystem<Profiler>();
+        m_threading = m_context->GetSubsystem<Threading>();
 
         CreateCamera();
         CreateEnvironment();
@@ -76,6 +82,12 @@ namespace Spartan
 
         SCOPED_TIME_BLOCK(m_profiler);
 
+        // Update the tickable components, if needed
+        if (m_tick_groups_dirty)
+        {
+            TickGroupsUpdate();
+        }
+
         // Tick entities
         {
             // Detect game toggling
@@ -102,22 +114,21 @@ namespace Spartan
             }
 
             // Tick
-            for (shared_ptr<Entity>& entity : m_entities)
-            {
-                entity->Tick(delta_time);
-            }
+            m_is_ticking = true;
+            TickGroupsTick(delta_time);
+            m_is_ticking = false;
         }
 
         if (m_resolve)
         {
-            // Update dirty entities
+            // Remove entities which were removed while ticking
             {
-                // Make a copy so we can iterate while removing entities
-                auto entities_copy = m_entities;
+                // Move them out, as removing an entity can mark more (e.g. its children)
+                vector<shared_ptr<Entity>> entities_to_remove = move(m_entities_pending_destruction);
 
-                for (shared_ptr<Entity>& entity : entities_copy)
+                for (const shared_ptr<Entity>& entity : entities_to_remove)
                 {
-                    if (entity->IsPendingDestruction())
+                    if (EntityExists(entity->GetHandle()))
                     {
                         _EntityRemove(entity);
                     }
@@ -125,7 +136,7 @@ namespace Spartan
             }
 
             // Notify Renderer
-            FIRE_EVENT_DATA(EventType::WorldResolved, m_entities);
+            FIRE_EVENT(EventType::WorldResolved);
             m_resolve = false;
         }
     }
@@ -164,6 +175,7 @@ namespace Spartan
 
         // Only save root entities as they will also save their descendants
         auto root_actors = EntityGetRoots();
+        root_actors.erase(remove_if(root_actors.begin(), root_actors.end(), [](const shared_ptr<Entity>& entity) { return entity->IsTransient(); }), root_actors.end());
         const auto root_entity_count = static_cast<uint32_t>(root_actors.size());
 
         ProgressTracker::Get().SetJobCount(ProgressType::World, root_entity_count);
@@ -217,6 +229,10 @@ namespace Spartan
         // Because this loading function can be called by a different thread, we wait for it to stop first.
         Renderer* renderer = m_context->GetSubsystem<Renderer>();
         renderer->Stop();
+
+        // The physics are stopped too, as the entities that are removed and loaded remove and add bodies to the physics world
+        Physics* physics = m_context->GetSubsystem<Physics>();
+        physics->Stop();
         
         // Clear current entities
         Clear();
@@ -247,6 +263,8 @@ namespace Spartan
             ProgressTracker::Get().IncrementJobsDone(ProgressType::World);
         }
 
+        physics->Start();
+
         ProgressTracker::Get().SetIsLoading(ProgressType::World, false);
         LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
 
@@ -269,6 +287,7 @@ namespace Spartan
     {
         shared_ptr<Entity> entity = m_entities.emplace_back(make_shared<Entity>(m_context));
         entity->SetActive(is_active);
+        EntitySlotAcquire(entity.get());
         return entity;
     }
 
@@ -285,9 +304,21 @@ namespace Spartan
         if (!entity)
             return;
 
-        // Mark for destruction but don't delete now
-        // as the Renderer might still be using it.
-        entity->MarkForDestruction();
+        // While ticking, components are being iterated, so mark for destruction and remove after the tick.
+        // Anywhere else, it's safe to remove it right away as the Renderer only holds handles.
+        if (m_is_ticking)
+        {
+            if (!entity->IsPendingDestruction())
+            {
+                entity->MarkForDestruction();
+                m_entities_pending_destruction.emplace_back(entity);
+            }
+        }
+        else
+        {
+            _EntityRemove(entity);
+        }
+
         m_resolve = true;
     }
 
@@ -337,14 +368,24 @@ namespace Spartan
         m_context->GetSubsystem<ResourceCache>()->Clear();
 
         // Clear the entities
+        m_tick_groups.clear();
+        m_entities_pending_destruction.clear();
+        for (const shared_ptr<Entity>& entity : m_entities)
+        {
+            EntitySlotRelease(entity.get());
+        }
         m_entities.clear();
 
-        m_resolve = true;
+        m_resolve           = true;
+        m_tick_groups_dirty = true;
     }
 
     // Removes an entity and all of it's children
-    void World::_EntityRemove(const std::shared_ptr<Entity>& entity)
+    void World::_EntityRemove(const std::shared_ptr<Entity>& entity_in)
     {
+        // Keep the entity alive until we are done, the reference could be pointing into m_entities
+        const shared_ptr<Entity> entity = entity_in;
+
         // Remove any descendants
         auto children = entity->GetTransform()->GetChildren();
         for (const auto& child : children)
@@ -358,8 +399,7 @@ namespace Spartan
         // Remove this entity
         for (auto it = m_entities.begin(); it < m_entities.end();)
         {
-            const auto temp = *it;
-            if (temp->GetId() == entity->GetId())
+            if ((*it).get() == entity.get())
             {
                 it = m_entities.erase(it);
                 break;
@@ -367,11 +407,182 @@ namespace Spartan
             ++it;
         }
 
+        // Invalidate any handles to it
+        EntitySlotRelease(entity.get());
+
         // If there was a parent, update it
         if (parent)
         {
             parent->AcquireChildren();
         }
+
+        // The entity's components might be referenced by a tick group
+        m_tick_groups_dirty = true;
+    }
+
+    void World::EntitySlotAcquire(Entity* entity)
+    {
+        lock_guard<mutex> lock(m_entity_slots_mutex);
+
+        uint32_t index = 0;
+
+        if (!m_entity_slots_free.empty())
+        {
+            index = m_entity_slots_free.back();
+            m_entity_slots_free.pop_back();
+        }
+        else
+        {
+            index = m_entity_slot_count.load(memory_order_relaxed);
+
+            const uint32_t page = index / entity_slots_per_page;
+            if (page >= entity_slot_pages_max)
+            {
+                LOG_ERROR("The entity table is full, %d entities at most", entity_slots_per_page * entity_slot_pages_max);
+                return;
+            }
+
+            if (!m_entity_slot_pages[page])
+            {
+                m_entity_slot_pages[page] = make_unique<EntitySlot[]>(entity_slots_per_page);
+            }
+        }
+
+        // The slot is filled before it can be resolved, a new one only becomes visible once the count includes it
+        EntitySlot& slot = EntitySlotGet(index);
+        slot.entity.store(entity, memory_order_release);
+        entity->SetHandle(EntityHandle(index, slot.generation.load(memory_order_relaxed)));
+
+        if (index == m_entity_slot_count.load(memory_order_relaxed))
+        {
+            m_entity_slot_count.store(index + 1, memory_order_release);
+        }
+    }
+
+    void World::EntitySlotRelease(Entity* entity)
+    {
+        lock_guard<mutex> lock(m_entity_slots_mutex);
+
+        const EntityHandle& handle = entity->GetHandle();
+        if (EntityGet(handle) != entity)
+            return;
+
+        // Bump the generation first so that existing handles stop resolving, zero is reserved for null handles
+        EntitySlot& slot        = EntitySlotGet(handle.index);
+        uint32_t generation     = slot.generation.load(memory_order_relaxed) + 1;
+        slot.generation.store(generation == 0 ? 1 : generation, memory_order_release);
+        slot.entity.store(nullptr, memory_order_release);
+
+        m_entity_slots_free.emplace_back(handle.index);
+        entity->SetHandle(EntityHandle());
+    }
+
+    void World::TickGroupsUpdate()
+    {
+        m_tick_groups.clear();
+        m_tick_wave_count = 0;
+
+        // Create a group for every component type that ticks
+        array<int32_t, static_cast<uint32_t>(ComponentType::Unknown) + 1> group_index;
+        group_index.fill(-1);
+        for (const ComponentTickDescription& description : IComponent::GetTickDescriptions())
+        {
+            group_index[static_cast<uint32_t>(description.type)] = static_cast<int32_t>(m_tick_groups.size());
+            m_tick_groups.emplace_back().description = &description;
+        }
+
+        // Collect the components, anything that doesn't tick (e.g. Transform, Renderable, Collider) never gets visited again
+        for (const shared_ptr<Entity>& entity : m_entities)
+        {
+            for (const shared_ptr<IComponent>& component : entity->GetAllComponents())
+            {
+                const int32_t index = group_index[static_cast<uint32_t>(component->GetType())];
+                if (index != -1)
+                {
+                    m_tick_groups[index].components.emplace_back(component.get());
+                }
+            }
+        }
+
+        // Remove empty groups
+        m_tick_groups.erase(remove_if(m_tick_groups.begin(), m_tick_groups.end(), [](const TickGroup& group) { return group.components.empty(); }), m_tick_groups.end());
+
+        // Assign waves, a group has to tick after any preceding group it conflicts with
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_tick_groups.size()); i++)
+        {
+            TickGroup& group = m_tick_groups[i];
+
+            for (uint32_t j = 0; j < i; j++)
+            {
+                const TickGroup& group_previous = m_tick_groups[j];
+                const ComponentTickDescription& a = *group.description;
+                const ComponentTickDescription& b = *group_previous.description;
+
+                const bool conflict =
+                    (a.access_write == ComponentAccess_All)                     ||
+                    (b.access_write == ComponentAccess_All)                     ||
+                    (a.access_write & (b.access_read | b.access_write)) != 0    ||
+                    (b.access_write & a.access_read) != 0;
+
+                if (conflict)
+                {
+                    group.wave = Helper::Max(group.wave, group_previous.wave + 1);
+                }
+            }
+
+            m_tick_wave_count = Helper::Max(m_tick_wave_count, group.wave + 1);
+        }
+
+        m_tick_groups_dirty = false;
+    }
+
+    void World::TickGroupsTick(float delta_time)
+    {
+        const auto tick_group = [delta_time](const TickGroup& group)
+        {
+            for (IComponent* component : group.components)
+            {
+                if (component->GetEntity()->IsActive())
+                {
+                    component->OnTick(delta_time);
+                }
+            }
+        };
+
+        for (uint32_t wave = 0; wave < m_tick_wave_count; wave++)
+        {
+            // Components might have been added or removed by the previous wave (e.g. by a script)
+            if (m_tick_groups_dirty)
+            {
+                TickGroupsUpdate();
+
+                if (wave >= m_tick_wave_count)
+                    break;
+            }
+
+            vector<const TickGroup*> groups_main;
+            vector<const TickGroup*> groups_worker;
+            for (const TickGroup& group : m_tick_groups)
+            {
+                if (group.wave != wave)
+                    continue;
+
+                (group.description->main_thread ? groups_main : groups_worker).emplace_back(&group);
+            }
+
+            // The threads start on the worker groups while this thread ticks the main thread ones, then it helps with what's left of the worker groups
+            m_threading->ParallelFor(
+                static_cast<uint32_t>(groups_worker.size()),
+                [&tick_group, &groups_worker](uint32_t i) { tick_group(*groups_worker[i]); },
+                [&tick_group, &groups_main]()
+                {
+                    for (const TickGroup* group : groups_main)
+                    {
+                        tick_group(*group);
+                    }
+                }
+            );
+        }
     }
 
     shared_ptr<Entity> World::CreateEnvironment()
@@ -409,4 +620,56 @@ namespace Spartan
 
         return light;
     }
+
+    bool World::Raycast(const Ray& ray, shared_ptr<Entity>* entity, float* distance /*= nullptr*/)
+    {
+        if (!entity)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // The candidates are kept around, so that tracing doesn't allocate once they've grown large enough
+        thread_local vector<pair<float, uint32_t>> candidates;
+        candidates.clear();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_entities.size()); i++)
+        {
+            Renderable* renderable = m_entities[i]->GetRenderable();
+            if (!renderable || !m_entities[i]->IsActive())
+                continue;
+
+            const float distance_box = ray.HitDistance(renderable->GetAabb());
+            if (distance_box != Helper::INFINITY_)
+            {
+                candidates.emplace_back(distance_box, i);
+            }
+        }
+        sort(candidates.begin(), candidates.end());
+
+        float distance_nearest  = Helper::INFINITY_;
+        uint32_t entity_nearest = 0;
+        for (const pair<float, uint32_t>& candidate : candidates)
+        {
+            if (candidate.first >= distance_nearest)
+                break;
+
+            const float distance_triangle = m_entities[candidate.second]->GetRenderable()->RayHitDistance(ray);
+            if (distance_triangle < distance_nearest)
+            {
+                distance_nearest    = distance_triangle;
+                entity_nearest      = candidate.second;
+            }
+        }
+
+        if (distance_nearest == Helper::INFINITY_)
+            return false;
+
+        *entity = m_entities[entity_nearest];
+        if (distance)
+        {
+            *distance = distance_nearest;
+        }
+
+        return true;
+    }
 }
@@ -25,6 +25,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <memory>
 #include <string>
+#include <mutex>
+#include <atomic>
+#include "EntityHandle.h"
 #include "../Core/ISubsystem.h"
 #include "../Core/Spartan_Definitions.h"
 //======================================
@@ -32,9 +35,29 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     class Entity;
+    class IComponent;
     class Light;
     class Input;
     class Profiler;
+    class Threading;
+    struct ComponentTickDescription;
+    namespace Math { class Ray; }
+
+    // All the components of a given type that need ticking
+    struct TickGroup
+    {
+        const ComponentTickDescription* description = nullptr;
+        uint32_t wave                               = 0; // groups in the same wave don't conflict and tick in parallel
+        std::vector<IComponent*> components;
+    };
+
+    // An entry of the entity table, which handles index into. Entities can be created by other threads (e.g. while a model or a world loads),
+    // while the main thread resolves handles, so a slot is read without locking.
+    struct EntitySlot
+    {
+        std::atomic<Entity*> entity         = { nullptr };
+        std::atomic<uint32_t> generation    = { 1 };
+    };
 
     class SPARTAN_CLASS World : public ISubsystem
     {
@@ -62,11 +85,32 @@ namespace Spartan
         const std::shared_ptr<Entity>& EntityGetByName(const std::string& name);
         const std::shared_ptr<Entity>& EntityGetById(uint32_t id);
         const auto& EntityGetAll() const    { return m_entities; }
+
+        // Resolves a handle in O(1), returns nullptr if the entity has been removed
+        Entity* EntityGet(const EntityHandle& handle) const
+        {
+            if (handle.index >= m_entity_slot_count.load(std::memory_order_acquire))
+                return nullptr;
+
+            const EntitySlot& slot = EntitySlotGet(handle.index);
+            Entity* entity = slot.entity.load(std::memory_order_acquire);
+            return slot.generation.load(std::memory_order_acquire) == handle.generation ? entity : nullptr;
+        }
+        bool EntityExists(const EntityHandle& handle) const { return EntityGet(handle) != nullptr; }
         //======================================================================
 
+        // Finds the nearest renderable whose triangles the ray hits (main thread, for picking and gameplay traces). Bounding boxes are tested first,
+        // then the bvhs of the entities they hit, nearest first, until the next box is further away than the nearest hit.
+        bool Raycast(const Math::Ray& ray, std::shared_ptr<Entity>* entity, float* distance = nullptr);
+
     private:
         void Clear();
         void _EntityRemove(const std::shared_ptr<Entity>& entity);
+        void EntitySlotAcquire(Entity* entity);
+        void EntitySlotRelease(Entity* entity);
+        EntitySlot& EntitySlotGet(const uint32_t index) const { return m_entity_slot_pages[index / entity_slots_per_page][index % entity_slots_per_page]; }
+        void TickGroupsUpdate();
+        void TickGroupsTick(float delta_time);
 
         //= COMMON ENTITY CREATION ======================
         std::shared_ptr<Entity> CreateEnvironment();
@@ -77,9 +121,27 @@ namespace Spartan
         std::string m_name;
         bool m_was_in_editor_mode   = false;
         bool m_resolve              = true;
+        bool m_is_ticking           = false;
         Input* m_input              = nullptr;
         Profiler* m_profiler        = nullptr;
+        Threading* m_threading      = nullptr;
 
         std::vector<std::shared_ptr<Entity>> m_entities;
+
+        // Entity table (slots are recycled, with their generation incremented). It grows a page at a time and the pages never move,
+        // so a slot that's being resolved stays where it is while another thread adds slots.
+        static const uint32_t entity_slots_per_page = 1024;
+        static const uint32_t entity_slot_pages_max = 4096;
+        std::unique_ptr<EntitySlot[]> m_entity_slot_pages[entity_slot_pages_max];
+        std::atomic<uint32_t> m_entity_slot_count = { 0 };
+        std::vector<uint32_t> m_entity_slots_free;
+        std::mutex m_entity_slots_mutex;
+
+        std::vector<std::shared_ptr<Entity>> m_entities_pending_destruction;
+
+        // Tickable components
+        std::vector<TickGroup> m_tick_groups;
+        uint32_t m_tick_wave_count  = 0;
+        bool m_tick_groups_dirty    = true;
     };
 }
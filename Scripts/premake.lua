@@ -33,6 +33,7 @@ INTERMEDIATE_DIR			= "../Binaries/Intermediate"
 TARGET_DIR_RELEASE  		= "../Binaries/Release"
 TARGET_DIR_DEBUG    		= "../Binaries/Debug"
 API_GRAPHICS				= _ARGS[1]
+BULLET_THREADSAFE			= _ARGS[2] == "bullet_threadsafe" -- the Bullet libraries have to be rebuilt with BT_THREADSAFE=1 first
 
 -- Compute graphics api specific variables
 if API_GRAPHICS == "d3d11" then
@@ -76,7 +77,8 @@ solution (SOLUTION_NAME)
 	defines
 	{
 		"SPARTAN_RUNTIME_STATIC=1",
-		"SPARTAN_RUNTIME_SHARED=0"
+		"SPARTAN_RUNTIME_SHARED=0",
+		"BT_THREADSAFE=" .. (BULLET_THREADSAFE and "1" or "0")
 	}
 	
 	filter { "platforms:x64" }